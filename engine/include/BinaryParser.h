@@ -1,5 +1,83 @@
 #pragma once
 #include "DataTypes.h"
+#include <cstddef>
+#include <cstdint>
 
-// Declares the function signature so other files know about it.
+// --- Byte order ---
+// Every integer on the wire (and in captures and journals) is little-endian.
+// On little-endian hosts, which is everything we deploy on, these helpers
+// compile to nothing; on a big-endian host they swap, so a capture or a sender
+// from either kind of machine decodes the same way.
+inline uint16_t fromLittleEndian(uint16_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap16(v);
+#else
+    return v;
+#endif
+}
+inline uint32_t fromLittleEndian(uint32_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(v);
+#else
+    return v;
+#endif
+}
+inline uint64_t fromLittleEndian(uint64_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(v);
+#else
+    return v;
+#endif
+}
+
+// Decodes one message. No validation: use parseBatch for anything from the network.
 PanoptesMessage parseMessage(const char* buffer);
+
+// What parseBatch accepts. A message is valid if:
+//  - its event type is 'A', 'X', 'E' or 'M' and its side is 'B' or 'A';
+//  - for adds, executes and modifies, 0 < size <= max_size;
+//  - for adds and modifies, min_price <= price <= max_price.
+// (A cancel's size and price, and an execute's price, are not used by the book.)
+struct ParseLimits {
+    Price min_price = 1;
+    // Keeps prices well inside the range every price-keyed structure handles.
+    Price max_price = (Price(1) << 47) - 1;
+    int32_t max_size = INT32_MAX;
+};
+
+// Why messages were turned away. Each reject is counted once, under the first
+// rule it breaks, in the order listed.
+struct ParseStats {
+    uint64_t accepted = 0;
+    uint64_t bad_event_type = 0;
+    uint64_t bad_side = 0;
+    uint64_t bad_size = 0;
+    uint64_t bad_price = 0;
+
+    uint64_t rejected() const { return bad_event_type + bad_side + bad_size + bad_price; }
+};
+
+// The instruction sets parseBatch can use.
+enum class ParserIsa {
+    Scalar,
+    Sse42,   // Four messages per step.
+    Avx2,    // Eight messages per step.
+};
+
+// The best instruction set this CPU supports (checked once).
+ParserIsa bestParserIsa();
+
+// Decodes 'count' back-to-back wire messages from 'buffer', validates them and
+// writes the valid ones, in order, to 'out' (which must have room for 'count').
+// Returns how many were written and adds the counts to 'stats'.
+//
+// The checks run on many messages at once with SIMD compares (see
+// BinaryParser.cpp); the valid ones are then copied out with no per-message
+// branches beyond the loop over a bit mask.
+size_t parseBatch(const char* buffer, size_t count, PanoptesMessage* out, ParseStats& stats,
+                  const ParseLimits& limits = {});
+
+// The same, forcing a particular implementation (for tests and benchmarks).
+// Falls back to Scalar if the CPU lacks the requested instructions.
+size_t parseBatchWith(ParserIsa isa, const char* buffer, size_t count, PanoptesMessage* out,
+                      ParseStats& stats, const ParseLimits& limits = {});
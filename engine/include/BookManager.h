@@ -0,0 +1,194 @@
+#pragma once // Standard header guard.
+
+#include "BookView.h"
+#include "DataTypes.h"
+#include "OrderBook.h"
+#include "LatencyReport.h"
+#include "MarketDataPublisher.h"
+#include "PerfCounters.h"
+#include "Snapshot.h"
+#include "SpscRing.h"
+#include "TscClock.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// What a book worker does while its ring is empty.
+enum class WorkerIdlePolicy {
+    // Spin with a pause instruction: the lowest wake-up latency, at the cost
+    // of a whole core whether or not messages are flowing.
+    Spin,
+    // Spin for a while, then yield the CPU for a while, then sleep briefly
+    // between looks at the ring. Frees the core on a quiet feed; the first
+    // message after a lull waits up to one sleep.
+    Backoff
+};
+
+struct BookManagerConfig {
+    size_t num_workers = 1;
+    // Capacity of each worker's inbound ring, in messages.
+    size_t queue_capacity = 1 << 16;
+    // If >= 0, worker i is pinned to CPU first_cpu + i.
+    int first_cpu = -1;
+    // If > 0, every worker runs SCHED_FIFO at this priority (see ThreadTuning.h).
+    int rt_priority = 0;
+    WorkerIdlePolicy idle = WorkerIdlePolicy::Spin;
+    // Backoff only: empty polls spent spinning, then yielding, before the
+    // worker starts sleeping for backoff_sleep_us between polls.
+    uint32_t backoff_spins = 4096;
+    uint32_t backoff_yields = 64;
+    uint32_t backoff_sleep_us = 50;
+    // Pool settings for every book the workers create.
+    OrderPoolConfig pool_config{};
+    // Tick size, base price and window size of each instrument's book.
+    InstrumentLadders ladders{};
+    // Order layout and matching for every book (see makeOrderBook()).
+    BookVariant variant{};
+    // Time every book update with the TSC (two reads per message), and the
+    // handoff from submit() to the worker (one more, on the network thread).
+    bool measure_latency = true;
+    // Hardware counters around sampled book updates (when compiled in).
+    PerfConfig perf{};
+    // If set, every book reports its level changes and worker i publishes them
+    // as producer i. Must have at least num_workers producers and outlive the
+    // manager's workers.
+    MarketDataPublisher* publisher = nullptr;
+    // Receives each worker's part of a snapshot (see requestSnapshot()). Must
+    // expect num_workers parts and outlive the manager's workers.
+    SnapshotWriter* snapshot_writer = nullptr;
+    // If set, every book's top levels are published to this shared-memory view
+    // whenever a message changes one of them. Must outlive the manager's workers.
+    SharedBookView* book_view = nullptr;
+};
+
+// Owns the books for many instruments and spreads them across worker threads.
+//
+// Instruments are partitioned statically: instrument i always belongs to worker
+// i % num_workers. Each worker owns its books outright and is the only thread
+// that ever touches them, so the books need no locking. The network thread hands
+// messages to a worker through that worker's single-producer/single-consumer
+// ring, which is the only point of contact between the threads.
+//
+// Books are created lazily by the owning worker the first time it sees a
+// message for that instrument.
+class BookManager {
+public:
+    explicit BookManager(const BookManagerConfig& config);
+    ~BookManager();
+
+    BookManager(const BookManager&) = delete;
+    BookManager& operator=(const BookManager&) = delete;
+
+    // Starts the worker threads.
+    void start();
+
+    // Waits for every queued message to be processed, then joins the workers.
+    void stop();
+
+    // Network thread only: queues a message for the worker that owns its instrument.
+    // Spins while that worker's ring is full, so nothing is ever dropped.
+    //
+    // The books never read the sender's timestamp, so the queued copy carries
+    // the submit time in its place, for the handoff latency. That keeps a
+    // slot at 32 bytes, two to a cache line.
+    inline void submit(const PanoptesMessage& msg) {
+        Worker& worker = *workers_[workerFor(msg.instrument_id)];
+        PanoptesMessage queued = msg;
+        if (config_.measure_latency) {
+            queued.timestamp = static_cast<Timestamp>(TscClock::now());
+        }
+        while (!worker.queue.tryPush(queued)) {
+            ++worker.producer_stalls;
+        }
+    }
+
+    // Network thread only: snapshots every book as of the messages submitted so
+    // far, which the journal has recorded up to 'journal_sequence'.
+    //
+    // A marker goes through each worker's ring like any other message. When a
+    // worker reaches it, everything submitted before it (and nothing after) has
+    // been applied to that worker's books, so the parts together are a
+    // consistent cut. The worker copies its resting orders, hands them to the
+    // snapshot writer and carries on; it never waits for the disk.
+    void requestSnapshot(uint64_t journal_sequence);
+
+    inline size_t workerFor(InstrumentID instrument) const {
+        return instrument % workers_.size();
+    }
+
+    size_t numWorkers() const { return workers_.size(); }
+
+    // Totals across all workers. Exact once stop() has returned.
+    uint64_t messagesProcessed() const;
+    uint64_t tradesProduced() const;
+    // How many times a book's shared-memory view was republished.
+    uint64_t viewPublishes() const;
+    // How many times submit() found a ring full and had to retry.
+    uint64_t producerStalls() const;
+    // The deepest any worker's ring has been (see SpscRing::highWaterMark()).
+    size_t ringHighWaterMark() const;
+    size_t ringCapacity() const { return workers_.front()->queue.capacity(); }
+
+    // Adds each worker's handoff and book-update latency histograms into 'report'.
+    // Safe to call while the workers are running (the counts may be slightly torn).
+    void collectLatency(LatencyReport& report) const;
+
+    // Adds each worker's book-update counter totals into 'report'. Only safe
+    // to call while the workers are stopped.
+    void collectPerf(PerfReport& report) const;
+
+    // The book for an instrument, or nullptr if no message for it has been seen.
+    // Only safe to call while the workers are stopped.
+    const OrderBook* book(InstrumentID instrument) const;
+
+private:
+    struct Worker {
+        explicit Worker(size_t queue_capacity) : queue(queue_capacity) {}
+
+        SpscRing<PanoptesMessage> queue;
+        // Books owned by this worker, indexed by instrument / num_workers.
+        std::vector<std::unique_ptr<OrderBook>> books;
+        std::thread thread;
+        // Book-update latency by event type, written only by this worker.
+        LatencyReport latency;
+        // Book-update counter totals by event type, written only by this worker.
+        PerfReport perf;
+        // Books (by slot, as 'books') whose market data lost an update to a
+        // full publisher ring and must be resent whole: flagged, and listed so
+        // a resync visits only those. Worker only.
+        std::vector<uint8_t> md_stale;
+        std::vector<size_t> md_stale_slots;
+        // Levels the last stale book in the list was found to need, at least;
+        // it is not read again until the ring has that much room.
+        size_t md_resync_need = 0;
+        // Scratch for reading a book's depth for a resync.
+        std::vector<BestPrice> md_depth;
+        std::vector<LevelUpdate> md_levels;
+
+        // Written by the worker, read by anyone.
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> trades{0};
+        std::atomic<uint64_t> view_publishes{0};
+        // Written by the network thread only.
+        alignas(CACHE_LINE_SIZE) uint64_t producer_stalls = 0;
+    };
+
+    // Internal message type of the snapshot marker; the sequence travels in
+    // the timestamp field.
+    static constexpr char SNAPSHOT_MARKER = 'S';
+
+    void run(size_t worker_index);
+    // Called each time a worker finds its ring empty; 'idle_polls' counts the
+    // empty polls in a row so far.
+    void waitForWork(uint32_t idle_polls) const;
+    void takeSnapshot(size_t worker_index, uint64_t journal_sequence) const;
+    // Resends the whole depth of each book whose market data went stale, as
+    // far as the publisher's ring has room.
+    void resyncMarketData(size_t worker_index);
+
+    BookManagerConfig config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{false};
+};
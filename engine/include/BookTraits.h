@@ -0,0 +1,54 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "OrderStorage.h"
+#include <cstddef>
+
+// Marks a trait that is read from the run-time config (PriceLadderConfig,
+// OrderPoolConfig) instead of being fixed at compile time.
+constexpr Price RUNTIME_TICK = 0;
+constexpr size_t RUNTIME_SIZE = 0;
+
+// What a book knows about its instruments at compile time.
+//
+//   Storage       The order storage layout (see OrderStorage.h).
+//   TickSize      The tick size, or RUNTIME_TICK. When fixed, the price to
+//   BasePrice     tick conversion and the off-grid check fold into constant
+//                 arithmetic; a unit tick with base 0 makes them disappear.
+//                 BasePrice only applies with a fixed TickSize.
+//   WindowLevels  The ladder's dense window, or RUNTIME_SIZE (see PriceLadder.h).
+//   MaxOrders     A hard cap on resting orders (adds past it are rejected),
+//                 or RUNTIME_SIZE to take capacity and policy from the pool config.
+//   Matching      Whether adds are matched against the other side. A book
+//                 built from a venue's own feed can turn it off: the venue has
+//                 already matched, adds never cross, and fills arrive as
+//                 executes.
+//
+// A book is only compiled for the traits L1CacheBook.cpp instantiates; the
+// presets below are the ones it does.
+template <typename StorageT, Price TickSize = RUNTIME_TICK, Price BasePrice = 0,
+          size_t WindowLevels = RUNTIME_SIZE, size_t MaxOrders = RUNTIME_SIZE, bool Matching = true>
+struct BookTraits {
+    using Storage = StorageT;
+    static constexpr Price TICK_SIZE = TickSize;
+    static constexpr Price BASE_PRICE = BasePrice;
+    static constexpr size_t WINDOW_LEVELS = WindowLevels;
+    static constexpr size_t MAX_ORDERS = MaxOrders;
+    static constexpr bool MATCHING = Matching;
+
+    static_assert(TickSize >= 0, "the tick size is positive, or RUNTIME_TICK");
+};
+
+// Everything from the run-time config: one build serves any instrument.
+template <typename Storage, bool Matching = true>
+using RuntimeBookTraits = BookTraits<Storage, RUNTIME_TICK, 0, RUNTIME_SIZE, RUNTIME_SIZE, Matching>;
+
+// Prices are whole ticks counted from zero, which is how most of our feeds
+// quote; window and capacity still come from the config.
+template <typename Storage, bool Matching = true>
+using UnitTickBookTraits = BookTraits<Storage, 1, 0, RUNTIME_SIZE, RUNTIME_SIZE, Matching>;
+
+// Every trait fixed: unit tick, the default window and pool capacity. For
+// measuring what the compile-time constants buy (see bench_L1CacheBook.cpp).
+using FixedBookTraits =
+    BookTraits<PointerOrderStorage, 1, 0, DEFAULT_LADDER_WINDOW_LEVELS, DEFAULT_ORDER_POOL_CAPACITY, true>;
@@ -0,0 +1,201 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "SpscRing.h" // For CACHE_LINE_SIZE
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shared-memory views of the books, for strategies and risk processes on the
+// same host.
+//
+// The engine creates a POSIX shared-memory segment (SharedBookView) holding one
+// slot per instrument: the best BOOK_VIEW_DEPTH levels of each side, the TSC
+// at which they were published, and a sequence number. Only the book's own
+// worker ever writes a slot, so each slot is a seqlock: the writer makes the
+// sequence odd, stores the view, then makes it even again. A reader
+// (BookViewReader, in any process that maps the segment) copies the view
+// between two reads of the sequence and keeps the copy only if the sequence
+// was even and unchanged. Readers take no locks and make no syscalls, and can
+// never hold up the writer; a reader that races a publish just copies again.
+//
+// The view is republished only when a message changes a level it shows, so
+// books that mostly churn behind the top levels rarely touch the segment.
+//
+// This header and BookView.cpp have no dependencies on the rest of the
+// engine, and build as the panoptes_book_view library for readers to link.
+
+// Levels per side in each instrument's view.
+constexpr size_t BOOK_VIEW_DEPTH = 10;
+
+// One instrument's published view. Levels are best first; only the first
+// bid_levels and ask_levels entries are meaningful.
+struct BookView {
+    // The writer's TscClock reading when it published this view (taken after
+    // the message that changed it was applied).
+    uint64_t publish_tsc = 0;
+    uint32_t bid_levels = 0;
+    uint32_t ask_levels = 0;
+    BestPrice bids[BOOK_VIEW_DEPTH];
+    BestPrice asks[BOOK_VIEW_DEPTH];
+
+    BestPrice bestBid() const { return bid_levels > 0 ? bids[0] : BestPrice{}; }
+    BestPrice bestAsk() const { return ask_levels > 0 ? asks[0] : BestPrice{}; }
+};
+
+// The layout of the segment: a header, then num_instruments slots. Bump
+// BOOK_VIEW_LAYOUT whenever any of it changes, so old readers refuse the segment.
+constexpr uint64_t BOOK_VIEW_MAGIC = 0x5745495642504E50ull; // "PNPBVIEW"
+constexpr uint32_t BOOK_VIEW_LAYOUT = 1;
+
+struct alignas(CACHE_LINE_SIZE) BookViewHeader {
+    // Written last by the creator, so a reader that sees the magic sees the rest.
+    std::atomic<uint64_t> magic;
+    uint32_t layout;
+    uint32_t depth;
+    uint32_t num_instruments;
+    uint32_t slot_bytes;
+    // The writer's TSC rate, so readers can turn publish_tsc ages into
+    // nanoseconds without calibrating their own clock.
+    double ns_per_tick;
+};
+
+struct alignas(CACHE_LINE_SIZE) BookViewSlot {
+    static constexpr size_t WORDS = sizeof(BookView) / sizeof(uint64_t);
+
+    // Odd while the writer is mid-update. sequence / 2 publishes so far.
+    std::atomic<uint64_t> sequence;
+    // The writer's own bookkeeping (readers ignore it): the worst price each
+    // side of the published view shows, or the side's limit if it shows
+    // fewer than BOOK_VIEW_DEPTH levels, and how many levels each side has.
+    // It shares the line the writer has to dirty to publish anyway, so
+    // checking it costs no extra cache line.
+    Price worst_bid;
+    Price worst_ask;
+    uint32_t bid_levels;
+    uint32_t ask_levels;
+    // The BookView, as words so that every access is a (relaxed) atomic one
+    // and a torn read is well defined; the sequence check throws it away.
+    std::atomic<uint64_t> words[WORDS];
+};
+
+static_assert(sizeof(BookView) % sizeof(uint64_t) == 0, "a BookView is copied as whole words");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots are shared between processes");
+
+// The engine's side: creates the segment and publishes into it.
+class SharedBookView {
+public:
+    SharedBookView() = default;
+    ~SharedBookView() { close(); }
+
+    SharedBookView(const SharedBookView&) = delete;
+    SharedBookView& operator=(const SharedBookView&) = delete;
+
+    // Creates the segment 'name' (a POSIX shared-memory name such as
+    // "/panoptes_book", replacing any left over from an earlier run) with
+    // slots for instruments 0 .. num_instruments - 1, and faults its pages in
+    // so no book thread takes a page fault on its first publish. Returns false
+    // (after printing why) on failure.
+    bool create(const std::string& name, size_t num_instruments, double ns_per_tick);
+
+    // Unmaps and removes the segment. Readers that still have it mapped keep
+    // their (now frozen) copy.
+    void close();
+
+    size_t numInstruments() const { return num_instruments_; }
+
+    // Owning book thread only: publishes a new view of 'instrument'.
+    void publish(InstrumentID instrument, const BookView& view) {
+        write(slots_[instrument], view, {true, true, true}, nullptr, 0);
+    }
+
+    // Owning book thread only: after 'book' has applied a message whose level
+    // changes are 'changes', republishes its view if any change shows in it.
+    // Returns true if it published. 'Book' is anything with OrderBook's depth().
+    //
+    // Most changes the view shows are a new volume at a level it already has,
+    // and are patched in place. A level appearing or emptying within the view
+    // moves the ones behind it, so that side is read afresh from the book.
+    template <typename Book>
+    bool update(InstrumentID instrument, const Book& book, const LevelUpdate* changes, size_t count,
+                uint64_t tsc) {
+        if (instrument >= num_instruments_) {
+            return false;
+        }
+        BookViewSlot& slot = slots_[instrument];
+        const Changes what = classify(slot, changes, count);
+        if (!what.shown) {
+            return false;
+        }
+        BookView view;
+        view.publish_tsc = tsc;
+        if (what.reread_bids) {
+            view.bid_levels = static_cast<uint32_t>(book.depth('B', view.bids, BOOK_VIEW_DEPTH));
+        }
+        if (what.reread_asks) {
+            view.ask_levels = static_cast<uint32_t>(book.depth('A', view.asks, BOOK_VIEW_DEPTH));
+        }
+        write(slot, view, what, changes, count);
+        return true;
+    }
+
+private:
+    // What a message's level changes do to a published view.
+    struct Changes {
+        bool shown;       // At least one change is within the view.
+        bool reread_bids; // A level appeared or emptied within that side.
+        bool reread_asks;
+    };
+
+    static Changes classify(const BookViewSlot& slot, const LevelUpdate* changes, size_t count);
+
+    // The seqlock write: the timestamp, the sides being reread from 'view',
+    // and patches for the other sides' changes.
+    static void write(BookViewSlot& slot, const BookView& view, Changes what, const LevelUpdate* changes,
+                      size_t count);
+
+    std::string name_;
+    void* memory_ = nullptr;
+    size_t bytes_ = 0;
+    BookViewSlot* slots_ = nullptr;
+    size_t num_instruments_ = 0;
+};
+
+// A reader's side: maps the segment read-only and takes consistent copies.
+class BookViewReader {
+public:
+    BookViewReader() = default;
+    ~BookViewReader() { close(); }
+
+    BookViewReader(const BookViewReader&) = delete;
+    BookViewReader& operator=(const BookViewReader&) = delete;
+
+    // Maps the segment the engine created under 'name'. Returns false (after
+    // printing why) if it does not exist or has a different layout.
+    bool open(const std::string& name);
+    void close();
+
+    size_t numInstruments() const { return num_instruments_; }
+    // The writer's TSC rate: ns since a view was published is
+    // (TscClock::now() - view.publish_tsc) * nsPerTick().
+    double nsPerTick() const { return ns_per_tick_; }
+
+    // How many times 'instrument' has been published. One load, for polling
+    // for changes before paying for a copy.
+    inline uint64_t version(InstrumentID instrument) const {
+        return slots_[instrument].sequence.load(std::memory_order_acquire) / 2;
+    }
+
+    // Copies the latest view of 'instrument' into 'view' and returns its
+    // version, or 0 (leaving 'view' alone) if it has never been published.
+    // Spins while the writer is mid-update, which lasts tens of nanoseconds.
+    uint64_t read(InstrumentID instrument, BookView& view) const;
+
+private:
+    void* memory_ = nullptr;
+    size_t bytes_ = 0;
+    const BookViewSlot* slots_ = nullptr;
+    size_t num_instruments_ = 0;
+    double ns_per_tick_ = 1.0;
+};
@@ -0,0 +1,14 @@
+#pragma once // Standard header guard.
+
+// A hint, inside a spin-wait loop, that the thread is only waiting. On x86 the
+// PAUSE instruction keeps the loop from flooding the pipeline (and the sibling
+// hyperthread) with speculative loads and avoids the memory-order flush on
+// exit; on ARM, YIELD plays the same part. Elsewhere it is a no-op.
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // For _mm_pause
+inline void cpuRelax() { _mm_pause(); }
+#elif defined(__aarch64__) || defined(__arm__)
+inline void cpuRelax() { asm volatile("yield" ::: "memory"); }
+#else
+inline void cpuRelax() {}
+#endif
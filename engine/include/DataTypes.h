@@ -8,23 +8,27 @@
 using OrderID = uint64_t;
 using Price = int64_t;
 using Timestamp = int64_t;
+using InstrumentID = uint16_t;
 
 // --- Exchange Message Format ---
 // This is the custom binary format we defined. It's what travels over the network.
 // It is 32 bytes, which is half of a typical 64-byte cache line, making it memory-friendly.
 // We use '#pragma pack(push, 1)' to ensure the compiler doesn't add extra padding,
 // so we can control the exact memory layout. This is critical for network serialization.
+// A modify carries the order's new price and its new total size (not the change).
+// An order cannot change side, so a modify's side is ignored.
 #pragma pack(push, 1)
 struct PanoptesMessage {
     Timestamp timestamp;      // 8 bytes (nanoseconds since midnight)
     OrderID order_id;         // 8 bytes
     Price price;              // 8 bytes (fixed-point: price * 10000)
     int32_t size;             // 4 bytes
-    char event_type;          // 1 byte ('A'dd, 'X'cancel, 'E'xecute)
+    char event_type;          // 1 byte ('A'dd, 'X'cancel, 'E'xecute, 'M'odify)
     char side;                // 1 byte ('B'id, 'A'sk)
-    char padding[2];          // 2 bytes to make the struct 32 bytes
+    InstrumentID instrument_id; // 2 bytes (which book the message is for)
 };
 #pragma pack(pop)
+static_assert(sizeof(PanoptesMessage) == 32, "PanoptesMessage must stay 32 bytes on the wire");
 
 
 // --- Internal Order Book Data Structures ---
@@ -50,14 +54,66 @@ struct PriceLevel {
     int32_t total_volume = 0; // The sum of sizes of all orders at this level.
 };
 
+// A single fill produced by the book: 'size' shares of a resting order traded
+// at the resting order's price. For an aggressive add, aggressor_id is the
+// incoming order; for an 'E'xecute message it is 0, since the feed does not
+// say who took the liquidity. 32 bytes, so two records share a cache line.
+struct Trade {
+    OrderID aggressor_id;
+    OrderID resting_id;
+    Price price;
+    int32_t size;
+    char aggressor_side;      // 'B'id or 'A'sk ('B' means the buyer took the liquidity).
+    char padding[3];
+};
+
+// The new state of one price level after a book update: what an L2 market data
+// consumer needs to maintain its own depth view. A volume of 0 means the level
+// is now empty. 16 bytes, packed, so it is also the market data wire entry
+// (see MarketData.h).
+#pragma pack(push, 1)
+struct LevelUpdate {
+    Price price;
+    int32_t total_volume;
+    char side;
+    char padding;
+    InstrumentID instrument_id; // Filled in by whoever owns the book.
+};
+#pragma pack(pop)
+static_assert(sizeof(LevelUpdate) == 16, "LevelUpdate must stay 16 bytes on the wire");
+
+// The price and aggregate volume at the top of one side of the book.
+// An empty side is reported as price -1 with zero volume.
+struct BestPrice {
+    Price price = -1;
+    int32_t volume = 0;
+};
+
 
 // --- Configuration Constants ---
 
-// The maximum number of price levels the order book can hold.
-// This must be large enough to accommodate all possible price ticks for the instrument.
-constexpr size_t MAX_PRICE_LEVELS = 1000000;
+// The number of distinct instruments the protocol can address.
+constexpr size_t MAX_INSTRUMENTS = 65536;
+
+// The number of price levels each side of a book keeps in its dense window
+// around the touch. Levels further away go into an overflow map (see PriceLadder).
+// 2048 levels of 24 bytes is 48KB per side.
+constexpr size_t DEFAULT_LADDER_WINDOW_LEVELS = 2048;
+
+// The number of Order slots the order pool allocates up front (and, by default,
+// adds each time it has to grow). Slots released by cancels and executions are
+// reused, so this only needs to cover the orders resting at any one time.
+constexpr size_t DEFAULT_ORDER_POOL_CAPACITY = 1 << 20;
+
+// The fill ratio at which the order index doubles its table. Lower values mean
+// shorter probe runs at the cost of more memory.
+constexpr double DEFAULT_INDEX_LOAD_FACTOR = 0.5;
+
+// The number of fills the book can buffer between two drains by the caller.
+// A single aggressive order that sweeps more resting orders than this loses the
+// excess trade records (they are counted), but is still matched correctly.
+constexpr size_t DEFAULT_TRADE_BUFFER_CAPACITY = 4096;
 
-// The base price used for normalizing prices to array indices.
-// This should be set to a value lower than any expected price for the instrument.
-// For a stock trading at ~$150, a base of $100 (1000000 in fixed-point) is safe.
-constexpr Price PRICE_NORMALIZATION_BASE = 1000000;
+// The number of level updates the book can buffer between two drains, when
+// level updates are enabled. A sweep changes one level per filled order.
+constexpr size_t DEFAULT_LEVEL_UPDATE_BUFFER_CAPACITY = 4096;
@@ -0,0 +1,120 @@
+#pragma once // Standard header guard.
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Memory for a book's large arrays (the order storage and the order index),
+// mapped straight from the kernel with a choice of page size.
+//
+// A book sized for a million orders spans about 80MB of order records and
+// index slots. Touched at random, as cancels and executes touch it, that is
+// some twenty thousand 4KB pages, far more than the dTLB holds, so most
+// lookups also walk the page tables. On 2MB pages it is forty pages; on 1GB
+// pages, one.
+//
+// Anonymous mappings come zero-filled, a page at a time on first touch, and
+// the structures that live here treat zeroed memory as empty. So by default
+// nothing is written at startup (lazy zeroing) and the first message to touch
+// a page pays for its fault. 'prefault' moves every fault to allocation time
+// instead, and 'lock' keeps the pages resident.
+
+enum class HugePageMode {
+    Off,         // 4KB pages.
+    Transparent, // madvise(MADV_HUGEPAGE): the kernel backs what it can with 2MB pages.
+    // MAP_HUGETLB pages of LargePageConfig::page_size from the reserved pool
+    // (vm.nr_hugepages for 2MB, hugepages-1048576kB for 1GB). An allocation
+    // the pool cannot cover falls back to Transparent, with a warning.
+    Explicit
+};
+
+struct LargePageConfig {
+    HugePageMode mode = HugePageMode::Off;
+    // Explicit only: the huge page size, 2MB or 1GB.
+    size_t page_size = size_t(2) << 20;
+    // Fault every page in (zero-filled) when it is mapped, so none faults on the hot path.
+    bool prefault = false;
+    // mlock the pages (which also faults them in). Needs CAP_IPC_LOCK or a
+    // large enough RLIMIT_MEMLOCK; without it the pages stay unlocked, with a warning.
+    bool lock = false;
+    // If >= 0, bind the pages to this NUMA node. Otherwise each page lands on
+    // the node of the thread that first touches it, which for a book is its
+    // worker: books are created on the worker that owns them.
+    int numa_node = -1;
+};
+
+// One anonymous mapping, unmapped on destruction. Move-only.
+//
+// Allocations smaller than a huge page use normal pages whatever the mode,
+// so a process with many small books does not give each one a whole huge page.
+class LargeBuffer {
+public:
+    LargeBuffer() = default;
+    // Maps at least 'bytes' of zeroed memory. Throws std::bad_alloc if even a
+    // mapping of normal pages fails.
+    LargeBuffer(size_t bytes, const LargePageConfig& config);
+    ~LargeBuffer();
+
+    LargeBuffer(LargeBuffer&& other) noexcept;
+    LargeBuffer& operator=(LargeBuffer&& other) noexcept;
+    LargeBuffer(const LargeBuffer&) = delete;
+    LargeBuffer& operator=(const LargeBuffer&) = delete;
+
+    void* data() const { return data_; }
+    // The bytes mapped: the request rounded up to whole pages.
+    size_t size() const { return size_; }
+    // Whether the mapping came from the explicit huge page pool.
+    bool explicitHugePages() const { return explicit_; }
+
+private:
+    void release();
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    bool explicit_ = false;
+};
+
+// A growable array of trivially copyable records in a LargeBuffer, for the
+// compact order storages. reserve() maps address space (and only faults it in
+// with 'prefault'), emplace_back() hands out the next zeroed record, and
+// growing copies everything into a bigger mapping.
+template <typename T>
+class LargeArray {
+    static_assert(std::is_trivially_copyable<T>::value, "records are moved with memcpy");
+
+public:
+    explicit LargeArray(const LargePageConfig& config = LargePageConfig{}) : config_(config) {}
+
+    void reserve(size_t count) {
+        if (count <= capacity_) {
+            return;
+        }
+        LargeBuffer bigger(count * sizeof(T), config_);
+        if (size_ > 0) {
+            std::memcpy(bigger.data(), buffer_.data(), size_ * sizeof(T));
+        }
+        buffer_ = std::move(bigger);
+        data_ = static_cast<T*>(buffer_.data());
+        capacity_ = buffer_.size() / sizeof(T);
+    }
+
+    inline T& emplace_back() {
+        if (size_ == capacity_) {
+            reserve(size_ == 0 ? 16 : size_ * 2);
+        }
+        return *new (data_ + size_++) T();
+    }
+
+    inline T& operator[](size_t i) { return data_[i]; }
+    inline const T& operator[](size_t i) const { return data_[i]; }
+    size_t size() const { return size_; }
+
+private:
+    LargePageConfig config_;
+    LargeBuffer buffer_;
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
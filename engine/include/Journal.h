@@ -0,0 +1,166 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "SpscRing.h" // For CACHE_LINE_SIZE
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+struct JournalConfig {
+    std::string path;
+    // Messages the file is preallocated for. Space is reused once a snapshot
+    // covers it, so this only has to hold the messages between two durable
+    // snapshots; appends beyond that are dropped, counted and reported.
+    // An existing file keeps the capacity it was created with.
+    size_t capacity_messages = size_t(1) << 24;
+    // How often the commit thread flushes newly appended records to disk. Every
+    // record appended within one interval shares a single msync.
+    uint32_t commit_interval_us = 1000;
+    // How far ahead of the writer the commit thread faults in journal pages.
+    size_t prefault_bytes = 4 << 20;
+};
+
+// One journal entry: a message and its position in the journal. The file is a
+// ring of 'capacity' records: the record with sequence s (counting from 1 for
+// the life of the journal) is at index (s - 1) % capacity. The sequence is
+// written after the message, so a record whose sequence is not the one its
+// position expects was never completely written, or is left from an earlier
+// lap, and marks the end of the journal.
+#pragma pack(push, 1)
+struct JournalRecord {
+    uint64_t sequence;
+    PanoptesMessage message;
+};
+#pragma pack(pop)
+static_assert(sizeof(JournalRecord) == 40, "JournalRecord layout changed");
+
+// File header, padded to a cache line. The records follow it.
+struct JournalHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t padding;
+    uint64_t capacity;  // Records the file has room for.
+    char reserved[40];
+};
+static_assert(sizeof(JournalHeader) == 64, "JournalHeader layout changed");
+
+// An append-only log of every message handed to the books, kept so a restarted
+// engine can rebuild them (see Recovery.h).
+//
+// The file is preallocated to its full size and memory-mapped, so an append is
+// a 40-byte copy into the page cache with no syscall. Making the data durable
+// is left to a commit thread, which wakes every commit_interval_us and msyncs
+// whatever was appended since its last pass: a group commit, with the cost of
+// the flush taken off the thread that appends. The commit thread also touches
+// the pages just ahead of the writer, so the appending thread does not take a
+// page fault every 4 KB.
+//
+// Records up to the latest durable snapshot are no longer needed (recovery
+// starts from the snapshot), so release() hands their space back and the
+// journal wraps round over it. Only the messages since that snapshot have to
+// fit; if they do not, appends fail loudly rather than overwrite a record a
+// restart would need.
+//
+// Reopening an existing journal continues after its last complete record.
+class Journal {
+public:
+    static constexpr uint32_t MAGIC = 0x4C4E524A; // "JRNL" read as little-endian bytes.
+    // Version 2 files wrap round. A version 1 file is a version 2 file that
+    // has not wrapped yet, so it is read and appended to as one.
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t OLDEST_READABLE_VERSION = 1;
+
+    // The index of the record with this sequence in a journal of 'capacity'.
+    static size_t recordIndex(uint64_t sequence, size_t capacity) {
+        return static_cast<size_t>((sequence - 1) % capacity);
+    }
+
+    explicit Journal(const JournalConfig& config);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Opens or creates the file and maps it, continuing after the last
+    // complete record that follows 'snapshot_sequence' (the sequence the
+    // latest snapshot covers; records up to it may already be overwritten).
+    // Returns false (after printing why) on failure.
+    bool open(uint64_t snapshot_sequence = 0);
+
+    // Starts and stops the commit thread. stop() commits everything appended.
+    void start();
+    void stop();
+
+    // Single writer only: appends a message. Returns false, and counts and
+    // reports an overflow, if the journal is full.
+    inline bool append(const PanoptesMessage& msg) {
+        if (next_sequence_ - released_ == capacity_) {
+            overflow();
+            return false;
+        }
+        JournalRecord* record = records_ + next_index_;
+        record->message = msg;
+        // The sequence goes in last: it is what marks the record as complete.
+        std::atomic_signal_fence(std::memory_order_release);
+        record->sequence = ++next_sequence_;
+        if (++next_index_ == capacity_) {
+            next_index_ = 0;
+        }
+        appended_.store(next_sequence_, std::memory_order_release);
+        return true;
+    }
+
+    // Single writer only: a snapshot covering every record up to 'sequence'
+    // is on disk, so their space may be reused.
+    void release(uint64_t sequence) {
+        released_ = std::max(released_, std::min(sequence, next_sequence_));
+    }
+
+    // The sequence of the last appended record (0 if there is none).
+    uint64_t lastSequence() const { return next_sequence_; }
+    // The sequence up to which space has been released.
+    uint64_t releasedSequence() const { return released_; }
+    // Records that a restart would still need.
+    size_t inUse() const { return static_cast<size_t>(next_sequence_ - released_); }
+    // The sequence of the last record known to be on disk.
+    uint64_t durableSequence() const { return durable_.load(std::memory_order_acquire); }
+    uint64_t overflowCount() const { return overflow_count_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    // Counts an append that did not fit, and says so on stderr: the first
+    // time, then at every power of two, so a stuck journal cannot go unseen.
+    void overflow();
+
+    void run();
+    void commit(uint64_t appended);
+    // msyncs records [first, end) of the file, by index.
+    bool flush(size_t first, size_t end);
+    void prefault(uint64_t appended);
+
+    JournalConfig config_;
+    int fd_ = -1;
+    char* map_ = nullptr;
+    size_t map_size_ = 0;
+    JournalRecord* records_ = nullptr;
+    size_t capacity_ = 0;
+
+    // Writer-owned.
+    uint64_t next_sequence_ = 0; // The last appended.
+    size_t next_index_ = 0;      // Where the next record goes.
+    uint64_t released_ = 0;
+    uint64_t overflow_count_ = 0;
+
+    // Shared with the commit thread.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> appended_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> durable_{0};
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    // Commit-thread-owned: byte offset up to which pages have been faulted in.
+    size_t prefaulted_ = 0;
+};
@@ -1,48 +1,257 @@
 #pragma once // Standard header guard.
 
 #include "DataTypes.h" // Include our core data structure definitions.
+#include "BookTraits.h"
+#include "OrderBook.h"
+#include "PriceLadder.h"
+#include "OrderStorage.h"
+#include "OrderIndex.h"
+#include "TradeBuffer.h"
 #include <vector>
-#include <array>
-#include <unordered_map>
 #include <iostream>
 
-class L1CacheBook {
+// The order book, parameterised on what it knows about its instruments at
+// compile time (see BookTraits.h): how its orders are stored, which of its tick
+// size, base price, window size and capacity are constants, and whether it
+// matches. The matching logic is the same for every variant.
+//
+// Bids and asks are different ladder types (SidedPriceLadder), and the code
+// that updates them is templated on the side, so the side is looked at once
+// per message, to pick the specialisation, and never again.
+//
+// The member functions are defined in L1CacheBook.cpp and instantiated there
+// for each preset; the aliases at the bottom of this file name the common ones,
+// and makeOrderBook() (OrderBook.h) picks one at run time.
+template <typename Traits>
+class BasicL1CacheBook final : public OrderBook {
 public:
-    // Constructor: Initializes the order book.
-    L1CacheBook();
+    using Storage = typename Traits::Storage;
+    using Handle = typename Storage::Handle;
+    using Level = typename Storage::Level;
+    using BidLadder = SidedPriceLadder<'B', Level, Traits::WINDOW_LEVELS>;
+    using AskLadder = SidedPriceLadder<'A', Level, Traits::WINDOW_LEVELS>;
+    using Tick = typename BidLadder::Tick;
+
+    // Constructor: Initializes the order book. The pool config sets how many
+    // resting orders the book can hold and what happens when it runs out. The
+    // order index is sized for the same number of orders at the given load factor.
+    // The ladder config sets the instrument's tick size and base price.
+    // Settings the traits fix at compile time override the configs.
+    explicit BasicL1CacheBook(const OrderPoolConfig& pool_config = OrderPoolConfig{},
+                              double index_load_factor = DEFAULT_INDEX_LOAD_FACTOR,
+                              const PriceLadderConfig& ladder_config = PriceLadderConfig{});
 
     // Public methods to modify the order book state.
     // These are the primary entry points for the event loop.
+
+    // Adds an order. If it crosses the opposite side it is matched first, in
+    // price-time priority, and only the unfilled remainder rests in the book.
+    // (Unless the traits turn matching off: then it always rests.)
     void addOrder(const PanoptesMessage& msg);
     void cancelOrder(const PanoptesMessage& msg);
-    // Execute is not fully implemented in Phase 1, but the stub is here.
+    // Reduces a resting order by msg.size shares (removing it once fully filled).
     void executeOrder(const PanoptesMessage& msg);
+    // Amends a resting order to msg.price and msg.size; its ID and side stay.
+    // Cutting the size at the same price happens in place and keeps the
+    // order's place in the queue. A new price, or more size, sends it to the
+    // back of its (new) level: the same slot is relinked, with no trip through
+    // the order index. A new price that crosses the other side matches first,
+    // as an add would.
+    void modifyOrder(const PanoptesMessage& msg);
+
+    void apply(const PanoptesMessage& msg) override {
+        switch (msg.event_type) {
+            case 'A': addOrder(msg); break;
+            case 'X': cancelOrder(msg); break;
+            case 'E': executeOrder(msg); break;
+            case 'M': modifyOrder(msg); break;
+        }
+    }
+
+    // Calls f(order_id, price, size, side) for every resting order: bids then
+    // asks, each level from the lowest price up, and the orders within a level
+    // in time priority. Adding the orders back in this sequence to an empty book
+    // rebuilds the same queues, which is what snapshots rely on.
+    template <typename F>
+    void forEachOrder(F&& f) const {
+        forEachOrderOn(bids_, f);
+        forEachOrderOn(asks_, f);
+    }
+
+    void visitOrders(const OrderVisitor& visit) const override { forEachOrder(visit); }
+
+    // Returns the best bid/ask price and the total volume resting there.
+    // These are O(1): the best levels are maintained incrementally on every update.
+    BestPrice getBestBid() const override;
+    BestPrice getBestAsk() const override;
+    size_t depth(char side, BestPrice* levels, size_t max_levels) const override;
+
+    // The number of adds dropped because the order pool was full (Reject policy only).
+    size_t rejectedOrderCount() const override { return orders_.rejectedCount(); }
+
+    // The number of adds and modifies dropped because their price was not on the tick grid.
+    size_t offTickOrderCount() const override { return off_tick_orders_; }
+
+    // The number of orders resting in the book.
+    size_t restingOrderCount() const override { return orders_.inUse(); }
+
+    const BidLadder& bidLadder() const { return bids_; }
+    const AskLadder& askLadder() const { return asks_; }
 
     // A simple method to print the top of the book for debugging.
     void printTopOfBook() const;
 
 private:
-    // Converts a fixed-point price to an array index.
-    inline size_t priceToIndex(Price price) const {
-        return static_cast<size_t>(price - PRICE_NORMALIZATION_BASE);
+    static constexpr bool FIXED_TICK = Traits::TICK_SIZE != RUNTIME_TICK;
+
+    inline Price tickSize() const {
+        if constexpr (FIXED_TICK) {
+            return Traits::TICK_SIZE;
+        } else {
+            return tick_size_;
+        }
+    }
+
+    inline Price basePrice() const {
+        if constexpr (FIXED_TICK) {
+            return Traits::BASE_PRICE;
+        } else {
+            return base_price_;
+        }
+    }
+
+    // Converts a fixed-point price to a ladder tick. Most instruments trade in
+    // single units, so skip the division for them.
+    inline Tick priceToTick(Price price) const {
+        const Price offset = price - basePrice();
+        return tickSize() == 1 ? offset : offset / tickSize();
+    }
+
+    // The inverse of priceToTick.
+    inline Price tickToPrice(Tick tick) const {
+        return tick * tickSize() + basePrice();
+    }
+
+    template <char Side>
+    inline auto& ladder() {
+        if constexpr (Side == 'B') {
+            return bids_;
+        } else {
+            return asks_;
+        }
     }
 
+    template <char Side>
+    inline Tick& bestTick() {
+        if constexpr (Side == 'B') {
+            return best_bid_tick_;
+        } else {
+            return best_ask_tick_;
+        }
+    }
+
+    // Reports a level's new total volume, if level updates are on.
+    inline void publishLevel(char side, Tick tick, int32_t total_volume) {
+        if (publish_levels_) {
+            level_updates_.push({tickToPrice(tick), total_volume, side, 0, 0});
+        }
+    }
+
+    template <typename Ladder, typename F>
+    void forEachOrderOn(const Ladder& ladder, F& f) const {
+        ladder.forEachOccupied([&](Tick tick, const Level& level) {
+            const Price price = tickToPrice(tick);
+            for (Handle order = level.head; order != Storage::NIL; order = orders_.next(order)) {
+                f(orders_.id(order), price, orders_.size(order), Ladder::SIDE);
+            }
+        });
+    }
+
+    template <typename Ladder>
+    size_t depthOn(const Ladder& ladder, Tick best, BestPrice* levels, size_t max_levels) const {
+        size_t count = 0;
+        if (max_levels > 0) {
+            ladder.walkBack(best, [&](Tick tick, const Level& level) {
+                levels[count++] = {tickToPrice(tick), level.total_volume};
+                return count < max_levels;
+            });
+        }
+        return count;
+    }
+
+    // The pool settings, with a compile-time capacity applied.
+    static OrderPoolConfig poolConfig(const OrderPoolConfig& config) {
+        if constexpr (Traits::MAX_ORDERS != RUNTIME_SIZE) {
+            return {Traits::MAX_ORDERS, Traits::MAX_ORDERS, PoolOverflowPolicy::Reject, config.pages};
+        } else {
+            return config;
+        }
+    }
+
+    // The side-specific halves of the public entry points.
+    template <char Side>
+    void addOn(const PanoptesMessage& msg);
+    template <char Side>
+    void executeOn(Handle order, const PanoptesMessage& msg);
+    template <char Side>
+    void modifyOn(Handle order, const PanoptesMessage& msg);
+
+    // Matches an incoming order on 'Side' against the opposite side while it
+    // crosses. Returns the quantity left unfilled.
+    template <char Side>
+    int32_t match(const PanoptesMessage& msg);
+
+    // Appends an order to the tail of its price level and updates the best price.
+    // The caller passes the tick it already has, so that the compact layouts do
+    // not have to read the price back from the cold records.
+    template <char Side>
+    void linkOrder(Handle order, Tick tick);
+
+    // Removes an order from its price level and updates the best price if the
+    // level empties. The order keeps its slot, so it can be linked again.
+    template <char Side>
+    void detachOrder(Handle order, Tick tick);
+
+    // Detaches an order and returns the slot to the storage. The caller removes
+    // it from the map.
+    template <char Side>
+    void unlinkOrder(Handle order, Tick tick);
+
     // --- Core Data Structures ---
 
-    // Two large, fixed-size arrays to hold all possible price levels for bids and asks.
-    // This is the core of the O(1) price level lookup. Accessing an element in an
-    // array is a single memory operation.
-    std::array<PriceLevel, MAX_PRICE_LEVELS> bids_;
-    std::array<PriceLevel, MAX_PRICE_LEVELS> asks_;
-
-    // A hash map to provide O(1) lookup of any order by its ID.
-    // This is essential for fast cancel/modify operations. The map stores a
-    // pointer to the order object, not the object itself.
-    std::unordered_map<OrderID, Order*> order_map_;
-
-    // A simple, contiguous memory pool for all Order objects.
-    // We pre-allocate a large number of orders to avoid memory allocation
-    // during runtime. This is a critical performance optimization.
-    std::vector<Order> order_pool_;
-    size_t next_order_pool_index_; // Tracks the next available slot in the pool.
+    // The price levels of each side: a dense window that follows the touch, with
+    // an overflow map for levels far away from it.
+    BidLadder bids_;
+    AskLadder asks_;
+
+    // Ticks of the current best bid and ask (the ladder's EMPTY if that side is empty).
+    Tick best_bid_tick_;
+    Tick best_ask_tick_;
+
+    // Only read when the traits leave the tick to the run-time config.
+    Price tick_size_;
+    Price base_price_;
+    size_t off_tick_orders_ = 0;
+
+    // A flat hash index to provide O(1) lookup of any order by its ID.
+    // This is essential for fast cancel/modify operations. The index stores the
+    // order's storage handle, not the object itself, and never allocates once
+    // it has been sized.
+    BasicOrderIndex<Handle, Storage::NIL> order_map_;
+
+    // Preallocated storage for all orders.
+    // Slots are reserved up front to avoid memory allocation during runtime, and
+    // cancelled or executed orders go back on a free list to be reused.
+    Storage orders_;
 };
+
+// The original layout: 48-byte Order records linked by pointers.
+using L1CacheBook = BasicL1CacheBook<RuntimeBookTraits<PointerOrderStorage>>;
+// 32-byte records linked by 32-bit slot numbers.
+using CompactL1CacheBook = BasicL1CacheBook<RuntimeBookTraits<CompactOrderStorage>>;
+// 12-byte hot records (links and size) with the ID, price and side kept apart.
+using HotColdL1CacheBook = BasicL1CacheBook<RuntimeBookTraits<HotColdOrderStorage>>;
+// The original layout for unit-tick instruments (see UnitTickBookTraits).
+using UnitTickL1CacheBook = BasicL1CacheBook<UnitTickBookTraits<PointerOrderStorage>>;
+// Every setting a compile-time constant (see FixedBookTraits).
+using FixedL1CacheBook = BasicL1CacheBook<FixedBookTraits>;
@@ -0,0 +1,82 @@
+#pragma once // Standard header guard.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// A fixed-size, log-linear latency histogram in the style of HdrHistogram.
+//
+// Values (nanoseconds) below 2^SUB_BUCKET_BITS get one bucket each. Above that,
+// every power-of-two range is split into 2^(SUB_BUCKET_BITS - 1) equal buckets,
+// so each bucket is at most 1/64 (about 1.6%) wide relative to its value,
+// whatever the magnitude. All buckets live in one array inside the object: record() is a
+// count-leading-zeros, a shift and an increment, with no allocation and no
+// branches on the value's size beyond the small/large split.
+//
+// Values at or above 2^MAX_VALUE_BITS ns (about 18 minutes) go in the last bucket.
+//
+// Counters are relaxed atomics written by a single thread. The increments
+// compile to a plain load/add/store (no locked instruction), but another thread
+// may read a live histogram, for example to dump a report on a signal.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 7;
+    static constexpr unsigned MAX_VALUE_BITS = 40;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+    static constexpr uint64_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+    static constexpr size_t NUM_BUCKETS = SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * HALF_SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    // Records one value. Negative values (e.g. from clock skew) are counted as 0.
+    inline void record(int64_t value_ns) {
+        const uint64_t value = value_ns < 0 ? 0 : static_cast<uint64_t>(value_ns);
+        bump(counts_[bucketFor(value)], 1);
+        bump(total_count_, 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count() const { return total_count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // The value at the given percentile (0-100), reported as the upper edge of
+    // the bucket it falls in, so it never understates a latency. 0 if empty.
+    uint64_t percentile(double pct) const;
+
+    // Adds another histogram's counts into this one.
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    // Bucket mapping, exposed for testing.
+    static inline size_t bucketFor(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        if (msb >= MAX_VALUE_BITS) {
+            return NUM_BUCKETS - 1;
+        }
+        // Keep the top SUB_BUCKET_BITS bits of the value; the leading one is implied.
+        const unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+        const uint64_t mantissa = value >> shift; // In [HALF_SUB_BUCKETS, SUB_BUCKETS).
+        return static_cast<size_t>(SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (mantissa - HALF_SUB_BUCKETS));
+    }
+
+    // The largest value that maps to a bucket.
+    static uint64_t bucketUpperBound(size_t bucket);
+
+private:
+    static inline void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> counts_;
+    std::atomic<uint64_t> total_count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
@@ -0,0 +1,57 @@
+#pragma once // Standard header guard.
+
+#include "LatencyHistogram.h"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// The stages a message's latency is split into.
+enum class LatencyStage : size_t {
+    WireToRecv, // Sender's timestamp to the moment the engine has the datagram.
+    Parse,      // Decoding the datagram into a PanoptesMessage.
+    Handoff,    // Queued for a book worker until the worker picks it up.
+    BookUpdate, // Applying the message to its book (on the worker thread).
+    Count
+};
+
+// Latency histograms broken down by stage and by event type.
+class LatencyReport {
+public:
+    // Event types get their own row; anything else is reported as "other".
+    static constexpr char EVENT_TYPES[] = {'A', 'X', 'E', 'M'};
+    static constexpr size_t NUM_EVENT_TYPES = sizeof(EVENT_TYPES) + 1;
+
+    static inline size_t eventTypeIndex(char event_type) {
+        for (size_t i = 0; i < sizeof(EVENT_TYPES); ++i) {
+            if (EVENT_TYPES[i] == event_type) {
+                return i;
+            }
+        }
+        return NUM_EVENT_TYPES - 1;
+    }
+
+    LatencyReport();
+
+    inline LatencyHistogram& at(LatencyStage stage, char event_type) {
+        return (*histograms_)[static_cast<size_t>(stage)][eventTypeIndex(event_type)];
+    }
+    const LatencyHistogram& at(LatencyStage stage, size_t event_type_index) const {
+        return (*histograms_)[static_cast<size_t>(stage)][event_type_index];
+    }
+
+    void merge(const LatencyReport& other);
+    void reset();
+
+    // Human-readable table: one row per stage and event type with p50..p99.99 and max.
+    void printText(std::ostream& out) const;
+
+    // The same numbers as JSON, for scripts. Returns false if the file can't be written.
+    bool writeJson(const std::string& path) const;
+
+private:
+    using StageHistograms = std::array<LatencyHistogram, NUM_EVENT_TYPES>;
+    // About 18KB per histogram, so keep them off the stack.
+    std::unique_ptr<std::array<StageHistograms, static_cast<size_t>(LatencyStage::Count)>> histograms_;
+};
@@ -0,0 +1,68 @@
+#pragma once // Standard header guard.
+
+#include <cstddef>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A read-only memory mapping of a whole file.
+//
+// Mapping a capture instead of reading it into a vector means a file of any
+// size costs no up-front copy and no resident memory beyond the pages actually
+// being read, and the kernel's read-ahead streams it in as it is scanned.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps 'path'. Returns false (after printing why) on failure.
+    bool open(const char* path) {
+        close();
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            perror("open failed");
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            perror("fstat failed");
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                perror("mmap failed");
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<const char*>(mapped);
+            // We read captures front to back: ask for aggressive read-ahead.
+            madvise(mapped, size_, MADV_SEQUENTIAL);
+        }
+        ::close(fd); // The mapping keeps the file alive.
+        return true;
+    }
+
+    void close() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,46 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include <cstdint>
+
+// Wire format of the L2 market data feed sent by MarketDataPublisher.
+//
+// Every datagram is an MdHeader followed by 'count' LevelUpdate entries
+// (16 bytes each, see DataTypes.h). Each entry gives the new total volume at
+// one price level; a volume of 0 means the level is gone.
+//
+// Incremental datagrams carry level changes for any mix of instruments.
+// Snapshot datagrams carry the full depth of a single instrument, best prices
+// first; a deep book may need several, the first flagged MD_FLAG_SNAPSHOT_BEGIN
+// (the receiver clears its copy of the instrument) and the last
+// MD_FLAG_SNAPSHOT_END.
+//
+// 'sequence' counts datagrams of both kinds, so a receiver that sees a gap knows
+// it has lost something and should wait for the next snapshot. Everything is in
+// host byte order, like PanoptesMessage.
+constexpr uint32_t MD_MAGIC = 0x314D4450; // "PDM1" read as little-endian bytes.
+constexpr uint8_t MD_VERSION = 1;
+
+enum class MdMessageType : uint8_t {
+    Incremental = 1,
+    Snapshot = 2,
+};
+
+constexpr uint8_t MD_FLAG_SNAPSHOT_BEGIN = 0x01;
+constexpr uint8_t MD_FLAG_SNAPSHOT_END = 0x02;
+
+#pragma pack(push, 1)
+struct MdHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;                // MdMessageType
+    uint8_t flags;               // MD_FLAG_* (snapshots only)
+    uint8_t padding;
+    uint16_t count;              // LevelUpdate entries after the header.
+    InstrumentID instrument_id;  // Snapshots only; 0 for incrementals.
+    uint32_t padding2;
+    uint64_t sequence;           // Per-publisher datagram counter, starting at 1.
+    int64_t send_timestamp;      // Wall clock at send, in nanoseconds since the epoch.
+};
+#pragma pack(pop)
+static_assert(sizeof(MdHeader) == 32, "MdHeader must stay 32 bytes on the wire");
@@ -0,0 +1,181 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "MarketData.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct MarketDataPublisherConfig {
+    // Where datagrams are sent. Any IPv4 address, unicast or multicast.
+    std::string address = "127.0.0.1";
+    int port = 12346;
+    // Largest datagram sent, header included. The default fits a standard
+    // Ethernet MTU without fragmentation.
+    size_t max_datagram_bytes = 1400;
+    // If non-zero, changes to the same level within this window are merged and
+    // only the latest volume is sent. 0 sends every change.
+    uint32_t conflation_window_us = 0;
+    // How often the full depth of every instrument is sent. 0 disables snapshots.
+    uint32_t snapshot_interval_ms = 1000;
+    // Number of threads that call publish() (one ring each).
+    size_t num_producers = 1;
+    // Capacity of each producer's ring, in level updates.
+    size_t queue_capacity = 1 << 16;
+};
+
+// Publishes L2 depth over UDP: incremental level updates as the books change,
+// plus periodic full-depth snapshots so late joiners and receivers that lost a
+// datagram can resynchronise. See MarketData.h for the wire format.
+//
+// The book threads never touch the socket. Each hands its LevelUpdates to the
+// publisher through its own single-producer/single-consumer ring, and a
+// dedicated publisher thread drains the rings, packs as many updates as fit into
+// each datagram and sends them. If a ring is full the update is dropped and
+// counted: a slow network must not stall the books.
+//
+// The publisher thread keeps its own copy of every instrument's depth, built
+// from the updates it has seen, so snapshots never need to read the books. A
+// dropped update would leave that copy, and every snapshot built from it, wrong
+// for good, so the book thread that dropped it resends the instrument's whole
+// depth, read from the book, once its ring has room (publishResync()). The
+// publisher replaces its copy with that and sends a snapshot of the instrument
+// straight away, which puts the receivers right as well.
+class MarketDataPublisher {
+public:
+    struct Stats {
+        uint64_t updates_received = 0;  // Level updates taken off the rings, resyncs aside.
+        uint64_t updates_published = 0; // Incremental entries actually sent.
+        uint64_t datagrams = 0;         // Datagrams sent, of both kinds.
+        uint64_t snapshots = 0;         // Instrument snapshots sent.
+        uint64_t resyncs = 0;           // Instruments resent whole after a drop.
+        uint64_t send_errors = 0;       // Datagrams the socket refused.
+    };
+
+    explicit MarketDataPublisher(const MarketDataPublisherConfig& config);
+    ~MarketDataPublisher();
+
+    MarketDataPublisher(const MarketDataPublisher&) = delete;
+    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+    // Creates the socket and resolves the destination. Returns false (after
+    // printing why) on failure.
+    bool open();
+
+    // Starts the publisher thread.
+    void start();
+
+    // Publishes everything already queued, then joins the publisher thread.
+    void stop();
+
+    // Producer 'producer' only: queues a level update. Never blocks; returns
+    // false and counts a drop if the ring is full.
+    inline bool publish(size_t producer, const LevelUpdate& update) {
+        Producer& p = *producers_[producer];
+        if (!p.ring.tryPush(update)) {
+            ++p.dropped;
+            return false;
+        }
+        return true;
+    }
+
+    // Producer 'producer' only: after publish() has dropped an update for
+    // 'instrument', replaces the publisher's copy of its depth with 'count'
+    // levels read from the book, and has a snapshot of it sent. All or
+    // nothing: returns false, having queued nothing, if the ring has no room
+    // for the whole book yet; try again later.
+    bool publishResync(size_t producer, InstrumentID instrument, const LevelUpdate* levels, size_t count);
+
+    // Producer 'producer' only: how many levels a resync could carry now,
+    // or 0 until its ring has drained to half full. Checked before reading a
+    // book, so a book that would not fit is never copied out.
+    size_t resyncRoom(size_t producer) const {
+        const SpscRing<LevelUpdate>& ring = producers_[producer]->ring;
+        const size_t queued = ring.size();
+        return queued <= ring.capacity() / 2 ? ring.capacity() - queued - 1 : 0;
+    }
+    // The most levels a resync from 'producer' can ever carry: an empty ring
+    // less the entry that starts it.
+    size_t maxResyncLevels(size_t producer) const { return producers_[producer]->ring.capacity() - 1; }
+
+    size_t numProducers() const { return producers_.size(); }
+
+    // Updates lost because a producer's ring was full.
+    uint64_t droppedCount() const;
+
+    // Publisher thread counters. Exact once stop() has returned.
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Producer {
+        explicit Producer(size_t capacity) : ring(capacity) {}
+        SpscRing<LevelUpdate> ring;
+        // Written by the producer only.
+        alignas(CACHE_LINE_SIZE) uint64_t dropped = 0;
+        // Publisher thread only: levels of a resync still to come off the ring.
+        alignas(CACHE_LINE_SIZE) size_t resync_remaining = 0;
+        InstrumentID resync_instrument = 0;
+    };
+
+    // On the rings only, never on the wire: the side of the entry that starts
+    // a resync. Its total_volume is the number of levels that follow.
+    static constexpr char RESYNC_SIDE = 'R';
+
+    // The publisher's copy of one instrument's book: price -> total volume.
+    struct Depth {
+        std::map<Price, int32_t, std::greater<Price>> bids;
+        std::map<Price, int32_t> asks;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+    // Moves queued updates off the rings. Returns how many were taken.
+    size_t drain();
+    void apply(const LevelUpdate& update);
+    // Takes one entry of a resync in place of apply().
+    void applyResync(Producer& producer, const LevelUpdate& update);
+    // Sets one level in the publisher's copy of a book.
+    void setLevel(const LevelUpdate& update);
+    void flushPending();
+    void sendSnapshots();
+    // Sends one instrument's snapshot. Returns the levels it held.
+    size_t sendSnapshot(InstrumentID instrument, const Depth& depth);
+    void sendDatagram(MdMessageType type, uint8_t flags, InstrumentID instrument,
+                      const LevelUpdate* entries, size_t count);
+
+    // Conflation key: one entry per (instrument, side, price). Exact for any
+    // non-negative price below 2^47.
+    static inline uint64_t levelKey(const LevelUpdate& u) {
+        return (static_cast<uint64_t>(u.price) << 17) |
+               (static_cast<uint64_t>(u.instrument_id) << 1) | (u.side == 'B' ? 1u : 0u);
+    }
+
+    MarketDataPublisherConfig config_;
+    std::vector<std::unique_ptr<Producer>> producers_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int sock_fd_ = -1;
+
+    // Everything below is owned by the publisher thread.
+    size_t max_entries_;  // LevelUpdates that fit in one datagram.
+    std::vector<char> datagram_;
+    // Updates waiting to be sent, in arrival order. With conflation, a repeat
+    // update for a level overwrites its earlier entry through pending_index_.
+    std::vector<LevelUpdate> pending_;
+    std::unordered_map<uint64_t, size_t> pending_index_;
+    Clock::time_point window_start_;
+    Clock::time_point next_snapshot_;
+    std::unordered_map<InstrumentID, Depth> depth_;
+    std::vector<LevelUpdate> snapshot_levels_;
+    uint64_t sequence_ = 0;
+    Stats stats_;
+};
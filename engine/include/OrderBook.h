@@ -0,0 +1,89 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "OrderPool.h"
+#include "PriceLadder.h"
+#include "TradeBuffer.h"
+#include <functional>
+#include <memory>
+
+// The run-time face of a book.
+//
+// Book variants are separate types (BasicL1CacheBook<Traits>, see
+// L1CacheBook.h), so code that picks the variant per instrument from config
+// holds them through this interface. It costs one indirect call per message
+// (apply()), after which everything runs in the variant's own specialised code.
+// Code that knows its variant uses the concrete type and pays nothing.
+//
+// The output buffers live here, so draining them needs no virtual calls.
+class OrderBook {
+public:
+    virtual ~OrderBook() = default;
+
+    // Applies one message: 'A'dd, 'X' cancel, 'E'xecute or 'M'odify. Anything
+    // else is ignored.
+    virtual void apply(const PanoptesMessage& msg) = 0;
+
+    virtual BestPrice getBestBid() const = 0;
+    virtual BestPrice getBestAsk() const = 0;
+
+    // Copies up to 'max_levels' levels of one side ('B' or 'A') into 'levels',
+    // best first, and returns how many there were. One bitmap search per level.
+    virtual size_t depth(char side, BestPrice* levels, size_t max_levels) const = 0;
+
+    // The number of orders resting in the book.
+    virtual size_t restingOrderCount() const = 0;
+    // The number of adds dropped because the order storage was full.
+    virtual size_t rejectedOrderCount() const = 0;
+    // The number of adds and modifies dropped because their price was not on the tick grid.
+    virtual size_t offTickOrderCount() const = 0;
+
+    // Calls visit(order_id, price, size, side) for every resting order, in the
+    // order described at BasicL1CacheBook::forEachOrder.
+    using OrderVisitor = std::function<void(OrderID, Price, int32_t, char)>;
+    virtual void visitOrders(const OrderVisitor& visit) const = 0;
+
+    // Fills produced since the caller last cleared the buffer. The caller is
+    // expected to drain it (read, then trades().clear()) after each message.
+    TradeBuffer& trades() { return trades_; }
+    const TradeBuffer& trades() const { return trades_; }
+
+    // Turns on level updates: from then on, every change to a level's total
+    // volume appends a LevelUpdate (with instrument_id 0) to levelUpdates().
+    // Off by default, so books nobody publishes pay nothing for the buffer.
+    void enableLevelUpdates() {
+        level_updates_ = LevelUpdateBuffer();
+        publish_levels_ = true;
+    }
+
+    // Level changes since the caller last cleared the buffer. Drained like trades().
+    LevelUpdateBuffer& levelUpdates() { return level_updates_; }
+
+protected:
+    // Preallocated output buffer for fills.
+    TradeBuffer trades_;
+
+    // Output buffer for level changes; empty until enableLevelUpdates().
+    LevelUpdateBuffer level_updates_{0};
+    bool publish_levels_ = false;
+};
+
+// How orders are stored (see OrderStorage.h).
+enum class OrderLayout {
+    Pointer,   // PointerOrderStorage
+    Compact,   // CompactOrderStorage
+    HotCold,   // HotColdOrderStorage
+};
+
+// The run-time choices between the book variants L1CacheBook.cpp compiles.
+struct BookVariant {
+    OrderLayout layout = OrderLayout::Pointer;
+    // See BookTraits::Matching.
+    bool matching = true;
+};
+
+// Creates a book of the given variant. Instruments whose prices are whole
+// ticks from zero (tick size 1, base price 0) get a unit-tick build, which has
+// no price conversion at all; others get one that reads the tick from 'ladder'.
+std::unique_ptr<OrderBook> makeOrderBook(const BookVariant& variant, const OrderPoolConfig& pool_config,
+                                         double index_load_factor, const PriceLadderConfig& ladder);
@@ -0,0 +1,121 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "HugePages.h"
+#include "SpscRing.h" // For CACHE_LINE_SIZE
+#include <cstddef>
+#include <cstdint>
+
+// An open-addressing hash index from OrderID to the order's storage handle:
+// an Order* for the pointer layout, or a 32-bit slot number for the compact
+// layouts (see OrderStorage.h).
+//
+// All entries live in one flat array of 16-byte slots (four per cache line),
+// so a lookup is a hash, one array access and usually a short linear probe
+// through adjacent memory. Nothing is allocated per insert or erase: the table
+// is sized up front from the expected number of live orders and only grows
+// (by doubling) if that estimate is exceeded.
+//
+// Collisions are resolved with Robin Hood linear probing: an entry that is
+// further from its home slot takes the place of one that is closer. This keeps
+// every probe run sorted by home slot, which lets lookups stop early and lets
+// deletion use backward shifting instead of tombstones. When an entry is
+// removed, the entries after it are moved back one slot until one is found
+// that already sits at its home, so the table never fills with dead slots over
+// a long add/cancel session.
+//
+// A slot is empty when its handle is NIL, so every OrderID value is usable.
+// The table is a LargeBuffer (see HugePages.h). Where NIL is all zero bits
+// (the pointer layout), the kernel's zero-filled pages are already empty
+// slots, so a new table is not written at all until orders arrive.
+//
+// The member functions are defined in OrderIndex.cpp and instantiated there for
+// each handle type the order storages use.
+template <typename Handle, Handle NIL>
+class BasicOrderIndex {
+public:
+    // 'expected_orders' is the number of orders expected to be live at once.
+    // 'max_load_factor' is the fill ratio above which the table doubles.
+    // 'pages' chooses the table's page size and prefaulting.
+    explicit BasicOrderIndex(size_t expected_orders = DEFAULT_ORDER_POOL_CAPACITY,
+                             double max_load_factor = DEFAULT_INDEX_LOAD_FACTOR,
+                             const LargePageConfig& pages = LargePageConfig{});
+
+    // Returns the order with this ID, or NIL if it is not in the index.
+    inline Handle find(OrderID id) const {
+        const size_t i = findSlot(id);
+        return i == NOT_FOUND ? NIL : slots_[i].order;
+    }
+
+    // Adds an entry. If the ID is already present, its entry is replaced.
+    void insert(OrderID id, Handle order);
+
+    // Removes an entry and returns its order, or NIL if the ID was not present.
+    // Doing the lookup and removal together means a cancel probes the table once.
+    Handle erase(OrderID id);
+
+    size_t size() const { return size_; }
+    size_t slotCount() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        OrderID id = 0;
+        Handle order = NIL;
+    };
+
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    // Consecutive IDs share a run of this many slots: two cache lines, the pair
+    // the adjacent-line prefetcher fetches together.
+    static constexpr size_t RUN_SLOTS = 2 * CACHE_LINE_SIZE / sizeof(Slot);
+
+    // Exchanges hand out order IDs from a counter, so consecutive IDs should land
+    // in adjacent slots: the slot a new order takes is then usually in a line
+    // the previous order already touched. Each run of RUN_SLOTS consecutive IDs
+    // keeps its order, and the runs themselves are spread over the table by a
+    // multiplicative hash. Consecutive IDs in consecutive slots across the whole
+    // table would not do: once the counter passed the table size, new IDs would
+    // come round onto the slots of orders still resting from earlier, and every
+    // insert and erase would walk the one long probe run the two made together.
+    inline size_t home(OrderID id) const {
+        const uint64_t run = (id / RUN_SLOTS) * 0x9E3779B97F4A7C15ull; // 2^64 / golden ratio.
+        return static_cast<size_t>(run >> run_shift_) * RUN_SLOTS + static_cast<size_t>(id % RUN_SLOTS);
+    }
+
+    // How far the entry in slot 'i' is from its home slot.
+    inline size_t distance(size_t i) const {
+        return (i - home(slots_[i].id)) & mask_;
+    }
+
+    inline size_t findSlot(OrderID id) const {
+        size_t i = home(id);
+        for (size_t dist = 0;; ++dist, i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            if (slot.order == NIL) {
+                return NOT_FOUND;
+            }
+            if (slot.id == id) {
+                return i;
+            }
+            // Runs are sorted by home slot, so once we pass entries that are
+            // closer to home than we would be, the ID cannot be further along.
+            if (distance(i) < dist) {
+                return NOT_FOUND;
+            }
+        }
+    }
+
+    void allocate(size_t slot_count);
+    void grow();
+
+    LargeBuffer memory_;
+    Slot* slots_ = nullptr;  // The table, in memory_.
+    size_t mask_ = 0;        // The slot count - 1 (the count is a power of two).
+    unsigned run_shift_ = 0; // 64 - log2(slot count / RUN_SLOTS).
+    size_t size_ = 0;        // Number of live entries.
+    size_t max_size_ = 0;    // Live entries allowed before the table grows.
+    double max_load_factor_;
+    LargePageConfig pages_;
+};
+
+// The index used by the pointer layout.
+using OrderIndex = BasicOrderIndex<Order*, nullptr>;
@@ -0,0 +1,81 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "HugePages.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// What the pool does when every slot is in use.
+enum class PoolOverflowPolicy {
+    Grow,   // Allocate another chunk of slots. Existing Order pointers stay valid.
+    Reject  // Refuse the allocation and count it. Memory use is strictly bounded.
+};
+
+struct OrderPoolConfig {
+    size_t capacity = DEFAULT_ORDER_POOL_CAPACITY;      // Slots allocated up front.
+    size_t grow_chunk_size = DEFAULT_ORDER_POOL_CAPACITY; // Slots added per growth step.
+    PoolOverflowPolicy policy = PoolOverflowPolicy::Grow;
+    // Page size, prefaulting and placement of the slots, and of the order
+    // index sized from them (see HugePages.h).
+    LargePageConfig pages{};
+};
+
+// A slab allocator for Order objects.
+//
+// Slots live in large chunks that never move, so Order pointers held by the
+// book stay valid for the lifetime of the pool. Released slots are pushed onto
+// an intrusive free list threaded through Order::next, and acquire() pops from
+// it first. Because the list is LIFO, the slot handed out next is the one most
+// recently freed, which is almost certainly still in cache. Slots that have
+// never been used are handed out with a bump pointer, so untouched memory is
+// not paged in until the book actually needs it.
+//
+// Both acquire() and release() are O(1).
+class OrderPool {
+public:
+    explicit OrderPool(const OrderPoolConfig& config = OrderPoolConfig{});
+
+    // Returns a free slot, or nullptr if the pool is full and the policy is Reject.
+    inline Order* acquire() {
+        if (free_list_ != nullptr) {
+            Order* slot = free_list_;
+            free_list_ = slot->next;
+            ++in_use_;
+            return slot;
+        }
+        if (next_unused_ != chunk_end_) {
+            ++in_use_;
+            return new (next_unused_++) Order();
+        }
+        return acquireSlow();
+    }
+
+    // Returns a slot to the pool. The caller must not touch it afterwards.
+    inline void release(Order* order) {
+        order->next = free_list_;
+        free_list_ = order;
+        --in_use_;
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t inUse() const { return in_use_; }
+    size_t rejectedCount() const { return rejected_count_; }
+
+private:
+    // Called when both the free list and the current chunk are exhausted.
+    Order* acquireSlow();
+    void addChunk(size_t num_slots);
+
+    // Raw storage. Slots are constructed when first handed out.
+    std::vector<LargeBuffer> chunks_;
+
+    Order* free_list_ = nullptr;   // Head of the intrusive list of released slots.
+    Order* next_unused_ = nullptr; // Next never-used slot in the newest chunk.
+    Order* chunk_end_ = nullptr;   // One past the last slot of the newest chunk.
+
+    OrderPoolConfig config_;
+    size_t capacity_ = 0;
+    size_t in_use_ = 0;
+    size_t rejected_count_ = 0;
+};
@@ -0,0 +1,252 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "OrderPool.h"
+#include <cstdint>
+#include <type_traits>
+
+// Order storage layouts for the book.
+//
+// The book never touches order records directly. It goes through a storage
+// type that hands out opaque handles and accessors for the fields, so the
+// record layout can change without touching the matching code:
+//
+//   PointerOrderStorage   Order records from OrderPool, linked by raw pointers.
+//                         48 bytes per order; a level walk touches a full
+//                         cache line per order.
+//   CompactOrderStorage   Records in one array, linked by 32-bit slot numbers.
+//                         32 bytes per order, and price levels shrink to 12 bytes.
+//   HotColdOrderStorage   As above, but the links and size (the only fields a
+//                         level walk reads) are in their own 12-byte records,
+//                         five to a cache line. The ID, price and side live in
+//                         a parallel array that is only read on cancel/execute
+//                         by ID and when a fill is reported.
+//
+// The price and side are still stored: cancels and executes arrive with just
+// an order ID, and the book needs them to find the order's level. They are
+// kept out of the hot records rather than dropped.
+
+// Slot numbers used by the compact layouts.
+using CompactHandle = uint32_t;
+constexpr CompactHandle COMPACT_NIL = UINT32_MAX;
+
+// A price level whose FIFO list is linked by slot numbers.
+struct CompactPriceLevel {
+    CompactHandle head = COMPACT_NIL;
+    CompactHandle tail = COMPACT_NIL;
+    int32_t total_volume = 0; // The sum of sizes of all orders at this level.
+};
+
+// The original layout: Order records from an OrderPool.
+class PointerOrderStorage {
+public:
+    using Handle = Order*;
+    using Level = PriceLevel;
+    static constexpr Handle NIL = nullptr;
+
+    explicit PointerOrderStorage(const OrderPoolConfig& config) : pool_(config) {}
+
+    // Returns a new order with the given fields, or NIL if the pool rejects it.
+    inline Handle acquire(OrderID id, Price price, int32_t size, char side) {
+        Order* order = pool_.acquire();
+        if (order != nullptr) {
+            order->id = id;
+            order->price = price;
+            order->size = size;
+            order->side = side;
+        }
+        return order;
+    }
+
+    inline void release(Handle order) { pool_.release(order); }
+
+    inline Handle& next(Handle order) { return order->next; }
+    inline Handle& prev(Handle order) { return order->prev; }
+    inline int32_t& size(Handle order) { return order->size; }
+    inline Handle next(Handle order) const { return order->next; }
+    inline int32_t size(Handle order) const { return order->size; }
+    // Starts loading an order's record; matching calls this on the next order
+    // in the queue while it fills the current one.
+    inline void prefetch(Handle order) const { __builtin_prefetch(order); }
+
+    inline OrderID id(Handle order) const { return order->id; }
+    inline Price price(Handle order) const { return order->price; }
+    inline char side(Handle order) const { return order->side; }
+    // Moves a resting order to a new price (the book relinks it).
+    inline void setPrice(Handle order, Price price) { order->price = price; }
+
+    size_t inUse() const { return pool_.inUse(); }
+    size_t rejectedCount() const { return pool_.rejectedCount(); }
+
+private:
+    OrderPool pool_;
+};
+
+// A 32-byte order record linked by slot number.
+struct CompactOrder {
+    CompactHandle next;
+    CompactHandle prev;
+    int32_t size;
+    char side;
+    char padding[3];
+    OrderID id;
+    Price price;
+};
+static_assert(sizeof(CompactOrder) == 32, "CompactOrder should be half a cache line");
+
+// The part of an order a level walk reads.
+struct CompactHotOrder {
+    CompactHandle next;
+    CompactHandle prev;
+    int32_t size;
+};
+static_assert(sizeof(CompactHotOrder) == 12, "CompactHotOrder should pack five to a cache line");
+
+// The rest of it.
+struct CompactColdOrder {
+    OrderID id;
+    Price price;
+    char side;
+};
+
+// Orders in flat arrays, addressed by 32-bit slot numbers.
+//
+// Like OrderPool, released slots go on a LIFO free list (threaded through the
+// 'next' link) and never-used slots are handed out in order, so the most
+// recently freed, still-cached slot is reused first. Slots are numbers rather
+// than addresses, so growing the arrays can move them without invalidating
+// any handle the book holds.
+//
+// With SplitHotCold, the records are split into a hot array (links and size)
+// and a cold array (ID, price and side) indexed by the same slot number.
+template <bool SplitHotCold>
+class BasicCompactOrderStorage {
+public:
+    using Handle = CompactHandle;
+    using Level = CompactPriceLevel;
+    static constexpr Handle NIL = COMPACT_NIL;
+
+    explicit BasicCompactOrderStorage(const OrderPoolConfig& config)
+        : hot_(config.pages), cold_(config.pages), config_(config) {
+        capacity_ = clampCapacity(config_.capacity);
+        // Only reserves address space (unless the config prefaults it); pages
+        // are mapped as slots are first used.
+        hot_.reserve(capacity_);
+        if (SplitHotCold) {
+            cold_.reserve(capacity_);
+        }
+    }
+
+    // Returns a new order with the given fields, or NIL if the storage is full
+    // and the policy is Reject.
+    inline Handle acquire(OrderID id, Price price, int32_t size, char side) {
+        Handle slot;
+        if (free_list_ != NIL) {
+            slot = free_list_;
+            free_list_ = hot_[slot].next;
+        } else if (hot_.size() < capacity_) {
+            slot = static_cast<Handle>(hot_.size());
+            hot_.emplace_back();
+            if (SplitHotCold) {
+                cold_.emplace_back();
+            }
+        } else {
+            slot = acquireSlow();
+            if (slot == NIL) {
+                return NIL;
+            }
+        }
+        ++in_use_;
+        hot_[slot].size = size;
+        if constexpr (SplitHotCold) {
+            cold_[slot] = CompactColdOrder{id, price, side};
+        } else {
+            hot_[slot].id = id;
+            hot_[slot].price = price;
+            hot_[slot].side = side;
+        }
+        return slot;
+    }
+
+    inline void release(Handle slot) {
+        hot_[slot].next = free_list_;
+        free_list_ = slot;
+        --in_use_;
+    }
+
+    inline Handle& next(Handle slot) { return hot_[slot].next; }
+    inline Handle& prev(Handle slot) { return hot_[slot].prev; }
+    inline int32_t& size(Handle slot) { return hot_[slot].size; }
+    inline Handle next(Handle slot) const { return hot_[slot].next; }
+    inline int32_t size(Handle slot) const { return hot_[slot].size; }
+    inline void prefetch(Handle slot) const {
+        __builtin_prefetch(&hot_[slot]);
+        if (SplitHotCold) {
+            __builtin_prefetch(&cold(slot));
+        }
+    }
+
+    inline OrderID id(Handle slot) const { return cold(slot).id; }
+    inline Price price(Handle slot) const { return cold(slot).price; }
+    inline char side(Handle slot) const { return cold(slot).side; }
+    inline void setPrice(Handle slot, Price price) {
+        if constexpr (SplitHotCold) {
+            cold_[slot].price = price;
+        } else {
+            hot_[slot].price = price;
+        }
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t inUse() const { return in_use_; }
+    size_t rejectedCount() const { return rejected_count_; }
+
+private:
+    using HotRecord = std::conditional_t<SplitHotCold, CompactHotOrder, CompactOrder>;
+
+    inline const auto& cold(Handle slot) const {
+        if constexpr (SplitHotCold) {
+            return cold_[slot];
+        } else {
+            return hot_[slot];
+        }
+    }
+
+    // NIL is reserved, so at most NIL slots can exist.
+    static size_t clampCapacity(size_t capacity) {
+        return capacity < NIL ? capacity : NIL;
+    }
+
+    // Called when the free list is empty and every reserved slot has been used.
+    Handle acquireSlow() {
+        const size_t grown = clampCapacity(capacity_ + config_.grow_chunk_size);
+        if (config_.policy == PoolOverflowPolicy::Reject || grown == capacity_) {
+            ++rejected_count_;
+            return NIL;
+        }
+        // Growing may move the arrays, but handles are slot numbers and stay valid.
+        capacity_ = grown;
+        hot_.reserve(capacity_);
+        if (SplitHotCold) {
+            cold_.reserve(capacity_);
+        }
+        const Handle slot = static_cast<Handle>(hot_.size());
+        hot_.emplace_back();
+        if (SplitHotCold) {
+            cold_.emplace_back();
+        }
+        return slot;
+    }
+
+    LargeArray<HotRecord> hot_;
+    LargeArray<CompactColdOrder> cold_; // Empty unless SplitHotCold.
+    Handle free_list_ = NIL;
+
+    OrderPoolConfig config_;
+    size_t capacity_ = 0;
+    size_t in_use_ = 0;
+    size_t rejected_count_ = 0;
+};
+
+using CompactOrderStorage = BasicCompactOrderStorage<false>;
+using HotColdOrderStorage = BasicCompactOrderStorage<true>;
@@ -0,0 +1,245 @@
+#pragma once // Standard header guard.
+
+#include "LatencyReport.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Hardware performance counters around the hot stages (receive, parse and each
+// book operation), read with Linux perf_event_open.
+//
+// Latency histograms say that a stage got slower; these say why: fewer
+// instructions retired per cycle, more cache or TLB misses, more mispredicted
+// branches. Counts are summed per stage and event type and reported per
+// message, so a regression can be pinned on, say, LLC misses in cancels.
+//
+// Build with -DPANOPTES_PERF_COUNTERS=1 (the PANOPTES_PERF_COUNTERS CMake
+// option) to compile the probes in. Without it PerfProbe is an empty class
+// whose sample() is a constant false, so every call site folds away and the
+// hot path is exactly what it was.
+//
+// Compiled in, a probe measures one message (or batch) in every
+// PerfConfig::sample_every. A measurement is two read() syscalls of the
+// counter group, about a microsecond each; the probe measures its own cost when
+// it opens, subtracts it from every sample and reports the bound it puts on
+// the average cost per message (see PerfReport::printText()).
+#ifndef PANOPTES_PERF_COUNTERS
+#define PANOPTES_PERF_COUNTERS 0
+#endif
+
+constexpr bool PERF_COUNTERS_COMPILED_IN = PANOPTES_PERF_COUNTERS != 0;
+
+// The stages a probe brackets.
+enum class PerfStage : size_t {
+    Receive,    // One batch receive; its "messages" are the datagrams received.
+    Parse,      // Validating and decoding a chunk of messages.
+    BookUpdate, // Applying one message to its book.
+    Count
+};
+
+// The counters read, in group order.
+enum class PerfCounter : size_t {
+    Cycles,
+    Instructions,
+    L1dMisses,    // L1 data cache read misses.
+    LlcMisses,    // Last-level cache misses.
+    BranchMisses,
+    DtlbMisses,   // Data TLB read misses.
+    Count
+};
+
+constexpr size_t NUM_PERF_COUNTERS = static_cast<size_t>(PerfCounter::Count);
+using PerfValues = std::array<uint64_t, NUM_PERF_COUNTERS>;
+
+// One read of a counter group: the counts, plus how long the group has been
+// enabled and how long it was actually on the PMU. The kernel time-slices
+// groups that do not fit next to whatever else holds counters (the NMI
+// watchdog, another perf user), so running can fall behind enabled, or stay
+// at zero if the group never fits at all.
+struct PerfReading {
+    PerfValues values{};
+    uint64_t time_enabled = 0;
+    uint64_t time_running = 0;
+};
+
+struct PerfConfig {
+    // Measure one message (or batch) in this many. 0 turns the probes off.
+    uint32_t sample_every = 64;
+    // Count kernel-mode events too, so the receive stage includes the syscall.
+    // Needs kernel.perf_event_paranoid <= 1; falls back to user mode without it.
+    bool include_kernel = true;
+};
+
+// Counter totals by stage and event type (the rows of LatencyReport). Receive
+// and parse cover many messages of mixed types at once, so they are recorded
+// with event type 0 and reported as "other".
+class PerfReport {
+public:
+    // Adds one sample: 'delta' counts, covering 'messages' messages. 'scaled'
+    // marks counts extrapolated from part of the sample's time on the PMU.
+    void record(PerfStage stage, char event_type, const PerfValues& delta, uint64_t messages, bool scaled = false);
+
+    // Notes a sample during which the group was never on the PMU, so there is
+    // nothing to record. Such samples are reported as unavailable, not as zeros.
+    void recordUnavailable(PerfStage stage, char event_type);
+
+    // What one sample costs (the counts subtracted from each, and the wall
+    // time of the two reads) and how often one is taken, for the overhead
+    // line of the report. Kept from the last call.
+    void setProbeCost(const PerfValues& cost, double probe_ns, uint32_t sample_every);
+
+    void merge(const PerfReport& other);
+
+    uint64_t samples(PerfStage stage, size_t event_type_index) const {
+        return rows_[static_cast<size_t>(stage)][event_type_index].samples;
+    }
+    // A counter's total over every sample of a row, and the messages they covered.
+    uint64_t total(PerfStage stage, size_t event_type_index, PerfCounter counter) const {
+        return rows_[static_cast<size_t>(stage)][event_type_index].totals[static_cast<size_t>(counter)];
+    }
+    uint64_t messages(PerfStage stage, size_t event_type_index) const {
+        return rows_[static_cast<size_t>(stage)][event_type_index].messages;
+    }
+    uint64_t scaledSamples(PerfStage stage, size_t event_type_index) const {
+        return rows_[static_cast<size_t>(stage)][event_type_index].scaled;
+    }
+    uint64_t unavailableSamples(PerfStage stage, size_t event_type_index) const {
+        return rows_[static_cast<size_t>(stage)][event_type_index].unavailable;
+    }
+
+    // One row per stage and event type: IPC, then cycles, instructions and
+    // each kind of miss per message, plus the probe overhead. Rows with no
+    // counted samples print as unavailable.
+    void printText(std::ostream& out) const;
+
+    // The same numbers as JSON, for scripts. Returns false if the file can't be written.
+    bool writeJson(const std::string& path) const;
+
+private:
+    struct Row {
+        uint64_t samples = 0;
+        uint64_t messages = 0;
+        PerfValues totals{};
+        uint64_t scaled = 0;      // Samples (counted in 'samples') that were scaled up.
+        uint64_t unavailable = 0; // Samples with the group off the PMU (not in 'samples').
+    };
+
+    std::array<std::array<Row, LatencyReport::NUM_EVENT_TYPES>, static_cast<size_t>(PerfStage::Count)> rows_{};
+    PerfValues probe_cost_{};
+    double probe_ns_ = 0.0;
+    uint32_t sample_every_ = 0;
+};
+
+#if PANOPTES_PERF_COUNTERS
+
+// One thread's counter group. perf_event_open counts the calling thread only,
+// so each thread that measures anything opens its own.
+class PerfCounterGroup {
+public:
+    PerfCounterGroup() = default;
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    // Opens and starts the counters for the calling thread. Counters the CPU
+    // or kernel does not offer read as zero. Returns false (after printing
+    // why) if not even the cycle counter can be opened. Warns if the group
+    // opened but is not being scheduled onto the PMU.
+    bool open(bool include_kernel);
+    bool isOpen() const { return fds_[0] >= 0; }
+
+    // Reads every counter, and the group's enabled and running times, with one syscall.
+    void read(PerfReading& reading) const;
+
+private:
+    std::array<int, NUM_PERF_COUNTERS> fds_{-1, -1, -1, -1, -1, -1};
+    // Where each counter's value lands in the group read (-1 if not open).
+    std::array<int, NUM_PERF_COUNTERS> slot_{-1, -1, -1, -1, -1, -1};
+    size_t num_open_ = 0;
+};
+
+// The hot-path face: decides which messages are measured and brackets them.
+//
+//     const bool sampled = probe.sample();
+//     if (sampled) probe.begin();
+//     book.apply(msg);
+//     if (sampled) probe.end(PerfStage::BookUpdate, msg.event_type);
+class PerfProbe {
+public:
+    PerfProbe(const PerfConfig& config, PerfReport& report) : config_(config), report_(report) {}
+
+    // Opens the calling thread's counters and measures the probe's own cost.
+    // Call it on the thread that will use the probe. Returns false (after
+    // printing why) if the counters are unavailable; the probe then never samples.
+    bool open();
+
+    // Counts down to the next sample. On the common path, one compare and a
+    // decrement.
+    inline bool sample() {
+        if (countdown_ > 1) {
+            --countdown_;
+            return false;
+        }
+        // 1: this call is sampled. 0: the probe is off (never opened, or
+        // sample_every is 0).
+        if (countdown_ == 0) {
+            return false;
+        }
+        countdown_ = config_.sample_every;
+        return true;
+    }
+
+    inline void begin() { group_.read(start_); }
+
+    inline void end(PerfStage stage, char event_type, uint64_t messages = 1) {
+        PerfReading now;
+        group_.read(now);
+        // 1. The group was never on the PMU: there are no counts to report.
+        const uint64_t enabled = now.time_enabled - start_.time_enabled;
+        const uint64_t running = now.time_running - start_.time_running;
+        if (running == 0) {
+            report_.recordUnavailable(stage, event_type);
+            return;
+        }
+        // 2. On it for part of the sample: extrapolate, as perf stat does.
+        const bool scaled = running < enabled;
+        const double scale = scaled ? static_cast<double>(enabled) / static_cast<double>(running) : 1.0;
+        PerfValues delta;
+        for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+            uint64_t counted = now.values[i] - start_.values[i];
+            if (scaled) {
+                counted = static_cast<uint64_t>(static_cast<double>(counted) * scale + 0.5);
+            }
+            delta[i] = counted > cost_[i] ? counted - cost_[i] : 0;
+        }
+        report_.record(stage, event_type, delta, messages, scaled);
+    }
+
+private:
+    PerfConfig config_;
+    PerfReport& report_;
+    PerfCounterGroup group_;
+    PerfReading start_{};
+    // What an empty begin()/end() pair counts, subtracted from every sample.
+    PerfValues cost_{};
+    // Calls left until the next sample; see sample().
+    uint32_t countdown_ = 0;
+};
+
+#else
+
+// Compiled out: no state, and sample() is a constant, so the branches that
+// guard begin() and end() disappear.
+class PerfProbe {
+public:
+    PerfProbe(const PerfConfig&, PerfReport&) {}
+    bool open() { return false; }
+    static constexpr bool sample() { return false; }
+    void begin() {}
+    void end(PerfStage, char, uint64_t = 1) {}
+};
+
+#endif
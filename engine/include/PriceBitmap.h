@@ -0,0 +1,179 @@
+#pragma once // Standard header guard.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// A hierarchical occupancy bitmap over a price ladder.
+//
+// Level 0 holds one bit per price level: the bit is set while that level has
+// resting orders. Every bit of level N+1 summarises one 64-bit word of level N
+// (the bit is set if any bit in that word is set). For 1,000,000 price levels
+// this gives four levels of 15625, 245, 4 and 1 words.
+//
+// Finding the best (highest or lowest) occupied level is then a walk from the
+// single top word down to level 0, which is one count-leading/trailing-zeros
+// instruction per level instead of a scan over the whole ladder.
+class PriceBitmap {
+public:
+    // Returned by highest()/lowest() when no bit is set.
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    explicit PriceBitmap(size_t num_bits) {
+        // Keep adding summary levels until a single word covers everything.
+        size_t words = wordsFor(num_bits);
+        levels_.emplace_back(words, 0);
+        while (words > 1) {
+            words = wordsFor(words);
+            levels_.emplace_back(words, 0);
+        }
+    }
+
+    // Marks a price level as occupied.
+    inline void set(size_t index) {
+        for (auto& level : levels_) {
+            uint64_t& word = level[index >> 6];
+            const bool was_empty = (word == 0);
+            word |= bit(index);
+            // If the word already had a bit set, the levels above already know about it.
+            if (!was_empty) {
+                return;
+            }
+            index >>= 6;
+        }
+    }
+
+    // Marks a price level as empty.
+    inline void clear(size_t index) {
+        for (auto& level : levels_) {
+            uint64_t& word = level[index >> 6];
+            word &= ~bit(index);
+            // Only propagate upwards if this word has just become empty.
+            if (word != 0) {
+                return;
+            }
+            index >>= 6;
+        }
+    }
+
+    inline bool test(size_t index) const {
+        return (levels_[0][index >> 6] & bit(index)) != 0;
+    }
+
+    // Returns the highest occupied index (the best bid), or NPOS.
+    inline size_t highest() const {
+        size_t index = 0;
+        for (size_t l = levels_.size(); l-- > 0;) {
+            const uint64_t word = levels_[l][index];
+            if (word == 0) {
+                return NPOS;
+            }
+            index = (index << 6) | (63 - __builtin_clzll(word));
+        }
+        return index;
+    }
+
+    // Returns the lowest occupied index (the best ask), or NPOS.
+    inline size_t lowest() const {
+        size_t index = 0;
+        for (size_t l = levels_.size(); l-- > 0;) {
+            const uint64_t word = levels_[l][index];
+            if (word == 0) {
+                return NPOS;
+            }
+            index = (index << 6) | __builtin_ctzll(word);
+        }
+        return index;
+    }
+
+    // Returns the highest occupied index strictly below 'index', or NPOS. Used
+    // to walk a side of the book down from its best level.
+    inline size_t highestBelow(size_t index) const {
+        // Climb until some word has a set bit below the one we came from, then
+        // descend to the highest set bit under it.
+        for (size_t l = 0; l < levels_.size(); ++l) {
+            const uint64_t word = levels_[l][index >> 6] & (bit(index) - 1);
+            if (word != 0) {
+                index = (index & ~size_t{63}) | (63 - __builtin_clzll(word));
+                while (l-- > 0) {
+                    index = (index << 6) | (63 - __builtin_clzll(levels_[l][index]));
+                }
+                return index;
+            }
+            index >>= 6;
+        }
+        return NPOS;
+    }
+
+    // Returns the lowest occupied index strictly above 'index', or NPOS.
+    inline size_t lowestAbove(size_t index) const {
+        for (size_t l = 0; l < levels_.size(); ++l) {
+            const uint64_t word = levels_[l][index >> 6] & ~(bit(index) | (bit(index) - 1));
+            if (word != 0) {
+                index = (index & ~size_t{63}) | __builtin_ctzll(word);
+                while (l-- > 0) {
+                    index = (index << 6) | __builtin_ctzll(levels_[l][index]);
+                }
+                return index;
+            }
+            index >>= 6;
+        }
+        return NPOS;
+    }
+
+    // Calls f(index) for every occupied index at or below 'from', highest
+    // first, until f returns false. Bits come straight out of the full-
+    // resolution words; only runs of empty words go through the summaries.
+    template <typename F>
+    void forEachDescending(size_t from, F&& f) const {
+        const uint64_t* words = levels_[0].data();
+        size_t word_index = from >> 6;
+        uint64_t word = words[word_index] & (bit(from) | (bit(from) - 1));
+        while (true) {
+            while (word != 0) {
+                const unsigned b = 63 - __builtin_clzll(word);
+                if (!f((word_index << 6) | b)) {
+                    return;
+                }
+                word &= ~(uint64_t{1} << b);
+            }
+            const size_t next = highestBelow(word_index << 6);
+            if (next == NPOS) {
+                return;
+            }
+            word_index = next >> 6;
+            word = words[word_index] & (bit(next) | (bit(next) - 1));
+        }
+    }
+
+    // Calls f(index) for every occupied index at or above 'from', lowest
+    // first, until f returns false.
+    template <typename F>
+    void forEachAscending(size_t from, F&& f) const {
+        const uint64_t* words = levels_[0].data();
+        size_t word_index = from >> 6;
+        uint64_t word = words[word_index] & ~(bit(from) - 1);
+        while (true) {
+            while (word != 0) {
+                const unsigned b = __builtin_ctzll(word);
+                if (!f((word_index << 6) | b)) {
+                    return;
+                }
+                word &= word - 1;
+            }
+            const size_t next = lowestAbove((word_index << 6) | 63);
+            if (next == NPOS) {
+                return;
+            }
+            word_index = next >> 6;
+            word = words[word_index] & ~(bit(next) - 1);
+        }
+    }
+
+private:
+    static constexpr size_t wordsFor(size_t bits) { return (bits + 63) / 64; }
+    static constexpr uint64_t bit(size_t index) { return uint64_t{1} << (index & 63); }
+
+    // levels_[0] is the full-resolution bitmap, levels_.back() is a single word.
+    std::vector<std::vector<uint64_t>> levels_;
+};
@@ -0,0 +1,335 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include "PriceBitmap.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+// How an instrument's prices map onto ladder ticks.
+struct PriceLadderConfig {
+    // Minimum price increment, in fixed-point units. Adds off this grid are rejected.
+    Price tick_size = 1;
+    // The price of tick 0. Prices below it are fine (ticks are signed); it only
+    // has to put every valid price on the tick grid.
+    Price base_price = 0;
+    // Price levels held in the dense window around the touch.
+    size_t window_levels = DEFAULT_LADDER_WINDOW_LEVELS;
+};
+
+// Ladder settings for every instrument, with a default for instruments that
+// are not listed.
+struct InstrumentLadders {
+    PriceLadderConfig default_config{};
+    // Indexed by InstrumentID. May be shorter than MAX_INSTRUMENTS, or empty.
+    std::vector<PriceLadderConfig> per_instrument;
+
+    const PriceLadderConfig& forInstrument(InstrumentID instrument) const {
+        return instrument < per_instrument.size() ? per_instrument[instrument] : default_config;
+    }
+};
+
+// One side's price levels, indexed by tick.
+//
+// The levels near the touch live in a small dense window, so the hot path is an
+// array index plus one bounds check and the whole window (plus its occupancy
+// bitmap) stays in L1/L2. Levels outside the window go into an ordered overflow
+// map. When the best price drifts towards the edge of the window, the book calls
+// recenter() to slide the window back over it, spilling levels that fall out to
+// the overflow and pulling in the ones it now covers.
+//
+// The ladder does not know which side it is on: the book tracks the best tick
+// and asks for highest() or lowest() when the best level empties.
+//
+// 'Level' is the order storage's level record (see OrderStorage.h). It only has
+// to be default-constructible as empty and copyable. A non-zero FixedWindow
+// fixes the window size at compile time (the constructor argument is then
+// ignored), so the bounds check on every lookup compares against a constant.
+// The member functions that are not inline are instantiated in PriceLadder.cpp
+// for each level type and fixed window size in use.
+template <typename Level, size_t FixedWindow = 0>
+class BasicPriceLadder {
+public:
+    using Tick = int64_t;
+    // Returned by highest()/lowest() when the ladder is empty.
+    static constexpr Tick NO_TICK = INT64_MIN;
+
+    static_assert(FixedWindow == 0 || FixedWindow >= 64, "the window holds at least one bitmap word");
+
+    explicit BasicPriceLadder(size_t window_levels = DEFAULT_LADDER_WINDOW_LEVELS);
+
+    // Returns the level at 'tick', creating an empty overflow level if it has
+    // none yet. Callers must follow up with setOccupied() when they put the
+    // first order on a new level.
+    inline Level& level(Tick tick) {
+        const uint64_t slot = static_cast<uint64_t>(tick - window_begin_);
+        if (slot < windowSize()) {
+            return window_[slot];
+        }
+        return overflowLevel(tick);
+    }
+
+    // Returns the level at 'tick', or nullptr if it has no orders.
+    inline const Level* find(Tick tick) const {
+        const uint64_t slot = static_cast<uint64_t>(tick - window_begin_);
+        if (slot < windowSize()) {
+            return occupied_.test(slot) ? &window_[slot] : nullptr;
+        }
+        return findOverflow(tick);
+    }
+
+    // The level at an occupied 'tick', such as the best one.
+    inline const Level& occupiedLevel(Tick tick) const {
+        const uint64_t slot = static_cast<uint64_t>(tick - window_begin_);
+        return slot < windowSize() ? window_[slot] : *findOverflow(tick);
+    }
+
+    // Records that the level at 'tick' has just received its first order.
+    inline void setOccupied(Tick tick) {
+        const uint64_t slot = static_cast<uint64_t>(tick - window_begin_);
+        if (slot < windowSize()) {
+            occupied_.set(slot);
+        }
+        ++occupied_levels_;
+    }
+
+    // Records that the level at 'tick' has just lost its last order.
+    inline void setEmpty(Tick tick) {
+        const uint64_t slot = static_cast<uint64_t>(tick - window_begin_);
+        if (slot < windowSize()) {
+            occupied_.clear(slot);
+        } else {
+            eraseOverflow(tick);
+        }
+        --occupied_levels_;
+    }
+
+    // The highest and lowest occupied ticks, or NO_TICK. Usually the overflow is
+    // empty and this is just a bitmap search of the window.
+    inline Tick highest() const {
+        if (!overflow_.empty()) {
+            return highestWithOverflow();
+        }
+        const size_t slot = occupied_.highest();
+        return slot == PriceBitmap::NPOS ? NO_TICK : window_begin_ + static_cast<Tick>(slot);
+    }
+
+    inline Tick lowest() const {
+        if (!overflow_.empty()) {
+            return lowestWithOverflow();
+        }
+        const size_t slot = occupied_.lowest();
+        return slot == PriceBitmap::NPOS ? NO_TICK : window_begin_ + static_cast<Tick>(slot);
+    }
+
+    bool empty() const { return occupied_levels_ == 0; }
+
+    // Calls f(tick, level) for the occupied levels at or below / above 'from',
+    // nearest first, for as long as f returns true. Within the window this
+    // takes the bits a word at a time, so reading the top few levels costs
+    // little more than reading the best one.
+    template <typename F>
+    void walkDown(Tick from, F&& f) const {
+        if (!overflow_.empty()) {
+            for (Tick tick = find(from) ? from : nextBelow(from); tick != NO_TICK && f(tick, occupiedLevel(tick));
+                 tick = nextBelow(tick)) {
+            }
+            return;
+        }
+        if (from < window_begin_) {
+            return;
+        }
+        const size_t start = from >= windowEnd() ? windowSize() - 1 : static_cast<size_t>(from - window_begin_);
+        occupied_.forEachDescending(start, [&](size_t slot) {
+            return f(window_begin_ + static_cast<Tick>(slot), window_[slot]);
+        });
+    }
+
+    template <typename F>
+    void walkUp(Tick from, F&& f) const {
+        if (!overflow_.empty()) {
+            for (Tick tick = find(from) ? from : nextAbove(from); tick != NO_TICK && f(tick, occupiedLevel(tick));
+                 tick = nextAbove(tick)) {
+            }
+            return;
+        }
+        if (from >= windowEnd()) {
+            return;
+        }
+        const size_t start = from < window_begin_ ? 0 : static_cast<size_t>(from - window_begin_);
+        occupied_.forEachAscending(start, [&](size_t slot) {
+            return f(window_begin_ + static_cast<Tick>(slot), window_[slot]);
+        });
+    }
+
+    // The nearest occupied tick strictly below / above 'tick', or NO_TICK. For
+    // walking the levels behind the best one; each step is a bitmap search.
+    inline Tick nextBelow(Tick tick) const {
+        if (!overflow_.empty()) {
+            return nextBelowWithOverflow(tick);
+        }
+        return nextBelowInWindow(tick);
+    }
+
+    inline Tick nextAbove(Tick tick) const {
+        if (!overflow_.empty()) {
+            return nextAboveWithOverflow(tick);
+        }
+        return nextAboveInWindow(tick);
+    }
+
+    inline bool inWindow(Tick tick) const {
+        return static_cast<uint64_t>(tick - window_begin_) < windowSize();
+    }
+
+    // True if 'tick' is outside the middle three quarters of the window, i.e. it
+    // is time to recenter before the touch walks off the dense levels.
+    inline bool nearEdge(Tick tick) const {
+        const uint64_t margin = windowSize() / 8;
+        return static_cast<uint64_t>(tick - window_begin_ - margin) >= windowSize() - 2 * margin;
+    }
+
+    // Calls f(tick, level) for every occupied level, lowest tick first. A full
+    // scan of the window, so for snapshots and diagnostics, not the hot path.
+    template <typename F>
+    void forEachOccupied(F&& f) const {
+        auto it = overflow_.begin();
+        for (; it != overflow_.end() && it->first < window_begin_; ++it) {
+            f(it->first, it->second);
+        }
+        for (uint64_t slot = 0; slot < windowSize(); ++slot) {
+            if (occupied_.test(slot)) {
+                f(window_begin_ + static_cast<Tick>(slot), window_[slot]);
+            }
+        }
+        for (; it != overflow_.end(); ++it) {
+            f(it->first, it->second);
+        }
+    }
+
+    // Slides the window so that it is centred on 'tick'.
+    void recenter(Tick tick);
+
+    Tick windowBegin() const { return window_begin_; }
+    Tick windowEnd() const { return window_begin_ + static_cast<Tick>(windowSize()); }
+    size_t windowLevels() const { return windowSize(); }
+    // Number of occupied levels currently held outside the window.
+    size_t overflowLevels() const { return overflow_.size(); }
+    // How many times the window has moved.
+    uint64_t recenterCount() const { return recenters_; }
+
+private:
+    // Out of line so the map code stays off the inlined fast path.
+    Level& overflowLevel(Tick tick);
+    const Level* findOverflow(Tick tick) const;
+    void eraseOverflow(Tick tick);
+    Tick highestWithOverflow() const;
+    Tick lowestWithOverflow() const;
+    Tick nextBelowWithOverflow(Tick tick) const;
+    Tick nextAboveWithOverflow(Tick tick) const;
+
+    inline Tick nextBelowInWindow(Tick tick) const {
+        if (tick <= window_begin_) {
+            return NO_TICK;
+        }
+        const size_t slot = tick >= windowEnd() ? occupied_.highest()
+                                                : occupied_.highestBelow(static_cast<size_t>(tick - window_begin_));
+        return slot == PriceBitmap::NPOS ? NO_TICK : window_begin_ + static_cast<Tick>(slot);
+    }
+
+    inline Tick nextAboveInWindow(Tick tick) const {
+        if (tick >= windowEnd() - 1) {
+            return NO_TICK;
+        }
+        const size_t slot = tick < window_begin_ ? occupied_.lowest()
+                                                 : occupied_.lowestAbove(static_cast<size_t>(tick - window_begin_));
+        return slot == PriceBitmap::NPOS ? NO_TICK : window_begin_ + static_cast<Tick>(slot);
+    }
+
+    // The window size: a constant when it is fixed at compile time.
+    inline uint64_t windowSize() const {
+        if constexpr (FixedWindow != 0) {
+            return FixedWindow;
+        } else {
+            return window_size_;
+        }
+    }
+
+    // A plain array rather than a vector: the size is read on every lookup, and
+    // keeping it in its own member saves recomputing it from two pointers.
+    std::unique_ptr<Level[]> window_;
+    uint64_t window_size_;
+    // Occupancy of the window's levels, used to find the next best level.
+    PriceBitmap occupied_;
+    // The tick held by window_[0].
+    Tick window_begin_ = 0;
+    // Far-away levels. Only occupied levels are kept here.
+    std::map<Tick, Level> overflow_;
+    size_t occupied_levels_ = 0;
+    uint64_t recenters_ = 0;
+};
+
+// A ladder for one side of the book.
+//
+// The side decides which way is better (higher for bids, lower for asks), and
+// that is all the book's side-dependent code needs, so with the side a template
+// argument none of it branches on the side at run time. The best tick of an
+// empty side is EMPTY, the worst possible price for that side rather than
+// NO_TICK, so "does this improve the best?" and "does this cross?" are single
+// compares with no special case for an empty side.
+template <char Side, typename Level, size_t FixedWindow = 0>
+class SidedPriceLadder : public BasicPriceLadder<Level, FixedWindow> {
+    using Base = BasicPriceLadder<Level, FixedWindow>;
+
+public:
+    using Tick = typename Base::Tick;
+    static_assert(Side == 'B' || Side == 'A', "a ladder holds bids ('B') or asks ('A')");
+
+    static constexpr char SIDE = Side;
+    static constexpr char OPPOSITE = Side == 'B' ? 'A' : 'B';
+    static constexpr Tick EMPTY = Side == 'B' ? INT64_MIN : INT64_MAX;
+
+    using Base::Base;
+
+    // True if 'tick' is a strictly better price than 'other' on this side.
+    // Every tick is better than EMPTY.
+    static constexpr bool better(Tick tick, Tick other) {
+        return Side == 'B' ? tick > other : tick < other;
+    }
+
+    // True if an incoming order on the other side with limit 'limit' trades
+    // against a level here at 'tick': a buy takes asks at or below its limit,
+    // a sell takes bids at or above it. Nothing trades against EMPTY.
+    static constexpr bool crossedBy(Tick limit, Tick tick) {
+        return !better(limit, tick);
+    }
+
+    // The best occupied tick, or EMPTY.
+    inline Tick best() const {
+        if constexpr (Side == 'B') {
+            return this->highest(); // NO_TICK is already EMPTY for bids.
+        } else {
+            const Tick lowest = this->lowest();
+            return lowest == Base::NO_TICK ? EMPTY : lowest;
+        }
+    }
+
+    // Calls f(tick, level) for the occupied levels from 'from' (normally the
+    // best tick) backwards, down for bids and up for asks, for as long as f
+    // returns true. Nothing for EMPTY.
+    template <typename F>
+    void walkBack(Tick from, F&& f) const {
+        if (from == EMPTY) {
+            return;
+        }
+        if constexpr (Side == 'B') {
+            this->walkDown(from, f);
+        } else {
+            this->walkUp(from, f);
+        }
+    }
+};
+
+// The ladder used with the pointer order layout.
+using PriceLadder = BasicPriceLadder<PriceLevel>;
@@ -0,0 +1,25 @@
+#pragma once // Standard header guard.
+
+#include "BookManager.h"
+#include <cstdint>
+#include <string>
+
+struct RecoveryStats {
+    bool snapshot_loaded = false;
+    uint64_t snapshot_sequence = 0;  // Journal sequence the snapshot covers.
+    uint64_t snapshot_orders = 0;    // Resting orders restored from it.
+    uint64_t journal_messages = 0;   // Journal records replayed after it.
+    uint64_t last_sequence = 0;      // Last journal record found.
+    double elapsed_ms = 0;           // Wall time for the whole recovery.
+};
+
+// Rebuilds the books after a restart: loads the latest snapshot (if there is
+// one), then replays only the journal records written after it.
+//
+// Snapshot orders are re-added level by level in time priority, so every queue
+// comes back in the same order it had. Everything is submitted to 'books',
+// which must already be started; this returns once the workers have applied it
+// all, so the time reported is the real restart cost. Returns false if the
+// journal exists but cannot be read.
+bool recoverBooks(const std::string& snapshot_path, const std::string& journal_path,
+                  BookManager& books, RecoveryStats& stats);
@@ -0,0 +1,37 @@
+#pragma once // Standard header guard.
+
+#include "OrderBook.h"
+#include "OrderPool.h"
+#include "PerfCounters.h"
+#include "PriceLadder.h"
+#include <cstddef>
+#include <string>
+
+struct ReplayConfig {
+    // A capture of back-to-back 32-byte PanoptesMessages (e.g. data/messages.bin).
+    std::string path;
+    // Timed passes over the whole file. Each pass starts from empty books.
+    size_t iterations = 1;
+    // Untimed passes run first to warm caches, the branch predictor and the page cache.
+    size_t warmup_iterations = 0;
+    // Record per-message parse and book-update latency (two TSC reads per message).
+    bool measure_latency = true;
+    // Where to write the machine-readable latency report.
+    std::string latency_path = "panoptes_latency.json";
+    // Hardware counters around sampled parse chunks and book updates of the
+    // timed passes (when compiled in), and where to write their report.
+    PerfConfig perf{};
+    std::string perf_path = "panoptes_perf.json";
+    OrderPoolConfig pool_config{};
+    InstrumentLadders ladders{};
+    BookVariant variant{};
+};
+
+// Offline replay: memory-maps a capture and drives it through parseMessage and
+// the books in a tight loop on the calling thread, with no sockets, queues or
+// other threads involved. This gives deterministic throughput and latency
+// numbers for the parser and book alone, on captures of any size.
+//
+// Prints messages per second for each pass and overall, plus the per-message
+// latency distribution. Returns a process exit code.
+int runReplay(const ReplayConfig& config);
@@ -0,0 +1,39 @@
+#pragma once // Standard header guard.
+
+#include "WireFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+// The engine's side of gap recovery: sends RetransmitRequests to a sender's
+// recovery service and collects the frames it sends back.
+//
+// The socket is connected to the service, so only its replies are received
+// here. They are read with non-blocking calls, and only while the sequence
+// tracker is waiting for a gap to be filled, so this costs nothing when no
+// datagrams are being lost.
+class RetransmitClient {
+public:
+    RetransmitClient(const std::string& address, int port);
+    ~RetransmitClient();
+
+    RetransmitClient(const RetransmitClient&) = delete;
+    RetransmitClient& operator=(const RetransmitClient&) = delete;
+
+    // Creates the socket. Returns false (after printing why) on failure.
+    bool open();
+
+    void request(const RetransmitRequest& request);
+
+    // Receives one reply without waiting. Returns its length, or 0 if none is queued.
+    size_t receive(char* buffer, size_t size);
+
+    uint64_t requestsSent() const { return requests_sent_; }
+
+private:
+    std::string address_;
+    int port_;
+    int sock_fd_ = -1;
+    uint64_t requests_sent_ = 0;
+};
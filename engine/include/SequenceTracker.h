@@ -0,0 +1,118 @@
+#pragma once // Standard header guard.
+
+#include "WireFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Where SequenceTracker sends its output.
+class SequencedSink {
+public:
+    virtual ~SequencedSink() = default;
+    // 'count' raw PanoptesMessages, now in sequence order.
+    virtual void deliver(const char* messages, size_t count) = 0;
+    // Asks the sender to resend a range of messages.
+    virtual void requestRetransmit(const RetransmitRequest& request) = 0;
+};
+
+struct SequenceTrackerConfig {
+    // Hold frames that arrive after a gap and ask the sender to fill it. If
+    // false, a gap is counted as lost straight away and processing carries on.
+    bool retransmit = false;
+    // How long to wait for a gap to be filled before giving up on it.
+    int64_t gap_timeout_ns = 50000000;
+    // Messages held back per stream while waiting; beyond this the gap is
+    // given up on at once.
+    size_t max_held_messages = 1 << 16;
+};
+
+// Puts v2 frames back in order and accounts for the ones that went missing.
+//
+// Each sender stream, told apart by where it comes from as well as by its
+// stream ID (two senders both numbering stream 0 are two streams), has an
+// expected next sequence number. A frame that
+// starts there is delivered at once. A frame that is wholly behind it is a
+// duplicate and is dropped; one that overlaps it has its repeated head
+// trimmed. A frame that starts beyond it means messages were lost: with
+// retransmission on, the tracker asks the sender for the missing range and
+// holds on to this and later frames until the gap is filled or times out, so
+// the books never see messages out of order. With it off, the gap is counted
+// and skipped.
+//
+// Not thread-safe: the network thread owns it.
+class SequenceTracker {
+public:
+    struct Stats {
+        uint64_t frames = 0;          // v2 frames received, retransmissions included.
+        uint64_t messages = 0;        // Messages delivered in sequence.
+        uint64_t duplicates = 0;      // Messages received more than once and dropped.
+        uint64_t gaps = 0;            // Distinct holes detected in a sequence.
+        uint64_t gap_messages = 0;    // Messages missing from those holes.
+        uint64_t retransmitted = 0;   // Messages delivered from retransmitted frames.
+        uint64_t lost = 0;            // Messages given up on.
+        uint64_t session_resets = 0;  // Times a stream came back with a new session.
+    };
+
+    explicit SequenceTracker(const SequenceTrackerConfig& config = {});
+
+    // Handles one frame whose messages follow 'header'. 'now_ns' is any
+    // monotonic clock, used for the gap timeout. 'source' identifies the
+    // sender in at most SOURCE_BITS bits (an IPv4 address and port, or a ring
+    // lane). A retransmitted frame comes from the sender's recovery service
+    // rather than from the stream's own source, so it is matched to its
+    // stream by session and stream ID instead.
+    void onFrame(const FrameHeader& header, const char* messages, int64_t now_ns, SequencedSink& sink,
+                 uint64_t source = 0);
+
+    // Gives up on gaps that have been open longer than the timeout and
+    // delivers whatever was held behind them. Call it regularly.
+    void poll(int64_t now_ns, SequencedSink& sink);
+
+    // True while any stream is holding frames for a gap to be filled.
+    bool waiting() const { return held_streams_ > 0; }
+
+    const Stats& stats() const { return stats_; }
+
+    static constexpr unsigned SOURCE_BITS = 48;
+
+private:
+    // A copy of a frame that arrived ahead of a gap.
+    struct HeldFrame {
+        std::vector<char> messages;
+        size_t count;
+        bool retransmit;
+    };
+
+    struct Stream {
+        bool active = false;
+        uint32_t session_id = 0;
+        uint64_t next = 1;     // Sequence of the next message to deliver.
+        uint64_t high = 1;     // One past the highest sequence received or requested.
+        // Frames received ahead of a gap, by first sequence.
+        std::map<uint64_t, HeldFrame> held;
+        size_t held_messages = 0;
+        int64_t gap_since_ns = 0;
+    };
+
+    // Streams are keyed by source and stream ID together.
+    static uint64_t streamKey(uint64_t source, uint16_t stream_id) {
+        return (source << 16) | stream_id;
+    }
+    // The stream a frame belongs to, created if it is new.
+    Stream& streamFor(const FrameHeader& header, uint64_t source);
+
+    // Delivers the part of a frame at or after stream.next.
+    void deliverFrom(Stream& stream, uint64_t first, const char* messages, size_t count, bool retransmit,
+                     SequencedSink& sink);
+    // Delivers held frames that have become contiguous.
+    void drainHeld(Stream& stream, SequencedSink& sink);
+    // Skips the gap in front of the oldest held frame, counting it as lost.
+    void skipGap(Stream& stream, SequencedSink& sink);
+
+    SequenceTrackerConfig config_;
+    std::unordered_map<uint64_t, Stream> streams_;
+    size_t held_streams_ = 0;
+    Stats stats_;
+};
@@ -0,0 +1,100 @@
+#pragma once // Standard header guard.
+
+#include "ShmRing.h"
+#include "UdpReceiver.h" // For ReceiveStats
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ShmReceiverConfig {
+    // The POSIX shared-memory name to create, e.g. "/panoptes_ring".
+    std::string name = "/panoptes_ring";
+    // Lanes, one per sender thread.
+    size_t num_lanes = 4;
+    // Bytes of records per lane (rounded up to a power of two).
+    size_t lane_bytes = 4 * 1024 * 1024;
+    // Datagrams returned per receiveBatch() call, across all lanes.
+    size_t batch_size = 64;
+    // The longest datagram a sender may write: as long as a UDP datagram can be.
+    size_t buffer_size = 65507;
+    // How long receiveBatch() waits for data before reporting a timeout.
+    int timeout_ms = 2000;
+    // Spin on the lanes without ever giving the CPU up, for a core of its own.
+    // Otherwise an idle receiver backs off as an idle book worker does: it
+    // spins for backoff_spins empty polls, yields for backoff_yields more, then
+    // sleeps backoff_sleep_us between polls, so a sender sharing the core can
+    // run, and the receiver is woken (and preempts it) when the sleep ends.
+    bool busy_poll = false;
+    uint32_t backoff_spins = 4096;
+    uint32_t backoff_yields = 64;
+    uint32_t backoff_sleep_us = 50;
+};
+
+// Receives datagrams from the shared-memory ring (ShmRing.h) in batches,
+// through the same interface as UdpReceiver: receiveBatch(), then data(i) and
+// length(i) for each datagram of the batch.
+//
+// A batch is read in place: data(i) points into the ring, and the space it
+// takes is only handed back to the sender at the next receiveBatch(), once the
+// caller has finished with it. Lanes are drained round robin, starting one
+// further on each batch, so a busy sender cannot starve the others. Receiving
+// makes no syscalls unless it is idle and backing off; there are no kernel
+// drops, since a full lane holds its sender back instead. The ring is shared
+// with other processes, so a record's length is checked against the segment
+// before any of it is read.
+class ShmReceiver {
+public:
+    using Stats = ReceiveStats;
+
+    explicit ShmReceiver(const ShmReceiverConfig& config);
+
+    ShmReceiver(const ShmReceiver&) = delete;
+    ShmReceiver& operator=(const ShmReceiver&) = delete;
+
+    // Creates the segment. Returns false (after printing why) on failure.
+    bool open();
+
+    // Waits for data and receives up to batch_size datagrams.
+    // Returns the number received, or 0 on timeout.
+    int receiveBatch();
+
+    // The i-th datagram of the last batch.
+    inline const char* data(size_t i) const { return data_[i]; }
+    inline size_t length(size_t i) const { return lengths_[i]; }
+    // Who sent it: the lane it was read from.
+    inline uint64_t source(size_t i) const { return lanes_[i]; }
+
+    const Stats& stats() const { return stats_; }
+    // Nothing to refresh: a ring never drops. Kept so both receivers read alike.
+    void refreshKernelDrops() {}
+
+    size_t numLanes() const { return segment_.numLanes(); }
+    // Lanes a sender has claimed and not yet given up.
+    size_t writersAttached() const;
+
+private:
+    // This side's copy of a lane's indices.
+    struct LaneCursor {
+        uint64_t head = 0;        // Consumed, including the current batch.
+        uint64_t released = 0;    // Handed back to the sender.
+        uint64_t cached_tail = 0; // The sender's tail as last read.
+    };
+
+    // Gives the space the last batch used back to the senders.
+    void release();
+    // Called each time a poll finds every lane empty; 'idle_polls' counts the
+    // empty polls in a row.
+    void waitForData(uint32_t idle_polls);
+    // One pass over the lanes. Returns the datagrams found.
+    int poll();
+
+    ShmReceiverConfig config_;
+    ShmRingSegment segment_;
+    std::vector<LaneCursor> cursors_;
+    size_t next_lane_ = 0;
+    std::vector<const char*> data_;
+    std::vector<size_t> lengths_;
+    std::vector<uint32_t> lanes_;
+    Stats stats_;
+};
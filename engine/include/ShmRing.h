@@ -0,0 +1,205 @@
+#pragma once // Standard header guard.
+
+#include "SpscRing.h" // For CACHE_LINE_SIZE
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// A shared-memory ingest transport, for a feed handler on the same host as the
+// engine: datagrams go through a ring in a POSIX shared-memory segment instead
+// of through the kernel's UDP stack.
+//
+// The engine creates the segment (ShmReceiver), holding a fixed number of
+// lanes. Each lane is a single-producer, single-consumer ring of variable-length
+// records, one record per datagram, carrying exactly the bytes the UDP path
+// would: a v2 frame or a v1 message. A sender thread claims a lane of its own
+// (ShmRingWriter), so no two writers ever share an index and nothing needs a
+// lock or a compare-and-swap on the hot path.
+//
+// Each lane's two indices count bytes ever written and ever consumed, and sit
+// on cache lines of their own, so the producer and the consumer only touch each
+// other's line to refresh a private, cached copy: the producer when the ring
+// looks full, the consumer when it looks empty. The producer publishes a whole
+// batch of records with one release store, as sendmmsg() sends a batch with one
+// syscall. A full ring holds the producer back rather than dropping data.
+
+// The layout of the segment: a header, then num_lanes lane blocks, each a
+// ShmRingLane followed by lane_bytes of records. Bump SHM_RING_LAYOUT whenever
+// any of it changes, so writers from an older build refuse the segment.
+constexpr uint64_t SHM_RING_MAGIC = 0x474E495253504E50ull; // "PNPSRING"
+constexpr uint32_t SHM_RING_LAYOUT = 1;
+constexpr size_t SHM_RING_MAX_LANES = 64;
+
+// Each record is a header word holding the datagram's length, then the
+// datagram, padded so the next record starts on an 8-byte boundary. A record
+// never wraps: when one does not fit before the end of the lane, the writer
+// leaves a SHM_RING_WRAP header there and starts it at the beginning.
+constexpr size_t SHM_RING_RECORD_HEADER = 8;
+constexpr uint32_t SHM_RING_WRAP = UINT32_MAX;
+
+inline size_t shmRingRecordBytes(size_t length) {
+    return SHM_RING_RECORD_HEADER + ((length + 7) & ~static_cast<size_t>(7));
+}
+
+struct alignas(CACHE_LINE_SIZE) ShmRingHeader {
+    // Written last by the creator, so a writer that sees the magic sees the rest.
+    std::atomic<uint64_t> magic;
+    uint32_t layout;
+    uint32_t num_lanes;
+    // Bytes of records per lane: a power of two, so offsets are a mask.
+    uint64_t lane_bytes;
+    // The longest datagram a writer may send, so the consumer's largest record
+    // always fits in a lane with room to spare.
+    uint32_t max_datagram;
+};
+
+struct ShmRingLane {
+    // The producer's line: bytes written and published so far, and the pid of
+    // the writer that has claimed the lane (0 if none).
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> writer_pid;
+    // The consumer's line: bytes consumed and released back to the producer.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "lanes are shared between processes");
+
+// One mapping of a ring segment: created by the engine, attached to by writers.
+class ShmRingSegment {
+public:
+    ShmRingSegment() = default;
+    ~ShmRingSegment() { close(); }
+
+    ShmRingSegment(const ShmRingSegment&) = delete;
+    ShmRingSegment& operator=(const ShmRingSegment&) = delete;
+
+    // Creates the segment 'name' (a POSIX shared-memory name such as
+    // "/panoptes_ring", replacing any left over from an earlier run) with
+    // 'num_lanes' empty lanes of 'lane_bytes' each (rounded up to a power of
+    // two), and faults its pages in. Returns false (after printing why) on failure.
+    bool create(const std::string& name, size_t num_lanes, size_t lane_bytes, size_t max_datagram);
+
+    // Maps a segment another process created. Returns false (after printing
+    // why) if it does not exist or has a different layout.
+    bool attach(const std::string& name);
+
+    // Unmaps the segment, and removes it if this mapping created it.
+    void close();
+
+    bool isOpen() const { return memory_ != nullptr; }
+    size_t numLanes() const { return num_lanes_; }
+    size_t laneBytes() const { return lane_bytes_; }
+    size_t maxDatagram() const { return max_datagram_; }
+
+    ShmRingLane& lane(size_t i) const {
+        return *reinterpret_cast<ShmRingLane*>(static_cast<char*>(memory_) + laneOffset(i));
+    }
+    char* records(size_t i) const {
+        return static_cast<char*>(memory_) + laneOffset(i) + sizeof(ShmRingLane);
+    }
+
+private:
+    size_t laneOffset(size_t i) const { return sizeof(ShmRingHeader) + i * (sizeof(ShmRingLane) + lane_bytes_); }
+
+    std::string name_;
+    bool owner_ = false;
+    void* memory_ = nullptr;
+    size_t bytes_ = 0;
+    size_t num_lanes_ = 0;
+    size_t lane_bytes_ = 0;
+    size_t max_datagram_ = 0;
+};
+
+// A sender's side: claims one lane of an engine's segment and writes
+// datagrams into it. One thread per writer.
+class ShmRingWriter {
+public:
+    ShmRingWriter() = default;
+    ~ShmRingWriter() { close(); }
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // Attaches to the segment 'name' and claims lane 'lane'. Returns false
+    // (after printing why) if the segment is missing or a live writer holds
+    // the lane. A lane still claimed by a process that has exited is taken over.
+    bool open(const std::string& name, size_t lane);
+
+    // Publishes anything still staged and gives the lane up.
+    void close();
+
+    size_t maxDatagram() const { return segment_.maxDatagram(); }
+    // How many times tryWrite() found the lane full.
+    uint64_t fullCount() const { return full_count_; }
+
+    // Stages one datagram made of two pieces (a frame header and its messages,
+    // say; 'second' may be empty). The consumer sees it at the next publish().
+    // Returns false if the lane has no room for it yet, after publishing what
+    // is staged so the consumer can make some; the caller retries. Datagrams
+    // longer than maxDatagram() are refused outright, also with false.
+    inline bool tryWrite(const void* first, size_t first_length, const void* second = nullptr,
+                         size_t second_length = 0) {
+        const size_t length = first_length + second_length;
+        if (length > segment_.maxDatagram()) {
+            return false;
+        }
+        // 1. Where the record goes, and how much of the lane's end it skips
+        // when it would not fit there.
+        const uint64_t record = shmRingRecordBytes(length);
+        const uint64_t offset = staged_ & mask_;
+        const uint64_t skip = offset + record > capacity_ ? capacity_ - offset : 0;
+
+        // 2. Room for it, refreshing the consumer's index only when the cached
+        // one says the lane is full.
+        const uint64_t end = staged_ + skip + record;
+        if (end - cached_head_ > capacity_) {
+            cached_head_ = lane_->head.load(std::memory_order_acquire);
+            if (end - cached_head_ > capacity_) {
+                ++full_count_;
+                publish();
+                return false;
+            }
+        }
+
+        // 3. The record itself. Its header is plain memory: the release store
+        // in publish() is what makes it visible.
+        if (skip != 0) {
+            writeHeader(records_ + offset, SHM_RING_WRAP);
+        }
+        char* at = records_ + (skip != 0 ? 0 : offset);
+        std::memcpy(at + SHM_RING_RECORD_HEADER, first, first_length);
+        if (second_length != 0) {
+            std::memcpy(at + SHM_RING_RECORD_HEADER + first_length, second, second_length);
+        }
+        writeHeader(at, static_cast<uint32_t>(length));
+        staged_ = end;
+        return true;
+    }
+
+    // Makes every staged datagram visible to the consumer.
+    inline void publish() {
+        if (staged_ != published_) {
+            lane_->tail.store(staged_, std::memory_order_release);
+            published_ = staged_;
+        }
+    }
+
+private:
+    static void writeHeader(char* at, uint32_t length) { std::memcpy(at, &length, sizeof(length)); }
+
+    ShmRingSegment segment_;
+    ShmRingLane* lane_ = nullptr;
+    char* records_ = nullptr;
+    uint64_t capacity_ = 0;
+    uint64_t mask_ = 0;
+    // Bytes written (staged_) and made visible (published_); both only ever
+    // grow, and equal the lane's tail when the writer opened it.
+    uint64_t staged_ = 0;
+    uint64_t published_ = 0;
+    // The consumer's head as last read.
+    uint64_t cached_head_ = 0;
+    uint64_t full_count_ = 0;
+};
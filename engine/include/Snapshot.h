@@ -0,0 +1,94 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One resting order in a snapshot. 24 bytes, packed.
+#pragma pack(push, 1)
+struct SnapshotOrder {
+    OrderID order_id;
+    Price price;
+    int32_t size;
+    char side;
+    char padding;
+    InstrumentID instrument_id;
+};
+#pragma pack(pop)
+static_assert(sizeof(SnapshotOrder) == 24, "SnapshotOrder layout changed");
+
+// Snapshot file header. The orders follow it, grouped by book, and within each
+// level in time priority (see L1CacheBook::forEachOrder).
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    // Every journal record up to and including this sequence is reflected in
+    // the snapshot; recovery replays only the records after it.
+    uint64_t journal_sequence;
+    uint64_t order_count;
+    uint64_t padding;
+};
+static_assert(sizeof(SnapshotHeader) == 32, "SnapshotHeader layout changed");
+
+constexpr uint32_t SNAPSHOT_MAGIC = 0x50414E53; // "SNAP" read as little-endian bytes.
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+// Writes snapshot files off the book threads.
+//
+// A snapshot is taken in parts, one per book worker: when a worker reaches the
+// snapshot point in its message stream it copies its resting orders into a
+// vector and hands it to submit(), then carries on. Copying is a walk over the
+// live orders only; the file I/O all happens here, on the writer's own thread.
+//
+// Once every part of a snapshot has arrived the writer writes it to a temporary
+// file, fsyncs it and renames it over 'path', so the file on disk is always a
+// complete snapshot.
+class SnapshotWriter {
+public:
+    // 'parts' is the number of submit() calls that make up one snapshot.
+    SnapshotWriter(const std::string& path, size_t parts);
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void start();
+    // Writes any snapshot that is already complete, then joins the thread.
+    void stop();
+
+    // Any thread: adds one part of the snapshot taken at 'journal_sequence'.
+    void submit(uint64_t journal_sequence, std::vector<SnapshotOrder>&& orders);
+
+    // Snapshots written so far, and the journal sequence of the latest one.
+    uint64_t snapshotsWritten() const;
+    uint64_t lastSequence() const;
+
+private:
+    struct Pending {
+        size_t parts = 0;
+        std::vector<SnapshotOrder> orders;
+    };
+
+    void run();
+    bool write(uint64_t journal_sequence, const std::vector<SnapshotOrder>& orders);
+
+    std::string path_;
+    size_t parts_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    bool running_ = false;
+    // Snapshots still waiting for parts, or complete and waiting to be written.
+    std::map<uint64_t, Pending> pending_;
+    uint64_t written_ = 0;
+    uint64_t last_sequence_ = 0;
+};
+
+// Reads a snapshot file. Returns false if it is missing or not a valid snapshot.
+bool loadSnapshot(const std::string& path, SnapshotHeader& header, std::vector<SnapshotOrder>& orders);
@@ -0,0 +1,98 @@
+#pragma once // Standard header guard.
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// The size of a cache line on the x86 CPUs we run on. Data written by different
+// threads is kept on separate lines so the cores do not fight over ownership of
+// the same line (false sharing).
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// A bounded, lock-free, single-producer/single-consumer ring buffer.
+//
+// Exactly one thread may call tryPush() and exactly one other thread may call
+// tryPop(). The producer only writes 'tail_' and the consumer only writes
+// 'head_', so no locks or read-modify-write atomics are needed: each side
+// publishes its progress with a release store and observes the other side's
+// with an acquire load.
+//
+// Each side also keeps a private cached copy of the other side's index and
+// only re-reads the shared one when the cache says the ring is full (producer)
+// or empty (consumer). In steady state that keeps the shared cache lines from
+// bouncing between cores on every message.
+//
+// The consumer also keeps a high-water mark: each time it re-reads the
+// producer's index it notes how many items are queued. That is off the
+// steady-state path, and since the consumer only re-reads once it has caught
+// up with its last view, it sees each backlog at close to its peak.
+template <typename T>
+class SpscRing {
+public:
+    // 'capacity' is rounded up to a power of two so indices can be masked.
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    // Producer side. Returns false if the ring is full.
+    inline bool tryPush(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    inline bool tryPop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+            const size_t queued = cached_tail_ - head;
+            if (queued > high_water_.load(std::memory_order_relaxed)) {
+                high_water_.store(queued, std::memory_order_relaxed);
+            }
+        }
+        item = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate number of queued items. Exact only when both sides are idle.
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // The most items the consumer has found queued (see above). Any thread
+    // may read it.
+    size_t highWaterMark() const { return high_water_.load(std::memory_order_relaxed); }
+
+private:
+    // Consumer-owned line: its read index and its cached view of the producer.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+    std::atomic<size_t> high_water_{0};
+
+    // Producer-owned line: its write index and its cached view of the consumer.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+
+    // Shared, read-only after construction.
+    alignas(CACHE_LINE_SIZE) std::vector<T> slots_;
+    size_t mask_ = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once // Standard header guard.
+
+#include <pthread.h>
+
+// CPU placement and scheduling for the engine's latency-critical threads: the
+// receive thread and the book workers.
+//
+// Pinning keeps a thread's working set in one core's caches and stops the
+// scheduler from migrating it mid-burst. SCHED_FIFO keeps ordinary processes
+// (and most kernel threads) from preempting it. A spinning SCHED_FIFO thread
+// never gives its CPU up, so only use it on CPUs set aside for the engine
+// (isolcpus or a cpuset), one thread per CPU.
+
+// Pins 'thread' to 'cpu'. Returns false (after printing why) on failure.
+bool pinThread(pthread_t thread, int cpu);
+
+// Moves 'thread' to SCHED_FIFO at 'priority' (1..99). Needs CAP_SYS_NICE or a
+// large enough RLIMIT_RTPRIO. Returns false (after printing why) on failure;
+// the thread then keeps its normal scheduling.
+bool setRealtimePriority(pthread_t thread, int priority);
@@ -0,0 +1,55 @@
+#pragma once // Standard header guard.
+
+#include "DataTypes.h"
+#include <cstddef>
+#include <vector>
+
+// A fixed-capacity buffer of records produced by the book: Trades for every
+// fill and, when enabled, LevelUpdates for every level whose volume changes.
+//
+// The storage is allocated once up front. The book appends a record per event;
+// the caller reads them with data()/size() after each message and then calls
+// clear(), which just resets the count. No memory is allocated per event.
+//
+// If the caller falls behind and the buffer fills up, further records are
+// dropped and counted rather than growing the buffer on the hot path.
+template <typename T>
+class BookOutputBuffer {
+public:
+    explicit BookOutputBuffer(size_t capacity)
+        : records_(capacity), size_(0), dropped_count_(0) {}
+
+    inline void push(const T& record) {
+        if (size_ == records_.size()) {
+            ++dropped_count_;
+            return;
+        }
+        records_[size_++] = record;
+    }
+
+    const T* data() const { return records_.data(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t i) const { return records_[i]; }
+
+    // Marks every buffered record as consumed.
+    void clear() { size_ = 0; }
+
+    // Records lost because the buffer was full when they happened.
+    size_t droppedCount() const { return dropped_count_; }
+
+private:
+    std::vector<T> records_;
+    size_t size_;
+    size_t dropped_count_;
+};
+
+class TradeBuffer : public BookOutputBuffer<Trade> {
+public:
+    explicit TradeBuffer(size_t capacity = DEFAULT_TRADE_BUFFER_CAPACITY) : BookOutputBuffer(capacity) {}
+};
+
+class LevelUpdateBuffer : public BookOutputBuffer<LevelUpdate> {
+public:
+    explicit LevelUpdateBuffer(size_t capacity = DEFAULT_LEVEL_UPDATE_BUFFER_CAPACITY) : BookOutputBuffer(capacity) {}
+};
@@ -0,0 +1,50 @@
+#pragma once // Standard header guard.
+
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // For __rdtsc
+#else
+#include <chrono>
+#endif
+
+// Cheap timestamps from the CPU's time-stamp counter.
+//
+// Reading the TSC is a single instruction (~20 cycles) with no syscall or vDSO
+// call, so it can bracket every stage of every message. On the CPUs we run on
+// the TSC is invariant (it ticks at a constant rate, independent of frequency
+// scaling) and synchronised across cores, so ticks taken on different threads
+// can be compared. Call calibrate() once at startup to learn the tick rate.
+//
+// Without a TSC, ARM's virtual counter plays the same part (a single register
+// read at a fixed frequency). Anywhere else the steady clock stands in, and
+// calibrate() finds its ticks are nanoseconds.
+class TscClock {
+public:
+#if defined(__x86_64__) || defined(__i386__)
+    static inline uint64_t now() { return __rdtsc(); }
+#elif defined(__aarch64__)
+    static inline uint64_t now() {
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+    }
+#else
+    static inline uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+#endif
+
+    // Measures the TSC rate against the steady clock. Blocks for about 'sample_ms'.
+    static void calibrate(int sample_ms = 20);
+
+    // Converts a tick difference to nanoseconds (requires calibrate()).
+    static inline int64_t toNanos(uint64_t ticks) {
+        return static_cast<int64_t>(static_cast<double>(ticks) * ns_per_tick_);
+    }
+
+    static double nsPerTick() { return ns_per_tick_; }
+
+private:
+    static double ns_per_tick_;
+};
@@ -0,0 +1,104 @@
+#pragma once // Standard header guard.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+struct UdpReceiverConfig {
+    int port = 12345;
+    // Datagrams fetched per recvmmsg call.
+    size_t batch_size = 64;
+    // Bytes reserved for each datagram in the batch.
+    size_t buffer_size = 2048;
+    // How long receiveBatch() waits for data before reporting a timeout.
+    int timeout_ms = 2000;
+    // Spin on non-blocking receives instead of sleeping in epoll.
+    bool busy_poll = false;
+    // SO_BUSY_POLL budget in microseconds (busy-poll mode only; needs CAP_NET_ADMIN
+    // to raise above the net.core.busy_read sysctl).
+    int busy_poll_usec = 50;
+    // SO_RCVBUF in bytes. 0 keeps the kernel default, except in busy-poll mode,
+    // which asks for BUSY_POLL_RCVBUF so bursts are absorbed while we spin.
+    int rcvbuf_bytes = 0;
+};
+
+// What a receiver has done. Other transports (ShmReceiver) report the same
+// counters, so the engine prints one summary whichever it listens on.
+struct ReceiveStats {
+    uint64_t syscalls = 0;   // epoll_wait + recvmmsg calls
+    uint64_t datagrams = 0;  // Datagrams received.
+    uint64_t batches = 0;    // recvmmsg calls that returned data.
+    uint64_t kernel_drops = 0; // Datagrams the kernel dropped (SO_RXQ_OVFL).
+    uint64_t corrupt_lanes = 0; // Ring lanes abandoned over an impossible record (ShmReceiver).
+};
+
+// Receives UDP datagrams in batches.
+//
+// Instead of one recv() per datagram, receiveBatch() pulls up to batch_size
+// datagrams out of the socket with a single recvmmsg() into buffers that are
+// allocated once, at construction. The caller processes the whole batch before
+// asking for the next one, so syscall cost is spread over many messages.
+//
+// In the default mode the receiver sleeps in epoll_wait() when the socket is
+// empty. In busy-poll mode it never sleeps: it spins on non-blocking
+// recvmmsg() calls, trading a core for lower and steadier wake-up latency.
+//
+// The kernel's count of datagrams dropped because the socket buffer was full
+// is read from SO_RXQ_OVFL, which is attached to every received datagram.
+class UdpReceiver {
+public:
+    // In busy-poll mode the socket buffer is raised to this unless configured.
+    static constexpr int BUSY_POLL_RCVBUF = 8 * 1024 * 1024;
+
+    using Stats = ReceiveStats;
+
+    explicit UdpReceiver(const UdpReceiverConfig& config);
+    ~UdpReceiver();
+
+    UdpReceiver(const UdpReceiver&) = delete;
+    UdpReceiver& operator=(const UdpReceiver&) = delete;
+
+    // Creates and binds the socket. Returns false (after printing why) on failure.
+    bool open();
+
+    // Waits for data and receives up to batch_size datagrams.
+    // Returns the number received, 0 on timeout, or -1 on error.
+    int receiveBatch();
+
+    // The i-th datagram of the last batch.
+    inline const char* data(size_t i) const { return buffers_.data() + i * config_.buffer_size; }
+    inline size_t length(size_t i) const { return headers_[i].msg_len; }
+    // Who sent it: the IPv4 address and port, packed into 48 bits.
+    inline uint64_t source(size_t i) const {
+        return (static_cast<uint64_t>(sources_[i].sin_addr.s_addr) << 16) | sources_[i].sin_port;
+    }
+
+    const Stats& stats() const { return stats_; }
+
+    // Brings stats().kernel_drops up to date with drops that happened after the
+    // last received datagram. This is a syscall, so call it off the hot path.
+    void refreshKernelDrops();
+
+private:
+    // Waits until the socket is readable (epoll mode).
+    // Returns 1 if readable, 0 on timeout or signal, -1 on error.
+    int waitReadable();
+    int receiveOnce(int flags);
+
+    UdpReceiverConfig config_;
+    int sock_fd_ = -1;
+    int epoll_fd_ = -1;
+    // True when the last batch was full, i.e. there is probably more data queued
+    // and we can skip epoll_wait for the next one.
+    bool maybe_more_ = false;
+
+    // All of these are sized once in the constructor and reused for every batch.
+    std::vector<char> buffers_;
+    std::vector<char> control_;
+    std::vector<struct iovec> iovecs_;
+    std::vector<struct mmsghdr> headers_;
+    std::vector<sockaddr_in> sources_;
+    Stats stats_;
+};
@@ -0,0 +1,83 @@
+#pragma once // Standard header guard.
+
+#include "BinaryParser.h" // For fromLittleEndian
+#include "DataTypes.h"
+#include <cstddef>
+#include <cstdint>
+
+// Wire formats accepted by the engine.
+//
+// v1: a datagram is exactly one 32-byte PanoptesMessage, with no framing.
+//     Still accepted so old senders keep working, but a lost datagram cannot
+//     be noticed.
+//
+// v2: a datagram is a FrameHeader followed by 'message_count' PanoptesMessages
+//     back to back. Each sender numbers the messages of each of its streams
+//     1, 2, 3, ... and 'first_sequence' is the number of the first message in
+//     the frame, so the receiver can tell when it has missed or repeated some
+//     (see SequenceTracker.h). A new session ID means the sender restarted and
+//     its numbering starts again.
+//
+// A datagram of exactly sizeof(PanoptesMessage) bytes is v1; anything else must
+// be a well-formed v2 frame. Every integer is little-endian, like the messages.
+constexpr uint32_t FRAME_MAGIC = 0x32584E50; // "PNX2" read as little-endian bytes.
+constexpr uint8_t FRAME_VERSION = 2;
+
+// Frame flags.
+constexpr uint8_t FRAME_FLAG_RETRANSMIT = 0x01; // Resent in answer to a RetransmitRequest.
+
+#pragma pack(push, 1)
+struct FrameHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t message_count;
+    uint32_t session_id;
+    uint16_t stream_id;
+    uint16_t reserved;
+    uint64_t first_sequence;
+};
+#pragma pack(pop)
+static_assert(sizeof(FrameHeader) == 24, "FrameHeader must stay 24 bytes on the wire");
+
+// Messages per frame that keep a datagram within a 1500-byte Ethernet MTU.
+constexpr size_t DEFAULT_FRAME_MESSAGES = 40;
+
+// Sent by the engine to a sender's recovery service to ask for messages
+// [first_sequence, first_sequence + count) of one stream again. The service
+// answers with ordinary v2 frames flagged FRAME_FLAG_RETRANSMIT, sent back to
+// the address the request came from.
+constexpr uint32_t RETRANSMIT_MAGIC = 0x52584E50; // "PNXR" read as little-endian bytes.
+
+#pragma pack(push, 1)
+struct RetransmitRequest {
+    uint32_t magic;
+    uint16_t stream_id;
+    uint16_t reserved;
+    uint32_t session_id;
+    uint32_t count;
+    uint64_t first_sequence;
+};
+#pragma pack(pop)
+static_assert(sizeof(RetransmitRequest) == 24, "RetransmitRequest must stay 24 bytes on the wire");
+
+// Converts every field of a frame header or retransmit request between wire
+// and host byte order, in place. The swap is its own inverse, so the same call
+// serves both directions; on little-endian hosts it compiles to nothing.
+inline void swapWireByteOrder(FrameHeader& header) {
+    header.magic = fromLittleEndian(header.magic);
+    header.message_count = fromLittleEndian(header.message_count);
+    header.session_id = fromLittleEndian(header.session_id);
+    header.stream_id = fromLittleEndian(header.stream_id);
+    header.reserved = fromLittleEndian(header.reserved);
+    header.first_sequence = fromLittleEndian(header.first_sequence);
+}
+
+inline void swapWireByteOrder(RetransmitRequest& request) {
+    request.magic = fromLittleEndian(request.magic);
+    request.stream_id = fromLittleEndian(request.stream_id);
+    request.reserved = fromLittleEndian(request.reserved);
+    request.session_id = fromLittleEndian(request.session_id);
+    request.count = fromLittleEndian(request.count);
+    request.first_sequence = fromLittleEndian(request.first_sequence);
+}
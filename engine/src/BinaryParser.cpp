@@ -2,19 +2,279 @@
 #include <cstring>     // For std::memcpy
 #include "BinaryParser.h"
 
-// This is the core parser function.
-// It takes a pointer to a raw character buffer from the network
-// and returns a PanoptesMessage struct.
+// The SSE4.2 and AVX2 parsers exist only on x86. Elsewhere only the scalar
+// parser is built, and every ParserIsa falls back to it.
+#if defined(__x86_64__) || defined(__i386__)
+#define PANOPTES_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define PANOPTES_X86_SIMD 0
+#endif
+
+// Byte offsets of the fields we validate within a 32-byte wire message.
+static_assert(offsetof(PanoptesMessage, price) == 16, "validation assumes price at byte 16");
+static_assert(offsetof(PanoptesMessage, size) == 24, "validation assumes size at byte 24");
+static_assert(offsetof(PanoptesMessage, event_type) == 28, "validation assumes event_type at byte 28");
+static_assert(offsetof(PanoptesMessage, side) == 29, "validation assumes side at byte 29");
+
+// Decodes one message from the wire.
 PanoptesMessage parseMessage(const char* buffer) {
-    // Here, we use reinterpret_cast to tell the compiler:
-    // "Treat this block of memory at 'buffer' as if it were a PanoptesMessage struct."
-    // This is extremely fast because it involves no copying or processing of individual fields.
-    // It simply re-interprets the raw bytes.
-    //
-    // WARNING: It only works because:
-    // 1. We have guaranteed the memory layout with #pragma pack(push, 1).
-    // 2. The sender (Thrasher) and receiver (Engine) are compiled on the same
-    //    architecture (ie. "endianness").
-    const PanoptesMessage* msg = reinterpret_cast<const PanoptesMessage*>(buffer);
-    return *msg;
+    // The memory layout is fixed with #pragma pack(push, 1) and the wire is
+    // little-endian, so on a little-endian host the message is just its bytes.
+    // memcpy (rather than dereferencing a cast pointer) is safe at any alignment
+    // and compiles to the same two 16-byte moves.
+    PanoptesMessage msg;
+    std::memcpy(&msg, buffer, sizeof(msg));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    msg.timestamp = static_cast<Timestamp>(fromLittleEndian(static_cast<uint64_t>(msg.timestamp)));
+    msg.order_id = fromLittleEndian(msg.order_id);
+    msg.price = static_cast<Price>(fromLittleEndian(static_cast<uint64_t>(msg.price)));
+    msg.size = static_cast<int32_t>(fromLittleEndian(static_cast<uint32_t>(msg.size)));
+    msg.instrument_id = fromLittleEndian(msg.instrument_id);
+#endif
+    return msg;
+}
+
+namespace {
+
+// Reject reasons, in the order they are checked.
+enum Verdict { Valid, BadEventType, BadSide, BadSize, BadPrice };
+
+inline Verdict classify(const PanoptesMessage& msg, const ParseLimits& limits) {
+    const char event = msg.event_type;
+    if (event != 'A' && event != 'X' && event != 'E' && event != 'M') {
+        return BadEventType;
+    }
+    if (msg.side != 'B' && msg.side != 'A') {
+        return BadSide;
+    }
+    if (event != 'X' && (msg.size <= 0 || msg.size > limits.max_size)) {
+        return BadSize;
+    }
+    if ((event == 'A' || event == 'M') && (msg.price < limits.min_price || msg.price > limits.max_price)) {
+        return BadPrice;
+    }
+    return Valid;
+}
+
+size_t parseScalar(const char* buffer, size_t count, PanoptesMessage* out, ParseStats& stats,
+                   const ParseLimits& limits) {
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const PanoptesMessage msg = parseMessage(buffer + i * sizeof(PanoptesMessage));
+        switch (classify(msg, limits)) {
+            case Valid: out[written++] = msg; break;
+            case BadEventType: ++stats.bad_event_type; break;
+            case BadSide: ++stats.bad_side; break;
+            case BadSize: ++stats.bad_size; break;
+            case BadPrice: ++stats.bad_price; break;
+        }
+    }
+    stats.accepted += written;
+    return written;
+}
+
+#if PANOPTES_X86_SIMD
+
+// Turns the per-message pass/fail bits of one block into counts, then copies
+// the valid messages out. Bit k of each mask is message k of the block.
+//
+// Every message is stored and the output position only advances past the
+// valid ones, so there is no branch on validity. That needs no extra room in
+// 'out': a message is only ever written at or before its own index.
+template <unsigned Width>
+inline size_t emitBlock(const char* block, unsigned event_ok, unsigned side_ok, unsigned size_ok, unsigned price_ok,
+                        PanoptesMessage* out, ParseStats& stats) {
+    constexpr unsigned all = (1u << Width) - 1;
+    const unsigned valid = event_ok & side_ok & size_ok & price_ok & all;
+    stats.bad_event_type += __builtin_popcount(~event_ok & all);
+    stats.bad_side += __builtin_popcount(event_ok & ~side_ok & all);
+    stats.bad_size += __builtin_popcount(event_ok & side_ok & ~size_ok & all);
+    stats.bad_price += __builtin_popcount(event_ok & side_ok & size_ok & ~price_ok & all);
+
+    size_t written = 0;
+#pragma GCC unroll 8
+    for (unsigned k = 0; k < Width; ++k) {
+        std::memcpy(&out[written], block + k * sizeof(PanoptesMessage), sizeof(PanoptesMessage));
+        written += (valid >> k) & 1;
+    }
+    return written;
+}
+
+// Both SIMD versions load the second half of each message (price, size, and
+// the event/side/instrument word) and transpose so each register holds one
+// field of several messages. The checks are then a handful of compares per
+// block, whatever the mix of valid and invalid messages.
+
+__attribute__((target("sse4.2")))
+size_t parseSse42(const char* buffer, size_t count, PanoptesMessage* out, ParseStats& stats,
+                  const ParseLimits& limits) {
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    const __m128i add = _mm_set1_epi32('A');
+    const __m128i cancel = _mm_set1_epi32('X');
+    const __m128i execute = _mm_set1_epi32('E');
+    const __m128i modify = _mm_set1_epi32('M');
+    const __m128i bid = _mm_set1_epi32('B');
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max_size = _mm_set1_epi32(limits.max_size);
+    const __m128i min_price = _mm_set1_epi64x(limits.min_price);
+    const __m128i max_price = _mm_set1_epi64x(limits.max_price);
+
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const char* block = buffer + i * sizeof(PanoptesMessage);
+        // Each register: [price lo, price hi, size, event|side|instrument] of one message.
+        const __m128i m0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+        const __m128i m1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48));
+        const __m128i m2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 80));
+        const __m128i m3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 112));
+
+        const __m128i hi01 = _mm_unpackhi_epi32(m0, m1); // size0 size1 word0 word1
+        const __m128i hi23 = _mm_unpackhi_epi32(m2, m3);
+        const __m128i size = _mm_unpacklo_epi64(hi01, hi23);
+        const __m128i word = _mm_unpackhi_epi64(hi01, hi23);
+        const __m128i price01 = _mm_unpacklo_epi64(m0, m1);
+        const __m128i price23 = _mm_unpacklo_epi64(m2, m3);
+
+        const __m128i event = _mm_and_si128(word, byte_mask);
+        const __m128i side = _mm_and_si128(_mm_srli_epi32(word, 8), byte_mask);
+        const __m128i is_add = _mm_cmpeq_epi32(event, add);
+        const __m128i is_cancel = _mm_cmpeq_epi32(event, cancel);
+        const __m128i is_modify = _mm_cmpeq_epi32(event, modify);
+        const __m128i event_ok = _mm_or_si128(_mm_or_si128(is_add, is_cancel),
+                                              _mm_or_si128(_mm_cmpeq_epi32(event, execute), is_modify));
+        const __m128i side_ok = _mm_or_si128(_mm_cmpeq_epi32(side, bid), _mm_cmpeq_epi32(side, add));
+        const __m128i size_in_range = _mm_andnot_si128(_mm_cmpgt_epi32(size, max_size), _mm_cmpgt_epi32(size, zero));
+        const __m128i size_ok = _mm_or_si128(size_in_range, is_cancel);
+
+        // A price is bad if it is below the minimum or above the maximum.
+        const unsigned price_bad =
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(_mm_cmpgt_epi64(min_price, price01),
+                                                          _mm_cmpgt_epi64(price01, max_price)))) |
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(_mm_cmpgt_epi64(min_price, price23),
+                                                          _mm_cmpgt_epi64(price23, max_price)))) << 2;
+        // Only adds and modifies carry a price the book uses.
+        const unsigned priced = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(is_add, is_modify)));
+
+        written += emitBlock<4>(block, _mm_movemask_ps(_mm_castsi128_ps(event_ok)),
+                                _mm_movemask_ps(_mm_castsi128_ps(side_ok)), _mm_movemask_ps(_mm_castsi128_ps(size_ok)),
+                                ~(priced & price_bad), out + written, stats);
+    }
+    stats.accepted += written;
+    return written + parseScalar(buffer + i * sizeof(PanoptesMessage), count - i, out + written, stats, limits);
+}
+
+__attribute__((target("avx2")))
+size_t parseAvx2(const char* buffer, size_t count, PanoptesMessage* out, ParseStats& stats,
+                 const ParseLimits& limits) {
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i add = _mm256_set1_epi32('A');
+    const __m256i cancel = _mm256_set1_epi32('X');
+    const __m256i execute = _mm256_set1_epi32('E');
+    const __m256i modify = _mm256_set1_epi32('M');
+    const __m256i bid = _mm256_set1_epi32('B');
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_size = _mm256_set1_epi32(limits.max_size);
+    const __m256i min_price = _mm256_set1_epi64x(limits.min_price);
+    const __m256i max_price = _mm256_set1_epi64x(limits.max_price);
+
+    auto half = [](const char* message) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(message + 16));
+    };
+
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const char* block = buffer + i * sizeof(PanoptesMessage);
+        // Register k holds message k in its low lane and message k + 4 in its
+        // high lane, so the in-lane unpacks below give lanes in message order.
+        const __m256i r0 = _mm256_set_m128i(half(block + 4 * 32), half(block + 0 * 32));
+        const __m256i r1 = _mm256_set_m128i(half(block + 5 * 32), half(block + 1 * 32));
+        const __m256i r2 = _mm256_set_m128i(half(block + 6 * 32), half(block + 2 * 32));
+        const __m256i r3 = _mm256_set_m128i(half(block + 7 * 32), half(block + 3 * 32));
+
+        const __m256i hi01 = _mm256_unpackhi_epi32(r0, r1);
+        const __m256i hi23 = _mm256_unpackhi_epi32(r2, r3);
+        const __m256i size = _mm256_unpacklo_epi64(hi01, hi23);  // Messages 0-3 | 4-7.
+        const __m256i word = _mm256_unpackhi_epi64(hi01, hi23);
+        const __m256i price01 = _mm256_unpacklo_epi64(r0, r1);    // Messages 0, 1 | 4, 5.
+        const __m256i price23 = _mm256_unpacklo_epi64(r2, r3);    // Messages 2, 3 | 6, 7.
+
+        const __m256i event = _mm256_and_si256(word, byte_mask);
+        const __m256i side = _mm256_and_si256(_mm256_srli_epi32(word, 8), byte_mask);
+        const __m256i is_add = _mm256_cmpeq_epi32(event, add);
+        const __m256i is_cancel = _mm256_cmpeq_epi32(event, cancel);
+        const __m256i is_modify = _mm256_cmpeq_epi32(event, modify);
+        const __m256i event_ok = _mm256_or_si256(_mm256_or_si256(is_add, is_cancel),
+                                                 _mm256_or_si256(_mm256_cmpeq_epi32(event, execute), is_modify));
+        const __m256i side_ok = _mm256_or_si256(_mm256_cmpeq_epi32(side, bid), _mm256_cmpeq_epi32(side, add));
+        const __m256i size_in_range = _mm256_andnot_si256(_mm256_cmpgt_epi32(size, max_size),
+                                                          _mm256_cmpgt_epi32(size, zero));
+        const __m256i size_ok = _mm256_or_si256(size_in_range, is_cancel);
+
+        const unsigned bad01 = _mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_cmpgt_epi64(min_price, price01), _mm256_cmpgt_epi64(price01, max_price))));
+        const unsigned bad23 = _mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_cmpgt_epi64(min_price, price23), _mm256_cmpgt_epi64(price23, max_price))));
+        // Back into message order: bits 0,1 and 2,3 of each mask are the low and high lanes.
+        const unsigned price_bad = (bad01 & 3) | (bad23 & 3) << 2 | (bad01 >> 2) << 4 | (bad23 >> 2) << 6;
+        const unsigned priced = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(is_add, is_modify)));
+
+        written += emitBlock<8>(block, _mm256_movemask_ps(_mm256_castsi256_ps(event_ok)),
+                                _mm256_movemask_ps(_mm256_castsi256_ps(side_ok)),
+                                _mm256_movemask_ps(_mm256_castsi256_ps(size_ok)), ~(priced & price_bad),
+                                out + written, stats);
+    }
+    // Back to code built without AVX: clear the upper halves first, or every
+    // SSE instruction after this pays for merging them.
+    _mm256_zeroupper();
+    stats.accepted += written;
+    return written + parseScalar(buffer + i * sizeof(PanoptesMessage), count - i, out + written, stats, limits);
+}
+
+#endif // PANOPTES_X86_SIMD
+
+bool cpuSupports(ParserIsa isa) {
+    switch (isa) {
+#if PANOPTES_X86_SIMD
+        case ParserIsa::Avx2: return __builtin_cpu_supports("avx2");
+        case ParserIsa::Sse42: return __builtin_cpu_supports("sse4.2");
+#else
+        case ParserIsa::Avx2:
+        case ParserIsa::Sse42: return false;
+#endif
+        case ParserIsa::Scalar: default: return true;
+    }
+}
+
+} // namespace
+
+ParserIsa bestParserIsa() {
+    static const ParserIsa best = cpuSupports(ParserIsa::Avx2)    ? ParserIsa::Avx2
+                                  : cpuSupports(ParserIsa::Sse42) ? ParserIsa::Sse42
+                                                                  : ParserIsa::Scalar;
+    return best;
+}
+
+size_t parseBatchWith(ParserIsa isa, const char* buffer, size_t count, PanoptesMessage* out,
+                      ParseStats& stats, const ParseLimits& limits) {
+#if PANOPTES_X86_SIMD && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // The SIMD paths read fields straight from the wire bytes.
+    if (cpuSupports(isa)) {
+        switch (isa) {
+            case ParserIsa::Avx2: return parseAvx2(buffer, count, out, stats, limits);
+            case ParserIsa::Sse42: return parseSse42(buffer, count, out, stats, limits);
+            case ParserIsa::Scalar: break;
+        }
+    }
+#else
+    (void)isa; // Only the scalar parser is built here.
+#endif
+    return parseScalar(buffer, count, out, stats, limits);
+}
+
+size_t parseBatch(const char* buffer, size_t count, PanoptesMessage* out, ParseStats& stats,
+                  const ParseLimits& limits) {
+    return parseBatchWith(bestParserIsa(), buffer, count, out, stats, limits);
 }
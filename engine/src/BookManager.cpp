@@ -0,0 +1,318 @@
+#include "BookManager.h"
+#include "CpuRelax.h"
+#include "ThreadTuning.h"
+#include "TscClock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sched.h>
+
+BookManager::BookManager(const BookManagerConfig& config) : config_(config) {
+    const size_t num_workers = config_.num_workers == 0 ? 1 : config_.num_workers;
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(config_.queue_capacity));
+        workers_.back()->books.resize((MAX_INSTRUMENTS + num_workers - 1) / num_workers);
+        workers_.back()->md_stale.resize(workers_.back()->books.size());
+    }
+}
+
+BookManager::~BookManager() {
+    stop();
+}
+
+void BookManager::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&BookManager::run, this, i);
+
+        // Pin each worker to its own core so its books stay in that core's caches.
+        if (config_.first_cpu >= 0) {
+            pinThread(workers_[i]->thread.native_handle(), config_.first_cpu + static_cast<int>(i));
+        }
+        if (config_.rt_priority > 0) {
+            setRealtimePriority(workers_[i]->thread.native_handle(), config_.rt_priority);
+        }
+    }
+}
+
+void BookManager::stop() {
+    // Workers only exit once their ring is empty, so everything submitted before
+    // this call is processed.
+    running_.store(false, std::memory_order_release);
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void BookManager::run(size_t worker_index) {
+    Worker& worker = *workers_[worker_index];
+    const size_t num_workers = workers_.size();
+    PanoptesMessage msg;
+    uint64_t processed = 0;
+    uint64_t trades = 0;
+    MarketDataPublisher* publisher = config_.publisher;
+    SharedBookView* book_view = config_.book_view;
+    uint64_t view_publishes = 0;
+    // Counters are per thread, so the probe is opened here, on the worker.
+    PerfProbe perf(config_.perf, worker.perf);
+    perf.open();
+    uint32_t idle_polls = 0;
+
+    while (true) {
+        if (!worker.queue.tryPop(msg)) {
+            // Nothing queued. Check for shutdown only when idle, after a final
+            // look at the ring, so no message submitted before stop() is lost.
+            if (!running_.load(std::memory_order_acquire) && worker.queue.size() == 0) {
+                break;
+            }
+            if (!worker.md_stale_slots.empty()) {
+                resyncMarketData(worker_index);
+            }
+            waitForWork(idle_polls);
+            if (idle_polls != UINT32_MAX) {
+                ++idle_polls;
+            }
+            continue;
+        }
+        idle_polls = 0;
+
+        if (msg.event_type == SNAPSHOT_MARKER) {
+            takeSnapshot(worker_index, static_cast<uint64_t>(msg.timestamp));
+            continue;
+        }
+
+        // 1. Find (or create) the book for this instrument.
+        std::unique_ptr<OrderBook>& book = worker.books[msg.instrument_id / num_workers];
+        if (!book) {
+            book = makeOrderBook(config_.variant, config_.pool_config, DEFAULT_INDEX_LOAD_FACTOR,
+                                 config_.ladders.forInstrument(msg.instrument_id));
+            if (publisher || book_view) {
+                book->enableLevelUpdates();
+            }
+        }
+
+        // 2. Apply the message, timing it if requested. A sampled message's
+        // counter reads sit outside the timed interval, so they do not
+        // show up in the latency histograms.
+        const bool sampled = perf.sample();
+        if (sampled) {
+            perf.begin();
+        }
+        const uint64_t start = config_.measure_latency ? TscClock::now() : 0;
+        book->apply(msg);
+        const uint64_t end = config_.measure_latency ? TscClock::now() : 0;
+        if (sampled) {
+            perf.end(PerfStage::BookUpdate, msg.event_type);
+        }
+        if (config_.measure_latency) {
+            worker.latency.at(LatencyStage::BookUpdate, msg.event_type).record(TscClock::toNanos(end - start));
+            // submit() stamped the queued copy. A sampled message's counter
+            // read is in this interval, so it is left out.
+            if (!sampled) {
+                worker.latency.at(LatencyStage::Handoff, msg.event_type)
+                    .record(TscClock::toNanos(start - static_cast<uint64_t>(msg.timestamp)));
+            }
+        }
+        trades += book->trades().size();
+        book->trades().clear();
+
+        // 3. Republish the book's shared-memory view if the message changed a
+        // level it shows. Most messages do not, and cost a compare per change.
+        LevelUpdateBuffer& updates = book->levelUpdates();
+        if (book_view && !updates.empty()) {
+            const uint64_t now = config_.measure_latency ? end : TscClock::now();
+            view_publishes += book_view->update(msg.instrument_id, *book, updates.data(), updates.size(), now);
+        }
+
+        // 4. Hand this message's level changes to the market data publisher.
+        if (publisher) {
+            // publish() never blocks: if the publisher has fallen behind, the
+            // update is dropped (and counted there) rather than stalling the
+            // book, and the book is marked to be resent whole.
+            const size_t slot = msg.instrument_id / num_workers;
+            for (size_t i = 0; i < updates.size(); ++i) {
+                LevelUpdate update = updates[i];
+                update.instrument_id = msg.instrument_id;
+                if (!publisher->publish(worker_index, update) && !worker.md_stale[slot]) {
+                    worker.md_stale[slot] = 1;
+                    worker.md_stale_slots.push_back(slot);
+                }
+            }
+            if (!worker.md_stale_slots.empty()) {
+                resyncMarketData(worker_index);
+            }
+        }
+        updates.clear();
+
+        // 5. Publish progress. Relaxed stores are enough for counters.
+        worker.processed.store(++processed, std::memory_order_relaxed);
+        worker.trades.store(trades, std::memory_order_relaxed);
+        worker.view_publishes.store(view_publishes, std::memory_order_relaxed);
+    }
+}
+
+void BookManager::resyncMarketData(size_t worker_index) {
+    Worker& worker = *workers_[worker_index];
+    MarketDataPublisher& publisher = *config_.publisher;
+    const size_t num_workers = workers_.size();
+    std::vector<BestPrice>& depth = worker.md_depth;
+    std::vector<LevelUpdate>& levels = worker.md_levels;
+    while (!worker.md_stale_slots.empty()) {
+        // 1. Wait for the ring to drain, and for room for at least as many
+        // levels as this book was last found to hold. Both are a compare.
+        const size_t room = publisher.resyncRoom(worker_index);
+        if (room == 0 || room < worker.md_resync_need) {
+            return;
+        }
+
+        // 2. Read every level of both sides, as the book holds them between
+        // messages, but never more than the room plus one: one more level
+        // than fits is enough to know the book does not fit yet.
+        const size_t slot = worker.md_stale_slots.back();
+        const OrderBook& book = *worker.books[slot];
+        const InstrumentID instrument = static_cast<InstrumentID>(slot * num_workers + worker_index);
+        levels.clear();
+        for (const char side : {'B', 'A'}) {
+            const size_t limit = room + 1 - levels.size();
+            depth.resize(std::max<size_t>(depth.size(), 64));
+            size_t count;
+            while ((count = book.depth(side, depth.data(), std::min(depth.size(), limit))) == depth.size() &&
+                   depth.size() < limit) {
+                depth.resize(std::min(2 * depth.size(), limit));
+            }
+            for (size_t i = 0; i < count; ++i) {
+                levels.push_back({depth[i].price, depth[i].volume, side, 0, instrument});
+            }
+            if (levels.size() > room) {
+                break;
+            }
+        }
+
+        // 3. A book that does not fit waits for more room. One deeper than the
+        // whole ring never fits, so it is left as it is rather than read again
+        // after every message; a later drop marks it stale again.
+        if (levels.size() > room) {
+            if (room < publisher.maxResyncLevels(worker_index)) {
+                worker.md_resync_need = room + 1;
+                return;
+            }
+            fprintf(stderr, "Instrument %u has more levels than the market data ring holds; it cannot be resent\n",
+                    static_cast<unsigned>(instrument));
+        } else if (!publisher.publishResync(worker_index, instrument, levels.data(), levels.size())) {
+            return; // Still no room; the next message or idle poll tries again.
+        }
+        worker.md_stale[slot] = 0;
+        worker.md_stale_slots.pop_back();
+        worker.md_resync_need = 0;
+    }
+}
+
+void BookManager::waitForWork(uint32_t idle_polls) const {
+    // 1. Spin. The pause keeps the loop from flooding the pipeline (and the
+    // sibling hyperthread) with speculative loads of the ring index.
+    if (config_.idle == WorkerIdlePolicy::Spin || idle_polls < config_.backoff_spins) {
+        cpuRelax();
+        return;
+    }
+    // 2. Let anything else runnable on this CPU have it, but stay runnable.
+    if (idle_polls - config_.backoff_spins < config_.backoff_yields) {
+        sched_yield();
+        return;
+    }
+    // 3. The feed has gone quiet: sleep between polls.
+    std::this_thread::sleep_for(std::chrono::microseconds(config_.backoff_sleep_us));
+}
+
+void BookManager::requestSnapshot(uint64_t journal_sequence) {
+    PanoptesMessage marker{};
+    marker.timestamp = static_cast<Timestamp>(journal_sequence);
+    marker.event_type = SNAPSHOT_MARKER;
+    for (auto& worker : workers_) {
+        while (!worker->queue.tryPush(marker)) {
+            ++worker->producer_stalls;
+        }
+    }
+}
+
+void BookManager::takeSnapshot(size_t worker_index, uint64_t journal_sequence) const {
+    if (config_.snapshot_writer == nullptr) {
+        return;
+    }
+    const Worker& worker = *workers_[worker_index];
+    const size_t num_workers = workers_.size();
+    std::vector<SnapshotOrder> orders;
+    for (size_t slot = 0; slot < worker.books.size(); ++slot) {
+        const OrderBook* book = worker.books[slot].get();
+        if (!book) {
+            continue;
+        }
+        // Undo the partitioning: book 'slot' of worker w is instrument slot * n + w.
+        const InstrumentID instrument = static_cast<InstrumentID>(slot * num_workers + worker_index);
+        orders.reserve(orders.size() + book->restingOrderCount());
+        book->visitOrders([&](OrderID id, Price price, int32_t size, char side) {
+            orders.push_back({id, price, size, side, 0, instrument});
+        });
+    }
+    config_.snapshot_writer->submit(journal_sequence, std::move(orders));
+}
+
+uint64_t BookManager::messagesProcessed() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->processed.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t BookManager::tradesProduced() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->trades.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t BookManager::viewPublishes() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->view_publishes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t BookManager::producerStalls() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->producer_stalls;
+    }
+    return total;
+}
+
+size_t BookManager::ringHighWaterMark() const {
+    size_t deepest = 0;
+    for (const auto& worker : workers_) {
+        deepest = std::max(deepest, worker->queue.highWaterMark());
+    }
+    return deepest;
+}
+
+void BookManager::collectLatency(LatencyReport& report) const {
+    for (const auto& worker : workers_) {
+        report.merge(worker->latency);
+    }
+}
+
+void BookManager::collectPerf(PerfReport& report) const {
+    for (const auto& worker : workers_) {
+        report.merge(worker->perf);
+    }
+}
+
+const OrderBook* BookManager::book(InstrumentID instrument) const {
+    const Worker& worker = *workers_[workerFor(instrument)];
+    return worker.books[instrument / workers_.size()].get();
+}
@@ -0,0 +1,277 @@
+#include "BookView.h"
+#include "CpuRelax.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t headerBytes() { return sizeof(BookViewHeader); }
+
+inline size_t segmentBytes(size_t num_instruments) {
+    return headerBytes() + num_instruments * sizeof(BookViewSlot);
+}
+
+// Where each side's levels start in a BookView, and the size of a level, in
+// words. A level is its price word, then its volume word.
+constexpr size_t BIDS_WORD = offsetof(BookView, bids) / sizeof(uint64_t);
+constexpr size_t ASKS_WORD = offsetof(BookView, asks) / sizeof(uint64_t);
+constexpr size_t LEVEL_WORDS = sizeof(BestPrice) / sizeof(uint64_t);
+
+static_assert(offsetof(BookView, bid_levels) == sizeof(uint64_t) && offsetof(BookView, ask_levels) == 12 &&
+                  BIDS_WORD == 2 && offsetof(BestPrice, price) == 0 && LEVEL_WORDS == 2,
+              "write() stores the counts as one word and patches a level's second word");
+
+// The index of the level at 'price' in one side of a published view, or -1.
+// Only the writer calls this, so the relaxed loads read its own stores.
+int findLevel(const BookViewSlot& slot, size_t side_word, uint32_t levels, Price price) {
+    for (uint32_t k = 0; k < levels; ++k) {
+        const uint64_t word = slot.words[side_word + k * LEVEL_WORDS].load(std::memory_order_relaxed);
+        if (static_cast<Price>(word) == price) {
+            return static_cast<int>(k);
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+bool SharedBookView::create(const std::string& name, size_t num_instruments, double ns_per_tick) {
+    close();
+    if (num_instruments == 0 || num_instruments > MAX_INSTRUMENTS) {
+        num_instruments = MAX_INSTRUMENTS;
+    }
+
+    // 1. Create the segment afresh, so a reader can never see a stale layout.
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return false;
+    }
+    const size_t bytes = segmentBytes(num_instruments);
+    if (ftruncate(fd, static_cast<off_t>(bytes)) < 0) {
+        perror("ftruncate failed");
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the segment alive.
+    if (mapped == MAP_FAILED) {
+        perror("mmap failed");
+        shm_unlink(name.c_str());
+        return false;
+    }
+    name_ = name;
+    memory_ = mapped;
+    bytes_ = bytes;
+    num_instruments_ = num_instruments;
+
+    // 2. Set every slot up as never published: sequence 0, and a range that
+    // makes the first change on either side show. This also faults in every
+    // page now rather than on some book thread's first publish.
+    slots_ = reinterpret_cast<BookViewSlot*>(static_cast<char*>(memory_) + headerBytes());
+    for (size_t i = 0; i < num_instruments; ++i) {
+        BookViewSlot* slot = new (&slots_[i]) BookViewSlot;
+        slot->sequence.store(0, std::memory_order_relaxed);
+        slot->worst_bid = INT64_MIN;
+        slot->worst_ask = INT64_MAX;
+        slot->bid_levels = 0;
+        slot->ask_levels = 0;
+    }
+
+    // 3. Fill in the header, and the magic last so readers see all of it.
+    BookViewHeader* header = new (memory_) BookViewHeader;
+    header->layout = BOOK_VIEW_LAYOUT;
+    header->depth = static_cast<uint32_t>(BOOK_VIEW_DEPTH);
+    header->num_instruments = static_cast<uint32_t>(num_instruments);
+    header->slot_bytes = static_cast<uint32_t>(sizeof(BookViewSlot));
+    header->ns_per_tick = ns_per_tick;
+    header->magic.store(BOOK_VIEW_MAGIC, std::memory_order_release);
+    return true;
+}
+
+void SharedBookView::close() {
+    if (memory_ != nullptr) {
+        munmap(memory_, bytes_);
+        shm_unlink(name_.c_str());
+    }
+    memory_ = nullptr;
+    bytes_ = 0;
+    slots_ = nullptr;
+    num_instruments_ = 0;
+}
+
+SharedBookView::Changes SharedBookView::classify(const BookViewSlot& slot, const LevelUpdate* changes, size_t count) {
+    Changes what{false, false, false};
+    for (size_t i = 0; i < count; ++i) {
+        const LevelUpdate& change = changes[i];
+        const bool bid = change.side == 'B';
+        if (bid ? change.price < slot.worst_bid : change.price > slot.worst_ask) {
+            continue; // Behind the view.
+        }
+        what.shown = true;
+        bool& reread = bid ? what.reread_bids : what.reread_asks;
+        if (!reread && (change.total_volume == 0 ||
+                        findLevel(slot, bid ? BIDS_WORD : ASKS_WORD, bid ? slot.bid_levels : slot.ask_levels,
+                                  change.price) < 0)) {
+            reread = true;
+        }
+    }
+    return what;
+}
+
+void SharedBookView::write(BookViewSlot& slot, const BookView& view, Changes what, const LevelUpdate* changes,
+                           size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(&view);
+    auto store = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+            slot.words[i].store(word, std::memory_order_relaxed);
+        }
+    };
+    const uint32_t bid_levels = what.reread_bids ? view.bid_levels : slot.bid_levels;
+    const uint32_t ask_levels = what.reread_asks ? view.ask_levels : slot.ask_levels;
+
+    // 1. Odd: readers that start now will retry, and readers already copying
+    // will see the sequence move. The release fence keeps the view's stores
+    // below from being seen before the odd sequence.
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // 2. The timestamp and level counts.
+    slot.words[0].store(view.publish_tsc, std::memory_order_relaxed);
+    slot.words[1].store(static_cast<uint64_t>(bid_levels) | static_cast<uint64_t>(ask_levels) << 32,
+                        std::memory_order_relaxed);
+
+    // 3. The sides being reread, whole. Levels past a side's count are left
+    // as they were; readers never look at them.
+    if (what.reread_bids) {
+        store(BIDS_WORD, BIDS_WORD + bid_levels * LEVEL_WORDS);
+    }
+    if (what.reread_asks) {
+        store(ASKS_WORD, ASKS_WORD + ask_levels * LEVEL_WORDS);
+    }
+
+    // 4. New volumes at levels the other sides already show.
+    for (size_t i = 0; i < count; ++i) {
+        const LevelUpdate& change = changes[i];
+        const bool bid = change.side == 'B';
+        if (bid ? what.reread_bids : what.reread_asks) {
+            continue;
+        }
+        const size_t side_word = bid ? BIDS_WORD : ASKS_WORD;
+        const int k = findLevel(slot, side_word, bid ? bid_levels : ask_levels, change.price);
+        if (k >= 0) {
+            const BestPrice level{change.price, change.total_volume};
+            uint64_t volume_word;
+            std::memcpy(&volume_word, reinterpret_cast<const char*>(&level) + sizeof(uint64_t), sizeof(volume_word));
+            slot.words[side_word + k * LEVEL_WORDS + 1].store(volume_word, std::memory_order_relaxed);
+        }
+    }
+
+    // 5. Even again, releasing the view.
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+
+    // 6. Remember how far each reread side reaches, for classify().
+    if (what.reread_bids) {
+        slot.bid_levels = bid_levels;
+        slot.worst_bid = bid_levels == BOOK_VIEW_DEPTH ? view.bids[BOOK_VIEW_DEPTH - 1].price : INT64_MIN;
+    }
+    if (what.reread_asks) {
+        slot.ask_levels = ask_levels;
+        slot.worst_ask = ask_levels == BOOK_VIEW_DEPTH ? view.asks[BOOK_VIEW_DEPTH - 1].price : INT64_MAX;
+    }
+}
+
+bool BookViewReader::open(const std::string& name) {
+    close();
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat failed");
+        ::close(fd);
+        return false;
+    }
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    if (bytes < headerBytes()) {
+        fprintf(stderr, "Book view %s is too small to be a book view\n", name.c_str());
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap failed");
+        return false;
+    }
+
+    // Refuse anything this build would misread.
+    const BookViewHeader* header = static_cast<const BookViewHeader*>(mapped);
+    if (header->magic.load(std::memory_order_acquire) != BOOK_VIEW_MAGIC ||
+        header->layout != BOOK_VIEW_LAYOUT || header->depth != BOOK_VIEW_DEPTH ||
+        header->slot_bytes != sizeof(BookViewSlot) || segmentBytes(header->num_instruments) > bytes) {
+        fprintf(stderr, "Book view %s is not ready or has a different layout\n", name.c_str());
+        munmap(mapped, bytes);
+        return false;
+    }
+    memory_ = mapped;
+    bytes_ = bytes;
+    num_instruments_ = header->num_instruments;
+    ns_per_tick_ = header->ns_per_tick;
+    slots_ = reinterpret_cast<const BookViewSlot*>(static_cast<const char*>(memory_) + headerBytes());
+    return true;
+}
+
+void BookViewReader::close() {
+    if (memory_ != nullptr) {
+        munmap(memory_, bytes_);
+    }
+    memory_ = nullptr;
+    bytes_ = 0;
+    slots_ = nullptr;
+    num_instruments_ = 0;
+}
+
+uint64_t BookViewReader::read(InstrumentID instrument, BookView& view) const {
+    const BookViewSlot& slot = slots_[instrument];
+    uint64_t words[BookViewSlot::WORDS];
+    while (true) {
+        // 1. An even sequence: no publish in progress as we start.
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return 0;
+        }
+        if (before & 1) {
+            cpuRelax();
+            continue;
+        }
+
+        // 2. Copy. Mid-publish this can be a mix of two views, so nothing in it
+        // is trusted (not even the level counts) until step 3 passes.
+        for (size_t i = 0; i < BookViewSlot::WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+
+        // 3. Keep the copy only if no publish started meanwhile. The acquire
+        // fence keeps the copy's loads above the second sequence load.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            std::memcpy(&view, words, sizeof(view));
+            return before / 2;
+        }
+        cpuRelax();
+    }
+}
@@ -0,0 +1,165 @@
+#include "HugePages.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+namespace {
+
+constexpr size_t SMALL_PAGE_SIZE = 4096;
+constexpr size_t TRANSPARENT_PAGE_SIZE = size_t(2) << 20;
+// Nodes an mbind() mask can name.
+constexpr int MAX_NUMA_NODES = 1024;
+
+// Every book makes the same allocations, so each problem is reported once per
+// process rather than once per book.
+std::atomic<bool> warned_explicit{false};
+std::atomic<bool> warned_numa{false};
+std::atomic<bool> warned_lock{false};
+
+void warnOnce(std::atomic<bool>& warned, const char* what, int error) {
+    if (!warned.exchange(true)) {
+        std::fprintf(stderr, "%s: %s\n", what, std::strerror(error));
+    }
+}
+
+size_t roundUp(size_t bytes, size_t page_size) {
+    return (bytes + page_size - 1) / page_size * page_size;
+}
+
+void* mapAnonymous(size_t length, int extra_flags) {
+    void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+}
+
+// Maps 'length' bytes of normal pages starting on an 'alignment' boundary, so
+// that transparent huge pages can back every 2MB extent of it: over-map by one
+// alignment, then unmap the ragged ends.
+void* mapAligned(size_t length, size_t alignment) {
+    const size_t padded = length + alignment;
+    void* raw = mapAnonymous(padded, 0);
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = (start + alignment - 1) & ~(alignment - 1);
+    if (aligned > start) {
+        munmap(raw, aligned - start);
+    }
+    const uintptr_t end = aligned + length;
+    if (start + padded > end) {
+        munmap(reinterpret_cast<void*>(end), start + padded - end);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+} // namespace
+
+LargeBuffer::LargeBuffer(size_t bytes, const LargePageConfig& config) {
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    HugePageMode mode = config.mode;
+    const size_t huge_page_size = mode == HugePageMode::Explicit ? config.page_size : TRANSPARENT_PAGE_SIZE;
+    if (bytes < huge_page_size) {
+        mode = HugePageMode::Off;
+    }
+
+    // 1. Explicit huge pages, in whole pages of the configured size.
+    if (mode == HugePageMode::Explicit) {
+        const size_t length = roundUp(bytes, config.page_size);
+        const int size_flag = __builtin_ctzll(config.page_size) << MAP_HUGE_SHIFT;
+        data_ = mapAnonymous(length, MAP_HUGETLB | size_flag);
+        if (data_ != nullptr) {
+            size_ = length;
+            explicit_ = true;
+        } else {
+            warnOnce(warned_explicit, "explicit huge pages unavailable, falling back to transparent huge pages "
+                                      "(reserve some with vm.nr_hugepages)", errno);
+            mode = HugePageMode::Transparent;
+        }
+    }
+
+    // 2. Normal pages, aligned for transparent huge pages if they are wanted.
+    if (data_ == nullptr) {
+        if (mode == HugePageMode::Transparent) {
+            size_ = roundUp(bytes, TRANSPARENT_PAGE_SIZE);
+            data_ = mapAligned(size_, TRANSPARENT_PAGE_SIZE);
+            // Only a hint: with THP set to "never" the pages simply stay small.
+            if (data_ != nullptr) {
+                madvise(data_, size_, MADV_HUGEPAGE);
+            }
+        } else {
+            size_ = roundUp(bytes, SMALL_PAGE_SIZE);
+            data_ = mapAnonymous(size_, 0);
+        }
+        if (data_ == nullptr) {
+            size_ = 0;
+            throw std::bad_alloc();
+        }
+    }
+
+    // 3. Placement, before any page is faulted in.
+    if (config.numa_node >= 0 && config.numa_node < MAX_NUMA_NODES) {
+        unsigned long nodes[MAX_NUMA_NODES / 64] = {};
+        nodes[config.numa_node / 64] = 1UL << (config.numa_node % 64);
+        if (syscall(SYS_mbind, data_, size_, MPOL_BIND, nodes, MAX_NUMA_NODES, 0) != 0) {
+            warnOnce(warned_numa, "binding book memory to its NUMA node failed", errno);
+        }
+    }
+
+    // 4. Fault the pages in now rather than on the hot path. mlock() does it
+    // as part of locking them.
+    bool faulted = false;
+    if (config.lock) {
+        if (mlock(data_, size_) == 0) {
+            faulted = true;
+        } else {
+            warnOnce(warned_lock, "locking book memory failed (raise RLIMIT_MEMLOCK)", errno);
+        }
+    }
+    if (config.prefault && !faulted) {
+        volatile char* memory = static_cast<volatile char*>(data_);
+        for (size_t offset = 0; offset < size_; offset += SMALL_PAGE_SIZE) {
+            memory[offset] = 0;
+        }
+    }
+}
+
+LargeBuffer::~LargeBuffer() {
+    release();
+}
+
+LargeBuffer::LargeBuffer(LargeBuffer&& other) noexcept
+    : data_(other.data_), size_(other.size_), explicit_(other.explicit_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+LargeBuffer& LargeBuffer::operator=(LargeBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        explicit_ = other.explicit_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void LargeBuffer::release() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
@@ -0,0 +1,167 @@
+#include "Journal.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr size_t PAGE_SIZE = 4096;
+
+Journal::Journal(const JournalConfig& config) : config_(config) {}
+
+Journal::~Journal() {
+    stop();
+    if (map_ != nullptr) {
+        munmap(map_, map_size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool Journal::open(uint64_t snapshot_sequence) {
+    fd_ = ::open(config_.path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        perror("journal open failed");
+        return false;
+    }
+
+    // 1. Read the header of an existing journal. Its capacity is kept, since
+    //    a record's position depends on it.
+    JournalHeader header{};
+    struct stat st;
+    if (fstat(fd_, &st) < 0) {
+        perror("journal fstat failed");
+        return false;
+    }
+    capacity_ = config_.capacity_messages;
+    if (static_cast<size_t>(st.st_size) >= sizeof(header)) {
+        if (pread(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            header.magic != MAGIC || header.version < OLDEST_READABLE_VERSION || header.version > VERSION ||
+            header.record_size != sizeof(JournalRecord) || header.capacity == 0) {
+            std::fprintf(stderr, "%s is not a journal this version can append to\n", config_.path.c_str());
+            return false;
+        }
+        capacity_ = header.capacity;
+    }
+
+    // 2. Reserve the disk blocks up front, so appends never extend the file.
+    map_size_ = sizeof(JournalHeader) + capacity_ * sizeof(JournalRecord);
+    if (posix_fallocate(fd_, 0, map_size_) != 0 && ftruncate(fd_, map_size_) < 0) {
+        perror("journal preallocation failed");
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        perror("journal mmap failed");
+        return false;
+    }
+    map_ = static_cast<char*>(mapped);
+    records_ = reinterpret_cast<JournalRecord*>(map_ + sizeof(JournalHeader));
+
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.record_size = sizeof(JournalRecord);
+    header.capacity = capacity_;
+    std::memcpy(map_, &header, sizeof(header));
+
+    // 3. Continue after the last complete record. The snapshot covers the
+    //    records before it, so their space is free.
+    next_sequence_ = snapshot_sequence;
+    released_ = snapshot_sequence;
+    while (next_sequence_ - released_ < capacity_ &&
+           records_[recordIndex(next_sequence_ + 1, capacity_)].sequence == next_sequence_ + 1) {
+        ++next_sequence_;
+    }
+    next_index_ = recordIndex(next_sequence_ + 1, capacity_);
+    appended_.store(next_sequence_, std::memory_order_relaxed);
+    durable_.store(next_sequence_, std::memory_order_relaxed);
+    // Once the journal has wrapped, every page has been touched before.
+    prefaulted_ = next_sequence_ >= capacity_ ? map_size_ : sizeof(JournalHeader) + next_index_ * sizeof(JournalRecord);
+    return true;
+}
+
+void Journal::overflow() {
+    ++overflow_count_;
+    if ((overflow_count_ & (overflow_count_ - 1)) == 0) {
+        std::fprintf(stderr,
+                     "ERROR: journal %s is full: %zu messages since the last durable snapshot (@%llu). "
+                     "%llu messages so far were NOT journaled and would be missing after a restart; "
+                     "snapshot more often or raise --journal-capacity\n",
+                     config_.path.c_str(), capacity_, static_cast<unsigned long long>(released_),
+                     static_cast<unsigned long long>(overflow_count_));
+    }
+}
+
+void Journal::start() {
+    if (map_ == nullptr || running_.exchange(true)) {
+        return;
+    }
+    prefault(next_index_);
+    thread_ = std::thread(&Journal::run, this);
+}
+
+void Journal::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (map_ != nullptr) {
+        commit(appended_.load(std::memory_order_acquire));
+    }
+}
+
+void Journal::run() {
+    const auto interval = std::chrono::microseconds(config_.commit_interval_us);
+    while (running_.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(interval);
+        const uint64_t appended = appended_.load(std::memory_order_acquire);
+        commit(appended);
+        prefault(appended);
+    }
+}
+
+void Journal::commit(uint64_t appended) {
+    const uint64_t durable = durable_.load(std::memory_order_relaxed);
+    if (appended <= durable) {
+        return;
+    }
+    // The new records run from just after 'durable' to 'appended', in two
+    // pieces if the journal wrapped round between them.
+    const size_t first = recordIndex(durable + 1, capacity_);
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(appended - durable, capacity_));
+    const bool ok = first + count <= capacity_ ? flush(first, first + count)
+                                               : flush(first, capacity_) && flush(0, first + count - capacity_);
+    if (ok) {
+        durable_.store(appended, std::memory_order_release);
+    }
+}
+
+bool Journal::flush(size_t first, size_t end) {
+    // msync wants a page-aligned start. The first page may be partly committed
+    // already; flushing it again is harmless.
+    const size_t begin = (sizeof(JournalHeader) + first * sizeof(JournalRecord)) & ~(PAGE_SIZE - 1);
+    const size_t stop = sizeof(JournalHeader) + end * sizeof(JournalRecord);
+    if (msync(map_ + begin, stop - begin, MS_SYNC) < 0) {
+        perror("journal msync failed");
+        return false;
+    }
+    return true;
+}
+
+void Journal::prefault(uint64_t appended) {
+    // Only the first lap needs it: after that every page has been written.
+    const size_t target = std::min<uint64_t>(map_size_, sizeof(JournalHeader) + appended * sizeof(JournalRecord) + config_.prefault_bytes);
+    size_t page = (prefaulted_ + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    for (; page < target; page += PAGE_SIZE) {
+        // A write fault makes the page present and writable. Adding zero with an
+        // atomic read-modify-write leaves the bytes as they are, even if the
+        // writer has caught up and is filling the same page.
+        __atomic_fetch_add(reinterpret_cast<uint64_t*>(map_ + page), 0, __ATOMIC_RELAXED);
+    }
+    prefaulted_ = std::max(prefaulted_, page);
+}
@@ -1,126 +1,401 @@
 #include "L1CacheBook.h" // Include the header file that defines the L1CacheBook class.
+#include <type_traits>
 
 // Constructor implementation.
-L1CacheBook::L1CacheBook() : next_order_pool_index_(0) {
-    // Pre-allocate memory for a large number of orders to avoid allocation at runtime.
-    // A real system would have a more sophisticated memory management strategy.
-    order_pool_.resize(10000000); // Reserve space for 10 million orders.
+template <typename Traits>
+BasicL1CacheBook<Traits>::BasicL1CacheBook(const OrderPoolConfig& pool_config, double index_load_factor,
+                                           const PriceLadderConfig& ladder_config)
+    : bids_(ladder_config.window_levels),
+      asks_(ladder_config.window_levels),
+      best_bid_tick_(BidLadder::EMPTY),
+      best_ask_tick_(AskLadder::EMPTY),
+      tick_size_(ladder_config.tick_size > 0 ? ladder_config.tick_size : 1),
+      base_price_(ladder_config.base_price),
+      order_map_(poolConfig(pool_config).capacity, index_load_factor, pool_config.pages),
+      orders_(poolConfig(pool_config)) {
 }
 
 // Implementation of the addOrder method.
-void L1CacheBook::addOrder(const PanoptesMessage& msg) {
-    // 1. Get a new order object from our pre-allocated memory pool.
-    // This avoids a slow call to 'new'.
-    Order* new_order = &order_pool_[next_order_pool_index_++];
-    new_order->id = msg.order_id;
-    new_order->price = msg.price;
-    new_order->size = msg.size;
-    new_order->side = msg.side;
-    new_order->next = nullptr;
-    new_order->prev = nullptr;
-
-    // 2. Add the new order to the order map for fast O(1) lookups later.
-    order_map_[new_order->id] = new_order;
-
-    // 3. Find the correct price level in the correct array (bids or asks).
-    size_t index = priceToIndex(new_order->price);
-    PriceLevel* level;
-    if (new_order->side == 'B') {same
-        level = &bids_[index];
+template <typename Traits>
+void BasicL1CacheBook<Traits>::addOrder(const PanoptesMessage& msg) {
+    // Prices must sit on the instrument's tick grid. (With a compile-time unit
+    // tick every price does, and this check compiles away.)
+    if (tickSize() != 1 && (msg.price - basePrice()) % tickSize() != 0) {
+        ++off_tick_orders_;
+        return;
+    }
+    if (msg.side == 'B') {
+        addOn<'B'>(msg);
     } else {
-        level = &asks_[index];
+        addOn<'A'>(msg);
     }
+}
 
-    // 4. Add the order to the doubly-linked list at that price level.
-    // We add new orders to the back of the list (tail). This represents FIFO (First-In, First-Out) priority.
-    if (level->head == nullptr) {
-        // If the list is empty, this order is both the head and the tail.
-        level->head = new_order;
-        level->tail = new_order;
-    } else {
-        // If the list is not empty, add the new order after the current tail.
-        level->tail->next = new_order;
-        new_order->prev = level->tail;
-        level->tail = new_order;
+template <typename Traits>
+template <char Side>
+void BasicL1CacheBook<Traits>::addOn(const PanoptesMessage& msg) {
+    // 1. Match against the opposite side first. An order that is completely
+    // filled never needs a slot in the book.
+    int32_t remaining = msg.size;
+    if constexpr (Traits::MATCHING) {
+        remaining = match<Side>(msg);
+    }
+    if (remaining <= 0) {
+        return;
+    }
+
+    // 2. Get a new order from our pre-allocated storage.
+    // This avoids a slow call to 'new'. If the storage is full and configured to
+    // reject, the add is dropped (the storage counts it).
+    const Handle new_order = orders_.acquire(msg.order_id, msg.price, remaining, Side);
+    if (new_order == Storage::NIL) {
+        return;
     }
-    level->total_volume += new_order->size;
+
+    // 3. Add the new order to the order map for fast O(1) lookups later.
+    order_map_.insert(msg.order_id, new_order);
+
+    // 4. Rest the order at the back of its price level.
+    linkOrder<Side>(new_order, priceToTick(msg.price));
 }
 
 // Implementation of the cancelOrder method.
-void L1CacheBook::cancelOrder(const PanoptesMessage& msg) {
-    // 1. Find the order to cancel using the order map. This is an O(1) operation.
-    auto it = order_map_.find(msg.order_id);
-    if (it == order_map_.end()) {
+template <typename Traits>
+void BasicL1CacheBook<Traits>::cancelOrder(const PanoptesMessage& msg) {
+    // 1. Find the order to cancel and remove it from the order map in one
+    // probe of the index. This is an O(1) operation.
+    const Handle order_to_cancel = order_map_.erase(msg.order_id);
+    if (order_to_cancel == Storage::NIL) {
         // The order ID was not found. This can happen in real-world scenarios.
         // We can log this event, but for now, we just ignore it.
         return;
     }
-    Order* order_to_cancel = it->second;
 
-    // 2. Remove the order from the order map.
-    order_map_.erase(it);
+    // 2. Take it out of its price level and give the slot back to the storage.
+    const Tick tick = priceToTick(orders_.price(order_to_cancel));
+    if (orders_.side(order_to_cancel) == 'B') {
+        unlinkOrder<'B'>(order_to_cancel, tick);
+    } else {
+        unlinkOrder<'A'>(order_to_cancel, tick);
+    }
+}
+
+template <typename Traits>
+void BasicL1CacheBook<Traits>::executeOrder(const PanoptesMessage& msg) {
+    const Handle order = order_map_.find(msg.order_id);
+    if (order == Storage::NIL || msg.size <= 0) {
+        return;
+    }
+    if (orders_.side(order) == 'B') {
+        executeOn<'B'>(order, msg);
+    } else {
+        executeOn<'A'>(order, msg);
+    }
+}
+
+template <typename Traits>
+template <char Side>
+void BasicL1CacheBook<Traits>::executeOn(Handle order, const PanoptesMessage& msg) {
+    // An execution message means a trade occurred against a resting order.
+    // It reduces that order's size in place, so it keeps its queue position
+    // unless it has been completely filled.
+    int32_t& size = orders_.size(order);
+    const int32_t fill = msg.size < size ? msg.size : size;
+    const Price price = orders_.price(order);
+    // The feed does not tell us who the aggressor was, only which order was hit.
+    trades_.push({0, msg.order_id, price, fill, Side == 'B' ? 'A' : 'B', {0}});
 
-    // 3. Find the price level where the order resides.
-    size_t index = priceToIndex(order_to_cancel->price);
-    PriceLevel* level;
-    if (order_to_cancel->side == 'B') {
-        level = &bids_[index];
+    size -= fill;
+    const Tick tick = priceToTick(price);
+    Level& level = ladder<Side>().level(tick);
+    level.total_volume -= fill;
+    if (size == 0) {
+        order_map_.erase(msg.order_id);
+        unlinkOrder<Side>(order, tick);
     } else {
-        level = &asks_[index];
+        publishLevel(Side, tick, level.total_volume);
     }
+}
 
-    // 4. Unlink the order from the doubly-linked list.
-    // This is where the prev/next pointers are crucial for an O(1) removal.
-    if (order_to_cancel->prev != nullptr) {
-        order_to_cancel->prev->next = order_to_cancel->next;
+template <typename Traits>
+void BasicL1CacheBook<Traits>::modifyOrder(const PanoptesMessage& msg) {
+    const Handle order = order_map_.find(msg.order_id);
+    if (order == Storage::NIL || msg.size <= 0) {
+        return;
+    }
+    if (tickSize() != 1 && (msg.price - basePrice()) % tickSize() != 0) {
+        ++off_tick_orders_;
+        return;
     }
-    if (order_to_cancel->next != nullptr) {
-        order_to_cancel->next->prev = order_to_cancel->prev;
+    // The order's own side, whatever the message says: orders cannot switch sides.
+    if (orders_.side(order) == 'B') {
+        modifyOn<'B'>(order, msg);
+    } else {
+        modifyOn<'A'>(order, msg);
+    }
+}
+
+template <typename Traits>
+template <char Side>
+void BasicL1CacheBook<Traits>::modifyOn(Handle order, const PanoptesMessage& msg) {
+    const Price old_price = orders_.price(order);
+    const Tick old_tick = priceToTick(old_price);
+
+    // 1. Less size at the same price: shrink the order in place. It keeps its
+    // place in the queue, as a venue keeps it for a size-down amendment.
+    if (msg.price == old_price && msg.size <= orders_.size(order)) {
+        Level& level = ladder<Side>().level(old_tick);
+        level.total_volume -= orders_.size(order) - msg.size;
+        orders_.size(order) = msg.size;
+        publishLevel(Side, old_tick, level.total_volume);
+        return;
     }
 
-    // 5. Update the head and tail pointers of the price level if necessary.
-    if (level->head == order_to_cancel) {
-        level->head = order_to_cancel->next;
+    // 2. Anything else loses priority. Take the order off its level, keeping
+    // its slot and its index entry.
+    detachOrder<Side>(order, old_tick);
+
+    // 3. At a price that crosses, it trades with the other side first. (A
+    // size increase at the old price cannot cross: the order was resting there.)
+    int32_t remaining = msg.size;
+    if constexpr (Traits::MATCHING) {
+        remaining = match<Side>(msg);
     }
-    if (level->tail == order_to_cancel) {
-        level->tail = order_to_cancel->prev;
+    if (remaining <= 0) {
+        order_map_.erase(msg.order_id);
+        orders_.release(order);
+        return;
     }
-    level->total_volume -= order_to_cancel->size;
 
-    // Note: In this simple implementation, the order object remains in the memory pool
-    // but is now "orphaned" (not pointed to by the map or any list). A more advanced
-    // memory pool would mark this slot as reusable.
+    // 4. Rest what is left at the back of its new level.
+    orders_.size(order) = remaining;
+    orders_.setPrice(order, msg.price);
+    linkOrder<Side>(order, priceToTick(msg.price));
 }
 
-void L1CacheBook::executeOrder(const PanoptesMessage& msg) {
-    // An execution message means a trade occurred. This typically reduces the size
-    // of an existing order at the top of the book.
-    // For Phase 1, we will treat it like a cancel to simplify the logic.
-    // A full implementation would find the order and decrease its size.
-    cancelOrder(msg);
-}
+template <typename Traits>
+template <char Side>
+int32_t BasicL1CacheBook<Traits>::match(const PanoptesMessage& msg) {
+    // A buy trades with the asks, a sell with the bids.
+    constexpr char Resting = Side == 'B' ? 'A' : 'B';
+    auto& resting_ladder = ladder<Resting>();
+    using RestingLadder = std::remove_reference_t<decltype(resting_ladder)>;
+    const Tick& best = bestTick<Resting>();
 
-// A simple helper function to see the state of the book.
-void L1CacheBook::printTopOfBook() const {
-    Price best_ask_price = -1;
-    int32_t best_ask_volume = 0;
-    for(size_t i = 0; i < MAX_PRICE_LEVELS; ++i) {
-        if(asks_[i].head != nullptr) {
-            best_ask_price = asks_[i].head->price;
-            best_ask_volume = asks_[i].total_volume;
+    int32_t remaining = msg.size;
+    const Tick limit = priceToTick(msg.price);
+
+    while (remaining > 0) {
+        // 1. Stop once the best opposite level no longer crosses (an empty side never does).
+        const Tick level_tick = best;
+        if (!RestingLadder::crossedBy(limit, level_tick)) {
             break;
         }
+        Level& level = resting_ladder.level(level_tick);
+
+        // 2. Walk the level's FIFO list from the head, so the oldest order fills first.
+        // Each fill trades at the level's price, which is the resting order's price.
+        const Handle resting = level.head;
+        const Handle following = orders_.next(resting);
+        if (following != Storage::NIL) {
+            orders_.prefetch(following);
+        }
+        int32_t& resting_size = orders_.size(resting);
+        const int32_t fill = remaining < resting_size ? remaining : resting_size;
+        const OrderID resting_id = orders_.id(resting);
+        trades_.push({msg.order_id, resting_id, tickToPrice(level_tick), fill, Side, {0}});
+
+        remaining -= fill;
+        resting_size -= fill;
+        level.total_volume -= fill;
+
+        // 3. A fully filled resting order leaves the book. If that empties the level,
+        // unlinkOrder moves the best price on to the next level for the next pass.
+        if (resting_size == 0) {
+            order_map_.erase(resting_id);
+            unlinkOrder<Resting>(resting, level_tick);
+        } else {
+            // The incoming order is done, leaving this level partly consumed.
+            publishLevel(Resting, level_tick, level.total_volume);
+        }
     }
+    return remaining;
+}
 
-    Price best_bid_price = -1;
-    int32_t best_bid_volume = 0;
-    for(int i = MAX_PRICE_LEVELS - 1; i >= 0; --i) {
-        if(bids_[i].head != nullptr) {
-            best_bid_price = bids_[i].head->price;
-            best_bid_volume = bids_[i].total_volume;
-            break;
+template <typename Traits>
+template <char Side>
+void BasicL1CacheBook<Traits>::linkOrder(Handle order, Tick tick) {
+    // 1. Find the correct price level in this side's ladder.
+    auto& side_ladder = ladder<Side>();
+    using SideLadder = std::remove_reference_t<decltype(side_ladder)>;
+    Tick& best = bestTick<Side>();
+    Level* level = &side_ladder.level(tick);
+
+    // 2. Add the order to the doubly-linked list at that price level.
+    // We add new orders to the back of the list (tail). This represents FIFO (First-In, First-Out) priority.
+    orders_.next(order) = Storage::NIL;
+    orders_.prev(order) = Storage::NIL;
+    if (level->head == Storage::NIL) {
+        // If the list is empty, this order is both the head and the tail.
+        level->head = order;
+        level->tail = order;
+        // The level has just become occupied.
+        side_ladder.setOccupied(tick);
+    } else {
+        // If the list is not empty, add the new order after the current tail.
+        orders_.next(level->tail) = order;
+        orders_.prev(order) = level->tail;
+        level->tail = order;
+    }
+    level->total_volume += orders_.size(order);
+    publishLevel(Side, tick, level->total_volume);
+
+    // 3. A bid above the current best becomes the new best bid, and an ask below
+    // the current best becomes the new best ask. If the touch has moved close to
+    // the edge of the dense window (or past it, as the first order on an empty
+    // side usually does), slide the window over it.
+    if (SideLadder::better(tick, best)) {
+        best = tick;
+        if (side_ladder.nearEdge(tick)) {
+            side_ladder.recenter(tick);
+        }
+    }
+}
+
+template <typename Traits>
+template <char Side>
+void BasicL1CacheBook<Traits>::detachOrder(Handle order, Tick tick) {
+    // 1. Find the price level where the order resides.
+    auto& side_ladder = ladder<Side>();
+    using SideLadder = std::remove_reference_t<decltype(side_ladder)>;
+    Level* level = &side_ladder.level(tick);
+
+    // 2. Unlink the order from the doubly-linked list.
+    // This is where the prev/next links are crucial for an O(1) removal.
+    const Handle prev = orders_.prev(order);
+    const Handle next = orders_.next(order);
+    if (prev != Storage::NIL) {
+        orders_.next(prev) = next;
+    }
+    if (next != Storage::NIL) {
+        orders_.prev(next) = prev;
+    }
+
+    // 3. Update the head and tail pointers of the price level if necessary.
+    if (level->head == order) {
+        level->head = next;
+    }
+    if (level->tail == order) {
+        level->tail = prev;
+    }
+    level->total_volume -= orders_.size(order);
+    // Report before an emptied overflow level is freed below.
+    publishLevel(Side, tick, level->head == Storage::NIL ? 0 : level->total_volume);
+
+    // 4. If the level is now empty, drop it from the ladder. If it was the best
+    // level, the ladder's bitmap gives us the next best one in a few word reads.
+    if (level->head == Storage::NIL) {
+        side_ladder.setEmpty(tick);
+        Tick& best = bestTick<Side>();
+        if (tick == best) {
+            best = side_ladder.best();
+            // Only follow the touch once it has left the window altogether. Doing
+            // it at the edge would make a touch that flips between two distant
+            // levels (add at one, cancel back to the other) recenter every time.
+            if (best != SideLadder::EMPTY && !side_ladder.inWindow(best)) {
+                side_ladder.recenter(best);
+            }
         }
     }
-    std::cout << "BBO: " << best_bid_volume << " @ " << (double)best_bid_price/10000.0
-              << " -- " << best_ask_volume << " @ " << (double)best_ask_price/10000.0 << std::endl;
+}
+
+template <typename Traits>
+template <char Side>
+void BasicL1CacheBook<Traits>::unlinkOrder(Handle order, Tick tick) {
+    detachOrder<Side>(order, tick);
+    // Hand the slot back to the storage so the next add can reuse it while it is still hot.
+    orders_.release(order);
+}
+
+template <typename Traits>
+BestPrice BasicL1CacheBook<Traits>::getBestBid() const {
+    BestPrice best;
+    if (best_bid_tick_ != BidLadder::EMPTY) {
+        best.price = tickToPrice(best_bid_tick_);
+        best.volume = bids_.occupiedLevel(best_bid_tick_).total_volume;
+    }
+    return best;
+}
+
+template <typename Traits>
+BestPrice BasicL1CacheBook<Traits>::getBestAsk() const {
+    BestPrice best;
+    if (best_ask_tick_ != AskLadder::EMPTY) {
+        best.price = tickToPrice(best_ask_tick_);
+        best.volume = asks_.occupiedLevel(best_ask_tick_).total_volume;
+    }
+    return best;
+}
+
+template <typename Traits>
+size_t BasicL1CacheBook<Traits>::depth(char side, BestPrice* levels, size_t max_levels) const {
+    return side == 'B' ? depthOn(bids_, best_bid_tick_, levels, max_levels)
+                       : depthOn(asks_, best_ask_tick_, levels, max_levels);
+}
+
+// A simple helper function to see the state of the book.
+template <typename Traits>
+void BasicL1CacheBook<Traits>::printTopOfBook() const {
+    const BestPrice best_bid = getBestBid();
+    const BestPrice best_ask = getBestAsk();
+    std::cout << "BBO: " << best_bid.volume << " @ " << (double)best_bid.price/10000.0
+              << " -- " << best_ask.volume << " @ " << (double)best_ask.price/10000.0 << std::endl;
+}
+
+// The variants the engine, tests and benchmarks use: every layout, with the
+// tick from the config or fixed at one unit, with and without matching.
+#define PANOPTES_INSTANTIATE_BOOKS(Storage)                           \
+    template class BasicL1CacheBook<RuntimeBookTraits<Storage, true>>;  \
+    template class BasicL1CacheBook<RuntimeBookTraits<Storage, false>>; \
+    template class BasicL1CacheBook<UnitTickBookTraits<Storage, true>>; \
+    template class BasicL1CacheBook<UnitTickBookTraits<Storage, false>>;
+PANOPTES_INSTANTIATE_BOOKS(PointerOrderStorage)
+PANOPTES_INSTANTIATE_BOOKS(CompactOrderStorage)
+PANOPTES_INSTANTIATE_BOOKS(HotColdOrderStorage)
+#undef PANOPTES_INSTANTIATE_BOOKS
+template class BasicL1CacheBook<FixedBookTraits>;
+
+namespace {
+
+template <typename Storage, bool Matching>
+std::unique_ptr<OrderBook> makeBook(const OrderPoolConfig& pool_config, double index_load_factor,
+                                    const PriceLadderConfig& ladder) {
+    if (ladder.tick_size <= 1 && ladder.base_price == 0) {
+        return std::make_unique<BasicL1CacheBook<UnitTickBookTraits<Storage, Matching>>>(
+            pool_config, index_load_factor, ladder);
+    }
+    return std::make_unique<BasicL1CacheBook<RuntimeBookTraits<Storage, Matching>>>(
+        pool_config, index_load_factor, ladder);
+}
+
+template <typename Storage>
+std::unique_ptr<OrderBook> makeBook(bool matching, const OrderPoolConfig& pool_config, double index_load_factor,
+                                    const PriceLadderConfig& ladder) {
+    return matching ? makeBook<Storage, true>(pool_config, index_load_factor, ladder)
+                    : makeBook<Storage, false>(pool_config, index_load_factor, ladder);
+}
+
+} // namespace
+
+std::unique_ptr<OrderBook> makeOrderBook(const BookVariant& variant, const OrderPoolConfig& pool_config,
+                                         double index_load_factor, const PriceLadderConfig& ladder) {
+    switch (variant.layout) {
+        case OrderLayout::Compact:
+            return makeBook<CompactOrderStorage>(variant.matching, pool_config, index_load_factor, ladder);
+        case OrderLayout::HotCold:
+            return makeBook<HotColdOrderStorage>(variant.matching, pool_config, index_load_factor, ladder);
+        case OrderLayout::Pointer:
+        default:
+            return makeBook<PointerOrderStorage>(variant.matching, pool_config, index_load_factor, ladder);
+    }
 }
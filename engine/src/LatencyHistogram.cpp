@@ -0,0 +1,61 @@
+#include "LatencyHistogram.h"
+
+double LatencyHistogram::mean() const {
+    const uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+uint64_t LatencyHistogram::percentile(double pct) const {
+    const uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    // The rank of the sample we want, rounded up, and at least the first sample.
+    uint64_t rank = static_cast<uint64_t>(pct / 100.0 * static_cast<double>(n) + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+        seen += counts_[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // The exact maximum is known, so never report more than it.
+            const uint64_t upper = bucketUpperBound(bucket);
+            return upper < max() ? upper : max();
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+        bump(counts_[bucket], other.counts_[bucket].load(std::memory_order_relaxed));
+    }
+    bump(total_count_, other.count());
+    bump(sum_, other.sum_.load(std::memory_order_relaxed));
+    if (other.max() > max()) {
+        max_.store(other.max(), std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    total_count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    if (bucket >= NUM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    const uint64_t offset = bucket - SUB_BUCKETS;
+    const unsigned shift = static_cast<unsigned>(offset / HALF_SUB_BUCKETS) + 1;
+    const uint64_t mantissa = HALF_SUB_BUCKETS + offset % HALF_SUB_BUCKETS;
+    return ((mantissa + 1) << shift) - 1;
+}
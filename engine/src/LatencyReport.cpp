@@ -0,0 +1,98 @@
+#include "LatencyReport.h"
+#include <fstream>
+#include <iomanip>
+
+namespace {
+
+const char* const STAGE_NAMES[] = {"wire_to_recv", "parse", "handoff", "book_update"};
+
+struct PercentileColumn {
+    const char* name;
+    double pct;
+};
+const PercentileColumn PERCENTILES[] = {
+    {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}, {"p99.99", 99.99},
+};
+
+std::string eventTypeName(size_t index) {
+    if (index < sizeof(LatencyReport::EVENT_TYPES)) {
+        return std::string(1, LatencyReport::EVENT_TYPES[index]);
+    }
+    return "other";
+}
+
+} // namespace
+
+LatencyReport::LatencyReport()
+    : histograms_(std::make_unique<std::array<StageHistograms, static_cast<size_t>(LatencyStage::Count)>>()) {
+}
+
+void LatencyReport::merge(const LatencyReport& other) {
+    for (size_t stage = 0; stage < histograms_->size(); ++stage) {
+        for (size_t type = 0; type < NUM_EVENT_TYPES; ++type) {
+            (*histograms_)[stage][type].merge((*other.histograms_)[stage][type]);
+        }
+    }
+}
+
+void LatencyReport::reset() {
+    for (auto& stage : *histograms_) {
+        for (auto& histogram : stage) {
+            histogram.reset();
+        }
+    }
+}
+
+void LatencyReport::printText(std::ostream& out) const {
+    out << std::left << std::setw(14) << "stage" << std::setw(7) << "event"
+        << std::right << std::setw(12) << "count";
+    for (const PercentileColumn& column : PERCENTILES) {
+        out << std::setw(10) << column.name;
+    }
+    out << std::setw(12) << "max" << "   (ns)\n";
+
+    for (size_t stage = 0; stage < histograms_->size(); ++stage) {
+        for (size_t type = 0; type < NUM_EVENT_TYPES; ++type) {
+            const LatencyHistogram& histogram = (*histograms_)[stage][type];
+            if (histogram.count() == 0) {
+                continue;
+            }
+            out << std::left << std::setw(14) << STAGE_NAMES[stage] << std::setw(7) << eventTypeName(type)
+                << std::right << std::setw(12) << histogram.count();
+            for (const PercentileColumn& column : PERCENTILES) {
+                out << std::setw(10) << histogram.percentile(column.pct);
+            }
+            out << std::setw(12) << histogram.max() << "\n";
+        }
+    }
+    out.flush();
+}
+
+bool LatencyReport::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "{\n  \"unit\": \"ns\",\n  \"stages\": {";
+    for (size_t stage = 0; stage < histograms_->size(); ++stage) {
+        out << (stage == 0 ? "\n" : ",\n") << "    \"" << STAGE_NAMES[stage] << "\": {";
+        bool first = true;
+        for (size_t type = 0; type < NUM_EVENT_TYPES; ++type) {
+            const LatencyHistogram& histogram = (*histograms_)[stage][type];
+            if (histogram.count() == 0) {
+                continue;
+            }
+            out << (first ? "\n" : ",\n") << "      \"" << eventTypeName(type) << "\": {"
+                << "\"count\": " << histogram.count()
+                << ", \"mean\": " << histogram.mean();
+            for (const PercentileColumn& column : PERCENTILES) {
+                out << ", \"" << column.name << "\": " << histogram.percentile(column.pct);
+            }
+            out << ", \"max\": " << histogram.max() << "}";
+            first = false;
+        }
+        out << (first ? "}" : "\n    }");
+    }
+    out << "\n  }\n}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,291 @@
+#include "MarketDataPublisher.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Updates taken from one ring per pass, so a busy producer cannot starve the
+// others or hold off the conflation and snapshot timers.
+static constexpr size_t DRAIN_LIMIT = 1024;
+
+MarketDataPublisher::MarketDataPublisher(const MarketDataPublisherConfig& config) : config_(config) {
+    const size_t num_producers = config_.num_producers == 0 ? 1 : config_.num_producers;
+    for (size_t i = 0; i < num_producers; ++i) {
+        producers_.push_back(std::make_unique<Producer>(config_.queue_capacity));
+    }
+    const size_t room = config_.max_datagram_bytes > sizeof(MdHeader)
+                            ? config_.max_datagram_bytes - sizeof(MdHeader) : 0;
+    max_entries_ = std::max<size_t>(1, std::min<size_t>(room / sizeof(LevelUpdate), UINT16_MAX));
+    datagram_.resize(sizeof(MdHeader) + max_entries_ * sizeof(LevelUpdate));
+    pending_.reserve(max_entries_);
+}
+
+MarketDataPublisher::~MarketDataPublisher() {
+    stop();
+    if (sock_fd_ >= 0) {
+        close(sock_fd_);
+    }
+}
+
+bool MarketDataPublisher::open() {
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.address.c_str(), &dest.sin_addr) != 1) {
+        std::fprintf(stderr, "Invalid market data address: %s\n", config_.address.c_str());
+        return false;
+    }
+
+    sock_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_fd_ < 0) {
+        perror("market data socket creation failed");
+        return false;
+    }
+    // Connecting fixes the destination, so each datagram is a plain send().
+    if (connect(sock_fd_, reinterpret_cast<const sockaddr*>(&dest), sizeof(dest)) < 0) {
+        perror("market data connect failed");
+        return false;
+    }
+    return true;
+}
+
+void MarketDataPublisher::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&MarketDataPublisher::run, this);
+}
+
+void MarketDataPublisher::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint64_t MarketDataPublisher::droppedCount() const {
+    uint64_t total = 0;
+    for (const auto& producer : producers_) {
+        total += producer->dropped;
+    }
+    return total;
+}
+
+bool MarketDataPublisher::publishResync(size_t producer, InstrumentID instrument, const LevelUpdate* levels,
+                                        size_t count) {
+    Producer& p = *producers_[producer];
+    // Only this thread pushes, so the room seen here can only grow. size()
+    // may overstate what is queued, never understate it.
+    if (p.ring.capacity() - p.ring.size() < count + 1) {
+        return false;
+    }
+    p.ring.tryPush({0, static_cast<int32_t>(count), RESYNC_SIDE, 0, instrument});
+    for (size_t i = 0; i < count; ++i) {
+        p.ring.tryPush(levels[i]);
+    }
+    return true;
+}
+
+void MarketDataPublisher::run() {
+    const auto window = std::chrono::microseconds(config_.conflation_window_us);
+    const auto snapshot_interval = std::chrono::milliseconds(config_.snapshot_interval_ms);
+    next_snapshot_ = Clock::now() + snapshot_interval;
+
+    while (true) {
+        const size_t taken = drain();
+        const Clock::time_point now = Clock::now();
+
+        // Without conflation a datagram goes out as soon as it is full (in
+        // apply()) or the rings run dry, so a burst shares datagrams but a lone
+        // update is not held back. With conflation everything waits for the
+        // window to close.
+        if (!pending_.empty() && (config_.conflation_window_us == 0 ? taken == 0 : now - window_start_ >= window)) {
+            flushPending();
+        }
+
+        if (config_.snapshot_interval_ms > 0 && now >= next_snapshot_) {
+            // Send what is pending first so the snapshot is not older than the
+            // incrementals sequenced before it.
+            flushPending();
+            sendSnapshots();
+            next_snapshot_ = now + snapshot_interval;
+        }
+
+        if (taken == 0) {
+            // Check for shutdown only when idle, after a final look at the rings,
+            // so no update queued before stop() is lost.
+            if (!running_.load(std::memory_order_acquire)) {
+                bool empty = true;
+                for (const auto& producer : producers_) {
+                    empty = empty && producer->ring.size() == 0;
+                }
+                if (empty) {
+                    break;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+    flushPending();
+}
+
+size_t MarketDataPublisher::drain() {
+    size_t taken = 0;
+    size_t resync_entries = 0;
+    LevelUpdate update;
+    for (auto& producer : producers_) {
+        for (size_t n = 0; n < DRAIN_LIMIT && producer->ring.tryPop(update); ++n) {
+            if (producer->resync_remaining > 0 || update.side == RESYNC_SIDE) {
+                applyResync(*producer, update);
+                ++resync_entries;
+            } else {
+                apply(update);
+            }
+            ++taken;
+        }
+    }
+    stats_.updates_received += taken - resync_entries;
+    return taken;
+}
+
+void MarketDataPublisher::apply(const LevelUpdate& update) {
+    // 1. Keep the snapshot copy of the book current.
+    if (config_.snapshot_interval_ms > 0) {
+        setLevel(update);
+    }
+
+    // 2. Queue it for the next incremental datagram.
+    if (config_.conflation_window_us > 0) {
+        if (pending_.empty()) {
+            window_start_ = Clock::now();
+        }
+        auto inserted = pending_index_.emplace(levelKey(update), pending_.size());
+        if (!inserted.second) {
+            // Already pending: only the latest volume matters.
+            pending_[inserted.first->second].total_volume = update.total_volume;
+            return;
+        }
+        pending_.push_back(update);
+    } else {
+        pending_.push_back(update);
+        if (pending_.size() == max_entries_) {
+            flushPending();
+        }
+    }
+}
+
+void MarketDataPublisher::applyResync(Producer& producer, const LevelUpdate& update) {
+    // 1. The start: forget what was known about the instrument.
+    if (producer.resync_remaining == 0) {
+        producer.resync_instrument = update.instrument_id;
+        producer.resync_remaining = static_cast<size_t>(update.total_volume);
+        depth_[update.instrument_id] = Depth{};
+    } else {
+        // 2. One of its levels, as the book holds it now.
+        setLevel(update);
+        --producer.resync_remaining;
+    }
+    if (producer.resync_remaining > 0) {
+        return;
+    }
+
+    // 3. The whole book is in: send it. Incrementals queued before the resync
+    // go first, so none of them lands on top of the snapshot.
+    flushPending();
+    auto it = depth_.find(producer.resync_instrument);
+    sendSnapshot(it->first, it->second);
+    ++stats_.resyncs;
+    if (config_.snapshot_interval_ms == 0) {
+        depth_.erase(it);
+    }
+}
+
+void MarketDataPublisher::setLevel(const LevelUpdate& update) {
+    Depth& depth = depth_[update.instrument_id];
+    if (update.side == 'B') {
+        if (update.total_volume == 0) {
+            depth.bids.erase(update.price);
+        } else {
+            depth.bids[update.price] = update.total_volume;
+        }
+    } else {
+        if (update.total_volume == 0) {
+            depth.asks.erase(update.price);
+        } else {
+            depth.asks[update.price] = update.total_volume;
+        }
+    }
+}
+
+void MarketDataPublisher::flushPending() {
+    for (size_t i = 0; i < pending_.size(); i += max_entries_) {
+        const size_t count = std::min(max_entries_, pending_.size() - i);
+        sendDatagram(MdMessageType::Incremental, 0, 0, pending_.data() + i, count);
+        stats_.updates_published += count;
+    }
+    pending_.clear();
+    pending_index_.clear();
+}
+
+void MarketDataPublisher::sendSnapshots() {
+    for (auto it = depth_.begin(); it != depth_.end();) {
+        // An empty book still gets one (empty) snapshot so receivers clear it,
+        // and is then forgotten until it trades again.
+        const size_t levels = sendSnapshot(it->first, it->second);
+        it = levels == 0 ? depth_.erase(it) : std::next(it);
+    }
+}
+
+size_t MarketDataPublisher::sendSnapshot(InstrumentID instrument, const Depth& depth) {
+    // Bids then asks, best price first on each side.
+    std::vector<LevelUpdate>& levels = snapshot_levels_;
+    levels.clear();
+    for (const auto& level : depth.bids) {
+        levels.push_back({level.first, level.second, 'B', 0, instrument});
+    }
+    for (const auto& level : depth.asks) {
+        levels.push_back({level.first, level.second, 'A', 0, instrument});
+    }
+
+    size_t sent = 0;
+    do {
+        const size_t count = std::min(max_entries_, levels.size() - sent);
+        uint8_t flags = 0;
+        if (sent == 0) {
+            flags |= MD_FLAG_SNAPSHOT_BEGIN;
+        }
+        if (sent + count == levels.size()) {
+            flags |= MD_FLAG_SNAPSHOT_END;
+        }
+        sendDatagram(MdMessageType::Snapshot, flags, instrument, levels.data() + sent, count);
+        sent += count;
+    } while (sent < levels.size());
+    ++stats_.snapshots;
+    return levels.size();
+}
+
+void MarketDataPublisher::sendDatagram(MdMessageType type, uint8_t flags, InstrumentID instrument,
+                                       const LevelUpdate* entries, size_t count) {
+    MdHeader header{};
+    header.magic = MD_MAGIC;
+    header.version = MD_VERSION;
+    header.type = static_cast<uint8_t>(type);
+    header.flags = flags;
+    header.count = static_cast<uint16_t>(count);
+    header.instrument_id = instrument;
+    header.sequence = ++sequence_;
+    header.send_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::memcpy(datagram_.data(), &header, sizeof(header));
+    std::memcpy(datagram_.data() + sizeof(header), entries, count * sizeof(LevelUpdate));
+    const size_t length = sizeof(header) + count * sizeof(LevelUpdate);
+    if (sock_fd_ < 0 || send(sock_fd_, datagram_.data(), length, 0) < 0) {
+        ++stats_.send_errors;
+        return;
+    }
+    ++stats_.datagrams;
+}
@@ -0,0 +1,110 @@
+#include "OrderIndex.h"
+#include "OrderStorage.h"
+#include <new>
+#include <utility>
+
+template <typename Handle, Handle NIL>
+BasicOrderIndex<Handle, NIL>::BasicOrderIndex(size_t expected_orders, double max_load_factor,
+                                              const LargePageConfig& pages)
+    : max_load_factor_(max_load_factor), pages_(pages) {
+    // Pick the smallest power of two that holds the expected orders below the load factor.
+    size_t slot_count = 16;
+    while (static_cast<double>(slot_count) * max_load_factor_ < static_cast<double>(expected_orders)) {
+        slot_count <<= 1;
+    }
+    allocate(slot_count);
+}
+
+template <typename Handle, Handle NIL>
+void BasicOrderIndex<Handle, NIL>::insert(OrderID id, Handle order) {
+    // 1. If the ID is already present, just replace its order.
+    const size_t existing = findSlot(id);
+    if (existing != NOT_FOUND) {
+        slots_[existing].order = order;
+        return;
+    }
+
+    if (size_ >= max_size_) {
+        grow();
+    }
+
+    // 2. Robin Hood insertion. Walk from the home slot carrying the new entry.
+    // Whenever we meet an entry that is closer to its home than the carried one,
+    // swap them and carry the displaced entry onwards instead.
+    Slot carried{id, order};
+    size_t i = home(id);
+    for (size_t dist = 0;; ++dist, i = (i + 1) & mask_) {
+        Slot& slot = slots_[i];
+        if (slot.order == NIL) {
+            slot = carried;
+            ++size_;
+            return;
+        }
+        const size_t slot_dist = distance(i);
+        if (slot_dist < dist) {
+            std::swap(slot, carried);
+            dist = slot_dist;
+        }
+    }
+}
+
+template <typename Handle, Handle NIL>
+Handle BasicOrderIndex<Handle, NIL>::erase(OrderID id) {
+    // 1. Find the entry.
+    size_t hole = findSlot(id);
+    if (hole == NOT_FOUND) {
+        return NIL;
+    }
+    Handle removed = slots_[hole].order;
+
+    // 2. Backward-shift deletion. Move each following entry back one slot until we
+    // reach an empty slot or an entry that is already at its home slot.
+    size_t next = (hole + 1) & mask_;
+    while (slots_[next].order != NIL && distance(next) != 0) {
+        slots_[hole] = slots_[next];
+        hole = next;
+        next = (next + 1) & mask_;
+    }
+    slots_[hole] = Slot{};
+    --size_;
+    return removed;
+}
+
+template <typename Handle, Handle NIL>
+void BasicOrderIndex<Handle, NIL>::allocate(size_t slot_count) {
+    memory_ = LargeBuffer(slot_count * sizeof(Slot), pages_);
+    slots_ = static_cast<Slot*>(memory_.data());
+    // Zeroed memory is a table of empty slots only if NIL is zero.
+    if constexpr (NIL != Handle{}) {
+        for (size_t i = 0; i < slot_count; ++i) {
+            new (&slots_[i]) Slot{};
+        }
+    }
+    mask_ = slot_count - 1;
+    // The smallest table (16 slots) still holds two runs, so the shift is below 64.
+    run_shift_ = 64 - static_cast<unsigned>(__builtin_ctzll(slot_count / RUN_SLOTS));
+    max_size_ = static_cast<size_t>(static_cast<double>(slot_count) * max_load_factor_);
+    // Always leave at least one empty slot so probes terminate.
+    if (max_size_ >= slot_count) {
+        max_size_ = slot_count - 1;
+    }
+}
+
+template <typename Handle, Handle NIL>
+void BasicOrderIndex<Handle, NIL>::grow() {
+    // Only reached if the book holds more live orders than it was sized for.
+    const LargeBuffer old_memory = std::move(memory_);
+    const Slot* old_slots = slots_;
+    const size_t old_count = mask_ + 1;
+    allocate(old_count * 2);
+    size_ = 0;
+    for (size_t i = 0; i < old_count; ++i) {
+        if (old_slots[i].order != NIL) {
+            insert(old_slots[i].id, old_slots[i].order);
+        }
+    }
+}
+
+// One index per order storage handle type.
+template class BasicOrderIndex<Order*, nullptr>;
+template class BasicOrderIndex<CompactHandle, COMPACT_NIL>;
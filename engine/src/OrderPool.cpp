@@ -0,0 +1,27 @@
+#include "OrderPool.h"
+
+OrderPool::OrderPool(const OrderPoolConfig& config) : config_(config) {
+    // Reserve the chunk list so growing never has to reallocate it on the hot path.
+    chunks_.reserve(64);
+    addChunk(config_.capacity);
+}
+
+Order* OrderPool::acquireSlow() {
+    if (config_.policy == PoolOverflowPolicy::Reject || config_.grow_chunk_size == 0) {
+        ++rejected_count_;
+        return nullptr;
+    }
+    addChunk(config_.grow_chunk_size);
+    ++in_use_;
+    return new (next_unused_++) Order();
+}
+
+void OrderPool::addChunk(size_t num_slots) {
+    // This only reserves address space (unless the config prefaults it); the
+    // OS maps each page the first time a slot in it is handed out.
+    chunks_.emplace_back(num_slots * sizeof(Order), config_.pages);
+    Order* chunk = static_cast<Order*>(chunks_.back().data());
+    next_unused_ = chunk;
+    chunk_end_ = chunk + num_slots;
+    capacity_ += num_slots;
+}
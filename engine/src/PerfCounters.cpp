@@ -0,0 +1,309 @@
+#include "PerfCounters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#if PANOPTES_PERF_COUNTERS
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char* const STAGE_NAMES[] = {"receive", "parse", "book_update"};
+const char* const COUNTER_NAMES[] = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"};
+
+std::string eventTypeName(size_t index) {
+    if (index < sizeof(LatencyReport::EVENT_TYPES)) {
+        return std::string(1, LatencyReport::EVENT_TYPES[index]);
+    }
+    return "other";
+}
+
+double perMessage(uint64_t total, uint64_t messages) {
+    return messages == 0 ? 0.0 : static_cast<double>(total) / static_cast<double>(messages);
+}
+
+} // namespace
+
+void PerfReport::record(PerfStage stage, char event_type, const PerfValues& delta, uint64_t messages, bool scaled) {
+    Row& row = rows_[static_cast<size_t>(stage)][LatencyReport::eventTypeIndex(event_type)];
+    ++row.samples;
+    row.messages += messages;
+    row.scaled += scaled ? 1 : 0;
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+        row.totals[i] += delta[i];
+    }
+}
+
+void PerfReport::recordUnavailable(PerfStage stage, char event_type) {
+    ++rows_[static_cast<size_t>(stage)][LatencyReport::eventTypeIndex(event_type)].unavailable;
+}
+
+void PerfReport::setProbeCost(const PerfValues& cost, double probe_ns, uint32_t sample_every) {
+    probe_cost_ = cost;
+    probe_ns_ = probe_ns;
+    sample_every_ = sample_every;
+}
+
+void PerfReport::merge(const PerfReport& other) {
+    for (size_t stage = 0; stage < rows_.size(); ++stage) {
+        for (size_t type = 0; type < LatencyReport::NUM_EVENT_TYPES; ++type) {
+            Row& row = rows_[stage][type];
+            const Row& theirs = other.rows_[stage][type];
+            row.samples += theirs.samples;
+            row.messages += theirs.messages;
+            row.scaled += theirs.scaled;
+            row.unavailable += theirs.unavailable;
+            for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                row.totals[i] += theirs.totals[i];
+            }
+        }
+    }
+    if (other.sample_every_ != 0) {
+        setProbeCost(other.probe_cost_, other.probe_ns_, other.sample_every_);
+    }
+}
+
+void PerfReport::printText(std::ostream& out) const {
+    if (!PERF_COUNTERS_COMPILED_IN) {
+        out << "Hardware counters: not compiled in (build with PANOPTES_PERF_COUNTERS)\n";
+        out.flush();
+        return;
+    }
+    out << std::left << std::setw(14) << "stage" << std::setw(7) << "event" << std::right
+        << std::setw(10) << "samples" << std::setw(7) << "IPC" << std::setw(10) << "cycles"
+        << std::setw(10) << "instrs" << std::setw(9) << "L1D" << std::setw(9) << "LLC"
+        << std::setw(9) << "br-miss" << std::setw(9) << "dTLB" << "   (per message; receive: per datagram)\n";
+    out << std::fixed;
+    bool any = false;
+    for (size_t stage = 0; stage < rows_.size(); ++stage) {
+        for (size_t type = 0; type < LatencyReport::NUM_EVENT_TYPES; ++type) {
+            const Row& row = rows_[stage][type];
+            if (row.samples == 0 && row.unavailable == 0) {
+                continue;
+            }
+            any = true;
+            if (row.samples == 0) {
+                // Zeros here would read as a real result; they are not one.
+                out << std::left << std::setw(14) << STAGE_NAMES[stage] << std::setw(7) << eventTypeName(type)
+                    << std::right << std::setw(10) << 0 << "   unavailable: the counters were never scheduled in "
+                    << row.unavailable << " samples\n";
+                continue;
+            }
+            const uint64_t cycles = row.totals[static_cast<size_t>(PerfCounter::Cycles)];
+            const uint64_t instructions = row.totals[static_cast<size_t>(PerfCounter::Instructions)];
+            out << std::left << std::setw(14) << STAGE_NAMES[stage] << std::setw(7) << eventTypeName(type)
+                << std::right << std::setw(10) << row.samples << std::setprecision(2) << std::setw(7)
+                << (cycles == 0 ? 0.0 : static_cast<double>(instructions) / static_cast<double>(cycles))
+                << std::setprecision(1);
+            for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                out << std::setw(i < 2 ? 10 : 9) << perMessage(row.totals[i], row.messages);
+            }
+            if (row.scaled != 0 || row.unavailable != 0) {
+                out << "   (" << row.scaled << " scaled, " << row.unavailable << " unavailable)";
+            }
+            out << "\n";
+        }
+    }
+    if (!any) {
+        out << "(no samples: the counters could not be opened, see above)\n";
+    }
+    if (sample_every_ != 0) {
+        // The probe's counts are subtracted from every sample; its time is not,
+        // so bound what it adds to the average message.
+        out << "Probe: 1 in " << sample_every_ << " sampled, " << std::setprecision(0) << probe_ns_
+            << " ns and " << probe_cost_[static_cast<size_t>(PerfCounter::Instructions)]
+            << " counted instructions per sample (subtracted), <= " << std::setprecision(1)
+            << probe_ns_ / sample_every_ << " ns per message on average\n";
+    }
+    out << std::defaultfloat;
+    out.flush();
+}
+
+bool PerfReport::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "{\n  \"compiled_in\": " << (PERF_COUNTERS_COMPILED_IN ? "true" : "false")
+        << ",\n  \"sample_every\": " << sample_every_ << ",\n  \"probe_ns\": " << probe_ns_
+        << ",\n  \"stages\": {";
+    for (size_t stage = 0; stage < rows_.size(); ++stage) {
+        out << (stage == 0 ? "\n" : ",\n") << "    \"" << STAGE_NAMES[stage] << "\": {";
+        bool first = true;
+        for (size_t type = 0; type < LatencyReport::NUM_EVENT_TYPES; ++type) {
+            const Row& row = rows_[stage][type];
+            if (row.samples == 0 && row.unavailable == 0) {
+                continue;
+            }
+            out << (first ? "\n" : ",\n") << "      \"" << eventTypeName(type) << "\": {"
+                << "\"samples\": " << row.samples << ", \"messages\": " << row.messages;
+            // Totals, so scripts can aggregate runs before dividing.
+            for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+                out << ", \"" << COUNTER_NAMES[i] << "\": " << row.totals[i];
+            }
+            // Samples extrapolated from part of their time on the PMU, and
+            // samples with no counts at all (left out of the totals).
+            out << ", \"scaled\": " << row.scaled << ", \"unavailable\": " << row.unavailable << "}";
+            first = false;
+        }
+        out << (first ? "}" : "\n    }");
+    }
+    out << "\n  }\n}\n";
+    return static_cast<bool>(out);
+}
+
+#if PANOPTES_PERF_COUNTERS
+
+namespace {
+
+// Type and config of each counter, in PerfCounter order.
+struct CounterSpec {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cacheEvent(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+const CounterSpec COUNTER_SPECS[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+};
+static_assert(sizeof(COUNTER_SPECS) / sizeof(COUNTER_SPECS[0]) == NUM_PERF_COUNTERS, "one spec per counter");
+
+int openCounter(const CounterSpec& spec, int group_fd, bool include_kernel) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // The leader starts disabled; the whole group is enabled at once.
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = include_kernel ? 0 : 1;
+    attr.exclude_hv = 1;
+    // This thread only (pid 0), on whichever CPU it runs.
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+} // namespace
+
+PerfCounterGroup::~PerfCounterGroup() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounterGroup::open(bool include_kernel) {
+    // 1. The cycle counter leads the group. Without kernel counting
+    // permission, fall back to user mode.
+    fds_[0] = openCounter(COUNTER_SPECS[0], -1, include_kernel);
+    if (fds_[0] < 0 && include_kernel && (errno == EACCES || errno == EPERM)) {
+        include_kernel = false;
+        fds_[0] = openCounter(COUNTER_SPECS[0], -1, false);
+    }
+    if (fds_[0] < 0) {
+        perror("perf_event_open failed");
+        return false;
+    }
+    slot_[0] = 0;
+    num_open_ = 1;
+
+    // 2. The rest join it. A counter this CPU lacks is left out and reads as zero.
+    for (size_t i = 1; i < NUM_PERF_COUNTERS; ++i) {
+        fds_[i] = openCounter(COUNTER_SPECS[i], fds_[0], include_kernel);
+        if (fds_[i] >= 0) {
+            slot_[i] = static_cast<int>(num_open_++);
+        } else {
+            std::fprintf(stderr, "perf counter %s unavailable: %s\n", COUNTER_NAMES[i], std::strerror(errno));
+        }
+    }
+
+    // 3. Start them together, so every read sees the same interval on each.
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    // 4. A group that opens can still never be scheduled, if something else
+    // holds the counters it needs. Say so now; samples will show as unavailable.
+    PerfReading before;
+    PerfReading after;
+    read(before);
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < 100000; ++i) {
+        sink = sink + i;
+    }
+    read(after);
+    if (after.time_running == before.time_running) {
+        std::fprintf(stderr, "perf counters opened but are not being scheduled (is the NMI watchdog or another "
+                             "perf user holding counters?); samples will be reported as unavailable\n");
+    } else if (after.time_running - before.time_running < after.time_enabled - before.time_enabled) {
+        std::fprintf(stderr, "perf counters are being multiplexed; samples will be scaled up\n");
+    }
+    return true;
+}
+
+void PerfCounterGroup::read(PerfReading& reading) const {
+    // PERF_FORMAT_GROUP with both times: the number of counters, the time
+    // enabled, the time running, then each value in open order.
+    uint64_t buffer[3 + NUM_PERF_COUNTERS] = {};
+    if (::read(fds_[0], buffer, sizeof(buffer)) < 0) {
+        reading = PerfReading{};
+        return;
+    }
+    reading.time_enabled = buffer[1];
+    reading.time_running = buffer[2];
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+        reading.values[i] = slot_[i] >= 0 ? buffer[3 + slot_[i]] : 0;
+    }
+}
+
+bool PerfProbe::open() {
+    if (config_.sample_every == 0 || !group_.open(config_.include_kernel)) {
+        countdown_ = 0;
+        return false;
+    }
+
+    // Measure an empty begin()/end() pair: the counts it adds are subtracted
+    // from every sample, and its time bounds the probe's overhead. The median
+    // of a few hundred pairs keeps a preemption out of it.
+    constexpr size_t CALIBRATION_PAIRS = 256;
+    std::array<std::array<uint64_t, CALIBRATION_PAIRS>, NUM_PERF_COUNTERS> counts;
+    std::array<double, CALIBRATION_PAIRS> nanos;
+    for (size_t pair = 0; pair < CALIBRATION_PAIRS; ++pair) {
+        PerfReading before;
+        PerfReading after;
+        const auto start = std::chrono::steady_clock::now();
+        group_.read(before);
+        group_.read(after);
+        nanos[pair] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+            counts[i][pair] = after.values[i] - before.values[i];
+        }
+    }
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+        std::nth_element(counts[i].begin(), counts[i].begin() + CALIBRATION_PAIRS / 2, counts[i].end());
+        cost_[i] = counts[i][CALIBRATION_PAIRS / 2];
+    }
+    std::nth_element(nanos.begin(), nanos.begin() + CALIBRATION_PAIRS / 2, nanos.end());
+    report_.setProbeCost(cost_, nanos[CALIBRATION_PAIRS / 2], config_.sample_every);
+
+    countdown_ = config_.sample_every;
+    return true;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "PriceLadder.h"
+#include "OrderStorage.h"
+#include <algorithm>
+
+template <typename Level, size_t FixedWindow>
+BasicPriceLadder<Level, FixedWindow>::BasicPriceLadder(size_t window_levels)
+    : window_size_(FixedWindow != 0 ? FixedWindow : window_levels < 64 ? 64 : window_levels),
+      occupied_(window_size_) {
+    window_.reset(new Level[window_size_]);
+    // Start centred on tick 0; the book recenters on the first order it sees.
+    window_begin_ = -static_cast<Tick>(window_size_ / 2);
+}
+
+template <typename Level, size_t FixedWindow>
+Level& BasicPriceLadder<Level, FixedWindow>::overflowLevel(Tick tick) {
+    return overflow_[tick];
+}
+
+template <typename Level, size_t FixedWindow>
+void BasicPriceLadder<Level, FixedWindow>::eraseOverflow(Tick tick) {
+    overflow_.erase(tick);
+}
+
+template <typename Level, size_t FixedWindow>
+const Level* BasicPriceLadder<Level, FixedWindow>::findOverflow(Tick tick) const {
+    auto it = overflow_.find(tick);
+    return it == overflow_.end() ? nullptr : &it->second;
+}
+
+template <typename Level, size_t FixedWindow>
+typename BasicPriceLadder<Level, FixedWindow>::Tick BasicPriceLadder<Level, FixedWindow>::highestWithOverflow() const {
+    // Only called with a non-empty overflow.
+    // 1. Anything in the overflow above the window beats the whole window.
+    if (overflow_.rbegin()->first >= windowEnd()) {
+        return overflow_.rbegin()->first;
+    }
+    // 2. Otherwise the best is in the window if the window has anything at all.
+    const size_t slot = occupied_.highest();
+    if (slot != PriceBitmap::NPOS) {
+        return window_begin_ + static_cast<Tick>(slot);
+    }
+    // 3. Failing that, the top of the overflow (which must be below the window).
+    return overflow_.rbegin()->first;
+}
+
+template <typename Level, size_t FixedWindow>
+typename BasicPriceLadder<Level, FixedWindow>::Tick BasicPriceLadder<Level, FixedWindow>::lowestWithOverflow() const {
+    if (overflow_.begin()->first < window_begin_) {
+        return overflow_.begin()->first;
+    }
+    const size_t slot = occupied_.lowest();
+    if (slot != PriceBitmap::NPOS) {
+        return window_begin_ + static_cast<Tick>(slot);
+    }
+    return overflow_.begin()->first;
+}
+
+template <typename Level, size_t FixedWindow>
+typename BasicPriceLadder<Level, FixedWindow>::Tick BasicPriceLadder<Level, FixedWindow>::nextBelowWithOverflow(Tick tick) const {
+    // The window and the overflow never hold the same tick: take the higher
+    // of the best candidate from each.
+    const Tick in_window = nextBelowInWindow(tick);
+    auto it = overflow_.lower_bound(tick);
+    if (it == overflow_.begin()) {
+        return in_window;
+    }
+    --it;
+    return std::max(in_window, it->first);
+}
+
+template <typename Level, size_t FixedWindow>
+typename BasicPriceLadder<Level, FixedWindow>::Tick BasicPriceLadder<Level, FixedWindow>::nextAboveWithOverflow(Tick tick) const {
+    const Tick in_window = nextAboveInWindow(tick);
+    auto it = overflow_.upper_bound(tick);
+    if (it == overflow_.end()) {
+        return in_window;
+    }
+    return in_window == NO_TICK ? it->first : std::min(in_window, it->first);
+}
+
+template <typename Level, size_t FixedWindow>
+void BasicPriceLadder<Level, FixedWindow>::recenter(Tick tick) {
+    const Tick new_begin = tick - static_cast<Tick>(window_size_ / 2);
+    if (new_begin == window_begin_) {
+        return;
+    }
+    ++recenters_;
+
+    // 1. Spill every occupied window level into the overflow. Levels are plain
+    // head/tail/volume records (orders never point back at them), so they can be
+    // copied anywhere. This walks the bitmap, so an empty window costs nothing.
+    for (size_t slot = occupied_.lowest(); slot != PriceBitmap::NPOS; slot = occupied_.lowest()) {
+        overflow_.emplace(window_begin_ + static_cast<Tick>(slot), window_[slot]);
+        window_[slot] = Level{};
+        occupied_.clear(slot);
+    }
+
+    // 2. Pull every overflow level the new window covers back into it.
+    window_begin_ = new_begin;
+    auto it = overflow_.lower_bound(window_begin_);
+    const Tick end = windowEnd();
+    while (it != overflow_.end() && it->first < end) {
+        const size_t slot = static_cast<size_t>(it->first - window_begin_);
+        window_[slot] = it->second;
+        occupied_.set(slot);
+        it = overflow_.erase(it);
+    }
+}
+
+// One ladder per order storage level type, with a run-time window size and
+// with the fixed window size of the preset book traits (see BookTraits.h).
+template class BasicPriceLadder<PriceLevel>;
+template class BasicPriceLadder<CompactPriceLevel>;
+template class BasicPriceLadder<PriceLevel, DEFAULT_LADDER_WINDOW_LEVELS>;
+template class BasicPriceLadder<CompactPriceLevel, DEFAULT_LADDER_WINDOW_LEVELS>;
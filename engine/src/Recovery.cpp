@@ -0,0 +1,75 @@
+#include "Recovery.h"
+#include "Journal.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+bool recoverBooks(const std::string& snapshot_path, const std::string& journal_path,
+                  BookManager& books, RecoveryStats& stats) {
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t processed_before = books.messagesProcessed();
+    uint64_t submitted = 0;
+
+    // 1. Restore the resting orders from the snapshot.
+    SnapshotHeader header{};
+    std::vector<SnapshotOrder> orders;
+    if (loadSnapshot(snapshot_path, header, orders)) {
+        stats.snapshot_loaded = true;
+        stats.snapshot_sequence = header.journal_sequence;
+        stats.snapshot_orders = orders.size();
+        for (const SnapshotOrder& order : orders) {
+            books.submit({0, order.order_id, order.price, order.size, 'A', order.side, order.instrument_id});
+        }
+        submitted += orders.size();
+    }
+    stats.last_sequence = stats.snapshot_sequence;
+
+    // 2. Replay the journal tail, up to the last complete record.
+    bool ok = true;
+    if (access(journal_path.c_str(), F_OK) == 0) {
+        MappedFile journal;
+        JournalHeader journal_header{};
+        if (!journal.open(journal_path.c_str()) || journal.size() < sizeof(JournalHeader)) {
+            ok = false;
+        } else {
+            std::memcpy(&journal_header, journal.data(), sizeof(journal_header));
+            ok = journal_header.magic == Journal::MAGIC && journal_header.version >= Journal::OLDEST_READABLE_VERSION &&
+                 journal_header.version <= Journal::VERSION && journal_header.record_size == sizeof(JournalRecord) &&
+                 journal_header.capacity > 0;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "%s is not a readable journal\n", journal_path.c_str());
+        } else {
+            // The journal is a ring: start at the record after the snapshot's,
+            // and follow it round for at most one lap.
+            const size_t available = (journal.size() - sizeof(JournalHeader)) / sizeof(JournalRecord);
+            const size_t capacity = std::min<size_t>(journal_header.capacity, available);
+            const JournalRecord* records = reinterpret_cast<const JournalRecord*>(journal.data() + sizeof(JournalHeader));
+            uint64_t sequence = stats.snapshot_sequence;
+            while (sequence - stats.snapshot_sequence < capacity) {
+                const JournalRecord& record = records[Journal::recordIndex(sequence + 1, capacity)];
+                if (record.sequence != sequence + 1) {
+                    break;
+                }
+                books.submit(record.message);
+                ++sequence;
+            }
+            stats.journal_messages = sequence - stats.snapshot_sequence;
+            stats.last_sequence = std::max(stats.last_sequence, sequence);
+            submitted += stats.journal_messages;
+        }
+    }
+
+    // 3. Wait for the workers to apply everything.
+    while (books.messagesProcessed() - processed_before < submitted) {
+        std::this_thread::yield();
+    }
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
@@ -0,0 +1,182 @@
+#include "Replay.h"
+#include "BinaryParser.h"
+#include "OrderBook.h"
+#include "LatencyReport.h"
+#include "MappedFile.h"
+#include "TscClock.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// The books for one pass, one per instrument seen in the capture.
+class ReplayBooks {
+public:
+    explicit ReplayBooks(const ReplayConfig& config) : config_(config), books_(MAX_INSTRUMENTS) {}
+
+    inline OrderBook& get(InstrumentID instrument) {
+        std::unique_ptr<OrderBook>& book = books_[instrument];
+        if (!book) {
+            book = makeOrderBook(config_.variant, config_.pool_config, DEFAULT_INDEX_LOAD_FACTOR,
+                                 config_.ladders.forInstrument(instrument));
+        }
+        return *book;
+    }
+
+private:
+    const ReplayConfig& config_;
+    std::vector<std::unique_ptr<OrderBook>> books_;
+};
+
+// Creates every book the capture needs before the clock starts, so the
+// book allocations (pool, order index and ladder windows) are not part of the timed pass.
+void createBooks(ReplayBooks& books, const char* data, size_t num_messages) {
+    for (size_t i = 0; i < num_messages; ++i) {
+        books.get(parseMessage(data + i * sizeof(PanoptesMessage)).instrument_id);
+    }
+}
+
+// Messages parsed (and validated) per parseBatch call.
+constexpr size_t REPLAY_CHUNK = 64;
+
+// The counter probes for the parse and book update stages. Each has its own,
+// so their sampling cannot fall into step with the chunk size.
+struct ReplayProbes {
+    PerfProbe parse;
+    PerfProbe book_update;
+};
+
+// One pass over the capture. Returns the number of trades produced. 'probes'
+// is null for warm-up passes.
+template <bool MeasureLatency>
+uint64_t replayPass(ReplayBooks& books, const char* data, size_t num_messages, LatencyReport* latency,
+                    ParseStats& parse_stats, ReplayProbes* probes) {
+    uint64_t trades = 0;
+    PanoptesMessage parsed[REPLAY_CHUNK];
+
+    for (size_t start = 0; start < num_messages; start += REPLAY_CHUNK) {
+        const size_t chunk = std::min(REPLAY_CHUNK, num_messages - start);
+        const bool parse_sampled = probes && probes->parse.sample();
+        if (parse_sampled) {
+            probes->parse.begin();
+        }
+        const uint64_t parse_start = MeasureLatency ? TscClock::now() : 0;
+        const size_t valid = parseBatch(data + start * sizeof(PanoptesMessage), chunk, parsed, parse_stats);
+        uint64_t previous_end = MeasureLatency ? TscClock::now() : 0;
+        if (parse_sampled) {
+            probes->parse.end(PerfStage::Parse, 0, chunk);
+            // Keep the counter reads out of the first book update's time.
+            previous_end = MeasureLatency ? TscClock::now() : 0;
+        }
+        const int64_t parse_ns = (MeasureLatency && valid > 0)
+            ? TscClock::toNanos(previous_end - parse_start) / static_cast<int64_t>(valid) : 0;
+
+        for (size_t i = 0; i < valid; ++i) {
+            const PanoptesMessage& msg = parsed[i];
+            OrderBook& book = books.get(msg.instrument_id);
+            const bool sampled = probes && probes->book_update.sample();
+            if (sampled) {
+                probes->book_update.begin();
+            }
+            book.apply(msg);
+            if (sampled) {
+                probes->book_update.end(PerfStage::BookUpdate, msg.event_type);
+            }
+            trades += book.trades().size();
+            book.trades().clear();
+
+            if (MeasureLatency) {
+                // Parsing is done a chunk at a time, so each message is charged
+                // its share of the chunk; its book update is timed on its own.
+                // A sampled update's time includes the counter reads, so it is left out.
+                const uint64_t updated = TscClock::now();
+                latency->at(LatencyStage::Parse, msg.event_type).record(parse_ns);
+                if (!sampled) {
+                    latency->at(LatencyStage::BookUpdate, msg.event_type).record(TscClock::toNanos(updated - previous_end));
+                }
+                previous_end = updated;
+            }
+        }
+    }
+    return trades;
+}
+
+} // namespace
+
+int runReplay(const ReplayConfig& config) {
+    MappedFile capture;
+    if (!capture.open(config.path.c_str())) {
+        std::cerr << "Error: Could not map capture file " << config.path << std::endl;
+        return 1;
+    }
+    const size_t num_messages = capture.size() / sizeof(PanoptesMessage);
+    if (capture.size() % sizeof(PanoptesMessage) != 0) {
+        std::cerr << "Warning: ignoring " << capture.size() % sizeof(PanoptesMessage)
+                  << " trailing bytes (not a whole message)" << std::endl;
+    }
+    std::cout << "Replaying " << num_messages << " messages from " << config.path << " ("
+              << config.warmup_iterations << " warm-up + " << config.iterations << " timed passes)" << std::endl;
+
+    TscClock::calibrate();
+    LatencyReport latency;
+    PerfReport perf;
+    ReplayProbes probes{PerfProbe(config.perf, perf), PerfProbe(config.perf, perf)};
+    probes.parse.open();
+    probes.book_update.open();
+    ParseStats parse_stats;
+    uint64_t total_messages = 0;
+    double total_seconds = 0.0;
+
+    for (size_t pass = 0; pass < config.warmup_iterations + config.iterations; ++pass) {
+        const bool warmup = pass < config.warmup_iterations;
+
+        // Fresh books for every pass, so each one replays the capture from scratch.
+        ReplayBooks books(config);
+        ParseStats pass_stats;
+        createBooks(books, capture.data(), num_messages);
+
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t trades = (config.measure_latency && !warmup)
+            ? replayPass<true>(books, capture.data(), num_messages, &latency, pass_stats, &probes)
+            : replayPass<false>(books, capture.data(), num_messages, nullptr, pass_stats, warmup ? nullptr : &probes);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (warmup ? "Warm-up pass " : "Pass ") << (warmup ? pass + 1 : pass - config.warmup_iterations + 1)
+                  << ": " << num_messages / seconds / 1e6 << " M msgs/s (" << seconds * 1e3 << " ms, "
+                  << trades << " trades)" << std::endl;
+        parse_stats = pass_stats; // Every pass sees the same capture.
+        if (!warmup) {
+            total_messages += num_messages;
+            total_seconds += seconds;
+        }
+    }
+
+    std::cout << "------------------------------------------" << std::endl;
+    std::cout << "           REPLAY SUMMARY" << std::endl;
+    std::cout << "------------------------------------------" << std::endl;
+    std::cout << "Messages replayed: " << total_messages << std::endl;
+    std::cout << "Rejected per pass: " << parse_stats.rejected() << " (" << parse_stats.bad_event_type
+              << " bad event type, " << parse_stats.bad_side << " bad side, " << parse_stats.bad_size
+              << " bad size, " << parse_stats.bad_price << " bad price)" << std::endl;
+    if (total_seconds > 0.0) {
+        std::cout << "Throughput: " << total_messages / total_seconds / 1e6 << " M msgs/s" << std::endl;
+        std::cout << "Mean time per message: " << total_seconds * 1e9 / total_messages << " ns" << std::endl;
+    }
+    if (config.measure_latency) {
+        latency.printText(std::cout);
+        if (latency.writeJson(config.latency_path)) {
+            std::cout << "Latency report written to " << config.latency_path << std::endl;
+        }
+    }
+    if (PERF_COUNTERS_COMPILED_IN && config.perf.sample_every != 0) {
+        perf.printText(std::cout);
+        if (perf.writeJson(config.perf_path)) {
+            std::cout << "Counter report written to " << config.perf_path << std::endl;
+        }
+    }
+    std::cout << "------------------------------------------" << std::endl;
+    return 0;
+}
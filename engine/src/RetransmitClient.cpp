@@ -0,0 +1,51 @@
+#include "RetransmitClient.h"
+#include <cstdio>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+RetransmitClient::RetransmitClient(const std::string& address, int port) : address_(address), port_(port) {}
+
+RetransmitClient::~RetransmitClient() {
+    if (sock_fd_ >= 0) {
+        close(sock_fd_);
+    }
+}
+
+bool RetransmitClient::open() {
+    sockaddr_in service{};
+    service.sin_family = AF_INET;
+    service.sin_port = htons(port_);
+    if (inet_pton(AF_INET, address_.c_str(), &service.sin_addr) != 1) {
+        std::fprintf(stderr, "Invalid retransmit service address: %s\n", address_.c_str());
+        return false;
+    }
+    sock_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_fd_ < 0) {
+        perror("retransmit socket creation failed");
+        return false;
+    }
+    // Retransmissions come in bursts of full frames; give them room.
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(sock_fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (connect(sock_fd_, reinterpret_cast<const sockaddr*>(&service), sizeof(service)) < 0) {
+        perror("retransmit connect failed");
+        return false;
+    }
+    return true;
+}
+
+void RetransmitClient::request(const RetransmitRequest& request) {
+    RetransmitRequest wire = request;
+    swapWireByteOrder(wire);
+    // A lost request just means the gap times out; there is nothing to retry here.
+    if (send(sock_fd_, &wire, sizeof(wire), 0) == static_cast<ssize_t>(sizeof(wire))) {
+        ++requests_sent_;
+    }
+}
+
+size_t RetransmitClient::receive(char* buffer, size_t size) {
+    const ssize_t n = recv(sock_fd_, buffer, size, MSG_DONTWAIT);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
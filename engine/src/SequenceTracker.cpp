@@ -0,0 +1,148 @@
+#include "SequenceTracker.h"
+#include <algorithm>
+
+SequenceTracker::SequenceTracker(const SequenceTrackerConfig& config) : config_(config) {}
+
+SequenceTracker::Stream& SequenceTracker::streamFor(const FrameHeader& header, uint64_t source) {
+    if ((header.flags & FRAME_FLAG_RETRANSMIT) != 0) {
+        // Only asked for while a gap is open, so this search is off the hot path.
+        for (auto& entry : streams_) {
+            Stream& stream = entry.second;
+            if (stream.active && static_cast<uint16_t>(entry.first) == header.stream_id &&
+                stream.session_id == header.session_id) {
+                return stream;
+            }
+        }
+    }
+    return streams_[streamKey(source, header.stream_id)];
+}
+
+void SequenceTracker::onFrame(const FrameHeader& header, const char* messages, int64_t now_ns, SequencedSink& sink,
+                              uint64_t source) {
+    ++stats_.frames;
+    const size_t count = header.message_count;
+    const bool retransmit = (header.flags & FRAME_FLAG_RETRANSMIT) != 0;
+    const uint64_t first = header.first_sequence;
+    const uint64_t end = first + count;
+
+    // 1. A stream we have not seen, or a sender that restarted: start following
+    //    its numbering from here. Anything held for the old session goes first.
+    Stream& stream = streamFor(header, source);
+    if (!stream.active || stream.session_id != header.session_id) {
+        if (stream.active) {
+            ++stats_.session_resets;
+            while (!stream.held.empty()) {
+                skipGap(stream, sink);
+            }
+        }
+        stream.active = true;
+        stream.session_id = header.session_id;
+        stream.next = first;
+        stream.high = first;
+    }
+
+    // 2. Entirely old: a duplicate, or a retransmission that arrived twice.
+    if (end <= stream.next) {
+        stats_.duplicates += count;
+        return;
+    }
+
+    // 3. Starts at (or overlaps) the next expected message: deliver it, and then
+    //    anything held that now follows on.
+    if (first <= stream.next) {
+        deliverFrom(stream, first, messages, count, retransmit, sink);
+        drainHeld(stream, sink);
+        return;
+    }
+
+    // 4. There is a gap in front of this frame.
+    if (!config_.retransmit) {
+        ++stats_.gaps;
+        stats_.gap_messages += first - stream.next;
+        stats_.lost += first - stream.next;
+        stream.next = first;
+        deliverFrom(stream, first, messages, count, retransmit, sink);
+        return;
+    }
+    if (first > stream.high) {
+        // Only ask for the part we have not already asked for.
+        ++stats_.gaps;
+        stats_.gap_messages += first - stream.high;
+        sink.requestRetransmit({RETRANSMIT_MAGIC, header.stream_id, 0, header.session_id,
+                                static_cast<uint32_t>(first - stream.high), stream.high});
+    }
+    stream.high = std::max(stream.high, end);
+
+    if (stream.held.count(first) != 0) {
+        stats_.duplicates += count;
+        return;
+    }
+    if (stream.held.empty()) {
+        ++held_streams_;
+        stream.gap_since_ns = now_ns;
+    }
+    stream.held.emplace(first, HeldFrame{std::vector<char>(messages, messages + count * sizeof(PanoptesMessage)),
+                                         count, retransmit});
+    stream.held_messages += count;
+    if (stream.held_messages > config_.max_held_messages) {
+        while (!stream.held.empty()) {
+            skipGap(stream, sink);
+        }
+    }
+}
+
+void SequenceTracker::poll(int64_t now_ns, SequencedSink& sink) {
+    if (held_streams_ == 0) {
+        return;
+    }
+    for (auto& entry : streams_) {
+        Stream& stream = entry.second;
+        if (!stream.held.empty() && now_ns - stream.gap_since_ns >= config_.gap_timeout_ns) {
+            skipGap(stream, sink);
+            // Any gap still open behind it gets a full timeout of its own.
+            stream.gap_since_ns = now_ns;
+        }
+    }
+}
+
+void SequenceTracker::deliverFrom(Stream& stream, uint64_t first, const char* messages, size_t count, bool retransmit,
+                                  SequencedSink& sink) {
+    const size_t skip = static_cast<size_t>(stream.next - first);
+    const size_t fresh = count - skip;
+    stats_.duplicates += skip;
+    sink.deliver(messages + skip * sizeof(PanoptesMessage), fresh);
+    stats_.messages += fresh;
+    if (retransmit) {
+        stats_.retransmitted += fresh;
+    }
+    stream.next = first + count;
+    stream.high = std::max(stream.high, stream.next);
+}
+
+void SequenceTracker::drainHeld(Stream& stream, SequencedSink& sink) {
+    if (stream.held.empty()) {
+        return;
+    }
+    while (!stream.held.empty() && stream.held.begin()->first <= stream.next) {
+        auto it = stream.held.begin();
+        const uint64_t first = it->first;
+        HeldFrame frame = std::move(it->second);
+        stream.held.erase(it);
+        stream.held_messages -= frame.count;
+        if (first + frame.count <= stream.next) {
+            stats_.duplicates += frame.count;
+        } else {
+            deliverFrom(stream, first, frame.messages.data(), frame.count, frame.retransmit, sink);
+        }
+    }
+    if (stream.held.empty()) {
+        --held_streams_;
+    }
+}
+
+void SequenceTracker::skipGap(Stream& stream, SequencedSink& sink) {
+    const uint64_t resume = stream.held.begin()->first;
+    stats_.lost += resume - stream.next;
+    stream.next = resume;
+    drainHeld(stream, sink);
+}
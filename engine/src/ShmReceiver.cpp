@@ -0,0 +1,124 @@
+#include "ShmReceiver.h"
+#include "CpuRelax.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+#include <thread>
+
+ShmReceiver::ShmReceiver(const ShmReceiverConfig& config)
+    : config_(config), data_(config.batch_size), lengths_(config.batch_size), lanes_(config.batch_size) {}
+
+bool ShmReceiver::open() {
+    if (!segment_.create(config_.name, config_.num_lanes, config_.lane_bytes, config_.buffer_size)) {
+        return false;
+    }
+    cursors_.assign(segment_.numLanes(), LaneCursor{});
+    return true;
+}
+
+size_t ShmReceiver::writersAttached() const {
+    size_t attached = 0;
+    for (size_t i = 0; i < segment_.numLanes(); ++i) {
+        attached += segment_.lane(i).writer_pid.load(std::memory_order_relaxed) != 0;
+    }
+    return attached;
+}
+
+int ShmReceiver::receiveBatch() {
+    release();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.timeout_ms);
+    for (uint32_t polls = 1;; ++polls) {
+        const int received = poll();
+        if (received != 0) {
+            stats_.datagrams += static_cast<uint64_t>(received);
+            ++stats_.batches;
+            return received;
+        }
+        waitForData(polls);
+        // Check the clock only occasionally while spinning.
+        const bool sleeping = !config_.busy_poll && polls >= config_.backoff_spins + config_.backoff_yields;
+        if ((sleeping || (polls & 0xFFF) == 0) && std::chrono::steady_clock::now() >= deadline) {
+            return 0;
+        }
+    }
+}
+
+void ShmReceiver::waitForData(uint32_t idle_polls) {
+    // 1. Spin, with a pause so the loop does not flood the pipeline with
+    // speculative loads of the lanes' tails.
+    if (config_.busy_poll || idle_polls < config_.backoff_spins) {
+        cpuRelax();
+        return;
+    }
+    // 2. Let a sender on this CPU run, but stay runnable.
+    ++stats_.syscalls;
+    if (idle_polls - config_.backoff_spins < config_.backoff_yields) {
+        sched_yield();
+        return;
+    }
+    // 3. The senders have gone quiet: sleep between polls.
+    std::this_thread::sleep_for(std::chrono::microseconds(config_.backoff_sleep_us));
+}
+
+void ShmReceiver::release() {
+    for (size_t i = 0; i < cursors_.size(); ++i) {
+        LaneCursor& cursor = cursors_[i];
+        if (cursor.head != cursor.released) {
+            segment_.lane(i).head.store(cursor.head, std::memory_order_release);
+            cursor.released = cursor.head;
+        }
+    }
+}
+
+int ShmReceiver::poll() {
+    const size_t num_lanes = cursors_.size();
+    const uint64_t capacity = segment_.laneBytes();
+    const uint64_t mask = capacity - 1;
+    size_t received = 0;
+    for (size_t n = 0; n < num_lanes && received < config_.batch_size; ++n) {
+        const size_t i = (next_lane_ + n) % num_lanes;
+        LaneCursor& cursor = cursors_[i];
+
+        // 1. Refresh the sender's index only when the cached one says the lane
+        // is empty. The acquire pairs with the sender's publish, so the records
+        // up to it are all written.
+        if (cursor.head == cursor.cached_tail) {
+            cursor.cached_tail = segment_.lane(i).tail.load(std::memory_order_acquire);
+            if (cursor.head == cursor.cached_tail) {
+                continue;
+            }
+        }
+
+        // 2. Take records until the lane is empty or the batch is full.
+        const char* records = segment_.records(i);
+        while (cursor.head != cursor.cached_tail && received < config_.batch_size) {
+            const uint64_t offset = cursor.head & mask;
+            uint32_t length;
+            std::memcpy(&length, records + offset, sizeof(length));
+            if (length == SHM_RING_WRAP) {
+                cursor.head += capacity - offset;
+                continue;
+            }
+            // A writer that follows the protocol can never leave a record
+            // longer than the segment allows or running past the end of the
+            // lane. One that does (a stray or half-dead writer) has lost the
+            // framing, so skip everything it has published rather than hand
+            // the parser bytes from outside the record.
+            if (length > segment_.maxDatagram() || offset + shmRingRecordBytes(length) > capacity) {
+                fprintf(stderr, "Ring lane %zu holds a record of %u bytes at offset %llu; skipping the lane's data\n",
+                        i, length, static_cast<unsigned long long>(offset));
+                ++stats_.corrupt_lanes;
+                cursor.head = cursor.cached_tail;
+                break;
+            }
+            data_[received] = records + offset + SHM_RING_RECORD_HEADER;
+            lengths_[received] = length;
+            lanes_[received] = static_cast<uint32_t>(i);
+            ++received;
+            cursor.head += shmRingRecordBytes(length);
+        }
+    }
+    next_lane_ = (next_lane_ + 1) % num_lanes;
+    return static_cast<int>(received);
+}
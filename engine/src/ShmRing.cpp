@@ -0,0 +1,192 @@
+#include "ShmRing.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+} // namespace
+
+bool ShmRingSegment::create(const std::string& name, size_t num_lanes, size_t lane_bytes, size_t max_datagram) {
+    close();
+    if (num_lanes == 0 || num_lanes > SHM_RING_MAX_LANES) {
+        fprintf(stderr, "A ring segment needs 1 to %zu lanes\n", SHM_RING_MAX_LANES);
+        return false;
+    }
+    // Room for at least two of the largest records, so a record that has to
+    // skip the end of the lane still fits.
+    lane_bytes = roundUpToPowerOfTwo(std::max(lane_bytes, 2 * shmRingRecordBytes(max_datagram)));
+    const size_t bytes = sizeof(ShmRingHeader) + num_lanes * (sizeof(ShmRingLane) + lane_bytes);
+
+    // 1. Create the segment afresh, so a writer can never attach to a stale one.
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) < 0) {
+        perror("ftruncate failed");
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd); // The mapping keeps the segment alive.
+    if (mapped == MAP_FAILED) {
+        perror("mmap failed");
+        shm_unlink(name.c_str());
+        return false;
+    }
+    name_ = name;
+    owner_ = true;
+    memory_ = mapped;
+    bytes_ = bytes;
+    num_lanes_ = num_lanes;
+    lane_bytes_ = lane_bytes;
+    max_datagram_ = max_datagram;
+
+    // 2. Empty, unclaimed lanes.
+    for (size_t i = 0; i < num_lanes; ++i) {
+        ShmRingLane* lane = new (&this->lane(i)) ShmRingLane;
+        lane->tail.store(0, std::memory_order_relaxed);
+        lane->writer_pid.store(0, std::memory_order_relaxed);
+        lane->head.store(0, std::memory_order_relaxed);
+    }
+
+    // 3. Fill in the header, and the magic last so writers see all of it.
+    ShmRingHeader* header = new (memory_) ShmRingHeader;
+    header->layout = SHM_RING_LAYOUT;
+    header->num_lanes = static_cast<uint32_t>(num_lanes);
+    header->lane_bytes = lane_bytes;
+    header->max_datagram = static_cast<uint32_t>(max_datagram);
+    header->magic.store(SHM_RING_MAGIC, std::memory_order_release);
+    return true;
+}
+
+bool ShmRingSegment::attach(const std::string& name) {
+    close();
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        perror("shm_open failed (is the engine running with --shm-ring?)");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat failed");
+        ::close(fd);
+        return false;
+    }
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    if (bytes < sizeof(ShmRingHeader)) {
+        fprintf(stderr, "Ring segment %s is too small to be a ring segment\n", name.c_str());
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap failed");
+        return false;
+    }
+
+    // Refuse anything this build would misread.
+    const ShmRingHeader* header = static_cast<const ShmRingHeader*>(mapped);
+    if (header->magic.load(std::memory_order_acquire) != SHM_RING_MAGIC || header->layout != SHM_RING_LAYOUT ||
+        header->num_lanes == 0 || header->num_lanes > SHM_RING_MAX_LANES ||
+        sizeof(ShmRingHeader) + header->num_lanes * (sizeof(ShmRingLane) + header->lane_bytes) > bytes) {
+        fprintf(stderr, "Ring segment %s is not ready or has a different layout\n", name.c_str());
+        munmap(mapped, bytes);
+        return false;
+    }
+    name_ = name;
+    owner_ = false;
+    memory_ = mapped;
+    bytes_ = bytes;
+    num_lanes_ = header->num_lanes;
+    lane_bytes_ = header->lane_bytes;
+    max_datagram_ = header->max_datagram;
+    return true;
+}
+
+void ShmRingSegment::close() {
+    if (memory_ != nullptr) {
+        munmap(memory_, bytes_);
+        if (owner_) {
+            shm_unlink(name_.c_str());
+        }
+    }
+    memory_ = nullptr;
+    bytes_ = 0;
+    num_lanes_ = 0;
+    lane_bytes_ = 0;
+    max_datagram_ = 0;
+    owner_ = false;
+}
+
+bool ShmRingWriter::open(const std::string& name, size_t lane) {
+    close();
+    if (!segment_.attach(name)) {
+        return false;
+    }
+    if (lane >= segment_.numLanes()) {
+        fprintf(stderr, "Ring segment %s has %zu lanes; there is no lane %zu\n", name.c_str(), segment_.numLanes(),
+                lane);
+        segment_.close();
+        return false;
+    }
+
+    // Claim the lane, so a second writer cannot corrupt it. A claim left by a
+    // writer that died without closing is taken over; anything it staged but
+    // never published is lost, and its published records are still read.
+    lane_ = &segment_.lane(lane);
+    const uint32_t pid = static_cast<uint32_t>(getpid());
+    uint32_t expected = 0;
+    while (!lane_->writer_pid.compare_exchange_strong(expected, pid)) {
+        // On failure 'expected' holds the current claim: 0 if it has just been
+        // given up, else a pid to check.
+        if (expected == 0) {
+            continue;
+        }
+        if (kill(static_cast<pid_t>(expected), 0) == 0 || errno != ESRCH) {
+            fprintf(stderr, "Lane %zu of ring segment %s is already claimed by pid %u\n", lane, name.c_str(),
+                    expected);
+            lane_ = nullptr;
+            segment_.close();
+            return false;
+        }
+        fprintf(stderr, "Reclaiming lane %zu of ring segment %s from pid %u, which has exited\n", lane,
+                name.c_str(), expected);
+    }
+    records_ = segment_.records(lane);
+    capacity_ = segment_.laneBytes();
+    mask_ = capacity_ - 1;
+    staged_ = lane_->tail.load(std::memory_order_relaxed);
+    published_ = staged_;
+    cached_head_ = lane_->head.load(std::memory_order_acquire);
+    return true;
+}
+
+void ShmRingWriter::close() {
+    if (lane_ != nullptr) {
+        publish();
+        lane_->writer_pid.store(0, std::memory_order_release);
+    }
+    lane_ = nullptr;
+    records_ = nullptr;
+    segment_.close();
+}
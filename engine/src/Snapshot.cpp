@@ -0,0 +1,148 @@
+#include "Snapshot.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <unistd.h>
+
+SnapshotWriter::SnapshotWriter(const std::string& path, size_t parts)
+    : path_(path), parts_(parts == 0 ? 1 : parts) {}
+
+SnapshotWriter::~SnapshotWriter() {
+    stop();
+}
+
+void SnapshotWriter::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&SnapshotWriter::run, this);
+}
+
+void SnapshotWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    ready_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SnapshotWriter::submit(uint64_t journal_sequence, std::vector<SnapshotOrder>&& orders) {
+    bool complete;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Pending& pending = pending_[journal_sequence];
+        if (pending.orders.empty()) {
+            pending.orders = std::move(orders);
+        } else {
+            pending.orders.insert(pending.orders.end(), orders.begin(), orders.end());
+        }
+        complete = ++pending.parts == parts_;
+    }
+    if (complete) {
+        ready_.notify_one();
+    }
+}
+
+uint64_t SnapshotWriter::snapshotsWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+uint64_t SnapshotWriter::lastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_sequence_;
+}
+
+void SnapshotWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Find the newest complete snapshot. Anything older is superseded by it.
+        auto complete = pending_.end();
+        for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+            if (it->second.parts == parts_) {
+                complete = it;
+            }
+        }
+        if (complete == pending_.end()) {
+            if (!running_) {
+                break;
+            }
+            ready_.wait(lock);
+            continue;
+        }
+
+        const uint64_t sequence = complete->first;
+        std::vector<SnapshotOrder> orders = std::move(complete->second.orders);
+        pending_.erase(pending_.begin(), std::next(complete));
+
+        // Write without holding the lock, so workers are never blocked on disk.
+        lock.unlock();
+        const bool ok = write(sequence, orders);
+        lock.lock();
+        if (ok) {
+            ++written_;
+            last_sequence_ = sequence;
+        }
+    }
+}
+
+bool SnapshotWriter::write(uint64_t journal_sequence, const std::vector<SnapshotOrder>& orders) {
+    const std::string tmp_path = path_ + ".tmp";
+    const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("snapshot open failed");
+        return false;
+    }
+
+    SnapshotHeader header{};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.journal_sequence = journal_sequence;
+    header.order_count = orders.size();
+
+    bool ok = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+    const char* data = reinterpret_cast<const char*>(orders.data());
+    size_t remaining = orders.size() * sizeof(SnapshotOrder);
+    while (ok && remaining > 0) {
+        const ssize_t n = ::write(fd, data, remaining);
+        ok = n > 0;
+        if (ok) {
+            data += n;
+            remaining -= static_cast<size_t>(n);
+        }
+    }
+    // The rename must not be able to reach the disk before the data does.
+    ok = ok && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp_path.c_str(), path_.c_str()) < 0) {
+        perror("snapshot write failed");
+        return false;
+    }
+    return true;
+}
+
+bool loadSnapshot(const std::string& path, SnapshotHeader& header, std::vector<SnapshotOrder>& orders) {
+    if (access(path.c_str(), F_OK) != 0) {
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(path.c_str()) || file.size() < sizeof(SnapshotHeader)) {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        file.size() != sizeof(SnapshotHeader) + header.order_count * sizeof(SnapshotOrder)) {
+        std::fprintf(stderr, "%s is not a valid snapshot; ignoring it\n", path.c_str());
+        return false;
+    }
+    orders.resize(header.order_count);
+    std::memcpy(orders.data(), file.data() + sizeof(SnapshotHeader), header.order_count * sizeof(SnapshotOrder));
+    return true;
+}
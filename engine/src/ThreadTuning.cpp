@@ -0,0 +1,30 @@
+#include "ThreadTuning.h"
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+
+// The pthread calls return an error number rather than setting errno, so
+// perror() would print the wrong reason.
+
+bool pinThread(pthread_t thread, int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    const int error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+    if (error != 0) {
+        std::fprintf(stderr, "pinning a thread to CPU %d failed: %s\n", cpu, std::strerror(error));
+        return false;
+    }
+    return true;
+}
+
+bool setRealtimePriority(pthread_t thread, int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    const int error = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (error != 0) {
+        std::fprintf(stderr, "SCHED_FIFO priority %d failed: %s\n", priority, std::strerror(error));
+        return false;
+    }
+    return true;
+}
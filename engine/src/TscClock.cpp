@@ -0,0 +1,20 @@
+#include "TscClock.h"
+#include <chrono>
+#include <thread>
+
+// Until calibrated, assume a 1GHz TSC so conversions are at least the right magnitude.
+double TscClock::ns_per_tick_ = 1.0;
+
+void TscClock::calibrate(int sample_ms) {
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start_ticks = now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(sample_ms));
+    const uint64_t end_ticks = now();
+    const auto end_time = std::chrono::steady_clock::now();
+
+    const double elapsed_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    if (end_ticks > start_ticks) {
+        ns_per_tick_ = elapsed_ns / static_cast<double>(end_ticks - start_ticks);
+    }
+}
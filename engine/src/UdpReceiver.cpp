@@ -0,0 +1,199 @@
+#include "UdpReceiver.h"
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/sock_diag.h> // For SK_MEMINFO_DROPS
+
+// Linux socket options that older libc headers may not define.
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef SO_MEMINFO
+#define SO_MEMINFO 55
+#endif
+
+// Room for one SO_RXQ_OVFL control message per datagram.
+static constexpr size_t CONTROL_SIZE = CMSG_SPACE(sizeof(uint32_t));
+
+UdpReceiver::UdpReceiver(const UdpReceiverConfig& config)
+    : config_(config),
+      buffers_(config.batch_size * config.buffer_size),
+      control_(config.batch_size * CONTROL_SIZE),
+      iovecs_(config.batch_size),
+      headers_(config.batch_size),
+      sources_(config.batch_size) {
+    // Point each message header at its own slice of the buffer and control blocks.
+    for (size_t i = 0; i < config_.batch_size; ++i) {
+        iovecs_[i].iov_base = buffers_.data() + i * config_.buffer_size;
+        iovecs_[i].iov_len = config_.buffer_size;
+        std::memset(&headers_[i], 0, sizeof(headers_[i]));
+        headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+UdpReceiver::~UdpReceiver() {
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+    if (sock_fd_ >= 0) {
+        close(sock_fd_);
+    }
+}
+
+bool UdpReceiver::open() {
+    sock_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_fd_ < 0) {
+        perror("socket creation failed");
+        return false;
+    }
+
+    // Ask the kernel to attach its running drop counter to every datagram.
+    int enable = 1;
+    if (setsockopt(sock_fd_, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) < 0) {
+        perror("setsockopt(SO_RXQ_OVFL) failed; drop counts will read 0");
+    }
+
+    int rcvbuf = config_.rcvbuf_bytes;
+    if (rcvbuf == 0 && config_.busy_poll) {
+        rcvbuf = BUSY_POLL_RCVBUF;
+    }
+    if (rcvbuf > 0 && setsockopt(sock_fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        perror("setsockopt(SO_RCVBUF) failed");
+    }
+
+    if (config_.busy_poll &&
+        setsockopt(sock_fd_, SOL_SOCKET, SO_BUSY_POLL, &config_.busy_poll_usec, sizeof(config_.busy_poll_usec)) < 0) {
+        // Not fatal: we still spin in user space, the driver just won't be polled for us.
+        perror("setsockopt(SO_BUSY_POLL) failed");
+    }
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(config_.port);
+    if (bind(sock_fd_, (const struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        perror("bind failed");
+        return false;
+    }
+
+    if (!config_.busy_poll) {
+        epoll_fd_ = epoll_create1(0);
+        if (epoll_fd_ < 0) {
+            perror("epoll_create1 failed");
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = sock_fd_;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sock_fd_, &event) < 0) {
+            perror("epoll_ctl failed");
+            return false;
+        }
+    }
+    return true;
+}
+
+int UdpReceiver::receiveBatch() {
+    if (config_.busy_poll) {
+        // Spin on non-blocking receives, checking the clock only occasionally.
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.timeout_ms);
+        for (uint32_t spins = 1;; ++spins) {
+            const int received = receiveOnce(MSG_DONTWAIT);
+            if (received != 0) {
+                return received;
+            }
+            if ((spins & 0xFFF) == 0 && std::chrono::steady_clock::now() >= deadline) {
+                return 0;
+            }
+        }
+    }
+
+    // If the previous batch was full there is probably more queued: go straight
+    // back to recvmmsg and only fall back to epoll once the socket runs dry.
+    if (maybe_more_) {
+        const int received = receiveOnce(MSG_DONTWAIT);
+        if (received != 0) {
+            return received;
+        }
+    }
+    const int ready = waitReadable();
+    if (ready <= 0) {
+        return ready;
+    }
+    return receiveOnce(MSG_DONTWAIT);
+}
+
+int UdpReceiver::waitReadable() {
+    epoll_event event;
+    ++stats_.syscalls;
+    const int ready = epoll_wait(epoll_fd_, &event, 1, config_.timeout_ms);
+    if (ready < 0) {
+        // A signal interrupting the wait is treated like a timeout.
+        if (errno == EINTR) {
+            return 0;
+        }
+        perror("epoll_wait failed");
+        return -1;
+    }
+    return ready;
+}
+
+int UdpReceiver::receiveOnce(int flags) {
+    // The kernel overwrites msg_controllen and msg_namelen, so reset them
+    // before every call.
+    for (size_t i = 0; i < config_.batch_size; ++i) {
+        headers_[i].msg_hdr.msg_control = control_.data() + i * CONTROL_SIZE;
+        headers_[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+        headers_[i].msg_hdr.msg_name = &sources_[i];
+        headers_[i].msg_hdr.msg_namelen = sizeof(sources_[i]);
+    }
+
+    ++stats_.syscalls;
+    const int received = recvmmsg(sock_fd_, headers_.data(), static_cast<unsigned>(config_.batch_size), flags, nullptr);
+    if (received < 0) {
+        maybe_more_ = false;
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        perror("recvmmsg failed");
+        return -1;
+    }
+
+    maybe_more_ = (static_cast<size_t>(received) == config_.batch_size);
+    if (received > 0) {
+        stats_.datagrams += static_cast<uint64_t>(received);
+        ++stats_.batches;
+
+        // The drop counter is cumulative, so the last datagram's value is the latest.
+        msghdr& last = headers_[received - 1].msg_hdr;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&last); cmsg != nullptr; cmsg = CMSG_NXTHDR(&last, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t drops;
+                std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                stats_.kernel_drops = drops;
+            }
+        }
+    }
+    return received;
+}
+
+void UdpReceiver::refreshKernelDrops() {
+    // SO_RXQ_OVFL only reports the drop count as of the last datagram that made
+    // it into the queue, so drops after it are invisible until more data arrives.
+    // SO_MEMINFO reads the socket's live counter instead.
+    uint32_t meminfo[SK_MEMINFO_VARS] = {};
+    socklen_t len = sizeof(meminfo);
+    if (sock_fd_ >= 0 && getsockopt(sock_fd_, SOL_SOCKET, SO_MEMINFO, meminfo, &len) == 0 &&
+        len > SK_MEMINFO_DROPS * sizeof(uint32_t) && meminfo[SK_MEMINFO_DROPS] > stats_.kernel_drops) {
+        stats_.kernel_drops = meminfo[SK_MEMINFO_DROPS];
+    }
+}
@@ -1,73 +1,554 @@
+#include <algorithm>
 #include <iostream>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <unistd.h>
-#include <sys/epoll.h>
 #include <chrono>
 #include <vector>
 #include <memory>
+#include <string>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
-#include "L1CacheBook.h"
+#include "BookManager.h"
+#include "BookView.h"
 #include "BinaryParser.h"
+#include "Journal.h"
+#include "LatencyReport.h"
+#include "MarketDataPublisher.h"
+#include "PerfCounters.h"
+#include "Recovery.h"
+#include "Replay.h"
+#include "RetransmitClient.h"
+#include "SequenceTracker.h"
+#include "ShmReceiver.h"
+#include "ThreadTuning.h"
+#include "TscClock.h"
+#include "UdpReceiver.h"
 
 constexpr int UDP_PORT = 12345;
-constexpr int MAX_EVENTS = 10;
-constexpr int BUFFER_SIZE = 1024;
 constexpr int TIMEOUT_MS = 2000; // 2 seconds
 
-int main() {
-    auto book = std::make_unique<L1CacheBook>();
-    std::cout << "Project Panoptes Engine Initializing..." << std::endl;
+// Set from signal handlers and polled by the event loop.
+static volatile std::sig_atomic_t dump_requested = 0; // SIGUSR1: dump latency stats and keep going.
+static volatile std::sig_atomic_t stop_requested = 0; // SIGINT/SIGTERM: stop and print the summary.
+
+static void onDumpSignal(int) { dump_requested = 1; }
+static void onStopSignal(int) { stop_requested = 1; }
+
+// Prints the latency breakdown and writes it to 'json_path'. The book-update
+// stage comes from the worker threads, so it is merged in fresh for each dump.
+static void dumpLatency(const LatencyReport& engine_latency, const BookManager& books, const std::string& json_path) {
+    LatencyReport combined;
+    combined.merge(engine_latency);
+    books.collectLatency(combined);
+    combined.printText(std::cout);
+    if (!combined.writeJson(json_path)) {
+        std::cerr << "Failed to write latency report to " << json_path << std::endl;
+    } else {
+        std::cout << "Latency report written to " << json_path << std::endl;
+    }
+}
+
+// Decodes datagrams of either wire format and feeds their messages, in
+// sequence, to the journal and the books.
+class NetworkInput : public SequencedSink {
+public:
+    NetworkInput(BookManager& books, Journal* journal, LatencyReport& latency, PerfProbe& perf,
+                 SequenceTracker& tracker, RetransmitClient* retransmit)
+        : books_(books), journal_(journal), latency_(latency), perf_(perf), tracker_(tracker), retransmit_(retransmit) {}
+
+    // 'source' is the receiver's identity for the sender, so streams from two
+    // senders stay apart. 'recv_ns' is the wall clock when the datagram's
+    // batch arrived; 'now_ns' is the steady clock, for the sequence tracker's
+    // gap timeouts.
+    inline void handle(const char* data, size_t length, uint64_t source, int64_t recv_ns, int64_t now_ns) {
+        recv_ns_ = recv_ns;
+        if (length == sizeof(PanoptesMessage)) {
+            ++v1_messages_;
+            deliver(data, 1);
+            return;
+        }
+        FrameHeader header;
+        if (length < sizeof(FrameHeader)) {
+            ++malformed_;
+            return;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        swapWireByteOrder(header);
+        if (header.magic != FRAME_MAGIC || header.version != FRAME_VERSION ||
+            length != sizeof(FrameHeader) + header.message_count * sizeof(PanoptesMessage)) {
+            ++malformed_;
+            return;
+        }
+        tracker_.onFrame(header, data + sizeof(FrameHeader), now_ns, *this, source);
+    }
+
+    void deliver(const char* messages, size_t count) override {
+        // Parse in chunks: the validation runs across a whole chunk at once, so
+        // each message's parse latency is its share of the chunk's.
+        for (size_t start = 0; start < count; start += PARSE_CHUNK) {
+            const size_t chunk = std::min(PARSE_CHUNK, count - start);
+            const bool sampled = perf_.sample();
+            if (sampled) {
+                perf_.begin();
+            }
+            const uint64_t parse_start = TscClock::now();
+            const size_t valid = parseBatch(messages + start * sizeof(PanoptesMessage), chunk, parsed_, parse_stats_);
+            const uint64_t parse_end = TscClock::now();
+            if (sampled) {
+                perf_.end(PerfStage::Parse, 0, chunk);
+            }
+            const int64_t parse_ns = valid > 0 ? TscClock::toNanos(parse_end - parse_start) / valid : 0;
+
+            for (size_t i = 0; i < valid; ++i) {
+                const PanoptesMessage& msg = parsed_[i];
+                // Journal it, then hand it to the worker that owns its instrument's book.
+                if (journal_) {
+                    journal_->append(msg);
+                }
+                books_.submit(msg);
+
+                // The sender stamps each message with its wall clock just before sending.
+                latency_.at(LatencyStage::WireToRecv, msg.event_type).record(recv_ns_ - msg.timestamp);
+                latency_.at(LatencyStage::Parse, msg.event_type).record(parse_ns);
+            }
+            message_count_ += valid;
+        }
+    }
 
-    int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock_fd < 0) {
-        perror("socket creation failed");
-        return -1;
+    void requestRetransmit(const RetransmitRequest& request) override {
+        if (retransmit_) {
+            retransmit_->request(request);
+        }
     }
 
-    sockaddr_in server_addr{};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(UDP_PORT);
+    uint64_t messageCount() const { return message_count_; }
+    uint64_t v1Messages() const { return v1_messages_; }
+    uint64_t malformed() const { return malformed_; }
+    const ParseStats& parseStats() const { return parse_stats_; }
+
+private:
+    static constexpr size_t PARSE_CHUNK = 256;
+
+
+    BookManager& books_;
+    Journal* journal_;
+    LatencyReport& latency_;
+    PerfProbe& perf_;
+    SequenceTracker& tracker_;
+    RetransmitClient* retransmit_;
+    int64_t recv_ns_ = 0;
+    uint64_t message_count_ = 0;
+    uint64_t v1_messages_ = 0;
+    uint64_t malformed_ = 0;
+    ParseStats parse_stats_;
+    PanoptesMessage parsed_[PARSE_CHUNK];
+};
+
+static int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --workers N       number of book worker threads (instruments are spread across them)\n"
+              << "  --first-cpu C     pin worker i to CPU C + i\n"
+              << "  --rx-cpu C        pin the receive thread (receive, parse, journal, hand off) to CPU C\n"
+              << "  --rt-priority P   run the receive thread and the workers SCHED_FIFO at priority P\n"
+              << "                    (needs CAP_SYS_NICE; only on CPUs reserved for the engine)\n"
+              << "  --idle I          what an idle worker does: spin (default) or backoff (spin, yield, sleep)\n"
+              << "  --batch N         datagrams received per recvmmsg call (default 64)\n"
+              << "  --busy-poll       spin on non-blocking receives instead of sleeping in epoll\n"
+              << "  --busy-poll-us U  SO_BUSY_POLL budget in microseconds (default 50)\n"
+              << "  --rcvbuf BYTES    socket receive buffer size\n"
+              << "  --latency-out F   machine-readable latency report path (default panoptes_latency.json)\n"
+              << "  --tick-size T     price increment of every instrument, in fixed-point units (default 1)\n"
+              << "  --ladder-window N price levels per side kept in each book's dense window (default 2048)\n"
+              << "  --layout L        order storage: pointer (default), compact or hotcold\n"
+              << "  --no-matching     rest every add without matching (for a venue's own, already matched feed)\n"
+              << "Book memory (order storage and index):\n"
+              << "  --huge-pages P    page size: off (default, 4KB), thp (transparent 2MB), 2m or 1g (reserved\n"
+              << "                    hugetlb pages, falling back to thp)\n"
+              << "  --prefault        fault every page in when a book is created, not on first use\n"
+              << "  --mlock           lock book memory in RAM (implies --prefault)\n"
+              << "  --numa-node N     place book memory on NUMA node N (default: the worker's own node)\n"
+              << "Market data (L2 depth over UDP):\n"
+              << "  --md-publish HOST:PORT  publish level updates and snapshots to this address\n"
+              << "  --md-conflate-us U      merge changes to a level within U microseconds (default 0, off)\n"
+              << "  --md-snapshot-ms M      full-depth snapshot interval (default 1000, 0 disables)\n"
+              << "Shared-memory book view (for strategies and risk on this host):\n"
+              << "  --book-view NAME        publish each book's top 10 levels to the POSIX shared-memory\n"
+              << "                          segment NAME (e.g. /panoptes_book); see BookView.h for readers\n"
+              << "Shared-memory input (instead of UDP, for a sender on this host):\n"
+              << "  --shm-ring NAME         receive from a ring in the POSIX shared-memory segment NAME\n"
+              << "                          (e.g. /panoptes_ring) that thrasher --shm-ring writes to\n"
+              << "  --shm-lanes N           lanes in the ring, one per sender thread (default 4)\n"
+              << "  --shm-lane-mb M         megabytes per lane (default 4)\n"
+              << "Gap recovery (v2 framed input):\n"
+              << "  --retransmit HOST:PORT  ask this recovery service to resend messages lost in a gap\n"
+              << "  --gap-timeout-ms M      give up on a gap after M ms (default 50)\n"
+              << "Journal and recovery:\n"
+              << "  --journal-dir DIR       journal every message to DIR/journal.bin and snapshot the books to\n"
+              << "                          DIR/snapshot.bin; on startup, rebuild the books from them\n"
+              << "  --snapshot-interval-s S seconds between snapshots (default 60, 0 = only at shutdown and\n"
+              << "                          when the journal is half full)\n"
+              << "  --journal-capacity N    messages the journal file is preallocated for (default 16777216);\n"
+              << "                          it wraps round over space a snapshot covers\n"
+              << "Offline replay (no network):\n"
+              << "  --replay FILE     drive the books directly from a capture of PanoptesMessages\n"
+              << "  --iterations N    timed passes over the capture (default 1)\n"
+              << "  --warmup N        untimed passes before the timed ones (default 0)\n"
+              << "  --no-latency      skip per-message latency timing for pure throughput\n"
+              << "Hardware counters (builds with PANOPTES_PERF_COUNTERS only):\n"
+              << "  --perf-sample N   read the counters around 1 in N book updates, parse chunks and\n"
+              << "                    receives (default 64, 0 = off)\n"
+              << "  --perf-out F      machine-readable counter report path (default panoptes_perf.json)\n"
+              << "Send SIGUSR1 to dump latency percentiles without stopping." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BookManagerConfig manager_config;
+    UdpReceiverConfig receiver_config;
+    receiver_config.port = UDP_PORT;
+    receiver_config.timeout_ms = TIMEOUT_MS;
+    std::string latency_path = "panoptes_latency.json";
+    std::string perf_path = "panoptes_perf.json";
+    ReplayConfig replay_config;
+    MarketDataPublisherConfig md_config;
+    bool md_enabled = false;
+    std::string book_view_name;
+    ShmReceiverConfig shm_config;
+    shm_config.timeout_ms = TIMEOUT_MS;
+    bool shm_enabled = false;
+    std::string journal_dir;
+    JournalConfig journal_config;
+    unsigned snapshot_interval_s = 60;
+    SequenceTrackerConfig tracker_config;
+    std::string retransmit_target;
+    int rx_cpu = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            manager_config.num_workers = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--first-cpu") == 0 && i + 1 < argc) {
+            manager_config.first_cpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rx-cpu") == 0 && i + 1 < argc) {
+            rx_cpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rt-priority") == 0 && i + 1 < argc) {
+            manager_config.rt_priority = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--idle") == 0 && i + 1 < argc) {
+            const char* idle = argv[++i];
+            if (std::strcmp(idle, "spin") == 0) {
+                manager_config.idle = WorkerIdlePolicy::Spin;
+            } else if (std::strcmp(idle, "backoff") == 0) {
+                manager_config.idle = WorkerIdlePolicy::Backoff;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            receiver_config.batch_size = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--busy-poll") == 0) {
+            receiver_config.busy_poll = true;
+        } else if (std::strcmp(argv[i], "--busy-poll-us") == 0 && i + 1 < argc) {
+            receiver_config.busy_poll_usec = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rcvbuf") == 0 && i + 1 < argc) {
+            receiver_config.rcvbuf_bytes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--latency-out") == 0 && i + 1 < argc) {
+            latency_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--tick-size") == 0 && i + 1 < argc) {
+            manager_config.ladders.default_config.tick_size = std::strtoll(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ladder-window") == 0 && i + 1 < argc) {
+            manager_config.ladders.default_config.window_levels = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            const char* layout = argv[++i];
+            if (std::strcmp(layout, "pointer") == 0) {
+                manager_config.variant.layout = OrderLayout::Pointer;
+            } else if (std::strcmp(layout, "compact") == 0) {
+                manager_config.variant.layout = OrderLayout::Compact;
+            } else if (std::strcmp(layout, "hotcold") == 0) {
+                manager_config.variant.layout = OrderLayout::HotCold;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--no-matching") == 0) {
+            manager_config.variant.matching = false;
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0 && i + 1 < argc) {
+            const char* pages = argv[++i];
+            LargePageConfig& memory = manager_config.pool_config.pages;
+            if (std::strcmp(pages, "off") == 0) {
+                memory.mode = HugePageMode::Off;
+            } else if (std::strcmp(pages, "thp") == 0) {
+                memory.mode = HugePageMode::Transparent;
+            } else if (std::strcmp(pages, "2m") == 0) {
+                memory.mode = HugePageMode::Explicit;
+                memory.page_size = size_t(2) << 20;
+            } else if (std::strcmp(pages, "1g") == 0) {
+                memory.mode = HugePageMode::Explicit;
+                memory.page_size = size_t(1) << 30;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--prefault") == 0) {
+            manager_config.pool_config.pages.prefault = true;
+        } else if (std::strcmp(argv[i], "--mlock") == 0) {
+            manager_config.pool_config.pages.lock = true;
+        } else if (std::strcmp(argv[i], "--numa-node") == 0 && i + 1 < argc) {
+            manager_config.pool_config.pages.numa_node = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--md-publish") == 0 && i + 1 < argc) {
+            const std::string target = argv[++i];
+            const size_t colon = target.rfind(':');
+            if (colon == std::string::npos) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            md_config.address = target.substr(0, colon);
+            md_config.port = std::atoi(target.c_str() + colon + 1);
+            md_enabled = true;
+        } else if (std::strcmp(argv[i], "--md-conflate-us") == 0 && i + 1 < argc) {
+            md_config.conflation_window_us = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--md-snapshot-ms") == 0 && i + 1 < argc) {
+            md_config.snapshot_interval_ms = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--book-view") == 0 && i + 1 < argc) {
+            book_view_name = argv[++i];
+        } else if (std::strcmp(argv[i], "--shm-ring") == 0 && i + 1 < argc) {
+            shm_config.name = argv[++i];
+            shm_enabled = true;
+        } else if (std::strcmp(argv[i], "--shm-lanes") == 0 && i + 1 < argc) {
+            shm_config.num_lanes = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--shm-lane-mb") == 0 && i + 1 < argc) {
+            shm_config.lane_bytes = std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        } else if (std::strcmp(argv[i], "--retransmit") == 0 && i + 1 < argc) {
+            retransmit_target = argv[++i];
+            if (retransmit_target.rfind(':') == std::string::npos) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            tracker_config.retransmit = true;
+        } else if (std::strcmp(argv[i], "--gap-timeout-ms") == 0 && i + 1 < argc) {
+            tracker_config.gap_timeout_ns = std::strtoll(argv[++i], nullptr, 10) * 1000000;
+        } else if (std::strcmp(argv[i], "--journal-dir") == 0 && i + 1 < argc) {
+            journal_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--snapshot-interval-s") == 0 && i + 1 < argc) {
+            snapshot_interval_s = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--journal-capacity") == 0 && i + 1 < argc) {
+            journal_config.capacity_messages = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_config.path = argv[++i];
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            replay_config.iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            replay_config.warmup_iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--no-latency") == 0) {
+            replay_config.measure_latency = false;
+        } else if (std::strcmp(argv[i], "--perf-sample") == 0 && i + 1 < argc) {
+            manager_config.perf.sample_every = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            if (!PERF_COUNTERS_COMPILED_IN) {
+                std::cerr << "Warning: --perf-sample ignored, hardware counters are not compiled in" << std::endl;
+            }
+        } else if (std::strcmp(argv[i], "--perf-out") == 0 && i + 1 < argc) {
+            perf_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (receiver_config.batch_size == 0) {
+        receiver_config.batch_size = 1;
+    }
+    // The ring takes the same batching and polling options as the socket.
+    shm_config.batch_size = receiver_config.batch_size;
+    shm_config.busy_poll = receiver_config.busy_poll;
+
+    if (!replay_config.path.empty()) {
+        replay_config.latency_path = latency_path;
+        replay_config.pool_config = manager_config.pool_config;
+        replay_config.ladders = manager_config.ladders;
+        replay_config.variant = manager_config.variant;
+        replay_config.perf = manager_config.perf;
+        replay_config.perf_path = perf_path;
+        return runReplay(replay_config);
+    }
+
+    // Declared before the books so it outlives their workers.
+    std::unique_ptr<MarketDataPublisher> publisher;
+    if (md_enabled) {
+        md_config.num_producers = manager_config.num_workers == 0 ? 1 : manager_config.num_workers;
+        publisher = std::make_unique<MarketDataPublisher>(md_config);
+        if (!publisher->open()) {
+            return -1;
+        }
+        manager_config.publisher = publisher.get();
+    }
+
+    // The view's header carries the TSC rate, so calibrate before creating it.
+    TscClock::calibrate();
+    std::unique_ptr<SharedBookView> book_view;
+    if (!book_view_name.empty()) {
+        book_view = std::make_unique<SharedBookView>();
+        if (!book_view->create(book_view_name, MAX_INSTRUMENTS, TscClock::nsPerTick())) {
+            return -1;
+        }
+        manager_config.book_view = book_view.get();
+    }
 
-    if (bind(sock_fd, (const struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        perror("bind failed");
-        close(sock_fd);
-        return -1;
+    // Like the publisher, these must outlive the book workers.
+    std::unique_ptr<Journal> journal;
+    std::unique_ptr<SnapshotWriter> snapshots;
+    if (!journal_dir.empty()) {
+        journal_config.path = journal_dir + "/journal.bin";
+        journal = std::make_unique<Journal>(journal_config);
+        snapshots = std::make_unique<SnapshotWriter>(journal_dir + "/snapshot.bin",
+                                                     manager_config.num_workers == 0 ? 1 : manager_config.num_workers);
+        manager_config.snapshot_writer = snapshots.get();
     }
 
-    int epoll_fd = epoll_create1(0);
-    if (epoll_fd < 0) {
-        perror("epoll_create1 failed");
-        close(sock_fd);
-        return -1;
+    BookManager books(manager_config);
+    std::cout << "Project Panoptes Engine Initializing..." << std::endl;
+
+    // Exactly one of these is the input: the UDP socket, or the shared-memory ring.
+    std::unique_ptr<UdpReceiver> udp;
+    std::unique_ptr<ShmReceiver> shm;
+    if (shm_enabled) {
+        shm = std::make_unique<ShmReceiver>(shm_config);
+        if (!shm->open()) {
+            return -1;
+        }
+    } else {
+        udp = std::make_unique<UdpReceiver>(receiver_config);
+        if (!udp->open()) {
+            return -1;
+        }
     }
 
-    epoll_event event{};
-    event.events = EPOLLIN;
-    event.data.fd = sock_fd;
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock_fd, &event) < 0) {
-        perror("epoll_ctl failed");
-        close(sock_fd);
-        close(epoll_fd);
-        return -1;
+    std::unique_ptr<RetransmitClient> retransmit;
+    if (tracker_config.retransmit) {
+        const size_t colon = retransmit_target.rfind(':');
+        retransmit = std::make_unique<RetransmitClient>(retransmit_target.substr(0, colon),
+                                                        std::atoi(retransmit_target.c_str() + colon + 1));
+        if (!retransmit->open()) {
+            return -1;
+        }
     }
 
-    epoll_event events[MAX_EVENTS];
-    char buffer[BUFFER_SIZE];
-    std::vector<int64_t> latencies;
-    latencies.reserve(1000000); // Pre-allocate for performance
+    // Fixed-memory histograms for the stages measured on this thread.
+    LatencyReport latency;
+
+    // Counters for the receive and parse stages on this thread. Each stage has
+    // its own probe, so their sampling cannot fall into step with each other.
+    PerfReport perf_report;
+    PerfProbe receive_perf(manager_config.perf, perf_report);
+    PerfProbe parse_perf(manager_config.perf, perf_report);
+    receive_perf.open();
+    parse_perf.open();
 
-    std::cout << "Engine is listening on port " << UDP_PORT << std::endl;
-    long message_count = 0;
+    std::signal(SIGUSR1, onDumpSignal);
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+
+    if (publisher) {
+        publisher->start();
+    }
+    books.start();
+
+    // Rebuild the books from the last snapshot and the journal after it, before
+    // any new message is accepted.
+    if (journal) {
+        RecoveryStats recovery;
+        if (!recoverBooks(journal_dir + "/snapshot.bin", journal_config.path, books, recovery) ||
+            !journal->open(recovery.snapshot_sequence)) {
+            books.stop();
+            return -1;
+        }
+        std::cout << "Recovered " << recovery.snapshot_orders << " resting orders from "
+                  << (recovery.snapshot_loaded ? "snapshot @" + std::to_string(recovery.snapshot_sequence) : std::string("no snapshot"))
+                  << " and replayed " << recovery.journal_messages << " journal messages in "
+                  << recovery.elapsed_ms << " ms" << std::endl;
+        journal->start();
+        snapshots->start();
+    }
+    // New threads inherit their creator's CPU mask and scheduling policy, so
+    // this thread is only tuned once every helper thread has started.
+    if (rx_cpu >= 0) {
+        pinThread(pthread_self(), rx_cpu);
+    }
+    if (manager_config.rt_priority > 0) {
+        setRealtimePriority(pthread_self(), manager_config.rt_priority);
+    }
+    const auto snapshot_interval = std::chrono::seconds(snapshot_interval_s);
+    auto next_snapshot = std::chrono::steady_clock::now() + snapshot_interval;
+    uint64_t next_early_snapshot = 0;
+    if (shm) {
+        std::cout << "Engine is reading " << shm->numLanes() << " lane(s) of shared-memory ring " << shm_config.name
+                  << " with " << books.numWorkers() << " book worker(s)";
+    } else {
+        std::cout << "Engine is listening on port " << UDP_PORT << " with "
+                  << books.numWorkers() << " book worker(s)";
+    }
+    std::cout << (receiver_config.busy_poll ? " (busy-poll)" : "") << std::endl;
+    SequenceTracker tracker(tracker_config);
+    NetworkInput input(books, journal.get(), latency, parse_perf, tracker, retransmit.get());
+    std::vector<char> retransmit_buffer(65536);
     bool stream_started = false;
+    // While a gap is open, pick up any retransmitted frames and give up on
+    // gaps that have waited too long.
+    auto serviceGaps = [&](int64_t recv_ns, int64_t now_ns) {
+        size_t length;
+        while (retransmit && (length = retransmit->receive(retransmit_buffer.data(), retransmit_buffer.size())) > 0) {
+            // Retransmitted frames find their stream by session, not source.
+            input.handle(retransmit_buffer.data(), length, 0, recv_ns, now_ns);
+        }
+        tracker.poll(now_ns, input);
+    };
+
+    while (!stop_requested) {
+        // Wait for packets, but with a timeout, and pull in a whole batch at once.
+        const bool receive_sampled = receive_perf.sample();
+        if (receive_sampled) {
+            receive_perf.begin();
+        }
+        int received = shm ? shm->receiveBatch() : udp->receiveBatch();
+        if (receive_sampled && received > 0) {
+            receive_perf.end(PerfStage::Receive, 0, static_cast<uint64_t>(received));
+        }
 
-    while (true) {
-        // Wait for packets, but with a timeout.
-        int num_events = epoll_wait(epoll_fd, events, MAX_EVENTS, TIMEOUT_MS);
+        if (dump_requested) {
+            dump_requested = 0;
+            dumpLatency(latency, books, latency_path);
+        }
+
+        if (journal) {
+            // Snapshot on the interval, and early (every eighth of the journal)
+            // once half the journal is in use, so space comes back before it fills.
+            const bool due = snapshot_interval_s > 0 && std::chrono::steady_clock::now() >= next_snapshot;
+            const bool filling =
+                journal->inUse() >= journal->capacity() / 2 && journal->lastSequence() >= next_early_snapshot;
+            if (due || filling) {
+                // The journal space before the last snapshot on disk can be reused.
+                journal->release(snapshots->lastSequence());
+                books.requestSnapshot(journal->lastSequence());
+                next_snapshot = std::chrono::steady_clock::now() + snapshot_interval;
+                next_early_snapshot = journal->lastSequence() + journal->capacity() / 8;
+            }
+        }
 
-        if (num_events == 0) {
-            // This means epoll_wait timed out.
+        if (received == 0) {
+            // A signal can interrupt the wait early; that is not the end of the stream.
+            if (stop_requested) {
+                break;
+            }
+            // This means the receive timed out. Retransmissions arrive on their
+            // own socket, so a gap that is open once the senders go quiet is
+            // only now answered; that is not the end of the stream either.
+            if (tracker.waiting()) {
+                const int64_t wall_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now()).time_since_epoch().count();
+                serviceGaps(wall_ns, steadyNanos());
+                continue;
+            }
             if (stream_started) {
                 std::cout << "No packets received for " << TIMEOUT_MS << "ms. Assuming stream has ended." << std::endl;
                 break; // Exit the loop to print the summary.
@@ -75,52 +556,121 @@ int main() {
             continue; // If stream never started, keep waiting.
         }
 
-        if (num_events < 0) {
-            perror("epoll_wait failed");
+        if (received < 0) {
             break;
         }
 
         stream_started = true; // Mark that we've received at least one packet.
 
-        for (int i = 0; i < num_events; ++i) {
-            int bytes_read = recv(events[i].data.fd, buffer, BUFFER_SIZE, 0);
+        // One wall-clock read per batch: every datagram in it arrived by this time.
+        auto now = std::chrono::system_clock::now();
+        int64_t recv_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(now).time_since_epoch().count();
 
-            if (bytes_read > 0) {
-                PanoptesMessage msg = parseMessage(buffer);
-                auto now = std::chrono::high_resolution_clock::now();
-                int64_t now_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(now).time_since_epoch().count();
+        const int64_t now_ns = steadyNanos();
 
-                switch (msg.event_type) {
-                    case 'A': book->addOrder(msg); break;
-                    case 'X': book->cancelOrder(msg); break;
-                    case 'E': book->executeOrder(msg); break;
-                }
-
-                int64_t latency = now_ns - msg.timestamp;
-                if (latency > 0 && latency < 1000000) { // Filter out outliers
-                    latencies.push_back(latency);
-                }
-
-                message_count++;
+        // Process the whole batch before going back to the kernel.
+        for (int i = 0; i < received; ++i) {
+            if (shm) {
+                input.handle(shm->data(i), shm->length(i), shm->source(i), recv_ns, now_ns);
+            } else {
+                input.handle(udp->data(i), udp->length(i), udp->source(i), recv_ns, now_ns);
             }
         }
-    }
 
-    close(sock_fd);
-    close(epoll_fd);
+        if (tracker.waiting()) {
+            serviceGaps(recv_ns, now_ns);
+        }
+    }
+    // Whatever is still held behind a gap is delivered before shutting down.
+    // Each poll gives up on one gap per stream.
+    while (tracker.waiting()) {
+        tracker.poll(INT64_MAX, input);
+    }
 
-    // This code is now reachable after the loop breaks.
-    long long total_latency = 0;
-    for (long long l : latencies) {
-        total_latency += l;
+    // Let the workers finish everything still queued before reporting.
+    if (journal) {
+        // A final snapshot, so the next start has no journal to replay.
+        books.requestSnapshot(journal->lastSequence());
+    }
+    books.stop();
+    if (publisher) {
+        publisher->stop();
+    }
+    if (journal) {
+        snapshots->stop();
+        journal->stop();
     }
 
+    if (udp) {
+        udp->refreshKernelDrops();
+    }
+    const ReceiveStats& rx = shm ? shm->stats() : udp->stats();
     std::cout << "------------------------------------------" << std::endl;
     std::cout << "           PERFORMANCE SUMMARY" << std::endl;
     std::cout << "------------------------------------------" << std::endl;
-    std::cout << "Total messages processed: " << message_count << std::endl;
-    if (!latencies.empty()) {
-        std::cout << "Average latency: " << (double)total_latency / latencies.size() << " ns" << std::endl;
+    std::cout << "Total messages processed: " << input.messageCount() << std::endl;
+    std::cout << "Total trades: " << books.tradesProduced() << std::endl;
+    std::cout << "Worker rings: high-water mark " << books.ringHighWaterMark() << " of " << books.ringCapacity()
+              << " messages, " << books.producerStalls() << " full-ring stalls" << std::endl;
+    std::cout << "Receive syscalls: " << rx.syscalls << std::endl;
+    if (rx.syscalls > 0) {
+        std::cout << "Datagrams per syscall: " << (double)rx.datagrams / rx.syscalls << std::endl;
+    }
+    if (rx.batches > 0) {
+        std::cout << "Average batch size: " << (double)rx.datagrams / rx.batches << std::endl;
+    }
+    if (rx.datagrams > 0) {
+        std::cout << "Messages per datagram: " << (double)input.messageCount() / rx.datagrams << std::endl;
+    }
+    if (udp) {
+        std::cout << "Kernel drops (socket buffer full): " << rx.kernel_drops << std::endl;
+    }
+    if (shm) {
+        std::cout << "Ring lanes skipped (corrupt record): " << rx.corrupt_lanes << std::endl;
+    }
+    const SequenceTracker::Stats& seq = tracker.stats();
+    std::cout << "Input: " << seq.frames << " v2 frames, " << input.v1Messages() << " v1 messages, "
+              << input.malformed() << " malformed datagrams" << std::endl;
+    const ParseStats& parse = input.parseStats();
+    std::cout << "Rejected messages: " << parse.rejected() << " (" << parse.bad_event_type << " bad event type, "
+              << parse.bad_side << " bad side, " << parse.bad_size << " bad size, " << parse.bad_price
+              << " bad price)" << std::endl;
+    std::cout << "Sequencing: " << seq.gaps << " gaps (" << seq.gap_messages << " messages), "
+              << seq.retransmitted << " recovered by retransmit, " << seq.lost << " lost, "
+              << seq.duplicates << " duplicates, " << seq.session_resets << " session resets";
+    if (retransmit) {
+        std::cout << ", " << retransmit->requestsSent() << " retransmit requests";
+    }
+    std::cout << std::endl;
+    if (journal) {
+        std::cout << "Journal: " << journal->lastSequence() << " records ("
+                  << journal->overflowCount() << " lost to a full journal), "
+                  << snapshots->snapshotsWritten() << " snapshots written" << std::endl;
+        if (journal->overflowCount() > 0) {
+            std::cerr << "ERROR: " << journal->overflowCount() << " messages were not journaled because the journal "
+                      << "was full; a restart from this journal would not rebuild the books" << std::endl;
+        }
+    }
+    if (publisher) {
+        const MarketDataPublisher::Stats& md = publisher->stats();
+        std::cout << "Market data: " << md.updates_published << " level updates in " << md.datagrams
+                  << " datagrams, " << md.snapshots << " snapshots, "
+                  << (md.updates_received - md.updates_published) << " conflated, "
+                  << publisher->droppedCount() << " dropped, " << md.resyncs << " books resent after a drop"
+                  << std::endl;
+    }
+    if (book_view) {
+        std::cout << "Book view: " << books.viewPublishes() << " publishes to " << book_view_name << std::endl;
+    }
+    std::cout << "------------------------------------------" << std::endl;
+    dumpLatency(latency, books, latency_path);
+    if (PERF_COUNTERS_COMPILED_IN && manager_config.perf.sample_every != 0) {
+        std::cout << "------------------------------------------" << std::endl;
+        books.collectPerf(perf_report);
+        perf_report.printText(std::cout);
+        if (perf_report.writeJson(perf_path)) {
+            std::cout << "Counter report written to " << perf_path << std::endl;
+        }
     }
     std::cout << "------------------------------------------" << std::endl;
 
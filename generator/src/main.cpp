@@ -0,0 +1,371 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <list>
+#include <map>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h> // For mkdir
+
+// We need the definition of PanoptesMessage from the main project.
+#include "../../engine/include/DataTypes.h"
+
+// Generates a synthetic but realistic stream of order flow for the engine.
+//
+// Messages are streamed to disk through a fixed-size buffer, so the number of
+// messages is limited only by disk space. The generator keeps a model of every
+// live order (and of each book's levels) so that its output is always valid
+// for the engine:
+//   - cancels and executes only ever refer to orders that are live,
+//   - executes hit the front of the best level, like real trades, and never
+//     exceed the order's remaining size,
+//   - adds never cross the opposite side, so the engine's matching never
+//     removes an order the generator still thinks is live.
+
+constexpr const char* DEFAULT_OUTPUT_PATH = "data/messages.bin";
+
+struct GeneratorConfig {
+    const char* output_path = DEFAULT_OUTPUT_PATH;
+    uint64_t num_messages = 1000000;
+    uint64_t seed = 42;
+    int num_instruments = 1;
+    // Relative weights of each event type.
+    double add_weight = 0.50;
+    double cancel_weight = 0.40;
+    double execute_weight = 0.10;
+    // Chance that an execute takes the whole order rather than part of it.
+    double full_fill_probability = 0.5;
+    // Order lifetime, in messages for the same instrument. Cancels remove the
+    // live order whose sampled lifetime expires first.
+    double mean_lifetime = 200.0;
+    bool lognormal_lifetime = false; // Exponential by default.
+    // Price model, in ticks of the fixed-point price.
+    Price start_price = 1500000;
+    double walk_probability = 0.05; // Chance per message that the mid moves one tick.
+    double depth_ticks = 10.0;      // Mean distance of new orders from the touch.
+    int min_size = 1;
+    int max_size = 500;
+    // Cap on live orders per instrument; beyond it, adds become cancels.
+    size_t max_live_orders = 100000;
+    // Mean gap between messages, for the timestamps (exponentially distributed).
+    double mean_gap_ns = 1000.0;
+};
+
+namespace {
+
+// The generator's view of one instrument's book.
+struct InstrumentModel {
+    Price mid = 0;
+    uint64_t step = 0; // Messages generated for this instrument so far.
+    size_t live_orders = 0;
+    // Live order IDs per price level, in FIFO order. A list, so an order can
+    // be removed through the position its LiveOrder keeps, however long the
+    // level is.
+    std::map<Price, std::list<OrderID>> bids;
+    std::map<Price, std::list<OrderID>> asks;
+    // Orders by scheduled expiry, earliest first. Entries for orders that have
+    // since been executed are skipped lazily.
+    std::priority_queue<std::pair<uint64_t, OrderID>, std::vector<std::pair<uint64_t, OrderID>>,
+                        std::greater<std::pair<uint64_t, OrderID>>> expiries;
+};
+
+struct LiveOrder {
+    InstrumentID instrument;
+    Price price;
+    int32_t size;
+    char side;
+    std::list<OrderID>::iterator position; // In its level's queue.
+};
+
+// Writes messages through a fixed buffer so memory use does not grow with the output.
+class MessageWriter {
+public:
+    explicit MessageWriter(std::ofstream& out) : out_(out) { buffer_.reserve(CAPACITY); }
+    ~MessageWriter() { flush(); }
+
+    void write(const PanoptesMessage& msg) {
+        buffer_.push_back(msg);
+        if (buffer_.size() == CAPACITY) {
+            flush();
+        }
+    }
+
+    void flush() {
+        out_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size() * sizeof(PanoptesMessage));
+        buffer_.clear();
+    }
+
+private:
+    static constexpr size_t CAPACITY = 32768; // 1MB of messages.
+    std::ofstream& out_;
+    std::vector<PanoptesMessage> buffer_;
+};
+
+class FlowGenerator {
+public:
+    explicit FlowGenerator(const GeneratorConfig& config)
+        : config_(config), rng_(config.seed), gap_(1.0 / config.mean_gap_ns), instruments_(config.num_instruments) {
+        // Spread the instruments' starting prices around the configured price.
+        std::uniform_int_distribution<Price> offset(-50000, 50000);
+        for (InstrumentModel& model : instruments_) {
+            model.mid = clampPrice(config_.num_instruments > 1 ? config_.start_price + offset(rng_) : config_.start_price);
+        }
+    }
+
+    PanoptesMessage next() {
+        const InstrumentID instrument = static_cast<InstrumentID>(
+            std::uniform_int_distribution<int>(0, config_.num_instruments - 1)(rng_));
+        InstrumentModel& model = instruments_[instrument];
+        ++model.step;
+
+        // 1. Random walk of the mid price.
+        if (uniform_(rng_) < config_.walk_probability) {
+            model.mid = clampPrice(model.mid + (uniform_(rng_) < 0.5 ? -1 : 1));
+        }
+
+        // 2. Pick the event type from the configured mix. Fall back to an add when
+        // there is nothing live to cancel or execute, and to a cancel when full.
+        timestamp_ += static_cast<Timestamp>(gap_(rng_));
+        const double total = config_.add_weight + config_.cancel_weight + config_.execute_weight;
+        const double pick = uniform_(rng_) * total;
+        const size_t live = model.live_orders;
+        if (live >= config_.max_live_orders || (pick >= config_.add_weight && live > 0)) {
+            if (live < config_.max_live_orders && pick >= config_.add_weight + config_.cancel_weight) {
+                return makeExecute(instrument, model);
+            }
+            return makeCancel(instrument, model);
+        }
+        return makeAdd(instrument, model);
+    }
+
+private:
+    Price clampPrice(Price price) const {
+        // Keep prices positive, with room for the order depth below the mid.
+        return std::max(price, static_cast<Price>(1000));
+    }
+
+    PanoptesMessage makeAdd(InstrumentID instrument, InstrumentModel& model) {
+        const char side = uniform_(rng_) < 0.5 ? 'B' : 'A';
+        // Distance from the touch: 0 most often, geometrically rarer further out.
+        std::geometric_distribution<Price> depth(1.0 / (1.0 + config_.depth_ticks));
+        Price price;
+        if (side == 'B') {
+            price = model.mid - 1 - depth(rng_);
+            // Never cross the best ask.
+            if (!model.asks.empty()) {
+                price = std::min(price, model.asks.begin()->first - 1);
+            }
+        } else {
+            price = model.mid + 1 + depth(rng_);
+            if (!model.bids.empty()) {
+                price = std::max(price, model.bids.rbegin()->first + 1);
+            }
+        }
+        price = clampPrice(price);
+
+        const OrderID id = ++next_order_id_;
+        const int32_t size = std::uniform_int_distribution<int32_t>(config_.min_size, config_.max_size)(rng_);
+        std::list<OrderID>& queue = (side == 'B' ? model.bids : model.asks)[price];
+        live_orders_[id] = {instrument, price, size, side, queue.insert(queue.end(), id)};
+        model.expiries.push({model.step + sampleLifetime(), id});
+        ++model.live_orders;
+
+        return {timestamp_, id, price, size, 'A', side, instrument};
+    }
+
+    PanoptesMessage makeCancel(InstrumentID instrument, InstrumentModel& model) {
+        // The live order whose sampled lifetime runs out first.
+        OrderID id = popExpiry(model);
+        const LiveOrder order = live_orders_[id];
+        removeFromLevel(model, order);
+        live_orders_.erase(id);
+        --model.live_orders;
+        return {timestamp_, id, order.price, order.size, 'X', order.side, instrument};
+    }
+
+    PanoptesMessage makeExecute(InstrumentID instrument, InstrumentModel& model) {
+        // Trades happen at the touch: hit the oldest order at the best bid or ask.
+        const bool hit_bid = !model.bids.empty() && (model.asks.empty() || uniform_(rng_) < 0.5);
+        const OrderID id = hit_bid ? model.bids.rbegin()->second.front() : model.asks.begin()->second.front();
+        LiveOrder& order = live_orders_[id];
+
+        int32_t fill = order.size;
+        if (order.size > 1 && uniform_(rng_) >= config_.full_fill_probability) {
+            fill = std::uniform_int_distribution<int32_t>(1, order.size - 1)(rng_);
+        }
+        const PanoptesMessage msg{timestamp_, id, order.price, fill, 'E', order.side, instrument};
+
+        order.size -= fill;
+        if (order.size == 0) {
+            removeFromLevel(model, order);
+            live_orders_.erase(id); // Its expiry entry is now stale and will be skipped.
+            --model.live_orders;
+            if (model.expiries.size() > 2 * model.live_orders + 1024) {
+                dropStaleExpiries(model);
+            }
+        }
+        return msg;
+    }
+
+    OrderID popExpiry(InstrumentModel& model) {
+        while (true) {
+            const OrderID id = model.expiries.top().second;
+            model.expiries.pop();
+            if (live_orders_.count(id) != 0) {
+                return id;
+            }
+        }
+    }
+
+    // Rebuilds the expiry heap without entries for filled orders, so long runs
+    // don't accumulate one stale entry per full execution.
+    void dropStaleExpiries(InstrumentModel& model) {
+        decltype(model.expiries) live;
+        while (!model.expiries.empty()) {
+            if (live_orders_.count(model.expiries.top().second) != 0) {
+                live.push(model.expiries.top());
+            }
+            model.expiries.pop();
+        }
+        model.expiries.swap(live);
+    }
+
+    void removeFromLevel(InstrumentModel& model, const LiveOrder& order) {
+        auto& levels = order.side == 'B' ? model.bids : model.asks;
+        auto level = levels.find(order.price);
+        std::list<OrderID>& queue = level->second;
+        queue.erase(order.position);
+        if (queue.empty()) {
+            levels.erase(level);
+        }
+    }
+
+    uint64_t sampleLifetime() {
+        double lifetime;
+        if (config_.lognormal_lifetime) {
+            // A heavy-tailed mix of fleeting and long-lived orders with the same mean.
+            constexpr double sigma = 1.5;
+            const double mu = std::log(config_.mean_lifetime) - sigma * sigma / 2.0;
+            lifetime = std::lognormal_distribution<double>(mu, sigma)(rng_);
+        } else {
+            lifetime = std::exponential_distribution<double>(1.0 / config_.mean_lifetime)(rng_);
+        }
+        return static_cast<uint64_t>(lifetime) + 1;
+    }
+
+    GeneratorConfig config_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+    std::exponential_distribution<double> gap_;
+    std::vector<InstrumentModel> instruments_;
+    std::unordered_map<OrderID, LiveOrder> live_orders_;
+    OrderID next_order_id_ = 0;
+    // Example start time: 9:30:00.000000000 AM in nanoseconds since midnight.
+    Timestamp timestamp_ = 34200000000000;
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --out PATH             output file (default data/messages.bin)\n"
+              << "  --messages N           number of messages (default 1000000)\n"
+              << "  --seed S               random seed (default 42)\n"
+              << "  --instruments K        number of instruments (default 1)\n"
+              << "  --mix A,X,E            relative weights of add/cancel/execute (default 50,40,10)\n"
+              << "  --full-fill P          chance an execute fills the whole order (default 0.5)\n"
+              << "  --mean-lifetime T      mean order lifetime in messages per instrument (default 200)\n"
+              << "  --lifetime exp|lognormal  lifetime distribution (default exp)\n"
+              << "  --start-price P        fixed-point starting mid price (default 1500000)\n"
+              << "  --walk-prob P          chance per message the mid moves a tick (default 0.05)\n"
+              << "  --depth D              mean distance of new orders from the touch, in ticks (default 10)\n"
+              << "  --size MIN,MAX         order size range (default 1,500)\n"
+              << "  --max-live N           live order cap per instrument (default 100000)\n"
+              << "  --mean-gap-ns G        mean time between messages (default 1000)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+            config.output_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--messages") == 0 && has_value) {
+            config.num_messages = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--instruments") == 0 && has_value) {
+            config.num_instruments = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--mix") == 0 && has_value) {
+            if (std::sscanf(argv[++i], "%lf,%lf,%lf", &config.add_weight, &config.cancel_weight, &config.execute_weight) != 3) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--full-fill") == 0 && has_value) {
+            config.full_fill_probability = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--mean-lifetime") == 0 && has_value) {
+            config.mean_lifetime = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lifetime") == 0 && has_value) {
+            config.lognormal_lifetime = std::strcmp(argv[++i], "lognormal") == 0;
+        } else if (std::strcmp(argv[i], "--start-price") == 0 && has_value) {
+            config.start_price = std::strtoll(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--walk-prob") == 0 && has_value) {
+            config.walk_probability = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--depth") == 0 && has_value) {
+            config.depth_ticks = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--size") == 0 && has_value) {
+            if (std::sscanf(argv[++i], "%d,%d", &config.min_size, &config.max_size) != 2) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--max-live") == 0 && has_value) {
+            config.max_live_orders = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--mean-gap-ns") == 0 && has_value) {
+            config.mean_gap_ns = std::atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.num_instruments < 1 || config.num_instruments > static_cast<int>(MAX_INSTRUMENTS) ||
+        config.min_size < 1 || config.max_size < config.min_size || config.mean_lifetime <= 0.0 ||
+        config.mean_gap_ns <= 0.0 || config.add_weight <= 0.0 || config.max_live_orders == 0) {
+        std::cerr << "Error: invalid configuration." << std::endl;
+        return 1;
+    }
+
+    // The default output goes in the repo's data directory; create it if this
+    // is a fresh checkout. Any other path is the caller's to provide.
+    if (std::strcmp(config.output_path, DEFAULT_OUTPUT_PATH) == 0) {
+        mkdir("data", 0755);
+    }
+
+    std::ofstream output_file(config.output_path, std::ios::binary);
+    if (!output_file.is_open()) {
+        std::cerr << "Failed to open " << config.output_path << " for writing." << std::endl;
+        return 1;
+    }
+
+    FlowGenerator generator(config);
+    uint64_t counts[3] = {0, 0, 0};
+    {
+        MessageWriter writer(output_file);
+        for (uint64_t i = 0; i < config.num_messages; ++i) {
+            const PanoptesMessage msg = generator.next();
+            ++counts[msg.event_type == 'A' ? 0 : (msg.event_type == 'X' ? 1 : 2)];
+            writer.write(msg);
+        }
+    }
+    output_file.close();
+
+    std::cout << "Wrote " << config.num_messages << " messages (" << counts[0] << " adds, "
+              << counts[1] << " cancels, " << counts[2] << " executes) across "
+              << config.num_instruments << " instrument(s) to " << config.output_path << std::endl;
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <benchmark/benchmark.h>
+#include "../engine/include/BinaryParser.h"
+#include <cstring>
+#include <vector>
+
+// A frame-sized stream of mostly valid adds, cancels and executes with one
+// message in 64 corrupted, like a feed with the odd bad packet.
+static std::vector<char> makeWire(size_t count) {
+    std::vector<PanoptesMessage> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const char event = "AAXE"[i % 4];
+        messages.push_back({static_cast<Timestamp>(i), i + 1, 1500000 + static_cast<Price>(i % 32),
+                            event == 'X' ? 0 : 100, event, (i % 3) ? 'B' : 'A', static_cast<InstrumentID>(i % 8)});
+        if (i % 64 == 63) {
+            messages.back().event_type = '?';
+        }
+    }
+    std::vector<char> wire(count * sizeof(PanoptesMessage));
+    std::memcpy(wire.data(), messages.data(), wire.size());
+    return wire;
+}
+
+// The old path: decode one message at a time, no validation.
+static void BM_ParseOneByOne(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    const std::vector<char> wire = makeWire(count);
+    std::vector<PanoptesMessage> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = parseMessage(wire.data() + i * sizeof(PanoptesMessage));
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ParseOneByOne)->Arg(40)->Arg(4096);
+
+// Decode and validate a batch with a given implementation.
+static void BM_ParseBatch(benchmark::State& state, ParserIsa isa) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    const std::vector<char> wire = makeWire(count);
+    std::vector<PanoptesMessage> out(count);
+    ParseStats stats;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseBatchWith(isa, wire.data(), count, out.data(), stats));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_ParseBatch, Scalar, ParserIsa::Scalar)->Arg(40)->Arg(4096);
+BENCHMARK_CAPTURE(BM_ParseBatch, Sse42, ParserIsa::Sse42)->Arg(40)->Arg(4096);
+BENCHMARK_CAPTURE(BM_ParseBatch, Avx2, ParserIsa::Avx2)->Arg(40)->Arg(4096);
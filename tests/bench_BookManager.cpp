@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include "../engine/include/BookManager.h"
+#include <thread>
+#include <vector>
+
+// Throughput of the whole multi-instrument pipeline with 1..N worker threads.
+//
+// The benchmark thread plays the network thread: it submits add/cancel pairs
+// spread round-robin over a fixed set of instruments, then waits for the
+// workers to drain. The instrument count stays the same for every thread
+// count, so the runs do the same book work and only the parallelism changes.
+static void BM_BookManagerThroughput(benchmark::State& state) {
+    constexpr InstrumentID num_instruments = 8;
+    constexpr size_t batch = 1 << 18;
+
+    BookManagerConfig config;
+    config.num_workers = static_cast<size_t>(state.range(0));
+    config.pool_config = {1 << 14, 1 << 14, PoolOverflowPolicy::Grow};
+    BookManager manager(config);
+    manager.start();
+
+    // Pre-build the message stream so the producer only measures routing.
+    std::vector<PanoptesMessage> messages;
+    messages.reserve(batch);
+    for (size_t i = 0; i < batch / 2; ++i) {
+        const InstrumentID instrument = static_cast<InstrumentID>(i % num_instruments);
+        // Keep a few hundred orders live per book so cancels hit a non-trivial level.
+        const OrderID id = i + 1;
+        messages.push_back({0, id, 1500000 + static_cast<Price>(i % 64), 100, 'A', 'B', instrument});
+        if (i >= 2048) {
+            const OrderID old_id = id - 2048;
+            messages.push_back({0, old_id, 0, 0, 'X', 'B', static_cast<InstrumentID>((old_id - 1) % num_instruments)});
+        } else {
+            messages.push_back({0, id, 0, 0, 'X', 'B', instrument});
+        }
+    }
+
+    // Touch every book once so their creation is not part of the timed loop.
+    uint64_t submitted = 0;
+    for (InstrumentID instrument = 0; instrument < num_instruments; ++instrument) {
+        manager.submit({0, 0, 0, 0, 'X', 'B', instrument});
+        ++submitted;
+    }
+    while (manager.messagesProcessed() < submitted) {
+    }
+
+    for (auto _ : state) {
+        for (const PanoptesMessage& msg : messages) {
+            manager.submit(msg);
+        }
+        submitted += messages.size();
+        while (manager.messagesProcessed() < submitted) {
+        }
+    }
+    manager.stop();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * messages.size()));
+    state.counters["producer_stalls"] = static_cast<double>(manager.producerStalls());
+    state.counters["ring_hwm"] = static_cast<double>(manager.ringHighWaterMark());
+}
+
+// One run per worker count from 1 up to the number of cores on this machine.
+static void WorkerCounts(benchmark::internal::Benchmark* bench) {
+    const unsigned cores = std::thread::hardware_concurrency();
+    for (unsigned workers = 1; workers <= (cores > 0 ? cores : 1); ++workers) {
+        bench->Arg(workers);
+    }
+}
+BENCHMARK(BM_BookManagerThroughput)->Apply(WorkerCounts)->UseRealTime()->Unit(benchmark::kMillisecond);
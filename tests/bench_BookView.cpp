@@ -0,0 +1,175 @@
+#include <benchmark/benchmark.h>
+#include "../engine/include/BookView.h"
+#include "../engine/include/L1CacheBook.h"
+#include "../engine/include/TscClock.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// The shared-memory book view (BookView.h): what publishing costs the book
+// thread, and how far behind the book a reader on another core is.
+
+static constexpr Price MID_PRICE = 1500000;
+
+// A book with 'live' orders spread over 'levels' prices per side, driven by
+// cancel/add pairs at random levels, optionally publishing to a view.
+class ViewedBook {
+public:
+    ViewedBook(size_t live, int64_t levels, SharedBookView* view)
+        : resting_(live), levels_(levels), view_(view) {
+        if (view_) {
+            book_.enableLevelUpdates();
+        }
+        for (size_t slot = 0; slot < live; ++slot) {
+            replace(slot, 0);
+        }
+    }
+
+    // Cancels a random live order and adds a new one. 'tsc' stamps any view
+    // it publishes.
+    void step(uint64_t tsc) {
+        const size_t victim = next() % resting_.size();
+        apply({0, resting_[victim], 0, 0, 'X', 0}, tsc);
+        replace(victim, tsc);
+    }
+
+    uint64_t publishes() const { return publishes_; }
+
+private:
+    void replace(size_t slot, uint64_t tsc) {
+        resting_[slot] = ++next_id_;
+        const bool bid = (next() & 1) != 0;
+        const Price offset = static_cast<Price>(next() % static_cast<uint64_t>(levels_));
+        apply({0, resting_[slot], bid ? MID_PRICE - offset : MID_PRICE + 1 + offset, 100, 'A', bid ? 'B' : 'A'}, tsc);
+    }
+
+    // What a book worker does per message (BookManager::run()).
+    void apply(const PanoptesMessage& msg, uint64_t tsc) {
+        book_.apply(msg);
+        if (view_) {
+            LevelUpdateBuffer& updates = book_.levelUpdates();
+            publishes_ += view_->update(msg.instrument_id, book_, updates.data(), updates.size(), tsc);
+            updates.clear();
+        }
+    }
+
+    // xorshift64.
+    uint64_t next() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        return rng_;
+    }
+
+    L1CacheBook book_;
+    std::vector<OrderID> resting_;
+    int64_t levels_;
+    SharedBookView* view_;
+    uint64_t rng_ = 42;
+    OrderID next_id_ = 0;
+    uint64_t publishes_ = 0;
+};
+
+static std::string segmentName() {
+    return "/panoptes_bench_view_" + std::to_string(getpid());
+}
+
+// --- Writer overhead ---
+
+// Add/cancel flow over 4096 live orders without (0) and with (1) a view.
+// Arguments are {view, active levels per side}. With one level nearly every
+// message changes the view; with many, most land behind the top ten levels and
+// cost only the check. 'publishes' is the fraction of messages that republished.
+static void BM_ViewWriterOverhead(benchmark::State& state) {
+    SharedBookView view;
+    if (state.range(0) != 0 && !view.create(segmentName(), 1, 1.0)) {
+        state.SkipWithError("could not create the shared-memory segment");
+        return;
+    }
+    ViewedBook book(4096, state.range(1), state.range(0) != 0 ? &view : nullptr);
+    const uint64_t before = book.publishes();
+
+    for (auto _ : state) {
+        book.step(0);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+    state.counters["publishes"] = static_cast<double>(book.publishes() - before) / (state.iterations() * 2.0);
+}
+BENCHMARK(BM_ViewWriterOverhead)->ArgsProduct({{0, 1}, {1, 16, 1024}});
+
+// One forced publish of a full view (ten levels a side): the depth walk plus
+// the seqlock write, which is what a message that does change the view pays.
+static void BM_ViewPublish(benchmark::State& state) {
+    SharedBookView view;
+    if (!view.create(segmentName(), 1, 1.0)) {
+        state.SkipWithError("could not create the shared-memory segment");
+        return;
+    }
+    L1CacheBook book;
+    OrderID id = 0;
+    for (Price level = 0; level < 64; ++level) {
+        book.apply({0, ++id, MID_PRICE - level, 100, 'A', 'B'});
+        book.apply({0, ++id, MID_PRICE + 1 + level, 100, 'A', 'A'});
+    }
+    const LevelUpdate at_touch{MID_PRICE, 100, 'B', 0, 0};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(view.update(0, book, &at_touch, 1, 0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ViewPublish);
+
+// --- Reader staleness ---
+
+// A writer thread runs add/cancel flow at the touch, publishing every change,
+// while the benchmark thread reads the view as fast as it can. Each iteration
+// is one read; 'staleness_ns' is the mean age of a view (TSC at the read minus
+// TSC at its publish) the first time the reader sees it, and 'new_views' the
+// fraction of reads that found one. Needs two free cores to mean much: on a
+// single core the two threads take turns and the age is a scheduler quantum.
+static void BM_ViewReaderStaleness(benchmark::State& state) {
+    TscClock::calibrate(5);
+    const std::string name = segmentName();
+    SharedBookView view;
+    BookViewReader reader;
+    if (!view.create(name, 1, TscClock::nsPerTick()) || !reader.open(name)) {
+        state.SkipWithError("could not create the shared-memory segment");
+        return;
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        ViewedBook book(64, 4, &view);
+        while (!stop.load(std::memory_order_relaxed)) {
+            book.step(TscClock::now());
+        }
+    });
+    // Wait for the first publish, so every read has something to see.
+    while (reader.version(0) == 0) {
+    }
+
+    BookView copy;
+    uint64_t last_version = 0;
+    uint64_t new_views = 0;
+    uint64_t total_age = 0;
+    for (auto _ : state) {
+        const uint64_t version = reader.read(0, copy);
+        if (version != last_version) {
+            const uint64_t now = TscClock::now();
+            last_version = version;
+            ++new_views;
+            total_age += now > copy.publish_tsc ? now - copy.publish_tsc : 0;
+        }
+    }
+    stop.store(true, std::memory_order_relaxed);
+    writer.join();
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["new_views"] = static_cast<double>(new_views) / static_cast<double>(state.iterations());
+    state.counters["staleness_ns"] =
+        new_views == 0 ? 0.0 : static_cast<double>(total_age) * reader.nsPerTick() / static_cast<double>(new_views);
+}
+BENCHMARK(BM_ViewReaderStaleness)->UseRealTime();
@@ -1,6 +1,11 @@
 #include <benchmark/benchmark.h>
 #include "../engine/include/L1CacheBook.h"
+#include "../engine/include/OrderIndex.h"
 #include <memory>
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
 
 // A benchmark fixture sets up a consistent environment for our tests.
 class L1CacheBookFixture : public benchmark::Fixture {
@@ -24,6 +29,10 @@ public:
 
 // Use BENCHMARK_F to register a benchmark that uses our fixture.
 BENCHMARK_F(L1CacheBookFixture, BM_AddOrder)(benchmark::State& state) {
+    // Adds to one level. The book is emptied (untimed) every ADD_ORDER_BATCH
+    // adds, so however many iterations the library picks, the level stays a
+    // realistic size and the pool never has to grow.
+    constexpr uint64_t ADD_ORDER_BATCH = 1 << 16;
     PanoptesMessage msg{0, 0, 1500000, 100, 'A', 'B'};
 
     // This is the main timing loop.
@@ -32,7 +41,16 @@ BENCHMARK_F(L1CacheBookFixture, BM_AddOrder)(benchmark::State& state) {
         msg.order_id = ++order_id_counter;
         // Use the 'book' object created in our fixture's SetUp method.
         book->addOrder(msg);
+
+        if (order_id_counter % ADD_ORDER_BATCH == 0) {
+            state.PauseTiming();
+            for (OrderID id = order_id_counter - ADD_ORDER_BATCH + 1; id <= order_id_counter; ++id) {
+                book->cancelOrder({0, id, 0, 0, 'X', 'B'});
+            }
+            state.ResumeTiming();
+        }
     }
+    state.SetItemsProcessed(state.iterations());
 }
 
 // Another benchmark using the same fixture.
@@ -49,5 +67,355 @@ BENCHMARK_F(L1CacheBookFixture, BM_AddCancelCycle)(benchmark::State& state) {
     }
 }
 
+// Fills both sides of the book with 'depth' price levels around a mid price of 150.0000.
+static void populateBook(L1CacheBook& book, int64_t depth, uint64_t& order_id_counter) {
+    for (int64_t i = 0; i < depth; ++i) {
+        book.addOrder({0, ++order_id_counter, 1500000 - i, 100, 'A', 'B'});
+        book.addOrder({0, ++order_id_counter, 1500001 + i, 100, 'A', 'A'});
+    }
+}
+
+// Measures the cost of reading the BBO with 'depth' levels resting on each side.
+BENCHMARK_DEFINE_F(L1CacheBookFixture, BM_BestBidAskQuery)(benchmark::State& state) {
+    populateBook(*book, state.range(0), order_id_counter);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book->getBestBid());
+        benchmark::DoNotOptimize(book->getBestAsk());
+    }
+}
+BENCHMARK_REGISTER_F(L1CacheBookFixture, BM_BestBidAskQuery)->Arg(1)->Arg(100)->Arg(10000)->Arg(100000);
+
+// Measures the cost of emptying the best bid level and reading the new BBO, which
+// forces a bitmap search for the next best level. The gap between levels is the
+// benchmark argument, so larger values make the next level further away.
+BENCHMARK_DEFINE_F(L1CacheBookFixture, BM_BestBidAfterLevelEmpties)(benchmark::State& state) {
+    const int64_t gap = state.range(0);
+    PanoptesMessage add_msg{0, 0, 1500000, 100, 'A', 'B'};
+    PanoptesMessage cancel_msg{0, 0, 0, 0, 'X', 'B'};
+
+    // A resting level far below the one we keep emptying.
+    book->addOrder({0, ++order_id_counter, 1500000 - gap, 100, 'A', 'B'});
+
+    for (auto _ : state) {
+        add_msg.order_id = ++order_id_counter;
+        cancel_msg.order_id = order_id_counter;
+
+        book->addOrder(add_msg);
+        book->cancelOrder(cancel_msg);
+        benchmark::DoNotOptimize(book->getBestBid());
+    }
+}
+BENCHMARK_REGISTER_F(L1CacheBookFixture, BM_BestBidAfterLevelEmpties)->Arg(1)->Arg(1000)->Arg(400000);
+
+// A resting ask and an aggressive bid that fills it completely: the shortest
+// matching path, which produces one trade per iteration.
+BENCHMARK_F(L1CacheBookFixture, BM_MatchFullFill)(benchmark::State& state) {
+    PanoptesMessage ask{0, 0, 1500000, 100, 'A', 'A'};
+    PanoptesMessage bid{0, 0, 1500000, 100, 'A', 'B'};
+
+    for (auto _ : state) {
+        ask.order_id = ++order_id_counter;
+        bid.order_id = ++order_id_counter;
+        book->addOrder(ask);
+        book->addOrder(bid);
+        book->trades().clear();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// An aggressive bid that sweeps 'levels' ask levels of four orders each.
+// Items processed counts fills, so the rate is matching throughput in fills per second.
+BENCHMARK_DEFINE_F(L1CacheBookFixture, BM_MatchSweep)(benchmark::State& state) {
+    const int64_t levels = state.range(0);
+    constexpr int orders_per_level = 4;
+    int64_t fills = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int64_t level = 0; level < levels; ++level) {
+            for (int i = 0; i < orders_per_level; ++i) {
+                book->addOrder({0, ++order_id_counter, 1500000 + level, 100, 'A', 'A'});
+            }
+        }
+        state.ResumeTiming();
+
+        book->addOrder({0, ++order_id_counter, 1500000 + levels, static_cast<int32_t>(100 * orders_per_level * levels), 'A', 'B'});
+        fills += static_cast<int64_t>(book->trades().size());
+        book->trades().clear();
+    }
+    state.SetItemsProcessed(fills);
+}
+BENCHMARK_REGISTER_F(L1CacheBookFixture, BM_MatchSweep)->Arg(1)->Arg(16)->Arg(256);
+
+// --- Order index: OrderIndex vs std::unordered_map ---
+
+// Thin adapters so the same benchmark body can drive both containers.
+struct FlatIndexAdapter {
+    explicit FlatIndexAdapter(size_t expected) : index(expected) {}
+    void insert(OrderID id, Order* order) { index.insert(id, order); }
+    Order* find(OrderID id) const { return index.find(id); }
+    Order* erase(OrderID id) { return index.erase(id); }
+    OrderIndex index;
+};
+
+struct UnorderedMapAdapter {
+    explicit UnorderedMapAdapter(size_t expected) { map.reserve(expected); }
+    void insert(OrderID id, Order* order) { map[id] = order; }
+    Order* find(OrderID id) const {
+        auto it = map.find(id);
+        return it == map.end() ? nullptr : it->second;
+    }
+    Order* erase(OrderID id) {
+        auto it = map.find(id);
+        if (it == map.end()) {
+            return nullptr;
+        }
+        Order* order = it->second;
+        map.erase(it);
+        return order;
+    }
+    std::unordered_map<OrderID, Order*> map;
+};
+
+// Generates 'count' order IDs, either sequential (like an exchange's counter)
+// or uniformly random 64-bit values (like IDs from many independent sources).
+static std::vector<OrderID> makeOrderIds(size_t count, bool random) {
+    std::vector<OrderID> ids(count);
+    std::mt19937_64 rng(42);
+    for (size_t i = 0; i < count; ++i) {
+        ids[i] = random ? rng() : 1000000 + i;
+    }
+    return ids;
+}
+
+// Steady-state add/cancel flow: 'live' orders stay in the index while each
+// iteration inserts one new ID and erases the oldest, as a book does.
+template <typename Index>
+static void BM_IndexInsertErase(benchmark::State& state) {
+    const size_t live = static_cast<size_t>(state.range(0));
+    const bool random = state.range(1) != 0;
+    const std::vector<OrderID> ids = makeOrderIds(live * 4, random);
+    Order order;
+    Index index(live);
+    for (size_t i = 0; i < live; ++i) {
+        index.insert(ids[i], &order);
+    }
+
+    size_t next = live;
+    for (auto _ : state) {
+        index.insert(ids[next % ids.size()], &order);
+        benchmark::DoNotOptimize(index.erase(ids[(next - live) % ids.size()]));
+        ++next;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Lookups of live IDs in a populated index, in a shuffled order.
+template <typename Index>
+static void BM_IndexFind(benchmark::State& state) {
+    const size_t live = static_cast<size_t>(state.range(0));
+    const bool random = state.range(1) != 0;
+    std::vector<OrderID> ids = makeOrderIds(live, random);
+    Order order;
+    Index index(live);
+    for (OrderID id : ids) {
+        index.insert(id, &order);
+    }
+    std::shuffle(ids.begin(), ids.end(), std::mt19937_64(7));
+
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.find(ids[next]));
+        if (++next == ids.size()) {
+            next = 0;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Arguments are {live orders, random IDs (0 = sequential, 1 = random)}.
+#define INDEX_BENCHMARK_ARGS ->ArgsProduct({{1000, 100000, 1000000}, {0, 1}})
+BENCHMARK_TEMPLATE(BM_IndexInsertErase, FlatIndexAdapter) INDEX_BENCHMARK_ARGS;
+BENCHMARK_TEMPLATE(BM_IndexInsertErase, UnorderedMapAdapter) INDEX_BENCHMARK_ARGS;
+BENCHMARK_TEMPLATE(BM_IndexFind, FlatIndexAdapter) INDEX_BENCHMARK_ARGS;
+BENCHMARK_TEMPLATE(BM_IndexFind, UnorderedMapAdapter) INDEX_BENCHMARK_ARGS;
+
+// Half the live orders rest and are never cancelled; the other half is a
+// sliding window of sequential IDs, as in BM_IndexInsertErase. Once the
+// counter has passed the table size, the window's IDs come round onto the
+// resting orders' slots, which must not turn them into one long probe run.
+template <typename Index>
+static void BM_IndexRestingAndChurn(benchmark::State& state) {
+    const size_t live = static_cast<size_t>(state.range(0));
+    const size_t window = live / 2;
+    Order order;
+    Index index(live);
+    OrderID next = 1;
+    for (; next <= live; ++next) {
+        index.insert(next, &order);
+    }
+
+    for (auto _ : state) {
+        index.insert(next, &order);
+        benchmark::DoNotOptimize(index.erase(next - window));
+        ++next;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_IndexRestingAndChurn, FlatIndexAdapter)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_IndexRestingAndChurn, UnorderedMapAdapter)->Arg(1000)->Arg(100000);
+
+// --- Order storage layouts: pointer vs compact vs hot/cold ---
+
+// Rests 'count' asks at one price, in slots scattered across the storage: a
+// burst of orders is added and cancelled in random order first, so the free
+// list hands slots back in a random order, as it does after a busy session.
+template <typename Book>
+static void restScatteredLevel(Book& book, int64_t count, uint64_t& order_id_counter, std::mt19937_64& rng) {
+    std::vector<OrderID> scratch;
+    for (int64_t i = 0; i < count; ++i) {
+        scratch.push_back(++order_id_counter);
+        book.addOrder({0, scratch.back(), 1400000, 100, 'A', 'A'});
+    }
+    std::shuffle(scratch.begin(), scratch.end(), rng);
+    for (OrderID id : scratch) {
+        book.cancelOrder({0, id, 0, 0, 'X', 'A'});
+    }
+    for (int64_t i = 0; i < count; ++i) {
+        book.addOrder({0, ++order_id_counter, 1500000, 100, 'A', 'A'});
+    }
+}
+
+// Walks one level's queue from head to tail: an aggressive bid fills every
+// order resting there. Items processed counts fills. Deep queues do not fit in
+// cache, so the cost is dominated by how many cache lines each order touches.
+template <typename Book>
+static void BM_LayoutLevelSweep(benchmark::State& state) {
+    const int64_t depth = state.range(0);
+    auto book = std::make_unique<Book>();
+    std::mt19937_64 rng(42);
+    uint64_t order_id_counter = 0;
+    int64_t fills = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        restScatteredLevel(*book, depth, order_id_counter, rng);
+        book->trades().clear();
+        state.ResumeTiming();
+
+        book->addOrder({0, ++order_id_counter, 1500000, static_cast<int32_t>(100 * depth), 'A', 'B'});
+        fills += depth;
+    }
+    state.SetItemsProcessed(fills);
+}
+BENCHMARK_TEMPLATE(BM_LayoutLevelSweep, L1CacheBook)->Arg(1024)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_LayoutLevelSweep, CompactL1CacheBook)->Arg(1024)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_LayoutLevelSweep, HotColdL1CacheBook)->Arg(1024)->Arg(65536);
+
+// Steady-state flow over a book with 'live' resting orders spread over 1000
+// levels: each iteration cancels a random live order and adds a new one in its
+// place, so both the index and the order records are hit at random.
+template <typename Book>
+static void BM_LayoutRandomAddCancel(benchmark::State& state) {
+    const size_t live = static_cast<size_t>(state.range(0));
+    auto book = std::make_unique<Book>();
+    std::mt19937_64 rng(42);
+    std::vector<OrderID> resting(live);
+    OrderID next_id = 0;
+    for (size_t i = 0; i < live; ++i) {
+        resting[i] = ++next_id;
+        const bool bid = (i & 1) != 0;
+        book->addOrder({0, resting[i], bid ? 1500000 - static_cast<Price>(rng() % 1000) : 1500001 + static_cast<Price>(rng() % 1000),
+                        100, 'A', bid ? 'B' : 'A'});
+    }
+
+    for (auto _ : state) {
+        const size_t victim = rng() % live;
+        const bool bid = (victim & 1) != 0;
+        book->cancelOrder({0, resting[victim], 0, 0, 'X', bid ? 'B' : 'A'});
+        resting[victim] = ++next_id;
+        book->addOrder({0, resting[victim], bid ? 1500000 - static_cast<Price>(rng() % 1000) : 1500001 + static_cast<Price>(rng() % 1000),
+                        100, 'A', bid ? 'B' : 'A'});
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_LayoutRandomAddCancel, L1CacheBook)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_LayoutRandomAddCancel, CompactL1CacheBook)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_LayoutRandomAddCancel, HotColdL1CacheBook)->Arg(1 << 12)->Arg(1 << 20);
+
+// --- Compile-time specialisation: traits and side-specialised ladders ---
+
+// A steady flow of adds, cancels and partial executes over 4096 live orders,
+// applied through apply() as the engine does. Sides are random, so any branch
+// on the side is a coin flip for the predictor. Bids rest below the mid and
+// asks above it, so no add crosses and a book with matching off does the same
+// book work as one with it on.
+//
+// Run with --benchmark_perf_counters=INSTRUCTIONS,BRANCHES,BRANCH-MISSES
+// (on a machine with a PMU and a libpfm-enabled benchmark build) to see the
+// per-message instruction and branch counts behind the times.
+template <typename Book>
+static void runVariantFlow(benchmark::State& state, Book& book) {
+    constexpr size_t live = 4096;
+    // xorshift64: a few instructions per number, so the generator does not
+    // drown out the differences being measured.
+    uint64_t seed = 42;
+    auto rng = [&seed] {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+    std::vector<OrderID> resting(live);
+    OrderID next_id = 0;
+    auto add = [&](size_t slot) {
+        const bool bid = (rng() & 1) != 0;
+        const Price offset = static_cast<Price>(rng() % 64);
+        resting[slot] = ++next_id;
+        book.apply({0, resting[slot], bid ? 1500000 - offset : 1500001 + offset, 100, 'A', bid ? 'B' : 'A'});
+    };
+    for (size_t i = 0; i < live; ++i) {
+        add(i);
+    }
+
+    int64_t messages = 0;
+    for (auto _ : state) {
+        const size_t victim = rng() % live;
+        if ((rng() & 3) == 0) {
+            book.apply({0, resting[victim], 0, 10, 'E', 0});
+            ++messages;
+        }
+        book.apply({0, resting[victim], 0, 0, 'X', 0});
+        add(victim);
+        book.trades().clear();
+        messages += 2;
+    }
+    state.SetItemsProcessed(messages);
+}
+
+template <typename Book>
+static void BM_VariantFlow(benchmark::State& state) {
+    auto book = std::make_unique<Book>();
+    runVariantFlow(state, *book);
+}
+// Tick, base and sizes read from the config (tick 1 here, but not known to be).
+BENCHMARK_TEMPLATE(BM_VariantFlow, L1CacheBook);
+// Unit tick known at compile time: no tick conversion or off-grid check.
+BENCHMARK_TEMPLATE(BM_VariantFlow, UnitTickL1CacheBook);
+// Plus the window size and capacity as constants.
+BENCHMARK_TEMPLATE(BM_VariantFlow, FixedL1CacheBook);
+// Unit tick with matching compiled out.
+using UnitTickFeedBook = BasicL1CacheBook<UnitTickBookTraits<PointerOrderStorage, false>>;
+BENCHMARK_TEMPLATE(BM_VariantFlow, UnitTickFeedBook);
+
+// The unit-tick book picked at run time by makeOrderBook(), as BookManager
+// holds it: the same code behind one indirect call per message.
+static void BM_VariantFlowThroughInterface(benchmark::State& state) {
+    auto book = makeOrderBook(BookVariant{}, OrderPoolConfig{}, DEFAULT_INDEX_LOAD_FACTOR, PriceLadderConfig{});
+    runVariantFlow(state, *book);
+}
+BENCHMARK(BM_VariantFlowThroughInterface);
+
 // The main entry point for the benchmark executable.
 BENCHMARK_MAIN();
@@ -0,0 +1,224 @@
+#include <benchmark/benchmark.h>
+#include "../engine/include/LatencyHistogram.h"
+#include "../engine/include/ShmReceiver.h"
+#include "../engine/include/ShmRing.h"
+#include "../engine/include/TscClock.h"
+#include "../engine/include/UdpReceiver.h"
+#include "../engine/include/WireFormat.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// The two ingest transports side by side: UDP over loopback (UdpReceiver) and
+// the shared-memory ring (ShmRing.h, ShmReceiver). A sender thread writes v2
+// frames the way the thrasher does, and the benchmark thread receives them the
+// way the engine does. The first argument picks the transport: 0 UDP, 1 ring.
+
+static constexpr int BENCH_PORT = 12399;
+static constexpr size_t LATENCY_FRAME_MESSAGES = 1;
+static constexpr size_t THROUGHPUT_FRAME_MESSAGES = DEFAULT_FRAME_MESSAGES;
+
+static std::string segmentName() {
+    return "/panoptes_bench_ring_" + std::to_string(getpid());
+}
+
+// One sender: a connected UDP socket, or a claimed lane of the ring.
+class BenchSender {
+public:
+    bool open(bool ring) {
+        ring_ = ring;
+        if (ring_) {
+            return writer_.open(segmentName(), 0);
+        }
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(BENCH_PORT);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        return fd_ >= 0 && connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    ~BenchSender() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    // Sends one frame of 'count' messages. UDP sends never wait (a full socket
+    // buffer drops); the ring waits for room, as the thrasher does.
+    void send(const FrameHeader& header, const PanoptesMessage* messages, size_t count,
+              const std::atomic<bool>& stop) {
+        if (ring_) {
+            while (!writer_.tryWrite(&header, sizeof(header), messages, count * sizeof(PanoptesMessage))) {
+                if (stop.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            writer_.publish();
+            return;
+        }
+        iovec iov[2] = {{const_cast<FrameHeader*>(&header), sizeof(header)},
+                        {const_cast<PanoptesMessage*>(messages), count * sizeof(PanoptesMessage)}};
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        sendmsg(fd_, &msg, 0);
+    }
+
+private:
+    bool ring_ = false;
+    int fd_ = -1;
+    ShmRingWriter writer_;
+};
+
+// The engine's side of either transport, behind one call.
+class BenchReceiver {
+public:
+    bool open(bool ring) {
+        if (ring) {
+            ShmReceiverConfig config;
+            config.name = segmentName();
+            config.num_lanes = 1;
+            config.timeout_ms = 200;
+            shm_ = std::make_unique<ShmReceiver>(config);
+            return shm_->open();
+        }
+        UdpReceiverConfig config;
+        config.port = BENCH_PORT;
+        config.timeout_ms = 200;
+        udp_ = std::make_unique<UdpReceiver>(config);
+        return udp_->open();
+    }
+
+    int receiveBatch() { return shm_ ? shm_->receiveBatch() : udp_->receiveBatch(); }
+    const char* data(size_t i) const { return shm_ ? shm_->data(i) : udp_->data(i); }
+
+private:
+    std::unique_ptr<UdpReceiver> udp_;
+    std::unique_ptr<ShmReceiver> shm_;
+};
+
+static FrameHeader frameHeader(uint64_t first_sequence, size_t count) {
+    return {FRAME_MAGIC, FRAME_VERSION, 0, static_cast<uint16_t>(count), 1, 0, 0, first_sequence};
+}
+
+// --- Latency ---
+
+// One single-message frame every 20 us, stamped with the TSC just before it is
+// sent; each iteration receives one and records how long it took to arrive.
+// The percentiles are of that send-to-receive time. The pacing keeps queues
+// empty, so this is the transport's own latency rather than a backlog's. With
+// both threads on one core the numbers include the scheduler handing it over.
+static void BM_TransportLatency(benchmark::State& state) {
+    TscClock::calibrate(5);
+    const bool ring = state.range(0) != 0;
+    BenchReceiver receiver;
+    if (!receiver.open(ring)) {
+        state.SkipWithError("could not open the receiver");
+        return;
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread sender([&] {
+        BenchSender out;
+        if (!out.open(ring)) {
+            return;
+        }
+        PanoptesMessage message{0, 1, 1000, 100, 'A', 'B'};
+        for (uint64_t sequence = 1; !stop.load(std::memory_order_relaxed); ++sequence) {
+            message.timestamp = static_cast<Timestamp>(TscClock::now());
+            out.send(frameHeader(sequence, LATENCY_FRAME_MESSAGES), &message, LATENCY_FRAME_MESSAGES, stop);
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    });
+
+    LatencyHistogram latency;
+    for (auto _ : state) {
+        const int received = receiver.receiveBatch();
+        const uint64_t now = TscClock::now();
+        if (received <= 0) {
+            state.SkipWithError("the sender stopped sending");
+            break;
+        }
+        for (int i = 0; i < received; ++i) {
+            PanoptesMessage message;
+            std::memcpy(&message, receiver.data(i) + sizeof(FrameHeader), sizeof(message));
+            latency.record(TscClock::toNanos(now - static_cast<uint64_t>(message.timestamp)));
+        }
+    }
+    stop.store(true, std::memory_order_relaxed);
+    sender.join();
+
+    state.counters["p50_ns"] = static_cast<double>(latency.percentile(50.0));
+    state.counters["p99_ns"] = static_cast<double>(latency.percentile(99.0));
+    state.counters["p99.9_ns"] = static_cast<double>(latency.percentile(99.9));
+}
+BENCHMARK(BM_TransportLatency)->Arg(0)->Arg(1)->UseRealTime()->Iterations(20000);
+
+// --- Throughput ---
+
+// The sender streams full frames (40 messages) as fast as it can; each
+// iteration is one batch received, with every message read as a parse would.
+// Items are messages. Over UDP the socket buffer overflows and drops, which
+// 'delivered' (the fraction of what was sent that arrived) shows; the ring
+// holds the sender back instead.
+static void BM_TransportThroughput(benchmark::State& state) {
+    const bool ring = state.range(0) != 0;
+    BenchReceiver receiver;
+    if (!receiver.open(ring)) {
+        state.SkipWithError("could not open the receiver");
+        return;
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> frames_sent{0};
+    std::thread sender([&] {
+        BenchSender out;
+        if (!out.open(ring)) {
+            return;
+        }
+        std::vector<PanoptesMessage> messages(THROUGHPUT_FRAME_MESSAGES, PanoptesMessage{0, 1, 1000, 100, 'A', 'B'});
+        uint64_t sequence = 1;
+        while (!stop.load(std::memory_order_relaxed)) {
+            out.send(frameHeader(sequence, messages.size()), messages.data(), messages.size(), stop);
+            sequence += messages.size();
+            frames_sent.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    uint64_t frames = 0;
+    int64_t volume = 0;
+    for (auto _ : state) {
+        const int received = receiver.receiveBatch();
+        if (received <= 0) {
+            state.SkipWithError("the sender stopped sending");
+            break;
+        }
+        for (int i = 0; i < received; ++i) {
+            const char* messages = receiver.data(i) + sizeof(FrameHeader);
+            for (size_t m = 0; m < THROUGHPUT_FRAME_MESSAGES; ++m) {
+                PanoptesMessage message;
+                std::memcpy(&message, messages + m * sizeof(message), sizeof(message));
+                volume += message.size;
+            }
+        }
+        frames += static_cast<uint64_t>(received);
+    }
+    benchmark::DoNotOptimize(volume);
+    stop.store(true, std::memory_order_relaxed);
+    sender.join();
+
+    state.SetItemsProcessed(static_cast<int64_t>(frames * THROUGHPUT_FRAME_MESSAGES));
+    const uint64_t sent = frames_sent.load(std::memory_order_relaxed);
+    state.counters["delivered"] = sent == 0 ? 0.0 : static_cast<double>(frames) / static_cast<double>(sent);
+}
+BENCHMARK(BM_TransportThroughput)->Arg(0)->Arg(1)->UseRealTime();
@@ -0,0 +1,385 @@
+#include <benchmark/benchmark.h>
+#include "../engine/include/BinaryParser.h"
+#include "../engine/include/L1CacheBook.h"
+#include "../engine/include/MappedFile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Workload suite: the book under the shapes of flow it sees in production,
+// swept over the parameters that move its cost (resting orders, active levels,
+// queue position, message mix), plus a replay of a recorded capture.
+//
+// Every benchmark reports items_per_second, where an item is one message
+// applied to the book. For cache misses per
+// message, build Google Benchmark with libpfm (PANOPTES_BENCH_PERF_COUNTERS in
+// tests/CMakeLists.txt) and run with --benchmark_perf_counters=CACHE-MISSES;
+// tools/bench_compare.py divides the per-iteration count by the items per
+// iteration. Compare runs against a baseline with that tool (see README.md).
+
+static constexpr Price MID_PRICE = 1500000;
+
+// xorshift64: a few instructions per number, so the generator does not drown
+// out the book work being measured.
+class FastRng {
+public:
+    explicit FastRng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    // Uniform enough in [0, n) for a benchmark.
+    uint64_t below(uint64_t n) { return next() % n; }
+
+private:
+    uint64_t state_;
+};
+
+// An add on a random side, at one of 'levels' prices behind the touch. Bids
+// rest below the mid and asks above it, so adds never cross.
+static PanoptesMessage randomAdd(FastRng& rng, OrderID id, int64_t levels) {
+    const bool bid = (rng.next() & 1) != 0;
+    const Price offset = static_cast<Price>(rng.below(static_cast<uint64_t>(levels)));
+    return {0, id, bid ? MID_PRICE - offset : MID_PRICE + 1 + offset, 100, 'A', bid ? 'B' : 'A'};
+}
+
+// A book holding 'live' orders spread over 'levels' prices per side, and the
+// IDs of those orders so the flow can cancel or execute them.
+struct LiveBook {
+    LiveBook(size_t live, int64_t levels, uint64_t seed, const OrderPoolConfig& pool = OrderPoolConfig{})
+        : book(pool), rng(seed), resting(live), levels(levels) {
+        for (size_t slot = 0; slot < live; ++slot) {
+            replace(slot);
+        }
+    }
+
+    // Rests a new order in 'slot' (whose previous order must be gone).
+    void replace(size_t slot) {
+        resting[slot] = ++next_id;
+        book.apply(randomAdd(rng, resting[slot], levels));
+    }
+
+    L1CacheBook book;
+    FastRng rng;
+    std::vector<OrderID> resting;
+    int64_t levels;
+    OrderID next_id = 0;
+};
+
+// --- Book depth and active levels ---
+
+// Steady add/cancel flow: each iteration cancels a random live order and adds
+// a new one at a random level. Arguments are {resting orders, active levels
+// per side}. More resting orders spread the order records and index entries
+// over more cache lines; more levels spread the ladder and its bitmap.
+static void BM_DepthAddCancel(benchmark::State& state) {
+    const size_t live = static_cast<size_t>(state.range(0));
+    LiveBook live_book(live, state.range(1), 42);
+
+    for (auto _ : state) {
+        const size_t victim = live_book.rng.below(live);
+        live_book.book.apply({0, live_book.resting[victim], 0, 0, 'X', 0});
+        live_book.replace(victim);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_DepthAddCancel)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 64, 4096}});
+
+// --- Queue position of cancels ---
+
+// One level holding 'depth' orders. Each iteration cancels the order at a
+// fixed queue position and adds a new one at the tail, so the position stays
+// the same. Arguments are {depth, position: 0 = head, 1 = middle, 2 = tail}.
+//
+// The first 'position' orders are never touched; behind them is a FIFO of the
+// most recent adds, whose oldest (the order at 'position') is the next to go,
+// so the loop needs no bookkeeping beyond a counter.
+static void BM_CancelPosition(benchmark::State& state) {
+    const int64_t depth = state.range(0);
+    const int64_t position = state.range(1) == 0 ? 0 : state.range(1) == 1 ? depth / 2 : depth - 1;
+    const uint64_t fifo = static_cast<uint64_t>(depth - position);
+    L1CacheBook book;
+    uint64_t added = 0;
+    for (int64_t i = 0; i < depth; ++i) {
+        book.apply({0, ++added, MID_PRICE, 100, 'A', 'B'});
+    }
+
+    for (auto _ : state) {
+        book.apply({0, added - fifo + 1, 0, 0, 'X', 0});
+        book.apply({0, ++added, MID_PRICE, 100, 'A', 'B'});
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_CancelPosition)->ArgsProduct({{64, 4096, 1 << 18}, {0, 1, 2}});
+
+// --- Execute-heavy flow ---
+
+// Three messages in four are partial executes of a random live order (a
+// quarter of its size at a time), so orders mostly leave the book by being
+// filled; the rest are cancel/add pairs. The argument is the active levels
+// per side, over 4096 live orders.
+static void BM_ExecuteHeavyFlow(benchmark::State& state) {
+    constexpr size_t live = 4096;
+    LiveBook live_book(live, state.range(0), 42);
+    std::vector<int32_t> remaining(live, 100);
+    int64_t messages = 0;
+
+    for (auto _ : state) {
+        const size_t victim = live_book.rng.below(live);
+        if ((live_book.rng.next() & 3) != 0) {
+            live_book.book.apply({0, live_book.resting[victim], 0, 25, 'E', 0});
+            live_book.book.trades().clear();
+            ++messages;
+            remaining[victim] -= 25;
+            if (remaining[victim] > 0) {
+                continue;
+            }
+        } else {
+            live_book.book.apply({0, live_book.resting[victim], 0, 0, 'X', 0});
+            ++messages;
+        }
+        live_book.replace(victim);
+        remaining[victim] = 100;
+        ++messages;
+    }
+    state.SetItemsProcessed(messages);
+}
+BENCHMARK(BM_ExecuteHeavyFlow)->Arg(1)->Arg(64)->Arg(1024);
+
+// --- BBO queries ---
+
+// Reads the BBO after every message of an add/cancel flow, as a strategy
+// watching the touch does. Cancels regularly empty the best level, so some
+// reads follow a search for the next one. The argument is the active levels
+// per side, over 4096 live orders; items are messages.
+static void BM_BboQuery(benchmark::State& state) {
+    constexpr size_t live = 4096;
+    LiveBook live_book(live, state.range(0), 42);
+
+    for (auto _ : state) {
+        const size_t victim = live_book.rng.below(live);
+        live_book.book.apply({0, live_book.resting[victim], 0, 0, 'X', 0});
+        benchmark::DoNotOptimize(live_book.book.getBestBid());
+        benchmark::DoNotOptimize(live_book.book.getBestAsk());
+        live_book.replace(victim);
+        benchmark::DoNotOptimize(live_book.book.getBestBid());
+        benchmark::DoNotOptimize(live_book.book.getBestAsk());
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_BboQuery)->Arg(1)->Arg(64)->Arg(4096);
+
+// --- Amendments ---
+
+// Each iteration amends a random one of 4096 live orders over 64 levels per
+// side, either with one modify ('M') or as the cancel and re-add that a feed
+// without modifies sends. Arguments are {amendment: 0 = size cut at the same
+// price, 1 = move to another level on the same side, path: 0 = cancel + add,
+// 1 = modify}. Items are amendments, so the two paths compare directly.
+//
+// Orders start large enough that the size cuts never run out. The cut is also
+// where the paths differ in effect, not just cost: the modify keeps the
+// order's queue position, the cancel and re-add loses it.
+static void BM_Amend(benchmark::State& state) {
+    constexpr size_t live = 4096;
+    constexpr int64_t levels = 64;
+    const bool reprice = state.range(0) == 1;
+    const bool modify = state.range(1) == 1;
+    FastRng rng(42);
+    L1CacheBook book;
+    std::vector<PanoptesMessage> orders(live);
+    for (size_t i = 0; i < live; ++i) {
+        orders[i] = randomAdd(rng, i + 1, levels);
+        orders[i].size = 1 << 30;
+        book.apply(orders[i]);
+    }
+
+    for (auto _ : state) {
+        PanoptesMessage& order = orders[rng.below(live)];
+        if (reprice) {
+            const Price offset = static_cast<Price>(rng.below(levels));
+            order.price = order.side == 'B' ? MID_PRICE - offset : MID_PRICE + 1 + offset;
+        } else {
+            --order.size;
+        }
+        if (modify) {
+            PanoptesMessage amend = order;
+            amend.event_type = 'M';
+            book.apply(amend);
+        } else {
+            book.apply({0, order.order_id, 0, 0, 'X', 0});
+            book.apply(order);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Amend)->ArgsProduct({{0, 1}, {0, 1}});
+
+// --- Page size ---
+
+// The book's order storage and index on 4KB pages, transparent huge pages or
+// reserved 2MB huge pages (which fall back to transparent ones, with a
+// warning, if none are reserved). The argument picks one: 0, 1 or 2.
+static LargePageConfig pagesFor(int64_t mode) {
+    LargePageConfig pages;
+    pages.mode = mode == 0 ? HugePageMode::Off : mode == 1 ? HugePageMode::Transparent : HugePageMode::Explicit;
+    return pages;
+}
+
+// Creating (and destroying) a book sized for a million orders: about 80MB of
+// order slots and index. Arguments are {page size, prefault}. Without
+// prefaulting nothing is touched, so this is the cost of mapping it; with it,
+// of faulting in every page, which the huge page sizes do in far fewer faults.
+static void BM_BookStartup(benchmark::State& state) {
+    OrderPoolConfig pool;
+    pool.pages = pagesFor(state.range(0));
+    pool.pages.prefault = state.range(1) != 0;
+    for (auto _ : state) {
+        L1CacheBook book(pool);
+        benchmark::DoNotOptimize(&book);
+    }
+}
+BENCHMARK(BM_BookStartup)->ArgsProduct({{0, 1, 2}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// BM_DepthAddCancel's largest book (a million resting orders over 4096 levels
+// per side, so cancels land all over the order slots and index) on each page
+// size. This is where the dTLB misses are: measure them with
+// --benchmark_perf_counters=DTLB-LOAD-MISSES.
+static void BM_PageSizeAddCancel(benchmark::State& state) {
+    constexpr size_t live = 1 << 20;
+    OrderPoolConfig pool;
+    pool.pages = pagesFor(state.range(0));
+    LiveBook live_book(live, 4096, 42, pool);
+
+    for (auto _ : state) {
+        const size_t victim = live_book.rng.below(live);
+        live_book.book.apply({0, live_book.resting[victim], 0, 0, 'X', 0});
+        live_book.replace(victim);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_PageSizeAddCancel)->Arg(0)->Arg(1)->Arg(2);
+
+// --- Capture replay ---
+
+// A capture in memory: either a recorded .bin file or, failing that, a
+// synthetic one, so the benchmark always has something to run.
+struct Capture {
+    std::vector<char> bytes;
+    std::string source;
+
+    size_t messages() const { return bytes.size() / sizeof(PanoptesMessage); }
+};
+
+// Generated flow over 8 instruments with 2048 order slots each: a message for
+// an empty slot adds an order, one for a live slot cancels it or (one time in
+// five) fully executes it. Adds are then about half the flow, near the
+// generator's default 50/40/10 mix.
+static Capture syntheticCapture() {
+    constexpr size_t num_messages = 1 << 18;
+    constexpr InstrumentID instruments = 8;
+    constexpr size_t slots_per_instrument = 2048;
+    FastRng rng(7);
+    // The add that filled each slot; order_id 0 marks an empty slot.
+    std::vector<PanoptesMessage> live(instruments * slots_per_instrument, PanoptesMessage{});
+    OrderID next_id = 0;
+
+    Capture capture;
+    capture.source = "synthetic";
+    capture.bytes.resize(num_messages * sizeof(PanoptesMessage));
+    for (size_t i = 0; i < num_messages; ++i) {
+        const InstrumentID instrument = static_cast<InstrumentID>(rng.below(instruments));
+        PanoptesMessage& slot = live[instrument * slots_per_instrument + rng.below(slots_per_instrument)];
+        PanoptesMessage msg;
+        if (slot.order_id == 0) {
+            slot = randomAdd(rng, ++next_id, 64);
+            slot.instrument_id = instrument;
+            msg = slot;
+        } else {
+            msg = slot;
+            msg.event_type = rng.below(5) == 0 ? 'E' : 'X';
+            slot.order_id = 0;
+        }
+        msg.timestamp = static_cast<Timestamp>(i);
+        // PanoptesMessage is laid out as the wire format on little-endian hosts.
+        std::memcpy(&capture.bytes[i * sizeof(msg)], &msg, sizeof(msg));
+    }
+    return capture;
+}
+
+// The capture named by PANOPTES_BENCH_CAPTURE (default data/messages.bin,
+// relative to the working directory), or a synthetic one if that cannot be read.
+static const Capture& benchCapture() {
+    static const Capture capture = [] {
+        const char* env = std::getenv("PANOPTES_BENCH_CAPTURE");
+        const std::string path = env != nullptr ? env : "data/messages.bin";
+        MappedFile file;
+        if (file.open(path.c_str()) && file.size() >= sizeof(PanoptesMessage)) {
+            const size_t usable = file.size() - file.size() % sizeof(PanoptesMessage);
+            Capture recorded;
+            recorded.bytes.assign(file.data(), file.data() + usable);
+            recorded.source = path;
+            return recorded;
+        }
+        return syntheticCapture();
+    }();
+    return capture;
+}
+
+// Messages parsed per parseBatch call, as in the replay mode (Replay.cpp).
+static constexpr size_t REPLAY_CHUNK = 64;
+
+// The whole capture through parseBatch and the books, one book per instrument,
+// from empty books each iteration. Book creation is not timed. Items are
+// messages; the label says which capture ran.
+static void BM_CaptureReplay(benchmark::State& state) {
+    const Capture& capture = benchCapture();
+    const size_t num_messages = capture.messages();
+    // Sized for the capture, so rebuilding the books each iteration is cheap.
+    OrderPoolConfig pool_config;
+    pool_config.capacity = std::max<size_t>(num_messages, 1024);
+    pool_config.grow_chunk_size = pool_config.capacity;
+
+    std::vector<std::unique_ptr<OrderBook>> books(MAX_INSTRUMENTS);
+    PanoptesMessage parsed[REPLAY_CHUNK];
+    ParseStats parse_stats;
+    uint64_t trades = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::fill(books.begin(), books.end(), nullptr);
+        for (size_t i = 0; i < num_messages; ++i) {
+            std::unique_ptr<OrderBook>& book =
+                books[parseMessage(capture.bytes.data() + i * sizeof(PanoptesMessage)).instrument_id];
+            if (!book) {
+                book = makeOrderBook(BookVariant{}, pool_config, DEFAULT_INDEX_LOAD_FACTOR, PriceLadderConfig{});
+            }
+        }
+        state.ResumeTiming();
+
+        for (size_t start = 0; start < num_messages; start += REPLAY_CHUNK) {
+            const size_t valid = parseBatch(capture.bytes.data() + start * sizeof(PanoptesMessage),
+                                            std::min(REPLAY_CHUNK, num_messages - start), parsed, parse_stats);
+            for (size_t i = 0; i < valid; ++i) {
+                OrderBook& book = *books[parsed[i].instrument_id];
+                book.apply(parsed[i]);
+                trades += book.trades().size();
+                book.trades().clear();
+            }
+        }
+    }
+    benchmark::DoNotOptimize(trades);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(num_messages));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(capture.bytes.size()));
+    state.counters["rejected"] = benchmark::Counter(static_cast<double>(parse_stats.rejected()), benchmark::Counter::kAvgIterations);
+    state.SetLabel(capture.source);
+}
+BENCHMARK(BM_CaptureReplay)->Unit(benchmark::kMillisecond);
+
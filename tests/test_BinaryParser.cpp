@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "../engine/include/BinaryParser.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const ParserIsa ALL_ISAS[] = {ParserIsa::Scalar, ParserIsa::Sse42, ParserIsa::Avx2};
+
+static std::vector<char> toWire(const std::vector<PanoptesMessage>& messages) {
+    std::vector<char> wire(messages.size() * sizeof(PanoptesMessage));
+    std::memcpy(wire.data(), messages.data(), wire.size());
+    return wire;
+}
+
+// The wire is little-endian whatever the host: check the bytes, not the struct.
+TEST(BinaryParserTest, DecodesLittleEndianFields) {
+    const unsigned char bytes[32] = {
+        0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, // timestamp
+        0x2A, 0, 0, 0, 0, 0, 0, 0,                      // order_id = 42
+        0x60, 0xE3, 0x16, 0, 0, 0, 0, 0,                // price = 1500000
+        0x64, 0, 0, 0,                                  // size = 100
+        'A', 'B',                                       // event_type, side
+        0x03, 0x01,                                     // instrument_id = 259
+    };
+    const PanoptesMessage msg = parseMessage(reinterpret_cast<const char*>(bytes));
+    EXPECT_EQ(msg.timestamp, 0x0102030405060708);
+    EXPECT_EQ(msg.order_id, 42u);
+    EXPECT_EQ(msg.price, 1500000);
+    EXPECT_EQ(msg.size, 100);
+    EXPECT_EQ(msg.event_type, 'A');
+    EXPECT_EQ(msg.side, 'B');
+    EXPECT_EQ(msg.instrument_id, 259);
+}
+
+// One message breaking each rule, among valid ones. Every implementation
+// must keep the valid ones in order and attribute each reject the same way.
+TEST(BinaryParserTest, RejectsEachRuleAndKeepsOrder) {
+    ParseLimits limits;
+    limits.max_size = 1000;
+    limits.max_price = 2000000;
+    const std::vector<PanoptesMessage> messages = {
+        {0, 1, 1500000, 100, 'A', 'B', 0},
+        {0, 2, 1500000, 100, 'Q', 'B', 0},  // Bad event type.
+        {0, 3, 1500000, 100, 'A', 'S', 0},  // Bad side.
+        {0, 4, 1500000, 0, 'A', 'B', 0},    // Zero size.
+        {0, 5, 1500000, -5, 'E', 'A', 0},   // Negative size.
+        {0, 6, 1500000, 1001, 'A', 'B', 0}, // Above max_size.
+        {0, 7, 0, 100, 'A', 'A', 0},        // Price below min.
+        {0, 8, 2000001, 100, 'A', 'B', 0},  // Price above max.
+        {0, 9, 0, 0, 'X', 'B', 0},          // Cancels don't need a size or price.
+        {0, 10, 0, 50, 'E', 'A', 0},        // Nor do executes need a price.
+        {0, 11, 1500000, 100, 'Z', 'Z', 0}, // Bad event and side: counted once, as event.
+        {0, 12, 2000000, 1000, 'A', 'A', 0},
+        {0, 13, 1500000, 50, 'M', 'B', 0},
+        {0, 14, 2000001, 50, 'M', 'B', 0},  // Modifies need a price in range too.
+        {0, 15, 1500000, 0, 'M', 'A', 0},   // And a size.
+    };
+    const std::vector<char> wire = toWire(messages);
+
+    for (ParserIsa isa : ALL_ISAS) {
+        SCOPED_TRACE(static_cast<int>(isa));
+        std::vector<PanoptesMessage> out(messages.size());
+        ParseStats stats;
+        const size_t valid = parseBatchWith(isa, wire.data(), messages.size(), out.data(), stats, limits);
+
+        ASSERT_EQ(valid, 5u);
+        EXPECT_EQ(out[0].order_id, 1u);
+        EXPECT_EQ(out[1].order_id, 9u);
+        EXPECT_EQ(out[2].order_id, 10u);
+        EXPECT_EQ(out[3].order_id, 12u);
+        EXPECT_EQ(out[4].order_id, 13u);
+        EXPECT_EQ(stats.accepted, 5u);
+        EXPECT_EQ(stats.bad_event_type, 2u);
+        EXPECT_EQ(stats.bad_side, 1u);
+        EXPECT_EQ(stats.bad_size, 4u);
+        EXPECT_EQ(stats.bad_price, 3u);
+        EXPECT_EQ(stats.rejected(), 10u);
+    }
+}
+
+// Random bytes, nudged so plenty of messages get past the early rules, must
+// give exactly the scalar result from every implementation, at every length
+// (so the SIMD blocks and the scalar tail are both covered).
+TEST(BinaryParserTest, SimdMatchesScalarOnRandomInput) {
+    std::mt19937_64 rng(7);
+    const char events[] = {'A', 'X', 'E', 'M', 'q'};
+    const char sides[] = {'B', 'A', 'B', 'x'};
+    std::vector<PanoptesMessage> messages(1000);
+    for (PanoptesMessage& msg : messages) {
+        uint64_t words[4] = {rng(), rng(), rng(), rng()};
+        std::memcpy(&msg, words, sizeof(msg));
+        msg.event_type = events[rng() % 5];
+        msg.side = sides[rng() % 4];
+        if (rng() % 2) {
+            msg.price = static_cast<Price>(rng() % 4000000);
+            msg.size = static_cast<int32_t>(rng() % 2000) - 100;
+        }
+    }
+    const std::vector<char> wire = toWire(messages);
+
+    for (size_t count : {0, 1, 3, 4, 7, 8, 9, 31, 1000}) {
+        std::vector<PanoptesMessage> expected(count);
+        ParseStats expected_stats;
+        expected.resize(parseBatchWith(ParserIsa::Scalar, wire.data(), count, expected.data(), expected_stats));
+
+        for (ParserIsa isa : {ParserIsa::Sse42, ParserIsa::Avx2}) {
+            SCOPED_TRACE(static_cast<int>(isa));
+            std::vector<PanoptesMessage> out(count);
+            ParseStats stats;
+            ASSERT_EQ(parseBatchWith(isa, wire.data(), count, out.data(), stats), expected.size());
+            EXPECT_EQ(std::memcmp(out.data(), expected.data(), expected.size() * sizeof(PanoptesMessage)), 0);
+            EXPECT_EQ(stats.accepted, expected_stats.accepted);
+            EXPECT_EQ(stats.bad_event_type, expected_stats.bad_event_type);
+            EXPECT_EQ(stats.bad_side, expected_stats.bad_side);
+            EXPECT_EQ(stats.bad_size, expected_stats.bad_size);
+            EXPECT_EQ(stats.bad_price, expected_stats.bad_price);
+        }
+    }
+}
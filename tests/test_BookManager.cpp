@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "../engine/include/BookManager.h"
+#include <chrono>
+#include <thread>
+
+// Messages for different instruments must end up in separate books, and every
+// message submitted before stop() must be applied.
+TEST(BookManagerTest, RoutesInstrumentsToSeparateBooks) {
+    BookManagerConfig config;
+    config.num_workers = 2;
+    config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+    BookManager manager(config);
+    manager.start();
+
+    for (InstrumentID instrument = 0; instrument < 3; ++instrument) {
+        const Price price = 1500000 + instrument * 100;
+        manager.submit({0, 1, price, 100, 'A', 'B', instrument});
+        manager.submit({0, 2, price + 10, 100, 'A', 'A', instrument});
+        manager.submit({0, 3, price + 10, 40, 'A', 'B', instrument}); // Crosses, one trade.
+    }
+    manager.stop();
+
+    EXPECT_EQ(manager.messagesProcessed(), 9u);
+    EXPECT_EQ(manager.tradesProduced(), 3u);
+    EXPECT_EQ(manager.workerFor(0), manager.workerFor(2));
+    EXPECT_NE(manager.workerFor(0), manager.workerFor(1));
+
+    for (InstrumentID instrument = 0; instrument < 3; ++instrument) {
+        const OrderBook* book = manager.book(instrument);
+        ASSERT_NE(book, nullptr);
+        EXPECT_EQ(book->getBestBid().price, 1500000 + instrument * 100);
+        EXPECT_EQ(book->getBestAsk().volume, 60);
+    }
+    EXPECT_EQ(manager.book(3), nullptr);
+}
+
+// A small ring forces the producer to wait for the consumer; nothing may be lost.
+TEST(BookManagerTest, FullRingBackpressuresWithoutLoss) {
+    BookManagerConfig config;
+    config.num_workers = 1;
+    config.queue_capacity = 8;
+    config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+    BookManager manager(config);
+    manager.start();
+
+    for (OrderID id = 1; id <= 20000; ++id) {
+        manager.submit({0, id, 1500000, 100, 'A', 'B', 0});
+        manager.submit({0, id, 0, 0, 'X', 'B', 0});
+    }
+    manager.stop();
+    EXPECT_EQ(manager.messagesProcessed(), 40000u);
+    EXPECT_EQ(manager.book(0)->getBestBid().price, -1);
+}
+
+// An idle backoff worker sleeps between polls; it must still pick up
+// everything, report how deep its ring got and time each handoff.
+TEST(BookManagerTest, BackoffWorkerDrainsAndReportsHandoff) {
+    TscClock::calibrate(5);
+    BookManagerConfig config;
+    config.num_workers = 1;
+    config.queue_capacity = 1024;
+    config.idle = WorkerIdlePolicy::Backoff;
+    config.backoff_spins = 16;
+    config.backoff_yields = 4;
+    config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+    BookManager manager(config);
+    manager.start();
+
+    // Let the worker go to sleep, then queue a burst behind it.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (OrderID id = 1; id <= 500; ++id) {
+        manager.submit({0, id, 1500000, 100, 'A', 'B', 0});
+    }
+    manager.stop();
+
+    EXPECT_EQ(manager.messagesProcessed(), 500u);
+    EXPECT_EQ(manager.book(0)->getBestBid().volume, 50000);
+    EXPECT_GT(manager.ringHighWaterMark(), 0u);
+    EXPECT_LE(manager.ringHighWaterMark(), 500u);
+    EXPECT_EQ(manager.ringCapacity(), 1024u);
+
+    LatencyReport report;
+    manager.collectLatency(report);
+    EXPECT_EQ(report.at(LatencyStage::Handoff, 'A').count(), 500u);
+    EXPECT_EQ(report.at(LatencyStage::BookUpdate, 'A').count(), 500u);
+}
+
+TEST(SpscRingTest, TracksHighWaterMark) {
+    SpscRing<int> ring(16);
+    int value;
+    EXPECT_FALSE(ring.tryPop(value));
+    EXPECT_EQ(ring.highWaterMark(), 0u);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(ring.tryPush(i));
+    }
+    while (ring.tryPop(value)) {
+    }
+    EXPECT_EQ(ring.highWaterMark(), 10u);
+    // A shallower backlog later does not lower it.
+    ASSERT_TRUE(ring.tryPush(1));
+    ASSERT_TRUE(ring.tryPop(value));
+    EXPECT_EQ(ring.highWaterMark(), 10u);
+}
+
+TEST(SpscRingTest, PreservesOrderAcrossThreads) {
+    SpscRing<uint64_t> ring(64);
+    constexpr uint64_t count = 200000;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < count; ++i) {
+            while (!ring.tryPush(i)) {
+            }
+        }
+    });
+    uint64_t expected = 0;
+    uint64_t value;
+    while (expected < count) {
+        if (ring.tryPop(value)) {
+            ASSERT_EQ(value, expected);
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_FALSE(ring.tryPop(value));
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include "../engine/include/BookManager.h"
+#include "../engine/include/BookView.h"
+#include "../engine/include/L1CacheBook.h"
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// A segment name no other test run on the host is using.
+std::string segmentName(const char* test) {
+    return "/panoptes_test_" + std::string(test) + "_" + std::to_string(getpid());
+}
+
+// Applies a message and lets the view see its level changes, as a book worker does.
+bool applyAndUpdate(L1CacheBook& book, SharedBookView& view, const PanoptesMessage& msg) {
+    book.apply(msg);
+    LevelUpdateBuffer& updates = book.levelUpdates();
+    const bool published = view.update(msg.instrument_id, book, updates.data(), updates.size(), 0);
+    updates.clear();
+    return published;
+}
+
+} // namespace
+
+// The view holds the best BOOK_VIEW_DEPTH levels of each side, best first, and
+// is only republished when a message changes one of them.
+TEST(BookViewTest, PublishesTopLevelsAndSkipsChangesBehindThem) {
+    const std::string name = segmentName("top_levels");
+    SharedBookView view;
+    ASSERT_TRUE(view.create(name, 16, 1.0));
+    BookViewReader reader;
+    ASSERT_TRUE(reader.open(name));
+    EXPECT_EQ(reader.numInstruments(), 16u);
+
+    BookView copy;
+    EXPECT_EQ(reader.read(3, copy), 0u); // Never published.
+
+    L1CacheBook book;
+    book.enableLevelUpdates();
+    // Twelve bid levels, 100 to 111, and one ask.
+    for (OrderID id = 1; id <= 12; ++id) {
+        EXPECT_TRUE(applyAndUpdate(book, view, {0, id, 100 + static_cast<Price>(id) - 1, 10, 'A', 'B', 3}));
+    }
+    EXPECT_TRUE(applyAndUpdate(book, view, {0, 100, 200, 7, 'A', 'A', 3}));
+
+    const uint64_t version = reader.read(3, copy);
+    EXPECT_EQ(version, 13u);
+    ASSERT_EQ(copy.bid_levels, BOOK_VIEW_DEPTH);
+    EXPECT_EQ(copy.bids[0].price, 111);
+    EXPECT_EQ(copy.bids[BOOK_VIEW_DEPTH - 1].price, 102);
+    ASSERT_EQ(copy.ask_levels, 1u);
+    EXPECT_EQ(copy.bestAsk().price, 200);
+    EXPECT_EQ(copy.bestAsk().volume, 7);
+
+    // Level 101 is behind the tenth: nothing to publish.
+    EXPECT_FALSE(applyAndUpdate(book, view, {0, 2, 0, 0, 'X', 'B', 3}));
+    EXPECT_EQ(reader.version(3), version);
+
+    // Emptying a shown level pulls the next one up.
+    EXPECT_TRUE(applyAndUpdate(book, view, {0, 12, 0, 0, 'X', 'B', 3}));
+    ASSERT_EQ(reader.read(3, copy), version + 1);
+    EXPECT_EQ(copy.bids[0].price, 110);
+    EXPECT_EQ(copy.bids[BOOK_VIEW_DEPTH - 1].price, 100);
+
+    // More volume at a shown level is patched in place.
+    EXPECT_TRUE(applyAndUpdate(book, view, {0, 13, 105, 5, 'A', 'B', 3}));
+    ASSERT_EQ(reader.read(3, copy), version + 2);
+    EXPECT_EQ(copy.bid_levels, BOOK_VIEW_DEPTH);
+    EXPECT_EQ(copy.bids[5].price, 105);
+    EXPECT_EQ(copy.bids[5].volume, 15);
+    EXPECT_EQ(copy.bids[4].volume, 10);
+    EXPECT_EQ(copy.bestAsk().price, 200);
+
+    // Other instruments are untouched.
+    EXPECT_EQ(reader.version(4), 0u);
+}
+
+// Patched or reread, the view must always match the book's own top levels,
+// under random adds (some crossing), cancels and executes.
+TEST(BookViewTest, ViewTracksBookUnderRandomFlow) {
+    const std::string name = segmentName("random");
+    SharedBookView view;
+    ASSERT_TRUE(view.create(name, 1, 1.0));
+    BookViewReader reader;
+    ASSERT_TRUE(reader.open(name));
+
+    L1CacheBook book;
+    book.enableLevelUpdates();
+    std::mt19937_64 rng(11);
+    std::vector<OrderID> live;
+    OrderID next_id = 0;
+    BookView copy;
+    BestPrice expected[BOOK_VIEW_DEPTH];
+    for (int n = 0; n < 20000; ++n) {
+        PanoptesMessage msg{};
+        const uint64_t roll = rng() % 10;
+        if (live.empty() || roll < 5) {
+            const bool bid = (rng() & 1) != 0;
+            // Mostly behind the mid, sometimes through it.
+            const Price offset = static_cast<Price>(rng() % 30) - 3;
+            msg = {0, ++next_id, bid ? 1000 - offset : 1001 + offset, static_cast<int32_t>(1 + rng() % 50), 'A',
+                   bid ? 'B' : 'A', 0};
+            live.push_back(next_id);
+        } else {
+            const size_t victim = rng() % live.size();
+            msg = {0, live[victim], 0, roll < 8 ? 0 : 10, roll < 8 ? 'X' : 'E', 0, 0};
+            if (roll < 8) {
+                live[victim] = live.back();
+                live.pop_back();
+            }
+        }
+        applyAndUpdate(book, view, msg);
+        book.trades().clear();
+
+        ASSERT_NE(reader.read(0, copy), 0u);
+        const size_t bids = book.depth('B', expected, BOOK_VIEW_DEPTH);
+        ASSERT_EQ(copy.bid_levels, bids) << "message " << n;
+        for (size_t i = 0; i < bids; ++i) {
+            ASSERT_EQ(copy.bids[i].price, expected[i].price) << "message " << n;
+            ASSERT_EQ(copy.bids[i].volume, expected[i].volume) << "message " << n;
+        }
+        const size_t asks = book.depth('A', expected, BOOK_VIEW_DEPTH);
+        ASSERT_EQ(copy.ask_levels, asks) << "message " << n;
+        for (size_t i = 0; i < asks; ++i) {
+            ASSERT_EQ(copy.asks[i].price, expected[i].price) << "message " << n;
+            ASSERT_EQ(copy.asks[i].volume, expected[i].volume) << "message " << n;
+        }
+    }
+}
+
+// A reader racing the writer must only ever see whole views.
+TEST(BookViewTest, ReadersNeverSeeTornViews) {
+    const std::string name = segmentName("torn");
+    SharedBookView view;
+    ASSERT_TRUE(view.create(name, 1, 1.0));
+    BookViewReader reader;
+    ASSERT_TRUE(reader.open(name));
+
+    // Every field of view n carries n, so a mix of two views shows.
+    constexpr uint64_t PUBLISHES = 200000;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        BookView next;
+        for (uint64_t n = 1; n <= PUBLISHES; ++n) {
+            next.publish_tsc = n;
+            next.bid_levels = BOOK_VIEW_DEPTH;
+            next.ask_levels = BOOK_VIEW_DEPTH;
+            for (size_t i = 0; i < BOOK_VIEW_DEPTH; ++i) {
+                next.bids[i] = {static_cast<Price>(n), static_cast<int32_t>(n)};
+                next.asks[i] = {static_cast<Price>(n), static_cast<int32_t>(n)};
+            }
+            view.publish(0, next);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t reads = 0;
+    uint64_t last_version = 0;
+    BookView copy;
+    while (!done.load(std::memory_order_acquire)) {
+        const uint64_t version = reader.read(0, copy);
+        if (version == 0) {
+            continue;
+        }
+        ++reads;
+        ASSERT_GE(version, last_version);
+        last_version = version;
+        ASSERT_EQ(copy.publish_tsc, version);
+        for (size_t i = 0; i < BOOK_VIEW_DEPTH; ++i) {
+            ASSERT_EQ(copy.bids[i].price, static_cast<Price>(version));
+            ASSERT_EQ(copy.asks[i].volume, static_cast<int32_t>(version));
+        }
+    }
+    writer.join();
+    EXPECT_EQ(reader.read(0, copy), PUBLISHES);
+    EXPECT_GT(reads, 0u);
+}
+
+// With a view configured, the book workers keep it up to date.
+TEST(BookViewTest, BookManagerPublishesViews) {
+    const std::string name = segmentName("manager");
+    SharedBookView view;
+    ASSERT_TRUE(view.create(name, MAX_INSTRUMENTS, 1.0));
+
+    BookManagerConfig config;
+    config.num_workers = 2;
+    config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+    config.book_view = &view;
+    BookManager manager(config);
+    manager.start();
+    manager.submit({0, 1, 1500000, 100, 'A', 'B', 5});
+    manager.submit({0, 2, 1500100, 30, 'A', 'A', 6});
+    manager.submit({0, 3, 1500100, 10, 'A', 'B', 6}); // Trades 10 of order 2.
+    manager.stop();
+    EXPECT_EQ(manager.viewPublishes(), 3u);
+
+    BookViewReader reader;
+    ASSERT_TRUE(reader.open(name));
+    BookView copy;
+    ASSERT_EQ(reader.read(5, copy), 1u);
+    EXPECT_EQ(copy.bestBid().price, 1500000);
+    EXPECT_EQ(copy.bestAsk().price, -1);
+    ASSERT_EQ(reader.read(6, copy), 2u);
+    EXPECT_EQ(copy.bestAsk().volume, 20);
+    EXPECT_EQ(copy.bid_levels, 0u);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "../engine/include/HugePages.h"
+#include "../engine/include/L1CacheBook.h"
+#include <cstdint>
+
+// Mappings come zeroed and rounded up to whole pages; small ones use normal
+// pages whatever the mode.
+TEST(LargeBufferTest, ZeroedAndRoundedToPages) {
+    LargePageConfig config;
+    config.mode = HugePageMode::Transparent;
+    config.prefault = true;
+
+    LargeBuffer small(100, config);
+    EXPECT_EQ(small.size(), 4096u);
+    LargeBuffer large((size_t(3) << 20) + 1, config);
+    EXPECT_EQ(large.size(), size_t(4) << 20);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large.data()) % (size_t(2) << 20), 0u);
+    const char* bytes = static_cast<const char*>(large.data());
+    for (size_t i = 0; i < large.size(); i += 4096) {
+        ASSERT_EQ(bytes[i], 0);
+    }
+
+    // Moving hands the mapping over.
+    LargeBuffer moved = std::move(large);
+    EXPECT_EQ(large.data(), nullptr);
+    EXPECT_EQ(moved.size(), size_t(4) << 20);
+}
+
+// Explicit huge pages fall back to ordinary memory when none are reserved,
+// so the engine still starts on a host without them.
+TEST(LargeBufferTest, ExplicitFallsBackWhenPoolIsEmpty) {
+    LargePageConfig config;
+    config.mode = HugePageMode::Explicit;
+    LargeBuffer buffer(size_t(4) << 20, config);
+    ASSERT_NE(buffer.data(), nullptr);
+    static_cast<char*>(buffer.data())[buffer.size() - 1] = 1;
+    EXPECT_GE(buffer.size(), size_t(4) << 20);
+}
+
+TEST(LargeArrayTest, GrowingKeepsRecords) {
+    LargeArray<uint64_t> array;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        array.emplace_back() = i;
+    }
+    ASSERT_EQ(array.size(), 100000u);
+    for (uint64_t i = 0; i < 100000; ++i) {
+        ASSERT_EQ(array[i], i);
+    }
+}
+
+// Every layout works the same on huge pages: the index starts out empty in
+// zeroed memory, or (for the compact layouts, whose NIL is not zero) filled.
+TEST(HugePagesTest, BooksRunOnHugePages) {
+    OrderPoolConfig pool{1 << 16, 1 << 16, PoolOverflowPolicy::Grow};
+    pool.pages.mode = HugePageMode::Transparent;
+    pool.pages.prefault = true;
+    for (OrderLayout layout : {OrderLayout::Pointer, OrderLayout::Compact, OrderLayout::HotCold}) {
+        auto book = makeOrderBook({layout, true}, pool, DEFAULT_INDEX_LOAD_FACTOR, PriceLadderConfig{});
+        for (OrderID id = 1; id <= 100000; ++id) {
+            book->apply({0, id, 1500000 + static_cast<Price>(id % 50), 10, 'A', 'B'});
+        }
+        for (OrderID id = 1; id <= 100000; id += 2) {
+            book->apply({0, id, 0, 0, 'X', 'B'});
+        }
+        EXPECT_EQ(book->restingOrderCount(), 50000u);
+        EXPECT_EQ(book->getBestBid().price, 1500048); // Only even IDs are left.
+    }
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "../engine/include/Journal.h"
+#include "../engine/include/Recovery.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Each test works in its own files under the gtest temp directory.
+class JournalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        journal_path_ = ::testing::TempDir() + "panoptes_" + name + ".journal";
+        snapshot_path_ = ::testing::TempDir() + "panoptes_" + name + ".snapshot";
+        std::remove(journal_path_.c_str());
+        std::remove(snapshot_path_.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(journal_path_.c_str());
+        std::remove(snapshot_path_.c_str());
+    }
+
+    JournalConfig journalConfig() const {
+        JournalConfig config;
+        config.path = journal_path_;
+        config.capacity_messages = 4096;
+        return config;
+    }
+
+    static BookManagerConfig managerConfig(SnapshotWriter* writer) {
+        BookManagerConfig config;
+        config.num_workers = 2;
+        config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+        config.snapshot_writer = writer;
+        return config;
+    }
+
+    std::string journal_path_;
+    std::string snapshot_path_;
+};
+
+// A reopened journal continues after its last record, and a full one counts
+// what it could not keep.
+TEST_F(JournalTest, ReopenContinuesAfterLastRecord) {
+    {
+        Journal journal(journalConfig());
+        ASSERT_TRUE(journal.open());
+        journal.start();
+        for (OrderID id = 1; id <= 100; ++id) {
+            EXPECT_TRUE(journal.append({0, id, 1500000, 100, 'A', 'B', 0}));
+        }
+        journal.stop();
+        EXPECT_EQ(journal.durableSequence(), 100u);
+    }
+
+    JournalConfig config = journalConfig();
+    config.capacity_messages = 16; // Smaller than the file: the file's capacity wins.
+    Journal journal(config);
+    ASSERT_TRUE(journal.open());
+    EXPECT_EQ(journal.lastSequence(), 100u);
+    EXPECT_EQ(journal.capacity(), 4096u);
+    for (size_t i = 100; i < journal.capacity(); ++i) {
+        journal.append({0, 0, 0, 0, 'X', 'B', 0});
+    }
+    EXPECT_FALSE(journal.append({0, 0, 0, 0, 'X', 'B', 0}));
+    EXPECT_EQ(journal.overflowCount(), 1u);
+}
+
+// Space a durable snapshot covers is reused: the journal wraps round over it,
+// and both a reopen and a recovery follow the records across the wrap.
+TEST_F(JournalTest, WrapsRoundOverSpaceASnapshotCovers) {
+    JournalConfig config = journalConfig();
+    config.capacity_messages = 16;
+    const auto add = [](OrderID id) { return PanoptesMessage{0, id, 1500000, 1, 'A', 'B', 0}; };
+    {
+        Journal journal(config);
+        ASSERT_TRUE(journal.open());
+        for (OrderID id = 1; id <= 16; ++id) {
+            ASSERT_TRUE(journal.append(add(id)));
+        }
+        // Nothing released yet: full.
+        EXPECT_FALSE(journal.append(add(17)));
+        EXPECT_EQ(journal.overflowCount(), 1u);
+
+        // A snapshot of the first ten goes to disk, and their space comes back.
+        SnapshotWriter writer(snapshot_path_, 1);
+        writer.start();
+        std::vector<SnapshotOrder> orders;
+        for (OrderID id = 1; id <= 10; ++id) {
+            orders.push_back({id, 1500000, 1, 'B', 0, 0});
+        }
+        writer.submit(10, std::move(orders));
+        writer.stop();
+        ASSERT_EQ(writer.lastSequence(), 10u);
+        journal.release(writer.lastSequence());
+        EXPECT_EQ(journal.inUse(), 6u);
+
+        for (OrderID id = 17; id <= 26; ++id) {
+            ASSERT_TRUE(journal.append(add(id)));
+        }
+        EXPECT_FALSE(journal.append(add(27)));
+        EXPECT_EQ(journal.overflowCount(), 2u);
+        journal.stop();
+        EXPECT_EQ(journal.durableSequence(), 26u);
+    }
+    {
+        Journal journal(config);
+        ASSERT_TRUE(journal.open(10));
+        EXPECT_EQ(journal.lastSequence(), 26u);
+        EXPECT_EQ(journal.releasedSequence(), 10u);
+    }
+
+    BookManager books(managerConfig(nullptr));
+    books.start();
+    RecoveryStats stats;
+    ASSERT_TRUE(recoverBooks(snapshot_path_, journal_path_, books, stats));
+    books.stop();
+    EXPECT_EQ(stats.snapshot_sequence, 10u);
+    EXPECT_EQ(stats.snapshot_orders, 10u);
+    EXPECT_EQ(stats.journal_messages, 16u);
+    EXPECT_EQ(stats.last_sequence, 26u);
+    ASSERT_NE(books.book(0), nullptr);
+    EXPECT_EQ(books.book(0)->getBestBid().volume, 26);
+}
+
+// A restart from snapshot plus journal tail gives back the same books, with
+// every level's queue in its original order.
+TEST_F(JournalTest, RecoveryRestoresBooksAndQueueOrder) {
+    // One message stream, split by a snapshot halfway through.
+    std::vector<PanoptesMessage> before = {
+        {0, 1, 1500000, 100, 'A', 'B', 0},
+        {0, 2, 1500000, 200, 'A', 'B', 0},
+        {0, 3, 1500100, 50, 'A', 'A', 0},
+        {0, 4, 1499900, 70, 'A', 'B', 1},
+        {0, 5, 1500000, 300, 'A', 'B', 0},
+        {0, 1, 0, 40, 'E', 'B', 0},
+    };
+    std::vector<PanoptesMessage> after = {
+        {0, 6, 1500000, 10, 'A', 'B', 0},
+        {0, 2, 0, 0, 'X', 'B', 0},
+        {0, 7, 1500200, 25, 'A', 'A', 1},
+    };
+
+    {
+        Journal journal(journalConfig());
+        ASSERT_TRUE(journal.open());
+        SnapshotWriter writer(snapshot_path_, 2);
+        BookManager books(managerConfig(&writer));
+        books.start();
+        writer.start();
+        for (const PanoptesMessage& msg : before) {
+            journal.append(msg);
+            books.submit(msg);
+        }
+        books.requestSnapshot(journal.lastSequence());
+        for (const PanoptesMessage& msg : after) {
+            journal.append(msg);
+            books.submit(msg);
+        }
+        books.stop();
+        writer.stop();
+        journal.stop();
+        EXPECT_EQ(writer.snapshotsWritten(), 1u);
+        EXPECT_EQ(writer.lastSequence(), before.size());
+    }
+
+    BookManager books(managerConfig(nullptr));
+    books.start();
+    RecoveryStats stats;
+    ASSERT_TRUE(recoverBooks(snapshot_path_, journal_path_, books, stats));
+    EXPECT_TRUE(stats.snapshot_loaded);
+    EXPECT_EQ(stats.snapshot_orders, 5u);
+    EXPECT_EQ(stats.journal_messages, after.size());
+    EXPECT_EQ(stats.last_sequence, before.size() + after.size());
+
+    // The bid level holds 1 (60 left), 5 (300) and 6 (10), in that order, so a
+    // sell of 100 fills all of order 1 and then 40 of order 5: two trades.
+    books.submit({0, 100, 1500000, 100, 'A', 'A', 0});
+    books.stop();
+
+    const OrderBook* book0 = books.book(0);
+    ASSERT_NE(book0, nullptr);
+    EXPECT_EQ(books.tradesProduced(), 2u);
+    EXPECT_EQ(book0->getBestBid().volume, 270);
+    EXPECT_EQ(book0->getBestAsk().price, 1500100);
+    EXPECT_EQ(book0->getBestAsk().volume, 50);
+
+    const OrderBook* book1 = books.book(1);
+    ASSERT_NE(book1, nullptr);
+    EXPECT_EQ(book1->getBestBid().price, 1499900);
+    EXPECT_EQ(book1->getBestAsk().volume, 25);
+}
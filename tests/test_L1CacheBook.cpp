@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "../engine/include/L1CacheBook.h" // Include the class we want to test.
+#include <memory>
+#include <random>
+#include <vector>
 
 // A test fixture class to set up a clean L1CacheBook for each test.
 class L1CacheBookTest : public ::testing::Test {
@@ -12,11 +15,9 @@ TEST_F(L1CacheBookTest, AddSingleOrder) {
     PanoptesMessage msg{'A', 1000, 1500000, 100, 'A', 'B'}; // A buy order.
     book.addOrder(msg);
 
-    // For this simple test, we don't have a public interface to check the state.
-    // A more complete test suite would have 'getter' methods to inspect the book.
-    // For now, we are just ensuring the code runs without crashing.
-    // A real test would check: ASSERT_EQ(book.getBestBid(), 1500000);
-    SUCCEED();
+    EXPECT_EQ(book.getBestBid().price, 1500000);
+    EXPECT_EQ(book.getBestBid().volume, 100);
+    EXPECT_EQ(book.getBestAsk().price, -1); // The ask side is still empty.
 }
 
 // Test case for adding and then cancelling an order.
@@ -28,9 +29,9 @@ TEST_F(L1CacheBookTest, AddAndCancelOrder) {
     PanoptesMessage cancel_msg{'X', 1001, 0, 0, 'X', 'B'};
     book.cancelOrder(cancel_msg);
 
-    // Again, without getters, we can only verify it doesn't crash.
-    // A real test would assert that the book is now empty.
-    SUCCEED();
+    // The book should now be empty again.
+    EXPECT_EQ(book.getBestBid().price, -1);
+    EXPECT_EQ(book.getBestBid().volume, 0);
 }
 
 // Test case for cancelling a non-existent order.
@@ -40,3 +41,370 @@ TEST_F(L1CacheBookTest, CancelNonExistentOrder) {
     book.cancelOrder(cancel_msg);
     SUCCEED();
 }
+
+// The best bid/ask should follow the most aggressive price on each side.
+TEST_F(L1CacheBookTest, BestPricesTrackAdds) {
+    book.addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    book.addOrder({0, 2, 1500100, 200, 'A', 'B'}); // Higher bid becomes the best.
+    book.addOrder({0, 3, 1499900, 300, 'A', 'B'}); // Lower bid does not.
+    book.addOrder({0, 4, 1500500, 50, 'A', 'A'});
+    book.addOrder({0, 5, 1500400, 60, 'A', 'A'});  // Lower ask becomes the best.
+    book.addOrder({0, 6, 1500400, 40, 'A', 'A'});  // Same level, volume accumulates.
+
+    EXPECT_EQ(book.getBestBid().price, 1500100);
+    EXPECT_EQ(book.getBestBid().volume, 200);
+    EXPECT_EQ(book.getBestAsk().price, 1500400);
+    EXPECT_EQ(book.getBestAsk().volume, 100);
+}
+
+// When the best level empties, the next best level should take its place,
+// even when it is far away on the ladder.
+TEST_F(L1CacheBookTest, BestPricesFallBackWhenLevelEmpties) {
+    book.addOrder({0, 1, 1000000, 100, 'A', 'B'});   // Bottom of the ladder.
+    book.addOrder({0, 2, 1700000, 200, 'A', 'B'});
+    book.addOrder({0, 3, 1700000, 300, 'A', 'B'});
+    book.addOrder({0, 4, 1999999, 10, 'A', 'A'});    // Top of the ladder.
+    book.addOrder({0, 5, 1800000, 20, 'A', 'A'});
+
+    book.cancelOrder({0, 2, 0, 0, 'X', 'B'});
+    EXPECT_EQ(book.getBestBid().price, 1700000); // Order 3 still rests at the best level.
+    EXPECT_EQ(book.getBestBid().volume, 300);
+
+    book.cancelOrder({0, 3, 0, 0, 'X', 'B'});
+    EXPECT_EQ(book.getBestBid().price, 1000000);
+    EXPECT_EQ(book.getBestBid().volume, 100);
+
+    book.executeOrder({0, 5, 0, 20, 'E', 'A'});
+    EXPECT_EQ(book.getBestAsk().price, 1999999);
+
+    book.cancelOrder({0, 1, 0, 0, 'X', 'B'});
+    book.cancelOrder({0, 4, 0, 0, 'X', 'A'});
+    EXPECT_EQ(book.getBestBid().price, -1);
+    EXPECT_EQ(book.getBestAsk().price, -1);
+}
+
+// An aggressive bid that exactly matches a resting ask fills it completely and never rests.
+TEST_F(L1CacheBookTest, CrossingAddFillsRestingOrder) {
+    book.addOrder({0, 1, 1500100, 100, 'A', 'A'});
+    book.addOrder({0, 2, 1500200, 100, 'A', 'B'}); // Crosses the ask at 150.0100.
+
+    ASSERT_EQ(book.trades().size(), 1u);
+    const Trade& trade = book.trades()[0];
+    EXPECT_EQ(trade.aggressor_id, 2u);
+    EXPECT_EQ(trade.resting_id, 1u);
+    EXPECT_EQ(trade.price, 1500100); // Trades at the resting order's price.
+    EXPECT_EQ(trade.size, 100);
+    EXPECT_EQ(trade.aggressor_side, 'B');
+
+    EXPECT_EQ(book.getBestAsk().price, -1);
+    EXPECT_EQ(book.getBestBid().price, -1);
+}
+
+// An aggressive sell sweeps several bid levels, oldest order first at each level,
+// and the unfilled remainder rests as the new best ask.
+TEST_F(L1CacheBookTest, CrossingAddSweepsLevelsInPriceTimePriority) {
+    book.addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    book.addOrder({0, 2, 1500000, 100, 'A', 'B'});
+    book.addOrder({0, 3, 1500100, 50, 'A', 'B'});  // Best bid.
+    book.addOrder({0, 4, 1499900, 100, 'A', 'B'}); // Below the sell's limit.
+
+    book.addOrder({0, 10, 1500000, 300, 'A', 'A'});
+
+    ASSERT_EQ(book.trades().size(), 3u);
+    EXPECT_EQ(book.trades()[0].resting_id, 3u);
+    EXPECT_EQ(book.trades()[0].price, 1500100);
+    EXPECT_EQ(book.trades()[1].resting_id, 1u);
+    EXPECT_EQ(book.trades()[2].resting_id, 2u);
+
+    EXPECT_EQ(book.getBestBid().price, 1499900);
+    EXPECT_EQ(book.getBestAsk().price, 1500000);
+    EXPECT_EQ(book.getBestAsk().volume, 50);
+
+    // The remainder is a normal resting order that can be cancelled.
+    book.cancelOrder({0, 10, 0, 0, 'X', 'A'});
+    EXPECT_EQ(book.getBestAsk().price, -1);
+}
+
+// A partial fill leaves the resting order at the front of its level with less size.
+TEST_F(L1CacheBookTest, CrossingAddPartiallyFillsRestingOrder) {
+    book.addOrder({0, 1, 1500100, 100, 'A', 'A'});
+    book.addOrder({0, 2, 1500100, 100, 'A', 'A'});
+    book.addOrder({0, 3, 1500100, 30, 'A', 'B'});
+    book.trades().clear();
+
+    EXPECT_EQ(book.getBestAsk().volume, 170);
+    book.addOrder({0, 4, 1500100, 80, 'A', 'B'});
+    ASSERT_EQ(book.trades().size(), 2u);
+    EXPECT_EQ(book.trades()[0].resting_id, 1u);
+    EXPECT_EQ(book.trades()[0].size, 70);
+    EXPECT_EQ(book.trades()[1].resting_id, 2u);
+    EXPECT_EQ(book.trades()[1].size, 10);
+    EXPECT_EQ(book.getBestAsk().volume, 90);
+}
+
+// An 'E' message reduces the resting order in place and removes it once it is fully filled.
+TEST_F(L1CacheBookTest, ExecuteReducesOrderInPlace) {
+    book.addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    book.addOrder({0, 2, 1500000, 100, 'A', 'B'});
+
+    book.executeOrder({0, 1, 0, 40, 'E', 'B'});
+    EXPECT_EQ(book.getBestBid().volume, 160);
+    ASSERT_EQ(book.trades().size(), 1u);
+    EXPECT_EQ(book.trades()[0].resting_id, 1u);
+    EXPECT_EQ(book.trades()[0].size, 40);
+    EXPECT_EQ(book.trades()[0].price, 1500000);
+
+    // Order 1 kept its place at the front: an aggressive sell fills it first.
+    book.trades().clear();
+    book.addOrder({0, 3, 1500000, 60, 'A', 'A'});
+    ASSERT_EQ(book.trades().size(), 1u);
+    EXPECT_EQ(book.trades()[0].resting_id, 1u);
+
+    book.executeOrder({0, 2, 0, 100, 'E', 'B'});
+    EXPECT_EQ(book.getBestBid().price, -1);
+}
+
+// Cutting an order's size at the same price keeps its place at the front of the queue.
+TEST_F(L1CacheBookTest, ModifySizeDownKeepsQueuePriority) {
+    book.addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    book.addOrder({0, 2, 1500000, 100, 'A', 'B'});
+    book.enableLevelUpdates();
+
+    book.modifyOrder({0, 1, 1500000, 40, 'M', 'B'});
+    EXPECT_EQ(book.getBestBid().volume, 140);
+    EXPECT_EQ(book.restingOrderCount(), 2u);
+    ASSERT_EQ(book.levelUpdates().size(), 1u);
+    EXPECT_EQ(book.levelUpdates()[0].total_volume, 140);
+
+    book.addOrder({0, 3, 1500000, 40, 'A', 'A'});
+    ASSERT_EQ(book.trades().size(), 1u);
+    EXPECT_EQ(book.trades()[0].resting_id, 1u);
+    EXPECT_EQ(book.trades()[0].size, 40);
+    EXPECT_EQ(book.getBestBid().volume, 100);
+}
+
+// More size, or a new price, sends the order to the back of its level.
+TEST_F(L1CacheBookTest, ModifyRepriceOrSizeUpLosesPriority) {
+    book.addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    book.addOrder({0, 2, 1500100, 100, 'A', 'B'});
+    book.addOrder({0, 3, 1500000, 100, 'A', 'B'});
+
+    // Order 1 joins order 2's level, behind it; its old level keeps order 3.
+    book.modifyOrder({0, 1, 1500100, 100, 'M', 'B'});
+    EXPECT_EQ(book.getBestBid().price, 1500100);
+    EXPECT_EQ(book.getBestBid().volume, 200);
+    EXPECT_EQ(book.restingOrderCount(), 3u);
+
+    // Order 2 grows, so it goes behind order 1.
+    book.modifyOrder({0, 2, 1500100, 150, 'M', 'B'});
+    EXPECT_EQ(book.getBestBid().volume, 250);
+    book.addOrder({0, 4, 1500100, 120, 'A', 'A'});
+    ASSERT_EQ(book.trades().size(), 2u);
+    EXPECT_EQ(book.trades()[0].resting_id, 1u);
+    EXPECT_EQ(book.trades()[0].size, 100);
+    EXPECT_EQ(book.trades()[1].resting_id, 2u);
+    EXPECT_EQ(book.trades()[1].size, 20);
+
+    // Moving the last order off a level empties it.
+    book.modifyOrder({0, 3, 1499900, 100, 'M', 'B'});
+    EXPECT_EQ(book.getBestBid().price, 1500100);
+    book.cancelOrder({0, 2, 0, 0, 'X', 'B'});
+    EXPECT_EQ(book.getBestBid().price, 1499900);
+    EXPECT_EQ(book.getBestBid().volume, 100);
+}
+
+// A modify to a price that crosses trades like an aggressive add; only the
+// remainder rests, and a fully filled order leaves the book.
+TEST_F(L1CacheBookTest, CrossingModifyMatches) {
+    book.addOrder({0, 1, 1500100, 50, 'A', 'A'});
+    book.addOrder({0, 2, 1500000, 80, 'A', 'B'});
+    book.addOrder({0, 3, 1499900, 30, 'A', 'B'});
+
+    book.modifyOrder({0, 2, 1500100, 80, 'M', 'B'});
+    ASSERT_EQ(book.trades().size(), 1u);
+    EXPECT_EQ(book.trades()[0].aggressor_id, 2u);
+    EXPECT_EQ(book.trades()[0].resting_id, 1u);
+    EXPECT_EQ(book.trades()[0].size, 50);
+    EXPECT_EQ(book.getBestAsk().price, -1);
+    EXPECT_EQ(book.getBestBid().price, 1500100);
+    EXPECT_EQ(book.getBestBid().volume, 30);
+
+    book.trades().clear();
+    book.addOrder({0, 4, 1500200, 40, 'A', 'A'});
+    book.modifyOrder({0, 3, 1500200, 40, 'M', 'B'});
+    ASSERT_EQ(book.trades().size(), 1u);
+    EXPECT_EQ(book.getBestAsk().price, -1);
+    EXPECT_EQ(book.restingOrderCount(), 1u);
+
+    // Unknown (or already filled) orders are ignored.
+    book.modifyOrder({0, 3, 1500000, 10, 'M', 'B'});
+    book.modifyOrder({0, 99, 1500000, 10, 'M', 'B'});
+    EXPECT_EQ(book.restingOrderCount(), 1u);
+    EXPECT_EQ(book.getBestBid().volume, 30);
+}
+
+// Prices anywhere in the Price range are accepted; there is no fixed ladder to fall off.
+TEST_F(L1CacheBookTest, PricesFarApartAreAccepted) {
+    book.addOrder({1, 1, 5, 100, 'A', 'B'});
+    book.addOrder({2, 2, 1000000000000, 200, 'A', 'A'});
+    book.addOrder({3, 3, 3, 300, 'A', 'B'});
+
+    EXPECT_EQ(book.getBestBid().price, 5);
+    EXPECT_EQ(book.getBestAsk().price, 1000000000000);
+
+    // Cancelling the best bid falls back to a level outside the current window.
+    book.cancelOrder({4, 1, 0, 0, 'X', 'B'});
+    EXPECT_EQ(book.getBestBid().price, 3);
+    EXPECT_EQ(book.getBestBid().volume, 300);
+}
+
+// As the touch walks away, the window follows it and the levels left behind
+// remain reachable through the overflow.
+TEST_F(L1CacheBookTest, BestPriceSurvivesRecentering) {
+    const Price start = 1500000;
+    for (int i = 0; i < 10000; ++i) {
+        book.addOrder({i, static_cast<OrderID>(i + 1), start + i, 10, 'A', 'B'});
+    }
+    EXPECT_GT(book.bidLadder().recenterCount(), 1u);
+    EXPECT_EQ(book.getBestBid().price, start + 9999);
+
+    // Cancel from the top down; each cancel must expose the level below.
+    for (int i = 9999; i >= 1; --i) {
+        book.cancelOrder({i, static_cast<OrderID>(i + 1), 0, 0, 'X', 'B'});
+        ASSERT_EQ(book.getBestBid().price, start + i - 1);
+    }
+    // A sell sweeping the last level trades at its price.
+    book.addOrder({0, 50000, start, 10, 'A', 'A'});
+    ASSERT_EQ(book.trades().size(), 1u);
+    EXPECT_EQ(book.trades()[0].price, start);
+    EXPECT_EQ(book.getBestBid().price, -1);
+}
+
+// Books for instruments with a coarser tick drop adds that are off the grid.
+TEST(L1CacheBookTickTest, OffTickAddsAreRejected) {
+    PriceLadderConfig ladder;
+    ladder.tick_size = 100;
+    ladder.base_price = 50;
+    auto book = std::make_unique<L1CacheBook>(OrderPoolConfig{}, DEFAULT_INDEX_LOAD_FACTOR, ladder);
+
+    book->addOrder({1, 1, 1500050, 100, 'A', 'B'});
+    book->addOrder({2, 2, 1500075, 100, 'A', 'B'}); // Not on the grid.
+    book->addOrder({3, 3, 1500150, 100, 'A', 'A'});
+
+    EXPECT_EQ(book->getBestBid().price, 1500050);
+    EXPECT_EQ(book->getBestAsk().price, 1500150);
+    EXPECT_EQ(book->offTickOrderCount(), 1u);
+}
+
+// With level updates on, every change to a level's volume is reported, and a
+// level that empties is reported with volume 0.
+TEST_F(L1CacheBookTest, LevelUpdatesTrackVolumeChanges) {
+    book.addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    EXPECT_TRUE(book.levelUpdates().empty()); // Off by default.
+
+    book.enableLevelUpdates();
+    book.addOrder({0, 2, 1500000, 50, 'A', 'B'});
+    book.addOrder({0, 3, 1500100, 70, 'A', 'A'});
+    book.executeOrder({0, 1, 0, 30, 'E', 'B'});
+    book.addOrder({0, 4, 1500000, 120, 'A', 'A'}); // Fills order 1 (70) and 2 (50).
+
+    const LevelUpdateBuffer& updates = book.levelUpdates();
+    ASSERT_EQ(updates.size(), 5u);
+    EXPECT_EQ(updates[0].side, 'B');
+    EXPECT_EQ(updates[0].total_volume, 150);
+    EXPECT_EQ(updates[1].side, 'A');
+    EXPECT_EQ(updates[1].price, 1500100);
+    EXPECT_EQ(updates[1].total_volume, 70);
+    EXPECT_EQ(updates[2].total_volume, 120);
+    EXPECT_EQ(updates[3].total_volume, 50);  // Order 1 filled and removed.
+    EXPECT_EQ(updates[4].price, 1500000);
+    EXPECT_EQ(updates[4].total_volume, 0);   // Order 2 filled; the level is gone.
+}
+
+// Every order storage layout and every compile-time specialisation must
+// produce the same book and the same fills. Drives them all with one random
+// flow of adds (some crossing), cancels, executes and modifies, and compares them with
+// the run-time configured pointer book after every message.
+TEST(L1CacheBookLayoutTest, VariantsAgree) {
+    const OrderPoolConfig pool{64, 64, PoolOverflowPolicy::Grow};
+    auto reference = std::make_unique<L1CacheBook>(pool);
+    std::vector<std::unique_ptr<OrderBook>> books;
+    books.push_back(std::make_unique<CompactL1CacheBook>(pool));
+    books.push_back(std::make_unique<HotColdL1CacheBook>(pool));
+    // The factory picks the unit-tick builds for the default ladder config.
+    for (OrderLayout layout : {OrderLayout::Pointer, OrderLayout::Compact, OrderLayout::HotCold}) {
+        books.push_back(makeOrderBook({layout, true}, pool, DEFAULT_INDEX_LOAD_FACTOR, PriceLadderConfig{}));
+    }
+    books.push_back(std::make_unique<FixedL1CacheBook>());
+
+    std::mt19937_64 rng(7);
+    std::vector<OrderID> ids;
+    std::vector<Price> prices; // Each ID's last price, for modifies that keep it.
+    OrderID next_id = 1;
+    for (int i = 0; i < 20000; ++i) {
+        PanoptesMessage msg{i, 0, 0, 0, 'A', 'B'};
+        const unsigned pick = rng() % 10;
+        if (pick < 5 || ids.empty()) {
+            msg.order_id = next_id++;
+            msg.side = (rng() & 1) ? 'B' : 'A';
+            msg.price = 1500000 + static_cast<Price>(rng() % 40) - 20;
+            msg.size = static_cast<int32_t>(rng() % 300) + 1;
+            ids.push_back(msg.order_id);
+            prices.push_back(msg.price);
+        } else {
+            // IDs that have already left the book are fine: all variants ignore them.
+            msg.event_type = pick < 8 ? 'X' : (pick == 8 ? 'E' : 'M');
+            const size_t pick_id = rng() % ids.size();
+            msg.order_id = ids[pick_id];
+            msg.size = static_cast<int32_t>(rng() % 150) + 1;
+            // Modifies keep the price half the time, so size cuts happen in place.
+            if (msg.event_type == 'M') {
+                if (rng() & 1) {
+                    prices[pick_id] = 1500000 + static_cast<Price>(rng() % 40) - 20;
+                }
+                msg.price = prices[pick_id];
+            }
+        }
+
+        reference->trades().clear();
+        reference->apply(msg);
+        for (auto& book : books) {
+            book->trades().clear();
+            book->apply(msg);
+
+            ASSERT_EQ(book->trades().size(), reference->trades().size());
+            for (size_t t = 0; t < reference->trades().size(); ++t) {
+                const Trade& expected = reference->trades()[t];
+                const Trade& actual = book->trades()[t];
+                ASSERT_EQ(actual.resting_id, expected.resting_id);
+                ASSERT_EQ(actual.price, expected.price);
+                ASSERT_EQ(actual.size, expected.size);
+                ASSERT_EQ(actual.aggressor_side, expected.aggressor_side);
+            }
+            ASSERT_EQ(book->getBestBid().price, reference->getBestBid().price);
+            ASSERT_EQ(book->getBestBid().volume, reference->getBestBid().volume);
+            ASSERT_EQ(book->getBestAsk().price, reference->getBestAsk().price);
+            ASSERT_EQ(book->getBestAsk().volume, reference->getBestAsk().volume);
+            ASSERT_EQ(book->restingOrderCount(), reference->restingOrderCount());
+        }
+    }
+    EXPECT_GT(reference->restingOrderCount(), 0u);
+}
+
+// With matching off, a crossing add rests like any other: the feed's own
+// executes report the fills.
+TEST(L1CacheBookLayoutTest, MatchingCanBeTurnedOff) {
+    auto book = makeOrderBook({OrderLayout::Pointer, false}, OrderPoolConfig{}, DEFAULT_INDEX_LOAD_FACTOR,
+                              PriceLadderConfig{});
+    book->apply({0, 1, 1500100, 100, 'A', 'A'});
+    book->apply({0, 2, 1500200, 40, 'A', 'B'}); // Would take order 1.
+
+    EXPECT_TRUE(book->trades().empty());
+    EXPECT_EQ(book->restingOrderCount(), 2u);
+    EXPECT_EQ(book->getBestBid().price, 1500200);
+    EXPECT_EQ(book->getBestAsk().price, 1500100);
+
+    book->apply({0, 1, 0, 40, 'E', 'A'});
+    ASSERT_EQ(book->trades().size(), 1u);
+    EXPECT_EQ(book->getBestAsk().volume, 60);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "../engine/include/LatencyHistogram.h"
+#include "../engine/include/LatencyReport.h"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+// Every bucket's upper bound must map back to that bucket, and the next value to the next bucket.
+TEST(LatencyHistogramTest, BucketsAreContiguous) {
+    for (size_t bucket = 0; bucket + 1 < LatencyHistogram::NUM_BUCKETS; ++bucket) {
+        const uint64_t upper = LatencyHistogram::bucketUpperBound(bucket);
+        ASSERT_EQ(LatencyHistogram::bucketFor(upper), bucket);
+        ASSERT_EQ(LatencyHistogram::bucketFor(upper + 1), bucket + 1);
+    }
+}
+
+// Percentiles are reported within the histogram's 1/64 (~1.6%) relative precision.
+TEST(LatencyHistogramTest, PercentilesWithinPrecision) {
+    auto histogram = std::make_unique<LatencyHistogram>();
+    for (int64_t value = 1; value <= 100000; ++value) {
+        histogram->record(value);
+    }
+    EXPECT_EQ(histogram->count(), 100000u);
+    EXPECT_EQ(histogram->max(), 100000u);
+    EXPECT_NEAR(histogram->mean(), 50000.5, 0.01);
+    EXPECT_NEAR(static_cast<double>(histogram->percentile(50.0)), 50000.0, 50000.0 * 0.016);
+    EXPECT_NEAR(static_cast<double>(histogram->percentile(99.0)), 99000.0, 99000.0 * 0.016);
+    EXPECT_EQ(histogram->percentile(100.0), 100000u);
+}
+
+// Out-of-range values are clamped rather than lost.
+TEST(LatencyHistogramTest, ClampsNegativeAndHugeValues) {
+    auto histogram = std::make_unique<LatencyHistogram>();
+    histogram->record(-5);
+    histogram->record(int64_t{1} << 50);
+    EXPECT_EQ(histogram->count(), 2u);
+    EXPECT_EQ(histogram->percentile(50.0), 0u);
+    EXPECT_EQ(histogram->max(), uint64_t{1} << 50);
+}
+
+TEST(LatencyHistogramTest, MergeAddsCounts) {
+    auto a = std::make_unique<LatencyHistogram>();
+    auto b = std::make_unique<LatencyHistogram>();
+    a->record(100);
+    b->record(200);
+    b->record(300);
+    a->merge(*b);
+    EXPECT_EQ(a->count(), 3u);
+    EXPECT_EQ(a->max(), 300u);
+}
+
+// The report breaks latencies down by stage and event type in both output formats.
+TEST(LatencyHistogramTest, ReportListsStagesAndEventTypes) {
+    LatencyReport report;
+    report.at(LatencyStage::Parse, 'A').record(40);
+    report.at(LatencyStage::BookUpdate, 'X').record(90);
+    report.at(LatencyStage::BookUpdate, '?').record(10);
+
+    std::ostringstream text;
+    report.printText(text);
+    EXPECT_NE(text.str().find("parse"), std::string::npos);
+    EXPECT_NE(text.str().find("book_update"), std::string::npos);
+    EXPECT_NE(text.str().find("other"), std::string::npos);
+
+    const std::string path = ::testing::TempDir() + "latency_report_test.json";
+    ASSERT_TRUE(report.writeJson(path));
+    std::ifstream in(path);
+    std::stringstream json;
+    json << in.rdbuf();
+    EXPECT_NE(json.str().find("\"parse\": {\n      \"A\": {\"count\": 1"), std::string::npos);
+    EXPECT_NE(json.str().find("\"wire_to_recv\": {}"), std::string::npos);
+    std::remove(path.c_str());
+}
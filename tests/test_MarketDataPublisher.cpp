@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include "../engine/include/BookManager.h"
+#include "../engine/include/MarketDataPublisher.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// A loopback UDP socket on a free port that collects what the publisher sends.
+class MarketDataPublisherTest : public ::testing::Test {
+protected:
+    struct Datagram {
+        MdHeader header;
+        std::vector<LevelUpdate> entries;
+    };
+
+    void SetUp() override {
+        sock_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(sock_fd_, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ASSERT_EQ(bind(sock_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        socklen_t len = sizeof(addr);
+        ASSERT_EQ(getsockname(sock_fd_, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+        config_.port = ntohs(addr.sin_port);
+        config_.snapshot_interval_ms = 0;
+
+        timeval timeout{0, 200000};
+        setsockopt(sock_fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    void TearDown() override {
+        close(sock_fd_);
+    }
+
+    // Everything sent so far, in order.
+    std::vector<Datagram> receiveAll() {
+        std::vector<Datagram> datagrams;
+        char buffer[65536];
+        ssize_t n;
+        while ((n = recv(sock_fd_, buffer, sizeof(buffer), 0)) > 0) {
+            Datagram d;
+            std::memcpy(&d.header, buffer, sizeof(MdHeader));
+            EXPECT_EQ(static_cast<size_t>(n), sizeof(MdHeader) + d.header.count * sizeof(LevelUpdate));
+            d.entries.resize(d.header.count);
+            std::memcpy(d.entries.data(), buffer + sizeof(MdHeader), d.header.count * sizeof(LevelUpdate));
+            datagrams.push_back(d);
+        }
+        return datagrams;
+    }
+
+    int sock_fd_ = -1;
+    MarketDataPublisherConfig config_;
+};
+
+// A burst of updates is packed into as few datagrams as fit, in order.
+TEST_F(MarketDataPublisherTest, BatchesUpdatesIntoDatagrams) {
+    MarketDataPublisher publisher(config_);
+    ASSERT_TRUE(publisher.open());
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(publisher.publish(0, {1500000 + i, 100, 'B', 0, 3}));
+    }
+    publisher.start();
+    publisher.stop();
+
+    const std::vector<Datagram> datagrams = receiveAll();
+    const size_t per_datagram = (config_.max_datagram_bytes - sizeof(MdHeader)) / sizeof(LevelUpdate);
+    ASSERT_EQ(datagrams.size(), (200 + per_datagram - 1) / per_datagram);
+
+    int next = 0;
+    for (size_t i = 0; i < datagrams.size(); ++i) {
+        EXPECT_EQ(datagrams[i].header.magic, MD_MAGIC);
+        EXPECT_EQ(datagrams[i].header.type, static_cast<uint8_t>(MdMessageType::Incremental));
+        EXPECT_EQ(datagrams[i].header.sequence, i + 1);
+        for (const LevelUpdate& entry : datagrams[i].entries) {
+            EXPECT_EQ(entry.price, 1500000 + next++);
+            EXPECT_EQ(entry.instrument_id, 3);
+        }
+    }
+    EXPECT_EQ(next, 200);
+    EXPECT_EQ(publisher.stats().updates_published, 200u);
+}
+
+// Within the conflation window only the latest volume of each level is sent.
+TEST_F(MarketDataPublisherTest, ConflationKeepsLatestVolumePerLevel) {
+    config_.conflation_window_us = 10000000; // Longer than the test: stop() flushes.
+    MarketDataPublisher publisher(config_);
+    ASSERT_TRUE(publisher.open());
+    publisher.publish(0, {1500000, 100, 'B', 0, 1});
+    publisher.publish(0, {1500100, 50, 'A', 0, 1});
+    publisher.publish(0, {1500000, 80, 'B', 0, 1});
+    publisher.publish(0, {1500000, 0, 'B', 0, 1});
+    publisher.publish(0, {1500000, 60, 'B', 0, 2}); // Same price, other instrument.
+    publisher.start();
+    publisher.stop();
+
+    const std::vector<Datagram> datagrams = receiveAll();
+    ASSERT_EQ(datagrams.size(), 1u);
+    ASSERT_EQ(datagrams[0].entries.size(), 3u);
+    EXPECT_EQ(datagrams[0].entries[0].total_volume, 0);
+    EXPECT_EQ(datagrams[0].entries[1].total_volume, 50);
+    EXPECT_EQ(datagrams[0].entries[2].total_volume, 60);
+    EXPECT_EQ(publisher.stats().updates_received, 5u);
+}
+
+// Snapshots carry each instrument's full depth, best prices first.
+TEST_F(MarketDataPublisherTest, SnapshotCarriesFullDepth) {
+    config_.snapshot_interval_ms = 1;
+    MarketDataPublisher publisher(config_);
+    ASSERT_TRUE(publisher.open());
+    publisher.publish(0, {1500000, 10, 'B', 0, 7});
+    publisher.publish(0, {1500100, 20, 'B', 0, 7});
+    publisher.publish(0, {1500200, 5, 'A', 0, 7});
+    publisher.publish(0, {1500100, 0, 'B', 0, 7}); // Level removed again.
+    publisher.publish(0, {1499900, 30, 'B', 0, 7});
+    publisher.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    publisher.stop();
+
+    const std::vector<Datagram> datagrams = receiveAll();
+    const Datagram* snapshot = nullptr;
+    for (const Datagram& d : datagrams) {
+        if (d.header.type == static_cast<uint8_t>(MdMessageType::Snapshot)) {
+            snapshot = &d;
+            break;
+        }
+    }
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->header.instrument_id, 7);
+    EXPECT_EQ(snapshot->header.flags, MD_FLAG_SNAPSHOT_BEGIN | MD_FLAG_SNAPSHOT_END);
+    ASSERT_EQ(snapshot->entries.size(), 3u);
+    EXPECT_EQ(snapshot->entries[0].price, 1500000);
+    EXPECT_EQ(snapshot->entries[0].total_volume, 10);
+    EXPECT_EQ(snapshot->entries[1].price, 1499900);
+    EXPECT_EQ(snapshot->entries[2].side, 'A');
+    EXPECT_EQ(snapshot->entries[2].total_volume, 5);
+    EXPECT_GT(publisher.stats().snapshots, 0u);
+}
+
+// A full ring drops updates instead of blocking the book thread.
+TEST_F(MarketDataPublisherTest, FullRingDropsAndCounts) {
+    config_.queue_capacity = 4;
+    MarketDataPublisher publisher(config_);
+    for (int i = 0; i < 10; ++i) {
+        publisher.publish(0, {1500000, 1, 'B', 0, 0});
+    }
+    EXPECT_EQ(publisher.droppedCount(), 6u);
+}
+
+// Updates dropped to a full ring do not leave snapshots wrong: the book's
+// worker resends the whole book once there is room, and every snapshot from
+// then on matches the book.
+TEST_F(MarketDataPublisherTest, SnapshotAfterFullRingMatchesBook) {
+    config_.queue_capacity = 64;
+    config_.snapshot_interval_ms = 5;
+    MarketDataPublisher publisher(config_);
+    ASSERT_TRUE(publisher.open());
+    BookManagerConfig manager_config;
+    manager_config.num_workers = 1;
+    manager_config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+    manager_config.publisher = &publisher;
+    BookManager books(manager_config);
+    books.start();
+
+    // 80 bid levels, then 50 of them cancelled again, with the publisher not
+    // yet draining: most of these updates are dropped.
+    uint64_t submitted = 0;
+    for (OrderID id = 1; id <= 80; ++id) {
+        books.submit({0, id, static_cast<Price>(1500000 + id), static_cast<int32_t>(id), 'A', 'B', 0});
+        ++submitted;
+    }
+    for (OrderID id = 1; id <= 50; ++id) {
+        books.submit({0, id, 0, 0, 'X', 'B', 0});
+        ++submitted;
+    }
+    while (books.messagesProcessed() < submitted) {
+        std::this_thread::yield();
+    }
+    EXPECT_GT(publisher.droppedCount(), 0u);
+
+    // Once the publisher drains the ring, the idle worker resends the book.
+    publisher.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    books.stop();
+    publisher.stop();
+    EXPECT_EQ(publisher.stats().resyncs, 1u);
+
+    const OrderBook* book = books.book(0);
+    ASSERT_NE(book, nullptr);
+    std::vector<BestPrice> bids(128);
+    bids.resize(book->depth('B', bids.data(), bids.size()));
+    ASSERT_EQ(bids.size(), 30u);
+
+    // The last snapshot of instrument 0 holds exactly the book's levels.
+    const std::vector<Datagram> datagrams = receiveAll();
+    const Datagram* snapshot = nullptr;
+    for (const Datagram& d : datagrams) {
+        if (d.header.type == static_cast<uint8_t>(MdMessageType::Snapshot) && d.header.instrument_id == 0) {
+            snapshot = &d;
+        }
+    }
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->header.flags, MD_FLAG_SNAPSHOT_BEGIN | MD_FLAG_SNAPSHOT_END);
+    ASSERT_EQ(snapshot->entries.size(), bids.size());
+    for (size_t i = 0; i < bids.size(); ++i) {
+        EXPECT_EQ(snapshot->entries[i].side, 'B');
+        EXPECT_EQ(snapshot->entries[i].price, bids[i].price);
+        EXPECT_EQ(snapshot->entries[i].total_volume, bids[i].volume);
+    }
+}
+
+// A book deeper than the whole ring can never be resent, so it is given up on
+// rather than read again and again; the other stale books still are resent.
+TEST_F(MarketDataPublisherTest, BookDeeperThanRingDoesNotBlockResyncs) {
+    config_.queue_capacity = 16;
+    MarketDataPublisher publisher(config_);
+    ASSERT_TRUE(publisher.open());
+    BookManagerConfig manager_config;
+    manager_config.num_workers = 1;
+    manager_config.pool_config = {1024, 1024, PoolOverflowPolicy::Grow};
+    manager_config.publisher = &publisher;
+    BookManager books(manager_config);
+    books.start();
+
+    // 40 bid levels on instrument 0, then 5 on instrument 1, all but the
+    // first 16 updates dropped.
+    uint64_t submitted = 0;
+    for (OrderID id = 1; id <= 40; ++id) {
+        books.submit({0, id, static_cast<Price>(1500000 + id), 10, 'A', 'B', 0});
+        ++submitted;
+    }
+    for (OrderID id = 41; id <= 45; ++id) {
+        books.submit({0, id, static_cast<Price>(1500000 + id), 10, 'A', 'B', 1});
+        ++submitted;
+    }
+    while (books.messagesProcessed() < submitted) {
+        std::this_thread::yield();
+    }
+    EXPECT_GT(publisher.droppedCount(), 0u);
+
+    publisher.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    books.stop();
+    publisher.stop();
+    EXPECT_EQ(publisher.stats().resyncs, 1u);
+}
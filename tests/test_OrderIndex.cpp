@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "../engine/include/OrderIndex.h"
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+TEST(OrderIndexTest, InsertFindErase) {
+    OrderIndex index(16);
+    Order a, b;
+    index.insert(1, &a);
+    index.insert(2, &b);
+    EXPECT_EQ(index.find(1), &a);
+    EXPECT_EQ(index.find(2), &b);
+    EXPECT_EQ(index.find(3), nullptr);
+    EXPECT_EQ(index.size(), 2u);
+
+    EXPECT_EQ(index.erase(1), &a);
+    EXPECT_EQ(index.find(1), nullptr);
+    EXPECT_EQ(index.erase(1), nullptr); // Already gone.
+    EXPECT_EQ(index.size(), 1u);
+}
+
+// Inserting an existing ID replaces its entry instead of adding a second one.
+TEST(OrderIndexTest, InsertReplacesExistingEntry) {
+    OrderIndex index(16);
+    Order a, b;
+    index.insert(7, &a);
+    index.insert(7, &b);
+    EXPECT_EQ(index.find(7), &b);
+    EXPECT_EQ(index.size(), 1u);
+}
+
+// The table should double rather than fill up when the size estimate is exceeded.
+TEST(OrderIndexTest, GrowsPastExpectedSize) {
+    OrderIndex index(16, 0.5);
+    const size_t initial_slots = index.slotCount();
+    std::vector<Order> orders(1000);
+    for (size_t i = 0; i < orders.size(); ++i) {
+        index.insert(i, &orders[i]);
+    }
+    EXPECT_GT(index.slotCount(), initial_slots);
+    for (size_t i = 0; i < orders.size(); ++i) {
+        ASSERT_EQ(index.find(i), &orders[i]);
+    }
+}
+
+// A long random insert/erase session checked against std::unordered_map.
+// This exercises backward-shift deletion across wrapped and colliding probe runs.
+TEST(OrderIndexTest, MatchesReferenceMapUnderChurn) {
+    OrderIndex index(256, 0.9); // A high load factor gives long probe runs.
+    std::unordered_map<OrderID, Order*> reference;
+    std::vector<Order> orders(512);
+    std::mt19937_64 rng(12345);
+
+    for (int step = 0; step < 200000; ++step) {
+        const OrderID id = rng() % 512;
+        if (rng() % 2 == 0 && reference.size() < 230) {
+            index.insert(id, &orders[id]);
+            reference[id] = &orders[id];
+        } else {
+            auto it = reference.find(id);
+            Order* expected = (it == reference.end()) ? nullptr : it->second;
+            ASSERT_EQ(index.erase(id), expected);
+            if (it != reference.end()) {
+                reference.erase(it);
+            }
+        }
+    }
+    ASSERT_EQ(index.size(), reference.size());
+    for (OrderID id = 0; id < 512; ++id) {
+        auto it = reference.find(id);
+        ASSERT_EQ(index.find(id), it == reference.end() ? nullptr : it->second);
+    }
+}
+
+// The add/cancel pattern of a real feed: a sliding window of sequential IDs,
+// plus IDs with a large power-of-two stride, which must not pile up on one slot.
+TEST(OrderIndexTest, SequentialAndStridedIds) {
+    OrderIndex index(1024);
+    std::vector<Order> orders(1024);
+    for (OrderID id = 0; id < 100000; ++id) {
+        index.insert(id, &orders[id % 1024]);
+        if (id >= 1000) {
+            ASSERT_EQ(index.erase(id - 1000), &orders[(id - 1000) % 1024]);
+        }
+    }
+    EXPECT_EQ(index.size(), 1000u);
+
+    OrderIndex strided(1024);
+    for (OrderID i = 0; i < 1000; ++i) {
+        strided.insert(i << 20, &orders[i]);
+    }
+    for (OrderID i = 0; i < 1000; ++i) {
+        ASSERT_EQ(strided.find(i << 20), &orders[i]);
+    }
+}
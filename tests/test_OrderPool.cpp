@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "../engine/include/OrderPool.h"
+#include "../engine/include/L1CacheBook.h"
+#include <memory>
+
+// A released slot should be the next one handed out (LIFO reuse keeps it hot).
+TEST(OrderPoolTest, ReleasedSlotIsReused) {
+    OrderPool pool({4, 4, PoolOverflowPolicy::Reject});
+    Order* first = pool.acquire();
+    Order* second = pool.acquire();
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(pool.inUse(), 2u);
+
+    pool.release(first);
+    EXPECT_EQ(pool.inUse(), 1u);
+    EXPECT_EQ(pool.acquire(), first);
+}
+
+// With the Reject policy the pool never grows and counts refused allocations.
+TEST(OrderPoolTest, RejectPolicyCountsOverflow) {
+    OrderPool pool({2, 2, PoolOverflowPolicy::Reject});
+    EXPECT_NE(pool.acquire(), nullptr);
+    EXPECT_NE(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.rejectedCount(), 2u);
+    EXPECT_EQ(pool.capacity(), 2u);
+}
+
+// With the Grow policy the pool adds chunks, and earlier slots keep their addresses.
+TEST(OrderPoolTest, GrowPolicyAddsChunks) {
+    OrderPool pool({2, 3, PoolOverflowPolicy::Grow});
+    Order* first = pool.acquire();
+    first->id = 42;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_NE(pool.acquire(), nullptr);
+    }
+    EXPECT_EQ(pool.capacity(), 5u);
+    EXPECT_EQ(pool.inUse(), 5u);
+    EXPECT_EQ(pool.rejectedCount(), 0u);
+    EXPECT_EQ(first->id, 42u);
+}
+
+// A long add/cancel session must run in a pool much smaller than the number of adds.
+TEST(OrderPoolTest, BookRecyclesSlotsOnCancel) {
+    // The book preallocates its order storage and index, so it lives on the heap.
+    auto book = std::make_unique<L1CacheBook>(OrderPoolConfig{16, 16, PoolOverflowPolicy::Reject});
+    for (uint64_t id = 1; id <= 100000; ++id) {
+        book->addOrder({0, id, 1500000, 100, 'A', 'B'});
+        book->cancelOrder({0, id, 0, 0, 'X', 'B'});
+    }
+    EXPECT_EQ(book->rejectedOrderCount(), 0u);
+    EXPECT_EQ(book->getBestBid().price, -1);
+}
+
+// Adds beyond a full Reject pool are dropped without corrupting the book.
+TEST(OrderPoolTest, BookDropsAddsWhenPoolIsFull) {
+    auto book = std::make_unique<L1CacheBook>(OrderPoolConfig{2, 2, PoolOverflowPolicy::Reject});
+    book->addOrder({0, 1, 1500000, 100, 'A', 'B'});
+    book->addOrder({0, 2, 1500000, 100, 'A', 'B'});
+    book->addOrder({0, 3, 1500100, 100, 'A', 'B'});
+    EXPECT_EQ(book->rejectedOrderCount(), 1u);
+    EXPECT_EQ(book->getBestBid().price, 1500000);
+    EXPECT_EQ(book->getBestBid().volume, 200);
+}
+
+// The compact layouts reuse slots LIFO, like OrderPool, and keep every field.
+TEST(CompactOrderStorageTest, ReleasedSlotIsReusedAndFieldsRoundTrip) {
+    HotColdOrderStorage storage({4, 4, PoolOverflowPolicy::Reject});
+    const CompactHandle first = storage.acquire(7, 1500000, 100, 'B');
+    const CompactHandle second = storage.acquire(8, 1500100, 200, 'A');
+    ASSERT_NE(first, COMPACT_NIL);
+    ASSERT_NE(second, COMPACT_NIL);
+    EXPECT_EQ(storage.id(second), 8u);
+    EXPECT_EQ(storage.price(second), 1500100);
+    EXPECT_EQ(storage.size(second), 200);
+    EXPECT_EQ(storage.side(second), 'A');
+
+    storage.release(first);
+    EXPECT_EQ(storage.inUse(), 1u);
+    EXPECT_EQ(storage.acquire(9, 1, 1, 'B'), first);
+}
+
+// Growing moves the arrays, but handles are slot numbers and stay valid.
+TEST(CompactOrderStorageTest, GrowKeepsHandlesValid) {
+    CompactOrderStorage storage({2, 3, PoolOverflowPolicy::Grow});
+    const CompactHandle first = storage.acquire(42, 1500000, 100, 'B');
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_NE(storage.acquire(100 + i, 1500000, 1, 'A'), COMPACT_NIL);
+    }
+    EXPECT_EQ(storage.capacity(), 11u);
+    EXPECT_EQ(storage.rejectedCount(), 0u);
+    EXPECT_EQ(storage.id(first), 42u);
+    EXPECT_EQ(storage.size(first), 100);
+}
+
+TEST(CompactOrderStorageTest, RejectPolicyCountsOverflow) {
+    HotColdOrderStorage storage({1, 1, PoolOverflowPolicy::Reject});
+    EXPECT_NE(storage.acquire(1, 1, 1, 'B'), COMPACT_NIL);
+    EXPECT_EQ(storage.acquire(2, 1, 1, 'B'), COMPACT_NIL);
+    EXPECT_EQ(storage.rejectedCount(), 1u);
+}
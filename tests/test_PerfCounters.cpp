@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "../engine/include/PerfCounters.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+static PerfValues values(uint64_t cycles, uint64_t instructions, uint64_t llc_misses) {
+    PerfValues v{};
+    v[static_cast<size_t>(PerfCounter::Cycles)] = cycles;
+    v[static_cast<size_t>(PerfCounter::Instructions)] = instructions;
+    v[static_cast<size_t>(PerfCounter::LlcMisses)] = llc_misses;
+    return v;
+}
+
+TEST(PerfReportTest, AggregatesByStageAndEventType) {
+    PerfReport report;
+    report.record(PerfStage::BookUpdate, 'A', values(100, 200, 1), 1);
+    report.record(PerfStage::BookUpdate, 'A', values(300, 400, 3), 1);
+    report.record(PerfStage::BookUpdate, 'X', values(50, 60, 0), 1);
+    report.record(PerfStage::Parse, 0, values(640, 1280, 2), 64);
+
+    const size_t add = LatencyReport::eventTypeIndex('A');
+    const size_t cancel = LatencyReport::eventTypeIndex('X');
+    const size_t other = LatencyReport::eventTypeIndex(0);
+    EXPECT_EQ(report.samples(PerfStage::BookUpdate, add), 2u);
+    EXPECT_EQ(report.total(PerfStage::BookUpdate, add, PerfCounter::Cycles), 400u);
+    EXPECT_EQ(report.total(PerfStage::BookUpdate, add, PerfCounter::LlcMisses), 4u);
+    EXPECT_EQ(report.samples(PerfStage::BookUpdate, cancel), 1u);
+    EXPECT_EQ(report.messages(PerfStage::Parse, other), 64u);
+    EXPECT_EQ(report.total(PerfStage::Parse, other, PerfCounter::Instructions), 1280u);
+
+    // Merging adds the other report's totals row by row.
+    PerfReport worker;
+    worker.record(PerfStage::BookUpdate, 'A', values(100, 100, 0), 1);
+    report.merge(worker);
+    EXPECT_EQ(report.samples(PerfStage::BookUpdate, add), 3u);
+    EXPECT_EQ(report.total(PerfStage::BookUpdate, add, PerfCounter::Cycles), 500u);
+}
+
+TEST(PerfReportTest, WritesTotalsAsJson) {
+    PerfReport report;
+    report.record(PerfStage::BookUpdate, 'E', values(120, 240, 5), 1);
+    const std::string path = "test_perf_report.json";
+    ASSERT_TRUE(report.writeJson(path));
+
+    std::ifstream in(path);
+    std::stringstream json;
+    json << in.rdbuf();
+    std::remove(path.c_str());
+    EXPECT_NE(json.str().find("\"book_update\": {\n      \"E\": {\"samples\": 1, \"messages\": 1, \"cycles\": 120, "
+                              "\"instructions\": 240, \"l1d_misses\": 0, \"llc_misses\": 5"),
+              std::string::npos)
+        << json.str();
+}
+
+// A sample taken while the group was off the PMU adds no counts and shows as
+// unavailable, rather than as a row of zeros; scaled samples are counted.
+TEST(PerfReportTest, ReportsUnscheduledSamplesAsUnavailable) {
+    PerfReport report;
+    report.recordUnavailable(PerfStage::BookUpdate, 'X');
+    report.recordUnavailable(PerfStage::BookUpdate, 'X');
+    report.record(PerfStage::BookUpdate, 'A', values(100, 200, 1), 1, true);
+
+    const size_t add = LatencyReport::eventTypeIndex('A');
+    const size_t cancel = LatencyReport::eventTypeIndex('X');
+    EXPECT_EQ(report.samples(PerfStage::BookUpdate, cancel), 0u);
+    EXPECT_EQ(report.unavailableSamples(PerfStage::BookUpdate, cancel), 2u);
+    EXPECT_EQ(report.total(PerfStage::BookUpdate, cancel, PerfCounter::Cycles), 0u);
+    EXPECT_EQ(report.scaledSamples(PerfStage::BookUpdate, add), 1u);
+
+    PerfReport worker;
+    worker.recordUnavailable(PerfStage::BookUpdate, 'X');
+    report.merge(worker);
+    EXPECT_EQ(report.unavailableSamples(PerfStage::BookUpdate, cancel), 3u);
+
+    const std::string path = "test_perf_unavailable.json";
+    ASSERT_TRUE(report.writeJson(path));
+    std::ifstream in(path);
+    std::stringstream json;
+    json << in.rdbuf();
+    std::remove(path.c_str());
+    EXPECT_NE(json.str().find("\"X\": {\"samples\": 0, \"messages\": 0, \"cycles\": 0"), std::string::npos)
+        << json.str();
+    EXPECT_NE(json.str().find("\"scaled\": 0, \"unavailable\": 3}"), std::string::npos) << json.str();
+    EXPECT_NE(json.str().find("\"scaled\": 1, \"unavailable\": 0}"), std::string::npos) << json.str();
+
+#if PANOPTES_PERF_COUNTERS
+    std::ostringstream text;
+    report.printText(text);
+    EXPECT_NE(text.str().find("unavailable: the counters were never scheduled in 3 samples"), std::string::npos)
+        << text.str();
+    EXPECT_NE(text.str().find("(1 scaled, 0 unavailable)"), std::string::npos) << text.str();
+#endif
+}
+
+#if PANOPTES_PERF_COUNTERS
+
+TEST(PerfProbeTest, SamplesOneCallInN) {
+    PerfReport report;
+    PerfConfig config;
+    config.sample_every = 8;
+    PerfProbe probe(config, report);
+    if (!probe.open()) {
+        GTEST_SKIP() << "no hardware counters on this machine";
+    }
+
+    size_t sampled = 0;
+    volatile uint64_t sink = 0;
+    for (size_t i = 0; i < 800; ++i) {
+        if (probe.sample()) {
+            ++sampled;
+            probe.begin();
+            for (int j = 0; j < 1000; ++j) {
+                sink = sink + j;
+            }
+            probe.end(PerfStage::BookUpdate, 'A');
+        }
+    }
+    EXPECT_EQ(sampled, 100u);
+    const size_t add = LatencyReport::eventTypeIndex('A');
+    const uint64_t counted = report.samples(PerfStage::BookUpdate, add);
+    EXPECT_EQ(counted + report.unavailableSamples(PerfStage::BookUpdate, add), 100u);
+    if (counted == 0) {
+        GTEST_SKIP() << "the counter group was never scheduled on this machine";
+    }
+    // A thousand-iteration loop retires thousands of instructions per sample.
+    EXPECT_GT(report.total(PerfStage::BookUpdate, add, PerfCounter::Instructions), counted * 1000u);
+}
+
+#else
+
+TEST(PerfProbeTest, CompiledOutProbeIsEmptyAndNeverSamples) {
+    static_assert(std::is_empty<PerfProbe>::value, "a compiled-out probe holds no state");
+    static_assert(!PerfProbe::sample(), "a compiled-out probe's sample() is a constant");
+    PerfReport report;
+    PerfProbe probe(PerfConfig{}, report);
+    EXPECT_FALSE(probe.open());
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "../engine/include/PriceLadder.h"
+#include <vector>
+
+namespace {
+
+// Puts a dummy head on a level so it looks occupied, the way the book would.
+Order g_order{};
+
+void occupy(PriceLadder& ladder, PriceLadder::Tick tick, int32_t volume) {
+    PriceLevel& level = ladder.level(tick);
+    level.head = &g_order;
+    level.tail = &g_order;
+    level.total_volume = volume;
+    ladder.setOccupied(tick);
+}
+
+} // namespace
+
+TEST(PriceLadderTest, EmptyLadderHasNoBest) {
+    PriceLadder ladder(256);
+    EXPECT_TRUE(ladder.empty());
+    EXPECT_EQ(ladder.highest(), PriceLadder::NO_TICK);
+    EXPECT_EQ(ladder.lowest(), PriceLadder::NO_TICK);
+}
+
+TEST(PriceLadderTest, WindowAndOverflowLevelsAreOrderedTogether) {
+    PriceLadder ladder(256);
+    ladder.recenter(1000);
+    occupy(ladder, 1000, 1);  // In the window.
+    occupy(ladder, 5000, 2);  // Above it.
+    occupy(ladder, -5000, 3); // Below it.
+
+    EXPECT_EQ(ladder.overflowLevels(), 2u);
+    EXPECT_EQ(ladder.highest(), 5000);
+    EXPECT_EQ(ladder.lowest(), -5000);
+
+    ladder.setEmpty(5000);
+    EXPECT_EQ(ladder.highest(), 1000);
+    ladder.setEmpty(1000);
+    EXPECT_EQ(ladder.highest(), -5000);
+    EXPECT_EQ(ladder.lowest(), -5000);
+}
+
+TEST(PriceLadderTest, RecenterMovesLevelsBetweenWindowAndOverflow) {
+    PriceLadder ladder(256);
+    ladder.recenter(0);
+    occupy(ladder, 10, 100);
+    occupy(ladder, 10000, 200);
+    EXPECT_EQ(ladder.overflowLevels(), 1u);
+
+    ladder.recenter(10000);
+    EXPECT_EQ(ladder.windowBegin(), 10000 - 128);
+    // Tick 10 was spilled and tick 10000 pulled into the window, contents intact.
+    EXPECT_EQ(ladder.overflowLevels(), 1u);
+    ASSERT_NE(ladder.find(10), nullptr);
+    EXPECT_EQ(ladder.find(10)->total_volume, 100);
+    ASSERT_NE(ladder.find(10000), nullptr);
+    EXPECT_EQ(ladder.find(10000)->total_volume, 200);
+    EXPECT_EQ(ladder.find(11), nullptr);
+    EXPECT_EQ(ladder.lowest(), 10);
+    EXPECT_EQ(ladder.highest(), 10000);
+}
+
+TEST(PriceLadderTest, NearEdgeCoversOuterEighths) {
+    PriceLadder ladder(256);
+    ladder.recenter(0); // Window is [-128, 128).
+    EXPECT_FALSE(ladder.nearEdge(0));
+    EXPECT_FALSE(ladder.nearEdge(-96));
+    EXPECT_FALSE(ladder.nearEdge(95));
+    EXPECT_TRUE(ladder.nearEdge(-97));
+    EXPECT_TRUE(ladder.nearEdge(96));
+    EXPECT_TRUE(ladder.nearEdge(100000));
+}
+
+// Walking away from the best level visits every occupied tick in order,
+// crossing bitmap words and the window's edges into the overflow.
+TEST(PriceLadderTest, NextBelowAndAboveWalkWindowAndOverflow) {
+    PriceLadder ladder(256);
+    ladder.recenter(0); // Window is [-128, 128).
+    const PriceLadder::Tick ticks[] = {-5000, -128, -64, -63, 0, 1, 127, 5000};
+    for (PriceLadder::Tick tick : ticks) {
+        occupy(ladder, tick, 1);
+    }
+
+    std::vector<PriceLadder::Tick> down;
+    for (PriceLadder::Tick tick = ladder.highest(); tick != PriceLadder::NO_TICK; tick = ladder.nextBelow(tick)) {
+        down.push_back(tick);
+    }
+    EXPECT_EQ(down, (std::vector<PriceLadder::Tick>{5000, 127, 1, 0, -63, -64, -128, -5000}));
+
+    std::vector<PriceLadder::Tick> up;
+    for (PriceLadder::Tick tick = ladder.lowest(); tick != PriceLadder::NO_TICK; tick = ladder.nextAbove(tick)) {
+        up.push_back(tick);
+    }
+    EXPECT_EQ(up, (std::vector<PriceLadder::Tick>{-5000, -128, -64, -63, 0, 1, 127, 5000}));
+
+    // walkDown() and walkUp() see the same levels, with and without the
+    // overflow, and stop when told to.
+    std::vector<PriceLadder::Tick> walked;
+    ladder.walkDown(5000, [&](PriceLadder::Tick tick, const PriceLevel&) {
+        walked.push_back(tick);
+        return true;
+    });
+    EXPECT_EQ(walked, down);
+    walked.clear();
+    ladder.walkUp(-5000, [&](PriceLadder::Tick tick, const PriceLevel&) {
+        walked.push_back(tick);
+        return walked.size() < 3;
+    });
+    EXPECT_EQ(walked, (std::vector<PriceLadder::Tick>{-5000, -128, -64}));
+
+    // Starting points with nothing occupied at them work too.
+    EXPECT_EQ(ladder.nextBelow(-62), -63);
+    EXPECT_EQ(ladder.nextAbove(2), 127);
+    EXPECT_EQ(ladder.nextBelow(-5000), PriceLadder::NO_TICK);
+    EXPECT_EQ(ladder.nextAbove(5000), PriceLadder::NO_TICK);
+
+    ladder.setEmpty(5000);
+    ladder.setEmpty(-5000);
+    walked.clear();
+    ladder.walkDown(126, [&](PriceLadder::Tick tick, const PriceLevel&) {
+        walked.push_back(tick);
+        return true;
+    });
+    EXPECT_EQ(walked, (std::vector<PriceLadder::Tick>{1, 0, -63, -64, -128}));
+    walked.clear();
+    ladder.walkUp(-63, [&](PriceLadder::Tick tick, const PriceLevel&) {
+        walked.push_back(tick);
+        return true;
+    });
+    EXPECT_EQ(walked, (std::vector<PriceLadder::Tick>{-63, 0, 1, 127}));
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "../engine/include/SequenceTracker.h"
+#include <vector>
+
+// Records what the tracker delivers (by order ID) and what it asks for.
+class RecordingSink : public SequencedSink {
+public:
+    void deliver(const char* messages, size_t count) override {
+        const PanoptesMessage* msgs = reinterpret_cast<const PanoptesMessage*>(messages);
+        for (size_t i = 0; i < count; ++i) {
+            ids.push_back(msgs[i].order_id);
+        }
+    }
+    void requestRetransmit(const RetransmitRequest& request) override {
+        requests.push_back(request);
+    }
+
+    std::vector<OrderID> ids;
+    std::vector<RetransmitRequest> requests;
+};
+
+// A frame of 'count' messages starting at 'first'; each message's order ID is
+// its sequence number, so deliveries are easy to check.
+struct Frame {
+    Frame(uint64_t first, size_t count, uint32_t session = 7, uint8_t flags = 0) {
+        header = {FRAME_MAGIC, FRAME_VERSION, flags, static_cast<uint16_t>(count), session, 0, 0, first};
+        for (size_t i = 0; i < count; ++i) {
+            messages.push_back({0, first + i, 1500000, 100, 'A', 'B', 0});
+        }
+    }
+    const char* data() const { return reinterpret_cast<const char*>(messages.data()); }
+
+    FrameHeader header;
+    std::vector<PanoptesMessage> messages;
+};
+
+static std::vector<OrderID> range(OrderID first, OrderID last) {
+    std::vector<OrderID> ids;
+    for (OrderID id = first; id <= last; ++id) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+TEST(SequenceTrackerTest, DropsDuplicatesAndTrimsOverlaps) {
+    SequenceTracker tracker;
+    RecordingSink sink;
+    Frame a(1, 4), repeat(1, 4), overlap(3, 4);
+    tracker.onFrame(a.header, a.data(), 0, sink);
+    tracker.onFrame(repeat.header, repeat.data(), 0, sink);
+    tracker.onFrame(overlap.header, overlap.data(), 0, sink);
+
+    EXPECT_EQ(sink.ids, range(1, 6));
+    EXPECT_EQ(tracker.stats().duplicates, 6u);
+    EXPECT_EQ(tracker.stats().gaps, 0u);
+}
+
+// Without retransmission a gap is counted as lost and skipped.
+TEST(SequenceTrackerTest, GapWithoutRetransmitIsSkipped) {
+    SequenceTracker tracker;
+    RecordingSink sink;
+    Frame a(1, 3), b(6, 2);
+    tracker.onFrame(a.header, a.data(), 0, sink);
+    tracker.onFrame(b.header, b.data(), 0, sink);
+
+    EXPECT_EQ(sink.ids, std::vector<OrderID>({1, 2, 3, 6, 7}));
+    EXPECT_EQ(tracker.stats().gaps, 1u);
+    EXPECT_EQ(tracker.stats().lost, 2u);
+    EXPECT_TRUE(sink.requests.empty());
+}
+
+// With retransmission, frames after a gap wait until the gap is filled, so
+// messages are still delivered in order.
+TEST(SequenceTrackerTest, RetransmitFillsGapInOrder) {
+    SequenceTrackerConfig config;
+    config.retransmit = true;
+    SequenceTracker tracker(config);
+    RecordingSink sink;
+    Frame a(1, 3), c(8, 2), d(10, 2);
+    tracker.onFrame(a.header, a.data(), 0, sink);
+    tracker.onFrame(c.header, c.data(), 0, sink);
+    tracker.onFrame(d.header, d.data(), 0, sink);
+
+    ASSERT_EQ(sink.requests.size(), 1u);
+    EXPECT_EQ(sink.requests[0].first_sequence, 4u);
+    EXPECT_EQ(sink.requests[0].count, 4u);
+    EXPECT_EQ(sink.ids, range(1, 3));
+    EXPECT_TRUE(tracker.waiting());
+
+    Frame resent(4, 4, 7, FRAME_FLAG_RETRANSMIT);
+    tracker.onFrame(resent.header, resent.data(), 0, sink);
+    EXPECT_EQ(sink.ids, range(1, 11));
+    EXPECT_FALSE(tracker.waiting());
+    EXPECT_EQ(tracker.stats().retransmitted, 4u);
+    EXPECT_EQ(tracker.stats().lost, 0u);
+}
+
+// A gap that is never filled is given up on after the timeout.
+TEST(SequenceTrackerTest, UnfilledGapTimesOut) {
+    SequenceTrackerConfig config;
+    config.retransmit = true;
+    config.gap_timeout_ns = 1000;
+    SequenceTracker tracker(config);
+    RecordingSink sink;
+    Frame a(1, 2), b(5, 2);
+    tracker.onFrame(a.header, a.data(), 0, sink);
+    tracker.onFrame(b.header, b.data(), 100, sink);
+
+    tracker.poll(500, sink);
+    EXPECT_EQ(sink.ids, range(1, 2));
+    tracker.poll(1100, sink);
+    EXPECT_EQ(sink.ids, std::vector<OrderID>({1, 2, 5, 6}));
+    EXPECT_EQ(tracker.stats().lost, 2u);
+    EXPECT_FALSE(tracker.waiting());
+}
+
+// A new session ID means the sender restarted: numbering starts again.
+TEST(SequenceTrackerTest, NewSessionRestartsNumbering) {
+    SequenceTracker tracker;
+    RecordingSink sink;
+    Frame a(1, 5), restarted(1, 2, 8);
+    tracker.onFrame(a.header, a.data(), 0, sink);
+    tracker.onFrame(restarted.header, restarted.data(), 0, sink);
+
+    EXPECT_EQ(sink.ids, std::vector<OrderID>({1, 2, 3, 4, 5, 1, 2}));
+    EXPECT_EQ(tracker.stats().session_resets, 1u);
+    EXPECT_EQ(tracker.stats().duplicates, 0u);
+}
+
+// Two senders that both number a stream 0 are two streams: neither one's
+// frames look like duplicates of, or gaps in, the other's.
+TEST(SequenceTrackerTest, SameStreamFromTwoSourcesIsTrackedSeparately) {
+    SequenceTracker tracker;
+    RecordingSink sink;
+    Frame first(1, 3), second(1, 3, 9), first_more(4, 2), second_more(4, 2, 9);
+    tracker.onFrame(first.header, first.data(), 0, sink, 1);
+    tracker.onFrame(second.header, second.data(), 0, sink, 2);
+    tracker.onFrame(first_more.header, first_more.data(), 0, sink, 1);
+    tracker.onFrame(second_more.header, second_more.data(), 0, sink, 2);
+
+    EXPECT_EQ(sink.ids, std::vector<OrderID>({1, 2, 3, 1, 2, 3, 4, 5, 4, 5}));
+    EXPECT_EQ(tracker.stats().duplicates, 0u);
+    EXPECT_EQ(tracker.stats().gaps, 0u);
+    EXPECT_EQ(tracker.stats().session_resets, 0u);
+}
+
+// A retransmission arrives from the recovery service, not the stream's own
+// source, and still fills the gap in the right stream.
+TEST(SequenceTrackerTest, RetransmitFromAnotherSourceFindsItsStream) {
+    SequenceTrackerConfig config;
+    config.retransmit = true;
+    SequenceTracker tracker(config);
+    RecordingSink sink;
+    Frame other(1, 2, 9), a(1, 2), c(5, 2), resent(3, 2, 7, FRAME_FLAG_RETRANSMIT);
+    tracker.onFrame(other.header, other.data(), 0, sink, 1);
+    tracker.onFrame(a.header, a.data(), 0, sink, 2);
+    tracker.onFrame(c.header, c.data(), 0, sink, 2);
+    ASSERT_TRUE(tracker.waiting());
+    tracker.onFrame(resent.header, resent.data(), 0, sink, 3);
+
+    EXPECT_FALSE(tracker.waiting());
+    EXPECT_EQ(sink.ids, std::vector<OrderID>({1, 2, 1, 2, 3, 4, 5, 6}));
+    EXPECT_EQ(tracker.stats().retransmitted, 2u);
+    EXPECT_EQ(tracker.stats().lost, 0u);
+}
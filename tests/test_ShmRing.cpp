@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+#include "../engine/include/ShmReceiver.h"
+#include "../engine/include/ShmRing.h"
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// A segment name no other test run on the host is using.
+std::string segmentName(const char* test) {
+    return "/panoptes_test_ring_" + std::string(test) + "_" + std::to_string(getpid());
+}
+
+ShmReceiverConfig smallRing(const std::string& name, size_t lanes) {
+    ShmReceiverConfig config;
+    config.name = name;
+    config.num_lanes = lanes;
+    config.lane_bytes = 4096;
+    config.buffer_size = 256;
+    config.batch_size = 16;
+    config.timeout_ms = 20;
+    return config;
+}
+
+// Datagram 'n': a 4-byte number, then a payload whose length and bytes depend on it.
+size_t fillDatagram(uint32_t n, char* out) {
+    const size_t payload = n % 200;
+    std::memcpy(out, &n, sizeof(n));
+    for (size_t i = 0; i < payload; ++i) {
+        out[sizeof(n) + i] = static_cast<char>(n + i);
+    }
+    return sizeof(n) + payload;
+}
+
+void expectDatagram(uint32_t n, const char* data, size_t length) {
+    char expected[256];
+    const size_t expected_length = fillDatagram(n, expected);
+    ASSERT_EQ(length, expected_length) << "datagram " << n;
+    ASSERT_EQ(std::memcmp(data, expected, length), 0) << "datagram " << n;
+}
+
+} // namespace
+
+// Datagrams of every length come out whole and in order, however many times
+// the lane wraps, including the two-piece (header, body) writes the thrasher uses.
+TEST(ShmRingTest, DeliversDatagramsInOrderAcrossWraps) {
+    const std::string name = segmentName("wraps");
+    ShmReceiver receiver(smallRing(name, 1));
+    ASSERT_TRUE(receiver.open());
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 0));
+
+    uint32_t written = 0;
+    uint32_t read = 0;
+    char buffer[256];
+    while (read < 2000) {
+        // A few at a time, split into two pieces at a point that moves.
+        for (int k = 0; k < 5; ++k) {
+            const size_t length = fillDatagram(written, buffer);
+            const size_t split = written % length;
+            if (!writer.tryWrite(buffer, split, buffer + split, length - split)) {
+                break;
+            }
+            ++written;
+        }
+        writer.publish();
+        const int received = receiver.receiveBatch();
+        ASSERT_GT(received, 0);
+        for (int i = 0; i < received; ++i) {
+            expectDatagram(read++, receiver.data(i), receiver.length(i));
+        }
+    }
+    EXPECT_EQ(receiver.stats().datagrams, read);
+    EXPECT_EQ(receiver.stats().kernel_drops, 0u);
+}
+
+// Nothing is visible until published, a full lane refuses further writes, and
+// the space a batch used comes back once the next batch is asked for.
+TEST(ShmRingTest, FullLaneHoldsTheWriterBack) {
+    const std::string name = segmentName("full");
+    ShmReceiver receiver(smallRing(name, 1));
+    ASSERT_TRUE(receiver.open());
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 0));
+
+    char datagram[120] = {};
+    ASSERT_TRUE(writer.tryWrite(datagram, sizeof(datagram)));
+    EXPECT_EQ(receiver.receiveBatch(), 0); // Staged, not published.
+    writer.publish();
+    EXPECT_EQ(receiver.receiveBatch(), 1);
+
+    // 4096 bytes hold 32 records of 128 bytes; the first is still held by the
+    // receiver's last batch.
+    int accepted = 0;
+    while (writer.tryWrite(datagram, sizeof(datagram))) {
+        ++accepted;
+    }
+    EXPECT_EQ(accepted, 31);
+    EXPECT_EQ(writer.fullCount(), 1u);
+    // A refused write publishes what was staged, so the receiver can drain it.
+    EXPECT_EQ(receiver.receiveBatch(), 16);
+    EXPECT_EQ(receiver.receiveBatch(), 15);
+    EXPECT_TRUE(writer.tryWrite(datagram, sizeof(datagram)));
+
+    // Longer than the segment allows: refused outright.
+    std::vector<char> too_long(writer.maxDatagram() + 1);
+    EXPECT_FALSE(writer.tryWrite(too_long.data(), too_long.size()));
+}
+
+// Each lane has one writer, and a batch takes from every lane with data.
+TEST(ShmRingTest, LanesAreClaimedOnceAndAllDrained) {
+    const std::string name = segmentName("lanes");
+    ShmReceiver receiver(smallRing(name, 2));
+    ASSERT_TRUE(receiver.open());
+    ShmRingWriter first;
+    ShmRingWriter second;
+    ShmRingWriter intruder;
+    ASSERT_TRUE(first.open(name, 0));
+    EXPECT_FALSE(intruder.open(name, 0));
+    EXPECT_FALSE(intruder.open(name, 2));
+    ASSERT_TRUE(second.open(name, 1));
+    EXPECT_EQ(receiver.writersAttached(), 2u);
+
+    const char a = 'a';
+    const char b = 'b';
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(first.tryWrite(&a, 1));
+        ASSERT_TRUE(second.tryWrite(&b, 1));
+    }
+    first.publish();
+    second.publish();
+    int seen[2] = {0, 0};
+    for (int received = 0; received < 20;) {
+        const int batch = receiver.receiveBatch();
+        ASSERT_GT(batch, 0);
+        for (int i = 0; i < batch; ++i) {
+            ++seen[receiver.data(i)[0] - 'a'];
+        }
+        received += batch;
+    }
+    EXPECT_EQ(seen[0], 10);
+    EXPECT_EQ(seen[1], 10);
+
+    // Closing gives the lane up for the next writer.
+    first.close();
+    EXPECT_EQ(receiver.writersAttached(), 1u);
+    EXPECT_TRUE(intruder.open(name, 0));
+}
+
+// A claim left behind by a writer that exited without closing does not lock
+// the lane for good.
+TEST(ShmRingTest, LaneOfAnExitedWriterIsReclaimed) {
+    const std::string name = segmentName("reclaim");
+    ShmReceiver receiver(smallRing(name, 1));
+    ASSERT_TRUE(receiver.open());
+
+    // A pid that is certainly gone: a child that has exited and been reaped.
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(child, nullptr, 0), child);
+    ShmRingSegment segment;
+    ASSERT_TRUE(segment.attach(name));
+    segment.lane(0).writer_pid.store(static_cast<uint32_t>(child));
+
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 0));
+    EXPECT_EQ(segment.lane(0).writer_pid.load(), static_cast<uint32_t>(getpid()));
+
+    // A live claim (this process's own) is still refused.
+    ShmRingWriter intruder;
+    EXPECT_FALSE(intruder.open(name, 0));
+}
+
+// A record whose length the segment could never hold is not handed out: the
+// receiver skips what the lane has published and carries on with what follows.
+TEST(ShmRingTest, ImpossibleRecordLengthSkipsTheLane) {
+    const std::string name = segmentName("corrupt");
+    ShmReceiver receiver(smallRing(name, 1));
+    ASSERT_TRUE(receiver.open());
+    ShmRingSegment segment;
+    ASSERT_TRUE(segment.attach(name));
+
+    // Records written by hand, as a misbehaving writer would.
+    uint64_t tail = 0;
+    auto put = [&](uint32_t length) {
+        std::memcpy(segment.records(0) + (tail & (segment.laneBytes() - 1)), &length, sizeof(length));
+        tail += shmRingRecordBytes(length == SHM_RING_WRAP ? 0 : length);
+    };
+
+    // 1. A length longer than the segment allows.
+    put(static_cast<uint32_t>(segment.maxDatagram() + 1));
+    segment.lane(0).tail.store(tail, std::memory_order_release);
+    EXPECT_EQ(receiver.receiveBatch(), 0);
+    EXPECT_EQ(receiver.stats().corrupt_lanes, 1u);
+
+    // 2. A length the segment allows, in a record that would run past the end
+    // of the lane. The good records before it are still delivered.
+    const uint64_t last = segment.laneBytes() - SHM_RING_RECORD_HEADER;
+    int good = 0;
+    for (; last - tail > shmRingRecordBytes(segment.maxDatagram()); ++good) {
+        put(static_cast<uint32_t>(segment.maxDatagram()));
+    }
+    put(static_cast<uint32_t>(last - tail - SHM_RING_RECORD_HEADER));
+    ++good;
+    ASSERT_EQ(tail, last);
+    put(64);
+    segment.lane(0).tail.store(tail, std::memory_order_release);
+    int received = 0;
+    for (int batch; (batch = receiver.receiveBatch()) > 0;) {
+        received += batch;
+    }
+    EXPECT_EQ(received, good);
+    EXPECT_EQ(receiver.stats().corrupt_lanes, 2u);
+
+    // A well-behaved writer taking the lane over is read normally.
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 0));
+    const char datagram[5] = "abcd";
+    ASSERT_TRUE(writer.tryWrite(datagram, sizeof(datagram)));
+    writer.publish();
+    ASSERT_EQ(receiver.receiveBatch(), 1);
+    EXPECT_EQ(receiver.length(0), sizeof(datagram));
+    EXPECT_EQ(std::memcmp(receiver.data(0), datagram, sizeof(datagram)), 0);
+}
+
+// A writer thread streaming flat out through a small lane: the receiver sees
+// every datagram, intact and in order.
+TEST(ShmRingTest, StreamsBetweenThreads) {
+    const std::string name = segmentName("threads");
+    ShmReceiver receiver(smallRing(name, 1));
+    ASSERT_TRUE(receiver.open());
+    constexpr uint32_t COUNT = 50000;
+
+    std::thread producer([&] {
+        ShmRingWriter writer;
+        if (!writer.open(name, 0)) {
+            return;
+        }
+        char buffer[256];
+        for (uint32_t n = 0; n < COUNT; ++n) {
+            const size_t length = fillDatagram(n, buffer);
+            while (!writer.tryWrite(buffer, length)) {
+                std::this_thread::yield();
+            }
+            if (n % 8 == 7) {
+                writer.publish();
+            }
+        }
+        writer.publish();
+    });
+
+    uint32_t read = 0;
+    while (read < COUNT) {
+        const int received = receiver.receiveBatch();
+        ASSERT_GT(received, 0) << "timed out after " << read << " datagrams";
+        for (int i = 0; i < received; ++i) {
+            expectDatagram(read++, receiver.data(i), receiver.length(i));
+        }
+    }
+    producer.join();
+}
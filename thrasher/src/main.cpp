@@ -1,72 +1,542 @@
 #include <iostream>
-#include <fstream>
 #include <vector>
+#include <string>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <chrono>
 #include <thread>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 
-#include "../../engine/include/DataTypes.h" // Include the message definition
+#include "DataTypes.h" // Include the message definition
+#include "LatencyHistogram.h"
+#include "MappedFile.h"
+#include "ShmRing.h"
+#include "WireFormat.h"
 
 constexpr int UDP_PORT = 12345;
+constexpr int RECOVERY_PORT = 12347;
 const char* TARGET_IP = "127.0.0.1";
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path_to_data_file>" << std::endl;
-        return 1;
+// How messages are spaced out in time.
+enum class PacingMode {
+    Flat,      // Evenly spaced at the target rate (or as fast as possible if no rate).
+    Burst,     // Bursts of back-to-back messages, spaced so the average is the target rate.
+    Recorded   // The capture's own inter-arrival times, from its timestamps.
+};
+
+struct ThrasherConfig {
+    const char* data_file_path = nullptr;
+    const char* target_ip = TARGET_IP;
+    int port = UDP_PORT;         // The engine's one receive port; each thread sends from a socket of its own.
+    int num_threads = 1;
+    size_t batch_size = 32;      // Datagrams per sendmmsg call.
+    double rate = 0.0;           // Target messages per second across all threads (0 = unpaced).
+    PacingMode pacing = PacingMode::Flat;
+    size_t burst_size = 100;     // Messages per burst in Burst mode.
+    double speed = 1.0;          // Playback speed multiplier in Recorded mode.
+    bool wait_for_enter = false; // The old interactive start.
+    int start_delay_ms = 0;
+    bool v1 = false;             // One bare message per datagram, no framing or sequence numbers.
+    size_t frame_messages = DEFAULT_FRAME_MESSAGES; // Messages per v2 datagram.
+    uint32_t session_id = 0;     // Chosen at startup; identifies this run to the engine.
+    int recovery_port = RECOVERY_PORT; // Where retransmit requests are served (0 = off).
+    int linger_ms = 1000;        // How long to keep serving retransmits after the last send.
+    size_t drop_every = 0;       // Skip every Nth datagram, to exercise gap recovery (0 = off).
+    const char* shm_ring = nullptr; // Write into this engine's shared-memory ring instead of sending UDP.
+};
+
+// One sender thread's stream: the capture positions of its messages, in send
+// order. The message at position p has sequence number p + 1. 'sent' is how
+// many of them have gone out, which is as far as a retransmit can reach.
+struct StreamLog {
+    std::vector<size_t> positions;
+    std::atomic<uint64_t> sent{0};
+};
+
+// What one sender thread did.
+struct SenderResult {
+    uint64_t sent = 0;
+    uint64_t datagrams = 0;
+    uint64_t dropped = 0;        // Datagrams deliberately not sent (--drop-every).
+    uint64_t send_errors = 0;
+    uint64_t syscalls = 0;
+    uint64_t ring_full = 0;      // Times the shared-memory ring had no room and the sender waited.
+    bool failed = false;         // Never started: no socket, no ring lane, or datagrams too big for the ring.
+    // How late each batch went out relative to its first message's slot (the send-side jitter).
+    std::unique_ptr<LatencyHistogram> lateness = std::make_unique<LatencyHistogram>();
+};
+
+static int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t wallClockNanos() {
+    auto now = std::chrono::system_clock::now();
+    return std::chrono::time_point_cast<std::chrono::nanoseconds>(now).time_since_epoch().count();
+}
+
+// Waits until 'deadline' (steady clock ns). Sleeps through long gaps and spins
+// through the last stretch, since sleeping is far too coarse for microsecond pacing.
+static void waitUntil(int64_t deadline) {
+    constexpr int64_t SPIN_THRESHOLD_NS = 200000;
+    int64_t now = nowNanos();
+    if (deadline - now > SPIN_THRESHOLD_NS) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now - SPIN_THRESHOLD_NS));
+    }
+    while (nowNanos() < deadline) {
     }
-    const char* data_file_path = argv[1];
+}
 
-    std::ifstream input_file(data_file_path, std::ios::binary | std::ios::ate);
-    if (!input_file.is_open()) {
-        std::cerr << "Error: Could not open data file " << data_file_path << std::endl;
-        return -1;
+// Builds v2 frame headers, in wire byte order.
+static FrameHeader makeFrameHeader(const ThrasherConfig& config, uint16_t stream, uint64_t first_sequence,
+                                   size_t count, uint8_t flags) {
+    FrameHeader header{FRAME_MAGIC, FRAME_VERSION, flags, static_cast<uint16_t>(count), config.session_id, stream, 0,
+                       first_sequence};
+    swapWireByteOrder(header);
+    return header;
+}
+
+// Sends this thread's stream: every message whose instrument belongs to it
+// (instrument % num_threads), so each instrument's messages stay in order on a
+// single socket, or on a single lane of the shared-memory ring.
+static void runSender(const ThrasherConfig& config, int thread_index, const PanoptesMessage* messages,
+                      StreamLog& stream, int64_t start_ns, SenderResult& result) {
+    ShmRingWriter ring;
+    int sock_fd = -1;
+    if (config.shm_ring != nullptr) {
+        if (!ring.open(config.shm_ring, static_cast<size_t>(thread_index))) {
+            result.failed = true;
+            return;
+        }
+        const size_t largest = config.v1 ? sizeof(PanoptesMessage)
+                                         : sizeof(FrameHeader) + config.frame_messages * sizeof(PanoptesMessage);
+        if (largest > ring.maxDatagram()) {
+            std::cerr << "Error: " << largest << "-byte datagrams do not fit the ring's " << ring.maxDatagram()
+                      << "-byte records; use a smaller --frame." << std::endl;
+            result.failed = true;
+            return;
+        }
+    } else if ((sock_fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("socket creation failed");
+        result.failed = true;
+        return;
+    }
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.port);
+    inet_pton(AF_INET, config.target_ip, &server_addr.sin_addr);
+
+    // The capture is mapped read-only, so each batch is copied into this buffer
+    // and stamped there. A v2 datagram is two iovecs, its frame header and its
+    // slice of the buffer; a v1 datagram is a single message. Everything
+    // sendmmsg needs is allocated once.
+    const size_t per_datagram = config.v1 ? 1 : config.frame_messages;
+    std::vector<PanoptesMessage> batch(config.batch_size * per_datagram);
+    std::vector<FrameHeader> frames(config.batch_size);
+    std::vector<iovec> iovecs(2 * config.batch_size);
+    std::vector<mmsghdr> headers(config.batch_size);
+    for (size_t i = 0; i < config.batch_size; ++i) {
+        std::memset(&headers[i], 0, sizeof(headers[i]));
+        headers[i].msg_hdr.msg_name = &server_addr;
+        headers[i].msg_hdr.msg_namelen = sizeof(server_addr);
+        headers[i].msg_hdr.msg_iov = &iovecs[2 * i];
     }
 
-    std::streamsize size = input_file.tellg();
-    input_file.seekg(0, std::ios::beg);
+    // The schedule is a function of each message's position in the capture (or
+    // its recorded timestamp), not of which thread sends it, so the threads
+    // together follow one global schedule however the instruments are spread.
+    const bool paced = config.rate > 0.0 || config.pacing == PacingMode::Recorded;
+    const Timestamp first_timestamp = messages[0].timestamp;
+    auto dueTime = [&](size_t index) -> int64_t {
+        switch (config.pacing) {
+            case PacingMode::Recorded:
+                return start_ns + static_cast<int64_t>((messages[index].timestamp - first_timestamp) / config.speed);
+            case PacingMode::Burst:
+                // Every message of a burst shares the burst's start time.
+                return start_ns + static_cast<int64_t>(index / config.burst_size * config.burst_size * 1e9 / config.rate);
+            case PacingMode::Flat:
+            default:
+                return config.rate > 0.0 ? start_ns + static_cast<int64_t>(index * 1e9 / config.rate) : start_ns;
+        }
+    };
 
-    std::vector<char> buffer(size);
-    if (!input_file.read(buffer.data(), size)) {
-        std::cerr << "Error: Could not read data file into buffer." << std::endl;
-        return -1;
+    const std::vector<size_t>& positions = stream.positions;
+    size_t next = 0;
+    uint64_t datagram_number = 0;
+    while (next < positions.size()) {
+        // 1. Wait for this thread's next message's slot.
+        if (paced) {
+            const int64_t due = dueTime(positions[next]);
+            waitUntil(due);
+            // How late we actually are is the send-side jitter.
+            result.lateness->record(nowNanos() - due);
+        }
+
+        // 2. Batch it with any following messages that are also due by now
+        // (the rest of a burst, or a backlog if we have fallen behind schedule).
+        // Unpaced, everything is due, so batches are always full.
+        const int64_t now = paced ? nowNanos() : 0;
+        const uint64_t first_sequence = next + 1;
+        size_t count = 0;
+        for (; next < positions.size() && count < batch.size(); ++next) {
+            if (paced && count > 0 && dueTime(positions[next]) > now) {
+                break;
+            }
+            batch[count++] = messages[positions[next]];
+        }
+
+        // 3. Overwrite the historical timestamps with the current time right
+        // before sending, so the engine can measure wire-to-receive latency.
+        const Timestamp send_time =
+            static_cast<Timestamp>(fromLittleEndian(static_cast<uint64_t>(wallClockNanos()))); // Wire byte order.
+        for (size_t i = 0; i < count; ++i) {
+            batch[i].timestamp = send_time;
+        }
+
+        // 4. Cut the batch into datagrams.
+        size_t num_datagrams = 0;
+        for (size_t offset = 0; offset < count; offset += per_datagram) {
+            const size_t in_datagram = std::min(per_datagram, count - offset);
+            if (config.drop_every > 0 && ++datagram_number % config.drop_every == 0) {
+                ++result.dropped;
+                continue;
+            }
+            iovec* iov = headers[num_datagrams].msg_hdr.msg_iov;
+            if (config.v1) {
+                iov[0] = {&batch[offset], sizeof(PanoptesMessage)};
+                headers[num_datagrams].msg_hdr.msg_iovlen = 1;
+            } else {
+                frames[num_datagrams] = makeFrameHeader(config, static_cast<uint16_t>(thread_index),
+                                                        first_sequence + offset, in_datagram, 0);
+                iov[0] = {&frames[num_datagrams], sizeof(FrameHeader)};
+                iov[1] = {&batch[offset], in_datagram * sizeof(PanoptesMessage)};
+                headers[num_datagrams].msg_hdr.msg_iovlen = 2;
+            }
+            ++num_datagrams;
+        }
+
+        // 5. Send them with as few syscalls as possible, or write them into the
+        // ring and publish them together. A full ring means the engine is behind:
+        // wait for it rather than drop.
+        size_t sent_datagrams = 0;
+        if (config.shm_ring != nullptr) {
+            for (; sent_datagrams < num_datagrams; ++sent_datagrams) {
+                const msghdr& datagram = headers[sent_datagrams].msg_hdr;
+                const iovec* iov = datagram.msg_iov;
+                while (!(datagram.msg_iovlen == 1 ? ring.tryWrite(iov[0].iov_base, iov[0].iov_len)
+                                                  : ring.tryWrite(iov[0].iov_base, iov[0].iov_len,
+                                                                  iov[1].iov_base, iov[1].iov_len))) {
+                    ++result.ring_full;
+                    std::this_thread::yield();
+                }
+            }
+            ring.publish();
+        }
+        while (sent_datagrams < num_datagrams) {
+            ++result.syscalls;
+            int sent = sendmmsg(sock_fd, headers.data() + sent_datagrams,
+                                static_cast<unsigned>(num_datagrams - sent_datagrams), 0);
+            if (sent <= 0) {
+                ++result.send_errors;
+                break;
+            }
+            sent_datagrams += static_cast<size_t>(sent);
+        }
+        result.datagrams += sent_datagrams;
+        result.sent += count;
+        // Everything up to here can now be asked for again.
+        stream.sent.store(next, std::memory_order_release);
     }
-    input_file.close();
 
-    const size_t num_messages = size / sizeof(PanoptesMessage);
-    std::cout << "Loaded " << num_messages << " messages from " << data_file_path << std::endl;
+    if (sock_fd >= 0) {
+        close(sock_fd);
+    }
+}
 
+// What the recovery service did.
+struct RecoveryResult {
+    uint64_t requests = 0;
+    uint64_t messages = 0;
+};
+
+// Serves RetransmitRequests for this run's streams until 'stop' is set. The
+// missing messages are resent as v2 frames flagged as retransmissions, to the
+// address the request came from.
+static void runRecoveryService(const ThrasherConfig& config, const PanoptesMessage* messages,
+                               std::vector<StreamLog>& streams, const std::atomic<bool>& stop,
+                               RecoveryResult& result) {
     int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock_fd < 0) {
-        perror("socket creation failed");
-        return -1;
+        perror("recovery socket creation failed");
+        return;
     }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(config.recovery_port);
+    if (bind(sock_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("recovery bind failed");
+        close(sock_fd);
+        return;
+    }
+    // Wake up regularly to notice 'stop'.
+    timeval timeout{0, 100000};
+    setsockopt(sock_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
 
-    sockaddr_in server_addr{};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(UDP_PORT);
-    inet_pton(AF_INET, TARGET_IP, &server_addr.sin_addr);
+    std::vector<PanoptesMessage> frame(config.frame_messages);
+    while (!stop.load(std::memory_order_acquire)) {
+        RetransmitRequest request;
+        sockaddr_in from{};
+        socklen_t from_len = sizeof(from);
+        const ssize_t n = recvfrom(sock_fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr*>(&from), &from_len);
+        swapWireByteOrder(request);
+        if (n != static_cast<ssize_t>(sizeof(request)) || request.magic != RETRANSMIT_MAGIC ||
+            request.session_id != config.session_id || request.stream_id >= streams.size()) {
+            continue;
+        }
+        ++result.requests;
+
+        // Only what has actually been sent can be resent.
+        const StreamLog& stream = streams[request.stream_id];
+        const uint64_t sent = stream.sent.load(std::memory_order_acquire);
+        uint64_t sequence = std::max<uint64_t>(request.first_sequence, 1);
+        const uint64_t end = std::min<uint64_t>(request.first_sequence + request.count, sent + 1);
+        const Timestamp send_time =
+            static_cast<Timestamp>(fromLittleEndian(static_cast<uint64_t>(wallClockNanos()))); // Wire byte order.
+        while (sequence < end) {
+            const size_t count = std::min<uint64_t>(frame.size(), end - sequence);
+            for (size_t i = 0; i < count; ++i) {
+                frame[i] = messages[stream.positions[sequence - 1 + i]];
+                frame[i].timestamp = send_time;
+            }
+            const FrameHeader header = makeFrameHeader(config, request.stream_id, sequence, count, FRAME_FLAG_RETRANSMIT);
+            iovec iov[2] = {{const_cast<FrameHeader*>(&header), sizeof(header)},
+                            {frame.data(), count * sizeof(PanoptesMessage)}};
+            msghdr msg{};
+            msg.msg_name = &from;
+            msg.msg_namelen = from_len;
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 2;
+            sendmsg(sock_fd, &msg, 0);
+            result.messages += count;
+            sequence += count;
+        }
+    }
+    close(sock_fd);
+}
 
-    std::cout << "Thrasher is ready. Start the engine now, then press Enter to begin." << std::endl;
-    std::cin.get(); // Wait for user to press Enter
-    std::cout << "Starting data blast..." << std::endl;
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <path_to_data_file> [options]\n"
+              << "  --target IP          destination address (default 127.0.0.1)\n"
+              << "  --port P             destination port (default 12345)\n"
+              << "  --threads N          sender threads, each with its own socket (default 1)\n"
+              << "  --batch N            messages per sendmmsg call (default 32)\n"
+              << "  --rate R             target messages per second in total (default: unpaced)\n"
+              << "  --burst N            send bursts of N back-to-back messages at the average --rate\n"
+              << "  --replay-timing      reproduce the capture's inter-arrival times\n"
+              << "  --speed X            playback speed for --replay-timing (default 1.0)\n"
+              << "  --v1                 send the old unframed format, one message per datagram\n"
+              << "  --frame N            messages per v2 datagram (default 40, fits a 1500-byte MTU)\n"
+              << "  --recovery-port P    serve retransmit requests on this port (default 12347, 0 = off)\n"
+              << "  --linger MS          keep serving retransmits this long after sending (default 1000)\n"
+              << "  --drop-every N       skip every Nth datagram to exercise gap recovery\n"
+              << "  --shm-ring NAME      write into the engine's shared-memory ring NAME instead of sending\n"
+              << "                       UDP (engine --shm-ring NAME, started first); thread t uses lane t\n"
+              << "  --start-delay MS     wait before sending (default 0)\n"
+              << "  --wait-for-enter     wait for Enter before sending" << std::endl;
+}
 
-    PanoptesMessage* messages = reinterpret_cast<PanoptesMessage*>(buffer.data());
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    ThrasherConfig config;
+    config.data_file_path = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            config.target_ip = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.num_threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            config.batch_size = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            config.rate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            config.pacing = PacingMode::Burst;
+            config.burst_size = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--replay-timing") == 0) {
+            config.pacing = PacingMode::Recorded;
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            config.speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--v1") == 0) {
+            config.v1 = true;
+        } else if (std::strcmp(argv[i], "--frame") == 0 && i + 1 < argc) {
+            config.frame_messages = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--recovery-port") == 0 && i + 1 < argc) {
+            config.recovery_port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--linger") == 0 && i + 1 < argc) {
+            config.linger_ms = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--drop-every") == 0 && i + 1 < argc) {
+            config.drop_every = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--shm-ring") == 0 && i + 1 < argc) {
+            config.shm_ring = argv[++i];
+        } else if (std::strcmp(argv[i], "--start-delay") == 0 && i + 1 < argc) {
+            config.start_delay_ms = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--wait-for-enter") == 0) {
+            config.wait_for_enter = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.num_threads < 1 || config.batch_size == 0 || config.burst_size == 0 || config.speed <= 0.0) {
+        std::cerr << "Error: threads, batch, burst and speed must be positive." << std::endl;
+        return 1;
+    }
+    // A frame's message count is 16 bits and the datagram must fit in 64 KB.
+    constexpr size_t MAX_FRAME_MESSAGES = (65507 - sizeof(FrameHeader)) / sizeof(PanoptesMessage);
+    if (config.frame_messages == 0 || config.frame_messages > MAX_FRAME_MESSAGES) {
+        std::cerr << "Error: --frame must be between 1 and " << MAX_FRAME_MESSAGES << "." << std::endl;
+        return 1;
+    }
+    if (config.pacing == PacingMode::Burst && config.rate <= 0.0) {
+        std::cerr << "Error: --burst needs a --rate to space the bursts." << std::endl;
+        return 1;
+    }
+
+    // Map the capture rather than reading it, so files of any size load instantly.
+    MappedFile input_file;
+    if (!input_file.open(config.data_file_path)) {
+        std::cerr << "Error: Could not open data file " << config.data_file_path << std::endl;
+        return -1;
+    }
+    const size_t num_messages = input_file.size() / sizeof(PanoptesMessage);
+    const PanoptesMessage* messages = reinterpret_cast<const PanoptesMessage*>(input_file.data());
+    std::cout << "Loaded " << num_messages << " messages from " << config.data_file_path << std::endl;
+    if (num_messages == 0) {
+        return 0;
+    }
+
+    // Split the capture into one stream per thread up front, so the recovery
+    // service can map any stream's sequence number back to its message.
+    std::vector<StreamLog> streams(config.num_threads);
     for (size_t i = 0; i < num_messages; ++i) {
-        // *** THIS IS THE CRITICAL FIX ***
-        // Overwrite the historical timestamp with the current time right before sending.
-        auto now = std::chrono::high_resolution_clock::now();
-        messages[i].timestamp = std::chrono::time_point_cast<std::chrono::nanoseconds>(now).time_since_epoch().count();
+        streams[messages[i].instrument_id % config.num_threads].positions.push_back(i);
+    }
+    // A fresh session ID tells the engine this is a new run and numbering restarts.
+    config.session_id = static_cast<uint32_t>(wallClockNanos() / 1000) ^ static_cast<uint32_t>(getpid());
 
-        sendto(sock_fd, &messages[i], sizeof(PanoptesMessage), 0,
-               (const struct sockaddr *)&server_addr, sizeof(server_addr));
+    std::atomic<bool> stop_recovery{false};
+    RecoveryResult recovery;
+    std::thread recovery_thread;
+    if (!config.v1 && config.recovery_port > 0) {
+        recovery_thread = std::thread(runRecoveryService, std::cref(config), messages, std::ref(streams),
+                                      std::cref(stop_recovery), std::ref(recovery));
     }
 
-    std::cout << "Finished sending " << num_messages << " messages." << std::endl;
-    close(sock_fd);
+    if (config.wait_for_enter) {
+        std::cout << "Thrasher is ready. Start the engine now, then press Enter to begin." << std::endl;
+        std::cin.get(); // Wait for user to press Enter
+    } else if (config.start_delay_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.start_delay_ms));
+    }
+    std::cout << "Starting data blast with " << config.num_threads << " thread(s)";
+    if (config.rate > 0.0) {
+        std::cout << " at " << config.rate << " msgs/s";
+    }
+    std::cout << "..." << std::endl;
+
+    // Give every thread the same start time so their schedules line up.
+    std::vector<SenderResult> results(config.num_threads);
+    std::vector<std::thread> threads;
+    const int64_t start_ns = nowNanos() + 1000000;
+    for (int t = 0; t < config.num_threads; ++t) {
+        threads.emplace_back(runSender, std::cref(config), t, messages, std::ref(streams[t]), start_ns, std::ref(results[t]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double elapsed_s = (nowNanos() - start_ns) / 1e9;
+    if (recovery_thread.joinable()) {
+        // Gaps near the end are only noticed, and asked about, after the last send.
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.linger_ms));
+        stop_recovery.store(true, std::memory_order_release);
+        recovery_thread.join();
+    }
+
+    uint64_t total_sent = 0;
+    uint64_t total_errors = 0;
+    uint64_t total_syscalls = 0;
+    uint64_t total_ring_full = 0;
+    uint64_t total_datagrams = 0;
+    uint64_t total_dropped = 0;
+    int failed_threads = 0;
+    size_t unsent = 0;
+    LatencyHistogram lateness;
+    for (int t = 0; t < config.num_threads; ++t) {
+        const SenderResult& result = results[t];
+        if (result.failed) {
+            ++failed_threads;
+            unsent += streams[t].positions.size();
+        }
+        total_sent += result.sent;
+        total_errors += result.send_errors;
+        total_syscalls += result.syscalls;
+        total_ring_full += result.ring_full;
+        total_datagrams += result.datagrams;
+        total_dropped += result.dropped;
+        lateness.merge(*result.lateness);
+    }
+
+    // A thread that never started leaves its instruments unsent, so the run
+    // is incomplete however well the others did.
+    if (failed_threads > 0) {
+        std::cerr << "Error: " << failed_threads << " of " << config.num_threads
+                  << " sender thread(s) failed to start; their " << unsent << " messages were not sent." << std::endl;
+    }
+    std::cout << "Finished sending " << total_sent << " messages." << std::endl;
+    std::cout << "Achieved rate: " << total_sent / elapsed_s << " msgs/s over " << elapsed_s * 1e3 << " ms";
+    if (config.rate > 0.0) {
+        std::cout << " (target " << config.rate << ")";
+    }
+    std::cout << std::endl;
+    if (total_syscalls > 0) {
+        std::cout << "Messages per sendmmsg: " << (double)total_sent / total_syscalls << std::endl;
+    }
+    if (total_datagrams > 0) {
+        std::cout << "Datagrams: " << total_datagrams << " (" << (double)total_sent / (total_datagrams + total_dropped)
+                  << " messages each, " << (config.v1 ? "v1" : "v2 framed") << ")" << std::endl;
+    }
+    if (total_dropped > 0) {
+        std::cout << "Datagrams deliberately dropped: " << total_dropped << std::endl;
+    }
+    if (recovery.requests > 0) {
+        std::cout << "Retransmit requests served: " << recovery.requests << " (" << recovery.messages
+                  << " messages resent)" << std::endl;
+    }
+    if (config.shm_ring != nullptr) {
+        std::cout << "Shared-memory ring " << config.shm_ring << ": " << total_ring_full << " waits for a full lane"
+                  << std::endl;
+    }
+    if (total_errors > 0) {
+        std::cout << "Send errors: " << total_errors << std::endl;
+    }
+    if (lateness.count() > 0) {
+        std::cout << "Send jitter (batch lateness vs schedule, ns): p50 " << lateness.percentile(50.0)
+                  << " p99 " << lateness.percentile(99.0) << " p99.9 " << lateness.percentile(99.9)
+                  << " max " << lateness.max() << std::endl;
+    }
 
-    return 0;
+    return failed_threads > 0 ? 1 : 0;
 }
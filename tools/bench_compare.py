@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Compares a Google Benchmark JSON run against a stored baseline.
+
+Record a baseline on the machine that will run the comparisons (numbers from
+different machines are not comparable):
+
+    run_benchmarks --benchmark_repetitions=5 --benchmark_out=run.json \\
+        --benchmark_out_format=json
+    tools/bench_compare.py record run.json tests/baselines/$(hostname).json
+
+Then check later runs against it:
+
+    tools/bench_compare.py compare tests/baselines/$(hostname).json run.json
+
+A benchmark regresses when its throughput (items_per_second) falls, or its
+time per iteration (real_time) rises, by more than the threshold (default
+10%). With repetitions, the median of each benchmark is compared, which is far
+less noisy than a single run. If the run has a CACHE-MISSES counter (from
+--benchmark_perf_counters=CACHE-MISSES), cache misses per item are printed too.
+
+Exit status: 0 if nothing regressed, 1 if something did, 2 on bad input.
+"""
+
+import argparse
+import json
+import sys
+
+TIME_UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_results(path):
+    """Returns {benchmark name: result} for one run, preferring medians."""
+    with open(path) as f:
+        data = json.load(f)
+    results = {}
+    medians = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("error_occurred"):
+            continue
+        name = bench.get("run_name", bench["name"])
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = bench
+        elif name not in results:
+            results[name] = bench
+    results.update(medians)
+    return results
+
+
+def time_ns(bench):
+    return bench["real_time"] * TIME_UNIT_NS[bench.get("time_unit", "ns")]
+
+
+def misses_per_item(bench):
+    """CACHE-MISSES is per iteration; items per iteration come from the rate."""
+    misses = bench.get("CACHE-MISSES")
+    rate = bench.get("items_per_second")
+    if misses is None or not rate:
+        return None
+    cpu_seconds = bench["cpu_time"] * TIME_UNIT_NS[bench.get("time_unit", "ns")] / 1e9
+    items_per_iteration = rate * cpu_seconds
+    return misses / items_per_iteration if items_per_iteration > 0 else None
+
+
+def record(args):
+    results = load_results(args.run)
+    if not results:
+        print(f"{args.run}: no benchmark results", file=sys.stderr)
+        return 2
+    # Keep only what compare() reads, so baselines stay small and diffable.
+    keep = ("name", "run_name", "label", "real_time", "cpu_time", "time_unit", "items_per_second", "CACHE-MISSES")
+    baseline = {"benchmarks": [{k: bench[k] for k in keep if k in bench} for bench in results.values()]}
+    with open(args.baseline, "w") as f:
+        json.dump(baseline, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print(f"Recorded {len(results)} benchmarks to {args.baseline}")
+    return 0
+
+
+def change(old, new):
+    return (new - old) / old if old else 0.0
+
+
+def compare(args):
+    baseline = load_results(args.baseline)
+    run = load_results(args.run)
+    if not baseline or not run:
+        print("No benchmark results to compare", file=sys.stderr)
+        return 2
+
+    regressions = []
+    missing = []
+    print(f"{'Benchmark':<48} {'time chg':>10} {'rate chg':>10} {'misses/item':>14}")
+    for name, old in sorted(baseline.items()):
+        new = run.get(name)
+        if new is None:
+            missing.append(name)
+            continue
+        # The label names the input where it varies (BM_CaptureReplay's capture).
+        if old.get("label", "") != new.get("label", ""):
+            print(f"{name:<48} not compared: ran on '{new.get('label', '')}', baseline on '{old.get('label', '')}'")
+            continue
+
+        # 1. Latency: time per iteration.
+        time_change = change(time_ns(old), time_ns(new))
+        failed = time_change > args.latency_threshold
+
+        # 2. Throughput, where the benchmark reports it.
+        rate_text = "-"
+        if old.get("items_per_second") and new.get("items_per_second"):
+            rate_change = change(old["items_per_second"], new["items_per_second"])
+            rate_text = f"{rate_change:+.1%}"
+            failed = failed or -rate_change > args.throughput_threshold
+
+        # 3. Cache misses, for information only: they need a PMU, and a run
+        # without one should still be comparable.
+        old_misses, new_misses = misses_per_item(old), misses_per_item(new)
+        if new_misses is None:
+            misses_text = "-"
+        elif old_misses is None:
+            misses_text = f"{new_misses:.2f}"
+        else:
+            misses_text = f"{old_misses:.2f}->{new_misses:.2f}"
+
+        print(f"{name:<48} {time_change:>+10.1%} {rate_text:>10} {misses_text:>14}{'  REGRESSION' if failed else ''}")
+        if failed:
+            regressions.append(name)
+
+    for name in missing:
+        print(f"{name}: in the baseline but not in the run")
+    print(f"{len(regressions)} regression(s) over {args.throughput_threshold:.0%} throughput / "
+          f"{args.latency_threshold:.0%} latency, {len(missing)} missing")
+    if regressions or (missing and args.strict):
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    record_parser = commands.add_parser("record", help="store a run as a baseline")
+    record_parser.add_argument("run", help="benchmark JSON output (--benchmark_out)")
+    record_parser.add_argument("baseline", help="baseline file to write")
+    record_parser.set_defaults(func=record)
+
+    compare_parser = commands.add_parser("compare", help="check a run against a baseline")
+    compare_parser.add_argument("baseline", help="baseline file from 'record'")
+    compare_parser.add_argument("run", help="benchmark JSON output (--benchmark_out)")
+    compare_parser.add_argument("--threshold", type=float, default=0.10,
+                                help="allowed throughput drop and latency rise (default 0.10)")
+    compare_parser.add_argument("--throughput-threshold", type=float,
+                                help="allowed items_per_second drop (default --threshold)")
+    compare_parser.add_argument("--latency-threshold", type=float,
+                                help="allowed real_time rise (default --threshold)")
+    compare_parser.add_argument("--strict", action="store_true",
+                                help="also fail if a baseline benchmark is missing from the run")
+    compare_parser.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    if args.command == "compare":
+        if args.throughput_threshold is None:
+            args.throughput_threshold = args.threshold
+        if args.latency_threshold is None:
+            args.latency_threshold = args.threshold
+    try:
+        return args.func(args)
+    except (OSError, ValueError, KeyError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())